@@ -19,85 +19,46 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <vector>
 #include <neolib/vecarray.hpp>
-#include <neolib/lifetime.hpp>
 #include <boost/pool/pool_alloc.hpp>
 #include <neogfx/core/numerical.hpp>
-#include <neogfx/game/i_collidable_object.hpp>
+#include <neogfx/game/ecs_ids.hpp>
 
 namespace neogfx::game
 {
-    template <std::size_t BucketSize = 16, typename Allocator = boost::fast_pool_allocator<i_collidable_object>>
+    // Loose spatial index of entity AABBs. An entity is held in every leaf its AABB intersects; leaves split
+    // when they hold more than BucketSize entities and empty subtrees are pruned as entities leave them. An
+    // entity whose AABB is not wholly within the root AABB is held in a list at the root instead, which every
+    // visit scans, so entities outside the tree's bounds are never lost.
+    template <std::size_t BucketSize = 16, typename Allocator = boost::fast_pool_allocator<aabb>>
     class aabb_octree
     {
     public:
         typedef Allocator allocator_type;
-        typedef typename allocator_type::pointer pointer;
-        typedef typename allocator_type::const_pointer const_pointer;
-        typedef typename allocator_type::reference reference;
-        typedef typename allocator_type::const_reference const_reference;
     public:
-        typedef const void* const_iterator; // todo
-        typedef void* iterator; // todo
+        struct object
+        {
+            entity_id id;
+            neogfx::aabb aabb;
+        };
     private:
-        class node : public neolib::lifetime
+        class node
         {
         private:
-            typedef neolib::vecarray<i_collidable_object*, BucketSize, -1> object_list;
-            typedef std::array<std::array<std::array<aabb, 2>, 2>, 2> octants;
-            typedef std::array<std::array<std::array<aabb_2d, 2>, 2>, 2> octants_2d;
-            typedef std::array<std::array<std::array<node*, 2>, 2>, 2> children;
-        private:
-            struct no_parent : std::logic_error { no_parent() : std::logic_error{ "neogfx::aabb_octree::node::no_parent" } {} };
-            struct no_children : std::logic_error { no_children() : std::logic_error{ "neogfx::aabb_octree::node::no_children" } {} };
+            typedef neolib::vecarray<object, BucketSize, -1> object_list;
+            typedef std::array<neogfx::aabb, 8> octants;
+            typedef std::array<node*, 8> children;
         public:
-            node(aabb_octree& aTree, const aabb& aAabb) : iTree{ aTree }, iParent{ nullptr }, iDepth{ 1 }, iAabb{ aAabb }, iChildren {}
+            node(aabb_octree& aTree, const neogfx::aabb& aAabb, uint32_t aDepth = 1) : iTree{ aTree }, iDepth{ aDepth }, iAabb{ aAabb }, iChildren{}
             {
-                iTree.iDepth = std::max(iTree.iDepth, iDepth);
-                populate_octants();
-            }
-            node(const node& aParent, const aabb& aAabb) : iTree{ aParent.iTree }, iParent{ &aParent }, iDepth{ aParent.iDepth + 1 }, iAabb { aAabb }, iChildren{}
-            {
-                iTree.iDepth = std::max(iTree.iDepth, iDepth);
                 populate_octants();
             }
             ~node()
             {
-                set_destroying();
-                if (has_child<0, 0, 0>())
-                    remove_child<0, 0, 0>();
-                if (has_child<0, 1, 0>())
-                    remove_child<0, 1, 0>();
-                if (has_child<1, 0, 0>())
-                    remove_child<1, 0, 0>();
-                if (has_child<1, 1, 0>())
-                    remove_child<1, 1, 0>();
-                if (has_child<0, 0, 1>())
-                    remove_child<0, 0, 1>();
-                if (has_child<0, 1, 1>())
-                    remove_child<0, 1, 1>();
-                if (has_child<1, 0, 1>())
-                    remove_child<1, 0, 1>();
-                if (has_child<1, 1, 1>())
-                    remove_child<1, 1, 1>();
-                if (has_parent())
-                    parent().unsplit(this);
+                unsplit();
             }
         public:
-            bool has_parent() const
-            {
-                return iParent != nullptr;
-            }
-            const node& parent() const
-            {
-                if (has_parent())
-                    return *iParent;
-                throw no_parent();
-            }
-            node& parent()
-            {
-                return const_cast<node&>(to_const(*this).parent());
-            }
             uint32_t depth() const
             {
                 return iDepth;
@@ -106,337 +67,191 @@ namespace neogfx::game
             {
                 return iAabb;
             }
-            void add_object(i_collidable_object& aObject)
+            void add_object(const object& aObject)
             {
-                iTree.iDepth = std::max(iTree.iDepth, iDepth);
                 if (is_split())
                 {
-                    if (aabb_intersects(iOctants[0][0][0], aObject.aabb()))
-                        child<0, 0, 0>().add_object(aObject);
-                    if (aabb_intersects(iOctants[0][1][0], aObject.aabb()))
-                        child<0, 1, 0>().add_object(aObject);
-                    if (aabb_intersects(iOctants[1][0][0], aObject.aabb()))
-                        child<1, 0, 0>().add_object(aObject);
-                    if (aabb_intersects(iOctants[1][1][0], aObject.aabb()))
-                        child<1, 1, 0>().add_object(aObject);
-                    if (aabb_intersects(iOctants[0][0][1], aObject.aabb()))
-                        child<0, 0, 1>().add_object(aObject);
-                    if (aabb_intersects(iOctants[0][1][1], aObject.aabb()))
-                        child<0, 1, 1>().add_object(aObject);
-                    if (aabb_intersects(iOctants[1][0][1], aObject.aabb()))
-                        child<1, 0, 1>().add_object(aObject);
-                    if (aabb_intersects(iOctants[1][1][1], aObject.aabb()))
-                        child<1, 1, 1>().add_object(aObject);
+                    for (std::size_t o = 0; o < 8; ++o)
+                        if (aabb_intersects(iOctants[o], aObject.aabb))
+                            child(o).add_object(aObject);
+                    return;
                 }
-                else
+                auto existing = find(aObject.id);
+                if (existing != iObjects.end())
                 {
-                    auto existing = std::find(iObjects.begin(), iObjects.end(), &aObject);
-                    if (existing == iObjects.end())
-                        iObjects.push_back(&aObject);
-                    if (iObjects.size() > BucketSize && (iAabb.max - iAabb.min).min() > iTree.minimum_octant_size())
-                        split();
+                    existing->aabb = aObject.aabb;
+                    return;
                 }
+                iObjects.push_back(aObject);
+                if (iObjects.size() > BucketSize && (iAabb.max - iAabb.min).min() > iTree.minimum_octant_size())
+                    split();
             }
-            void remove_object(i_collidable_object& aObject)
-            {
-                remove_object(aObject, aabb_union(aObject.aabb(), aObject.saved_aabb()));
-            }
-            void remove_object(i_collidable_object& aObject, const neogfx::aabb& aAabb)
+            void remove_object(entity_id aId, const neogfx::aabb& aAabb)
             {
-                if (!aObject.collidable() || !aabb_intersects(aObject.aabb(), iAabb))
+                if (!is_split())
                 {
-                    auto existing = std::find(iObjects.begin(), iObjects.end(), &aObject);
+                    auto existing = find(aId);
                     if (existing != iObjects.end())
                         iObjects.erase(existing);
+                    return;
                 }
-                if (has_child<0, 0, 0>() && aabb_intersects(iOctants[0][0][0], aAabb))
-                    child<0, 0, 0>().remove_object(aObject, aAabb);
-                if (has_child<0, 0, 1>() && aabb_intersects(iOctants[0][0][1], aAabb))
-                    child<0, 0, 1>().remove_object(aObject, aAabb);
-                if (has_child<0, 1, 0>() && aabb_intersects(iOctants[0][1][0], aAabb))
-                    child<0, 1, 0>().remove_object(aObject, aAabb);
-                if (has_child<0, 1, 1>() && aabb_intersects(iOctants[0][1][1], aAabb))
-                    child<0, 1, 1>().remove_object(aObject, aAabb);
-                if (has_child<1, 0, 0>() && aabb_intersects(iOctants[1][0][0], aAabb))
-                    child<1, 0, 0>().remove_object(aObject, aAabb);
-                if (has_child<1, 0, 1>() && aabb_intersects(iOctants[1][0][1], aAabb))
-                    child<1, 0, 1>().remove_object(aObject, aAabb);
-                if (has_child<1, 1, 0>() && aabb_intersects(iOctants[1][1][0], aAabb))
-                    child<1, 1, 0>().remove_object(aObject, aAabb);
-                if (has_child<1, 1, 1>() && aabb_intersects(iOctants[1][1][1], aAabb))
-                    child<1, 1, 1>().remove_object(aObject, aAabb);
-                if (empty())
-                    iTree.destroy_node(*this);
+                for (std::size_t o = 0; o < 8; ++o)
+                    if (has_child(o) && aabb_intersects(iOctants[o], aAabb))
+                    {
+                        child(o).remove_object(aId, aAabb);
+                        if (child(o).empty())
+                            remove_child(o);
+                    }
+                if (!has_children())
+                    unsplit();
             }
-            void update_object(i_collidable_object& aObject)
+            void update_object(const object& aObject, const neogfx::aabb& aPrevious)
             {
-                iTree.iDepth = std::max(iTree.iDepth, iDepth);
-                const auto& currentAabb = aObject.aabb();
-                const auto& savedAabb = aObject.saved_aabb();
-                if (currentAabb == savedAabb)
+                if (!is_split())
+                {
+                    if (aabb_intersects(aObject.aabb, iAabb))
+                        add_object(aObject);
+                    else
+                        remove_object(aObject.id, aPrevious);
                     return;
-                if (aabb_intersects(currentAabb, iAabb))
-                    add_object(aObject);
-                if (aabb_intersects(savedAabb, iAabb))
-                    remove_object(aObject, savedAabb);
+                }
+                for (std::size_t o = 0; o < 8; ++o)
+                {
+                    bool const inCurrent = aabb_intersects(iOctants[o], aObject.aabb);
+                    bool const inPrevious = aabb_intersects(iOctants[o], aPrevious);
+                    if (inCurrent)
+                        child(o).update_object(aObject, aPrevious);
+                    else if (inPrevious && has_child(o))
+                    {
+                        child(o).remove_object(aObject.id, aPrevious);
+                        if (child(o).empty())
+                            remove_child(o);
+                    }
+                }
+                if (!has_children())
+                    unsplit();
             }
             bool empty() const
             {
-                bool result = iObjects.empty();
-                if (has_child<0, 0, 0>())
-                    result = child<0, 0, 0>().empty() && result;
-                if (has_child<0, 0, 1>())
-                    result = child<0, 0, 1>().empty() && result;
-                if (has_child<0, 1, 0>())
-                    result = child<0, 1, 0>().empty() && result;
-                if (has_child<0, 1, 1>())
-                    result = child<0, 1, 1>().empty() && result;
-                if (has_child<1, 0, 0>())
-                    result = child<1, 0, 0>().empty() && result;
-                if (has_child<1, 0, 1>())
-                    result = child<1, 0, 1>().empty() && result;
-                if (has_child<1, 1, 0>())
-                    result = child<1, 1, 0>().empty() && result;
-                if (has_child<1, 1, 1>())
-                    result = child<1, 1, 1>().empty() && result;
-                return result;
-            }
-            const object_list& objects() const
-            {
-                return iObjects;
-            }
-            template <typename Visitor>
-            void visit(const i_collidable_object& aCandidate, const Visitor& aVisitor) const
-            {
-                visit(aCandidate.aabb(), aVisitor, &aCandidate);
+                return iObjects.empty() && !has_children();
             }
-            template <typename Visitor>
-            void visit(const vec3& aPoint, const Visitor& aVisitor) const
-            {
-                visit(neogfx::aabb{ aPoint, aPoint }, aVisitor);
-            }
-            template <typename Visitor>
-            void visit(const vec2& aPoint, const Visitor& aVisitor) const
+            uint32_t max_depth() const
             {
-                visit(neogfx::aabb_2d{ aPoint, aPoint }, aVisitor);
+                uint32_t result = iDepth;
+                for (std::size_t o = 0; o < 8; ++o)
+                    if (has_child(o))
+                        result = std::max(result, (*iChildren)[o]->max_depth());
+                return result;
             }
             template <typename Visitor>
-            void visit(const neogfx::aabb& aAabb, const Visitor& aVisitor, const i_collidable_object* aCandidate = nullptr) const
+            void visit(const neogfx::aabb& aAabb, const Visitor& aVisitor) const
             {
-                if (aCandidate != nullptr && !aCandidate->collidable())
-                    return;
-                for (auto o = objects().begin(); (aCandidate == nullptr || aCandidate->collidable()) && o != objects().end(); ++o)
-                    if (aabb_intersects(aAabb, (**o).aabb()))
-                        aVisitor(*o);
-                if (has_child<0, 0, 0>() && aabb_intersects(iOctants[0][0][0], aAabb))
-                    child<0, 0, 0>().visit(aAabb, aVisitor);
-                if (has_child<0, 0, 1>() && aabb_intersects(iOctants[0][0][1], aAabb))
-                    child<0, 0, 1>().visit(aAabb, aVisitor);
-                if (has_child<0, 1, 0>() && aabb_intersects(iOctants[0][1][0], aAabb))
-                    child<0, 1, 0>().visit(aAabb, aVisitor);
-                if (has_child<0, 1, 1>() && aabb_intersects(iOctants[0][1][1], aAabb))
-                    child<0, 1, 1>().visit(aAabb, aVisitor);
-                if (has_child<1, 0, 0>() && aabb_intersects(iOctants[1][0][0], aAabb))
-                    child<1, 0, 0>().visit(aAabb, aVisitor);
-                if (has_child<1, 0, 1>() && aabb_intersects(iOctants[1][0][1], aAabb))
-                    child<1, 0, 1>().visit(aAabb, aVisitor);
-                if (has_child<1, 1, 0>() && aabb_intersects(iOctants[1][1][0], aAabb))
-                    child<1, 1, 0>().visit(aAabb, aVisitor);
-                if (has_child<1, 1, 1>() && aabb_intersects(iOctants[1][1][1], aAabb))
-                    child<1, 1, 1>().visit(aAabb, aVisitor);
+                for (auto const& o : iObjects)
+                    if (aabb_intersects(aAabb, o.aabb))
+                        aVisitor(o);
+                for (std::size_t o = 0; o < 8; ++o)
+                    if (has_child(o) && aabb_intersects(iOctants[o], aAabb))
+                        (*iChildren)[o]->visit(aAabb, aVisitor);
             }
             template <typename Visitor>
             void visit(const neogfx::aabb_2d& aAabb, const Visitor& aVisitor) const
             {
-                for (auto o : objects())
-                    if (aabb_intersects(aAabb, neogfx::aabb_2d{ o->aabb() }))
+                for (auto const& o : iObjects)
+                    if (aabb_intersects(aAabb, aabb_2d{ o.aabb }))
                         aVisitor(o);
-                if (has_child<0, 0, 0>() && aabb_intersects(iOctants2d[0][0][0], aAabb))
-                    child<0, 0, 0>().visit(aAabb, aVisitor);
-                if (has_child<0, 0, 1>() && aabb_intersects(iOctants2d[0][0][1], aAabb))
-                    child<0, 0, 1>().visit(aAabb, aVisitor);
-                if (has_child<0, 1, 0>() && aabb_intersects(iOctants2d[0][1][0], aAabb))
-                    child<0, 1, 0>().visit(aAabb, aVisitor);
-                if (has_child<0, 1, 1>() && aabb_intersects(iOctants2d[0][1][1], aAabb))
-                    child<0, 1, 1>().visit(aAabb, aVisitor);
-                if (has_child<1, 0, 0>() && aabb_intersects(iOctants2d[1][0][0], aAabb))
-                    child<1, 0, 0>().visit(aAabb, aVisitor);
-                if (has_child<1, 0, 1>() && aabb_intersects(iOctants2d[1][0][1], aAabb))
-                    child<1, 0, 1>().visit(aAabb, aVisitor);
-                if (has_child<1, 1, 0>() && aabb_intersects(iOctants2d[1][1][0], aAabb))
-                    child<1, 1, 0>().visit(aAabb, aVisitor);
-                if (has_child<1, 1, 1>() && aabb_intersects(iOctants2d[1][1][1], aAabb))
-                    child<1, 1, 1>().visit(aAabb, aVisitor);
-            }
-            template <typename Visitor>
-            void visit_objects(const Visitor& aVisitor) const
-            {
-                for (auto o : iObjects)
-                    aVisitor(o);
-                if (has_child<0, 0, 0>())
-                    child<0, 0, 0>().visit_objects(aVisitor);
-                if (has_child<0, 0, 1>())
-                    child<0, 0, 1>().visit_objects(aVisitor);
-                if (has_child<0, 1, 0>())
-                    child<0, 1, 0>().visit_objects(aVisitor);
-                if (has_child<0, 1, 1>())
-                    child<0, 1, 1>().visit_objects(aVisitor);
-                if (has_child<1, 0, 0>())
-                    child<1, 0, 0>().visit_objects(aVisitor);
-                if (has_child<1, 0, 1>())
-                    child<1, 0, 1>().visit_objects(aVisitor);
-                if (has_child<1, 1, 0>())
-                    child<1, 1, 0>().visit_objects(aVisitor);
-                if (has_child<1, 1, 1>())
-                    child<1, 1, 1>().visit_objects(aVisitor);
+                for (std::size_t o = 0; o < 8; ++o)
+                    if (has_child(o) && aabb_intersects(aabb_2d{ iOctants[o] }, aAabb))
+                        (*iChildren)[o]->visit(aAabb, aVisitor);
             }
             template <typename Visitor>
             void visit_aabbs(const Visitor& aVisitor) const
             {
                 aVisitor(aabb());
-                if (has_child<0, 0, 0>())
-                    child<0, 0, 0>().visit_aabbs(aVisitor);
-                if (has_child<0, 0, 1>())
-                    child<0, 0, 1>().visit_aabbs(aVisitor);
-                if (has_child<0, 1, 0>())
-                    child<0, 1, 0>().visit_aabbs(aVisitor);
-                if (has_child<0, 1, 1>())
-                    child<0, 1, 1>().visit_aabbs(aVisitor);
-                if (has_child<1, 0, 0>())
-                    child<1, 0, 0>().visit_aabbs(aVisitor);
-                if (has_child<1, 0, 1>())
-                    child<1, 0, 1>().visit_aabbs(aVisitor);
-                if (has_child<1, 1, 0>())
-                    child<1, 1, 0>().visit_aabbs(aVisitor);
-                if (has_child<1, 1, 1>())
-                    child<1, 1, 1>().visit_aabbs(aVisitor);
+                for (std::size_t o = 0; o < 8; ++o)
+                    if (has_child(o))
+                        (*iChildren)[o]->visit_aabbs(aVisitor);
             }
         private:
+            typename object_list::iterator find(entity_id aId)
+            {
+                return std::find_if(iObjects.begin(), iObjects.end(), [aId](const object& aObject) { return aObject.id == aId; });
+            }
             void populate_octants()
             {
                 const auto& min = iAabb.min;
                 const auto& max = iAabb.max;
                 const auto& centre = (min + max) / 2.0;
-                iOctants[0][0][0] = neogfx::aabb{ min, centre };
-                iOctants[0][1][0] = neogfx::aabb{ vec3{ min.x, centre.y, min.z }, vec3{ centre.x, max.y, centre.z } };
-                iOctants[1][0][0] = neogfx::aabb{ vec3{ centre.x, min.y, min.z }, vec3{ max.x, centre.y, centre.z } };
-                iOctants[1][1][0] = neogfx::aabb{ vec3{ centre.x, centre.y, min.z }, vec3{ max.x, max.y, centre.z } };
-                iOctants[0][0][1] = neogfx::aabb{ vec3{ min.x, min.y, centre.z }, vec3{ centre.x, centre.y, max.z } };
-                iOctants[0][1][1] = neogfx::aabb{ vec3{ min.x, centre.y, centre.z }, vec3{ centre.x, max.y, max.z } };
-                iOctants[1][0][1] = neogfx::aabb{ vec3{ centre.x, min.y, centre.z }, vec3{ max.x, centre.y, max.z } };
-                iOctants[1][1][1] = neogfx::aabb{ vec3{ centre.x, centre.y, centre.z }, vec3{ max.x, max.y, max.z } };
-                iOctants2d[0][0][0] = aabb_2d{ ~min.xy, ~centre.xy };
-                iOctants2d[0][1][0] = aabb_2d{ vec2{ min.x, centre.y }, vec2{ centre.x, max.y } };
-                iOctants2d[1][0][0] = aabb_2d{ vec2{ centre.x, min.y }, vec2{ max.x, centre.y } };
-                iOctants2d[1][1][0] = aabb_2d{ ~centre.xy, ~max.xy };
-                iOctants2d[0][0][1] = aabb_2d{ ~min.xy, ~centre.xy};
-                iOctants2d[0][1][1] = aabb_2d{ vec2{ min.x, centre.y }, vec2{ centre.x, max.y } };
-                iOctants2d[1][0][1] = aabb_2d{ vec2{ centre.x, min.y }, vec2{ max.x, centre.y } };
-                iOctants2d[1][1][1] = aabb_2d{ ~centre.xy, ~max.xy };
+                for (std::size_t o = 0; o < 8; ++o)
+                    iOctants[o] = neogfx::aabb{
+                        vec3{ (o & 1) ? centre.x : min.x, (o & 2) ? centre.y : min.y, (o & 4) ? centre.z : min.z },
+                        vec3{ (o & 1) ? max.x : centre.x, (o & 2) ? max.y : centre.y, (o & 4) ? max.z : centre.z } };
             }
-            template <std::size_t X, std::size_t Y, std::size_t Z>
-            node& child() const
+            node& child(std::size_t aOctant)
             {
-                if (iChildren == std::nullopt)
+                if (!is_split())
                     iChildren.emplace();
-                if ((*iChildren)[X][Y][Z] == nullptr)
-                    (*iChildren)[X][Y][Z] = iTree.create_node(*this, iOctants[X][Y][Z]);
-                return *(*iChildren)[X][Y][Z];
+                auto& c = (*iChildren)[aOctant];
+                if (c == nullptr)
+                    c = iTree.create_node(iOctants[aOctant], iDepth + 1);
+                return *c;
             }
-            template <std::size_t X, std::size_t Y, std::size_t Z>
-            bool has_child() const
+            bool has_child(std::size_t aOctant) const
             {
-                if (iChildren == std::nullopt)
-                    return false;
-                return (*iChildren)[X][Y][Z] != nullptr;
+                return is_split() && (*iChildren)[aOctant] != nullptr;
             }
-            template <std::size_t X, std::size_t Y, std::size_t Z>
-            bool remove_child(node* aDestroyedNode = nullptr) const
+            bool has_children() const
             {
-                if (iChildren == std::nullopt)
-                    return true;
-                if ((*iChildren)[X][Y][Z] == nullptr)
-                    return true;
-                if ((*iChildren)[X][Y][Z] == aDestroyedNode || aDestroyedNode == nullptr)
-                {
-                    auto n = (*iChildren)[X][Y][Z];
-                    (*iChildren)[X][Y][Z] = nullptr;
-                    iTree.destroy_node(*n);
-                    return true;
-                }
+                if (!is_split())
+                    return false;
+                for (auto c : *iChildren)
+                    if (c != nullptr)
+                        return true;
                 return false;
             }
+            void remove_child(std::size_t aOctant)
+            {
+                auto& c = (*iChildren)[aOctant];
+                iTree.destroy_node(*c);
+                c = nullptr;
+            }
             bool is_split() const
             {
                 return iChildren != std::nullopt;
             }
             void split()
             {
-                for (auto o : objects())
-                {
-                    if (aabb_intersects(iOctants[0][0][0], o->aabb()))
-                        child<0, 0, 0>().add_object(*o);
-                    if (aabb_intersects(iOctants[0][0][1], o->aabb()))
-                        child<0, 0, 1>().add_object(*o);
-                    if (aabb_intersects(iOctants[0][1][0], o->aabb()))
-                        child<0, 1, 0>().add_object(*o);
-                    if (aabb_intersects(iOctants[0][1][1], o->aabb()))
-                        child<0, 1, 1>().add_object(*o);
-                    if (aabb_intersects(iOctants[1][0][0], o->aabb()))
-                        child<1, 0, 0>().add_object(*o);
-                    if (aabb_intersects(iOctants[1][0][1], o->aabb()))
-                        child<1, 0, 1>().add_object(*o);
-                    if (aabb_intersects(iOctants[1][1][0], o->aabb()))
-                        child<1, 1, 0>().add_object(*o);
-                    if (aabb_intersects(iOctants[1][1][1], o->aabb()))
-                        child<1, 1, 1>().add_object(*o);
-                }
+                iChildren.emplace();
+                for (auto const& object : iObjects)
+                    for (std::size_t o = 0; o < 8; ++o)
+                        if (aabb_intersects(iOctants[o], object.aabb))
+                            child(o).add_object(object);
                 iObjects.clear();
             }
-            void unsplit(node* aDestroyedNode)
+            void unsplit()
             {
-                bool haveChildren = false;
-                if (!remove_child<0, 0, 0>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<0, 1, 0>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<1, 0, 0>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<1, 1, 0>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<0, 0, 1>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<0, 1, 1>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<1, 0, 1>(aDestroyedNode))
-                    haveChildren = true;
-                if (!remove_child<1, 1, 1>(aDestroyedNode))
-                    haveChildren = true;
-                if (!haveChildren)
-                    iChildren = std::nullopt;
-                if (empty())
-                    iTree.destroy_node(*this);
+                if (!is_split())
+                    return;
+                for (std::size_t o = 0; o < 8; ++o)
+                    if (has_child(o))
+                        remove_child(o);
+                iChildren = std::nullopt;
             }
         private:
             aabb_octree& iTree;
-            const node* iParent;
             uint32_t iDepth;
             neogfx::aabb iAabb;
             octants iOctants;
-            octants_2d iOctants2d;
             object_list iObjects;
-            mutable std::optional<children> iChildren;
+            std::optional<children> iChildren;
         };
         typedef typename allocator_type::template rebind<node>::other node_allocator;
     public:
         aabb_octree(const aabb& aRootAabb = aabb{ vec3{-4096.0, -4096.0, -4096.0}, vec3{4096.0, 4096.0, 4096.0} }, dimension aMinimumOctantSize = 16.0, const allocator_type& aAllocator = allocator_type{}) :
             iAllocator{ aAllocator },
             iRootAabb{ aRootAabb },
-            iCount{ 0 },
-            iDepth{ 0 },
-            iRootNode{ *this, aRootAabb },
             iMinimumOctantSize{ aMinimumOctantSize },
-            iCollisionUpdateId{ 0 }
+            iCount{ 0 },
+            iRootNode{ *this, aRootAabb }
         {
         }
     public:
@@ -444,75 +259,35 @@ namespace neogfx::game
         {
             return iMinimumOctantSize;
         }
-        template <typename IterObject>
-        IterObject full_update(IterObject aStart, IterObject aEnd)
-        {
-            iDepth = 0;
-            iRootNode.~node();
-            new(&iRootNode) node{ *this, iRootAabb };
-            IterObject o;
-            for (o = aStart; o != aEnd && (**o).category() != object_category::Shape; ++o)
-            {
-                iRootNode.add_object((**o).as_collidable_object());
-                (**o).as_collidable_object().save_aabb();
-            }
-            return o;
-        }
-        template <typename IterObject>
-        IterObject dynamic_update(IterObject aStart, IterObject aEnd)
-        {
-            iDepth = 0;
-            IterObject o;
-            for (o = aStart; o != aEnd && (**o).category() != object_category::Shape; ++o)
-            {
-                iRootNode.update_object((**o).as_collidable_object());
-                (**o).as_collidable_object().save_aabb();
-            }
-            return o;
-        }
-        template <typename IterObject, typename CollisionAction>
-        IterObject collisions(IterObject aStart, IterObject aEnd, CollisionAction aCollisionAction) const
+        template <typename Visitor>
+        void visit(const aabb& aAabb, const Visitor& aVisitor) const
         {
-            IterObject o;
-            for (o = aStart; o != aEnd && (**o).category() != object_category::Shape; ++o)
-            {
-                auto& candidate = (**o).as_collidable_object();
-                if (!candidate.collidable())
-                    continue;
-                if (++iCollisionUpdateId == 0)
-                    iCollisionUpdateId = 1;
-                iRootNode.visit(candidate, [this, &candidate, &aCollisionAction](i_collidable_object* aHit)
-                {
-                    if (std::less<i_collidable_object*>{}(&candidate, aHit) && aHit->collidable())
-                    {
-                        if (aHit->collision_update_id() != iCollisionUpdateId)
-                        {
-                            aHit->set_collision_update_id(iCollisionUpdateId);
-                            if (candidate.has_collided(*aHit))
-                                aCollisionAction(candidate, *aHit);
-                        }
-                    }
-                });
-            }
-            return o;
+            for (auto const& o : iOutsideObjects)
+                if (aabb_intersects(aAabb, o.aabb))
+                    aVisitor(o);
+            iRootNode.visit(aAabb, aVisitor);
         }
         template <typename ResultContainer>
-        void pick(const vec3& aPoint, ResultContainer& aResult, std::function<bool(reference, const vec3& aPoint)> aColliderPredicate = [](reference, const vec3&) { return true; }) const
+        void pick(const vec3& aPoint, ResultContainer& aResult) const
         {
-            iRootNode.visit(aPoint, [&](i_collidable_object* aMatch)
-            { 
-                if (aColliderPredicate(*aMatch, aPoint))
-                    aResult.insert(aResult.end(), aMatch); 
+            visit(aabb{ aPoint, aPoint }, [&](const object& aMatch)
+            {
+                if (std::find(aResult.begin(), aResult.end(), aMatch.id) == aResult.end())
+                    aResult.insert(aResult.end(), aMatch.id);
             });
         }
         template <typename ResultContainer>
-        void pick(const vec2& aPoint, ResultContainer& aResult, std::function<bool(reference, const vec2& aPoint)> aColliderPredicate = [](reference, const vec2&) { return true; }) const
+        void pick(const vec2& aPoint, ResultContainer& aResult) const
         {
-            iRootNode.visit(aPoint, [&](i_collidable_object* aMatch)
-            {
-                if (aColliderPredicate(*aMatch, aPoint))
-                    aResult.insert(aResult.end(), aMatch);
-                return true;
+            aabb_2d const point{ aPoint, aPoint };
+            for (auto const& o : iOutsideObjects)
+                if (aabb_intersects(point, aabb_2d{ o.aabb }))
+                    if (std::find(aResult.begin(), aResult.end(), o.id) == aResult.end())
+                        aResult.insert(aResult.end(), o.id);
+            iRootNode.visit(point, [&](const object& aMatch)
+            {
+                if (std::find(aResult.begin(), aResult.end(), aMatch.id) == aResult.end())
+                    aResult.insert(aResult.end(), aMatch.id);
             });
         }
         template <typename Visitor>
@@ -521,13 +296,39 @@ namespace neogfx::game
             iRootNode.visit_aabbs(aVisitor);
         }
     public:
-        void insert(reference aItem)
+        void insert(entity_id aId, const aabb& aAabb)
+        {
+            if (within_root(aAabb))
+                iRootNode.add_object(object{ aId, aAabb });
+            else
+                add_outside_object(object{ aId, aAabb });
+        }
+        void remove(entity_id aId, const aabb& aAabb)
         {
-            iRootNode.add_object(aItem);
+            if (within_root(aAabb))
+                iRootNode.remove_object(aId, aAabb);
+            else
+                remove_outside_object(aId);
+        }
+        void update(entity_id aId, const aabb& aPrevious, const aabb& aCurrent)
+        {
+            if (aPrevious == aCurrent)
+                return;
+            bool const previousWithin = within_root(aPrevious);
+            bool const currentWithin = within_root(aCurrent);
+            if (previousWithin && currentWithin)
+                iRootNode.update_object(object{ aId, aCurrent }, aPrevious);
+            else
+            {
+                remove(aId, aPrevious);
+                insert(aId, aCurrent);
+            }
         }
-        void remove(reference aItem)
+        void clear()
         {
-            iRootNode.remove_object(aItem);
+            iOutsideObjects.clear();
+            iRootNode.~node();
+            new(&iRootNode) node{ *this, iRootAabb };
         }
     public:
         uint32_t count() const
@@ -536,37 +337,56 @@ namespace neogfx::game
         }
         uint32_t depth() const
         {
-            return iDepth;
+            return iRootNode.max_depth();
         }
-    public:
-        const node& root_node() const
+    private:
+        bool within_root(const aabb& aAabb) const
         {
-            return iRootNode;
+            // component-wise (vector comparison operators are lexicographic)
+            return aAabb.min.max(iRootAabb.min) == aAabb.min && aAabb.max.min(iRootAabb.max) == aAabb.max;
         }
-    private:
-        node* create_node(const node& aParent, const aabb& aAabb)
+        void add_outside_object(const object& aObject)
+        {
+            auto existing = std::find_if(iOutsideObjects.begin(), iOutsideObjects.end(), [&](const object& aOutside) { return aOutside.id == aObject.id; });
+            if (existing != iOutsideObjects.end())
+                existing->aabb = aObject.aabb;
+            else
+                iOutsideObjects.push_back(aObject);
+        }
+        void remove_outside_object(entity_id aId)
+        {
+            auto existing = std::find_if(iOutsideObjects.begin(), iOutsideObjects.end(), [aId](const object& aOutside) { return aOutside.id == aId; });
+            if (existing != iOutsideObjects.end())
+                iOutsideObjects.erase(existing);
+        }
+        node* create_node(const aabb& aAabb, uint32_t aDepth)
         {
             ++iCount;
             node* newNode = iAllocator.allocate(1);
-            iAllocator.construct(newNode, aParent, aAabb);
+            try
+            {
+                new (newNode) node{ *this, aAabb, aDepth };
+            }
+            catch (...)
+            {
+                iAllocator.deallocate(newNode, 1);
+                --iCount;
+                throw;
+            }
             return newNode;
         }
         void destroy_node(node& aNode)
         {
-            if (&aNode != &iRootNode && aNode.is_alive())
-            {
-                --iCount;
-                iAllocator.destroy(&aNode);
-                iAllocator.deallocate(&aNode, 1);
-            }
+            --iCount;
+            aNode.~node();
+            iAllocator.deallocate(&aNode, 1);
         }
     private:
         node_allocator iAllocator;
         aabb iRootAabb;
         dimension iMinimumOctantSize;
         uint32_t iCount;
-        mutable uint32_t iDepth;
         node iRootNode;
-        mutable uint32_t iCollisionUpdateId;
+        std::vector<object> iOutsideObjects;
     };
-}
\ No newline at end of file
+}
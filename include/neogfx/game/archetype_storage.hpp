@@ -0,0 +1,250 @@
+// archetype_storage.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <array>
+#include <optional>
+#include <functional>
+#include <neogfx/game/ecs_ids.hpp>
+#include <neogfx/game/i_component_data.hpp>
+
+namespace neogfx::game
+{
+    // Type erased description of a component data type used to lay out a column of an archetype chunk.
+    struct component_column
+    {
+        component_id id;
+        std::size_t size;
+        std::size_t alignment;
+        void(*move_construct)(void* aDestination, void* aSource);
+        void(*destroy)(void* aData);
+    };
+
+    template <typename Data>
+    inline const component_column& component_column_of()
+    {
+        typedef ecs_data_type_t<Data> data_type;
+        static const component_column sColumn
+        {
+            data_type::meta::id(),
+            sizeof(data_type),
+            alignof(data_type),
+            [](void* aDestination, void* aSource) { new (aDestination) data_type{ std::move(*static_cast<data_type*>(aSource)) }; },
+            [](void* aData) { static_cast<data_type*>(aData)->~data_type(); }
+        };
+        return sColumn;
+    }
+
+    // All entities that have exactly the same set of components. Component data is held in fixed size chunks, each
+    // chunk holding a parallel array (column) per component plus the entity ids, so iterating several components
+    // of the archetype is a linear scan. Rows are kept dense: removing a row moves the last row into its place.
+    class archetype_table
+    {
+    public:
+        struct column_not_found : std::logic_error { column_not_found() : std::logic_error("neogfx::game::archetype_table::column_not_found") {} };
+    public:
+        static constexpr std::size_t ChunkSize = 16u * 1024u;
+    public:
+        typedef std::vector<const component_column*> signature_t; // sorted by component id
+        typedef std::size_t row_t;
+    private:
+        struct alignas(64) block { std::byte bytes[64]; };
+        typedef std::unique_ptr<block[]> chunk;
+    public:
+        archetype_table(const signature_t& aSignature);
+        ~archetype_table();
+    public:
+        const signature_t& signature() const;
+        bool has_column(const component_id& aComponentId) const;
+        std::size_t column_index(const component_id& aComponentId) const;
+        bool contains(const std::vector<component_id>& aComponentIds) const;
+        std::size_t chunk_capacity() const;
+        std::size_t chunk_count() const;
+        std::size_t size() const;
+        std::size_t chunk_size(std::size_t aChunk) const;
+    public:
+        const entity_id* entities(std::size_t aChunk) const;
+        entity_id entity(row_t aRow) const;
+        void* column(std::size_t aChunk, std::size_t aColumn) const;
+        void* element(row_t aRow, std::size_t aColumn) const;
+        template <typename Data>
+        ecs_data_type_t<Data>* column(std::size_t aChunk) const
+        {
+            return static_cast<ecs_data_type_t<Data>*>(column(aChunk, column_index(ecs_data_type_t<Data>::meta::id())));
+        }
+    public:
+        void reserve(std::size_t aRows);
+        row_t append(entity_id aEntity);
+        entity_id remove(row_t aRow, bool aDestroyData = true);
+    public:
+        archetype_table* add_edge(const component_id& aComponentId) const;
+        void set_add_edge(const component_id& aComponentId, archetype_table& aTable);
+        archetype_table* remove_edge(const component_id& aComponentId) const;
+        void set_remove_edge(const component_id& aComponentId, archetype_table& aTable);
+    private:
+        signature_t iSignature;
+        std::size_t iChunkCapacity;
+        std::size_t iChunkBlocks;
+        std::vector<std::size_t> iColumnOffsets;
+        std::vector<chunk> iChunks;
+        std::size_t iSize;
+        std::map<component_id, archetype_table*> iAddEdges;
+        std::map<component_id, archetype_table*> iRemoveEdges;
+    };
+
+    // Archetype based alternative to static_component storage; an entity's components all live in the one
+    // archetype_table matching its component set. Adding or removing a component moves the entity to another table.
+    class archetype_storage
+    {
+    public:
+        struct entity_record_not_found : std::logic_error { entity_record_not_found() : std::logic_error("neogfx::game::archetype_storage::entity_record_not_found") {} };
+    public:
+        struct location
+        {
+            archetype_table* table;
+            archetype_table::row_t row;
+        };
+        typedef std::vector<location> locations_t;
+        typedef std::map<std::vector<component_id>, std::unique_ptr<archetype_table>> tables_t;
+    public:
+        archetype_storage();
+        ~archetype_storage();
+    public:
+        std::recursive_mutex& mutex() const;
+        const tables_t& tables() const;
+        bool has_entity(entity_id aEntity) const;
+        const location& entity_location(entity_id aEntity) const;
+        void destroy_entity(entity_id aEntity);
+        void clear();
+    public:
+        template <typename Data>
+        bool has_entity_record(entity_id aEntity) const
+        {
+            return has_entity(aEntity) && entity_location(aEntity).table->has_column(ecs_data_type_t<Data>::meta::id());
+        }
+        template <typename Data>
+        const ecs_data_type_t<Data>& entity_record(entity_id aEntity) const
+        {
+            if (!has_entity_record<Data>(aEntity))
+                throw entity_record_not_found();
+            auto const& l = entity_location(aEntity);
+            return *static_cast<const ecs_data_type_t<Data>*>(l.table->element(l.row, l.table->column_index(ecs_data_type_t<Data>::meta::id())));
+        }
+        template <typename Data>
+        ecs_data_type_t<Data>& entity_record(entity_id aEntity)
+        {
+            return const_cast<ecs_data_type_t<Data>&>(to_const(*this).entity_record<Data>(aEntity));
+        }
+        template <typename Data>
+        ecs_data_type_t<Data>& populate(entity_id aEntity, Data&& aData)
+        {
+            typedef ecs_data_type_t<Data> data_type;
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+            if (has_entity_record<data_type>(aEntity))
+                return entity_record<data_type>(aEntity) = std::forward<Data>(aData);
+            auto const& column = component_column_of<data_type>();
+            auto& l = move_entity(aEntity, add_table(aEntity, column));
+            return *new (l.table->element(l.row, l.table->column_index(column.id))) data_type{ std::forward<Data>(aData) };
+        }
+        // Gives every entity in aEntities the component; entities are moved between tables a table at a time.
+        template <typename Data>
+        void populate(const std::vector<entity_id>& aEntities, const Data& aData)
+        {
+            typedef ecs_data_type_t<Data> data_type;
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+            auto const& column = component_column_of<data_type>();
+            std::vector<entity_id> toMove;
+            for (auto e : aEntities)
+                if (has_entity_record<data_type>(e))
+                    entity_record<data_type>(e) = aData;
+                else
+                    toMove.push_back(e);
+            move_entities(toMove,
+                [&](entity_id aEntity) -> archetype_table& { return add_table(aEntity, column); },
+                [&](archetype_table& aTable, archetype_table::row_t aRow) { new (aTable.element(aRow, aTable.column_index(column.id))) data_type{ aData }; });
+        }
+        template <typename Data>
+        void destroy_entity_record(entity_id aEntity)
+        {
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+            if (!has_entity_record<Data>(aEntity))
+                throw entity_record_not_found();
+            auto const& column = component_column_of<Data>();
+            auto& l = iLocations[aEntity];
+            auto& from = *l.table;
+            from.signature()[from.column_index(column.id)]->destroy(from.element(l.row, from.column_index(column.id)));
+            if (from.signature().size() == 1u)
+            {
+                relocate_last(from, from.remove(l.row, false), l.row);
+                l = location{};
+                return;
+            }
+            move_entity(aEntity, remove_table(from, column), column.id);
+        }
+    public:
+        // Calls aVisitor(entity_id, Data&...) for every entity that has all of the components.
+        template <typename... Data, typename Visitor>
+        void for_each(Visitor aVisitor)
+        {
+            for_each_chunk<Data...>([&](std::size_t aCount, const entity_id* aEntities, ecs_data_type_t<Data>*... aColumns)
+            {
+                for (std::size_t i = 0; i < aCount; ++i)
+                    aVisitor(aEntities[i], aColumns[i]...);
+            });
+        }
+        // Calls aVisitor(std::size_t aCount, const entity_id*, Data*...) once per chunk holding all of the components.
+        template <typename... Data, typename Visitor>
+        void for_each_chunk(Visitor aVisitor)
+        {
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+            std::vector<component_id> const query{ ecs_data_type_t<Data>::meta::id()... };
+            for (auto const& t : iTables)
+            {
+                auto& table = *t.second;
+                if (table.size() == 0u || !table.contains(query))
+                    continue;
+                std::array<std::size_t, sizeof...(Data)> const columns{ table.column_index(ecs_data_type_t<Data>::meta::id())... };
+                for (std::size_t chunk = 0; chunk < table.chunk_count(); ++chunk)
+                    visit_chunk<Data...>(table, chunk, columns, aVisitor, std::index_sequence_for<Data...>{});
+            }
+        }
+    private:
+        template <typename... Data, typename Visitor, std::size_t... Index>
+        static void visit_chunk(archetype_table& aTable, std::size_t aChunk, const std::array<std::size_t, sizeof...(Data)>& aColumns, Visitor& aVisitor, std::index_sequence<Index...>)
+        {
+            aVisitor(aTable.chunk_size(aChunk), aTable.entities(aChunk), static_cast<ecs_data_type_t<Data>*>(aTable.column(aChunk, aColumns[Index]))...);
+        }
+        archetype_table& table(const archetype_table::signature_t& aSignature);
+        archetype_table& add_table(entity_id aEntity, const component_column& aColumn);
+        archetype_table& remove_table(archetype_table& aFrom, const component_column& aColumn);
+        location& move_entity(entity_id aEntity, archetype_table& aTo, const std::optional<component_id>& aDestroyed = {});
+        void move_entities(const std::vector<entity_id>& aEntities, const std::function<archetype_table&(entity_id)>& aTarget,
+            const std::function<void(archetype_table&, archetype_table::row_t)>& aConstruct);
+        void relocate_last(archetype_table& aTable, entity_id aMoved, archetype_table::row_t aRow);
+    private:
+        mutable std::recursive_mutex iMutex;
+        tables_t iTables;
+        locations_t iLocations;
+    };
+}
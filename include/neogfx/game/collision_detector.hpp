@@ -0,0 +1,110 @@
+// collision_detector.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <chrono>
+#include <mutex>
+#include <deque>
+#include <neolib/timer.hpp>
+#include <neogfx/core/event.hpp>
+#include <neogfx/game/system.hpp>
+#include <neogfx/game/aabb_octree.hpp>
+
+namespace neogfx::game
+{
+    // Broadphase collision detection for entities with a broadphase_collider and a mesh_filter. Entities with a
+    // rigid_body are in the dynamic layer and their AABBs are refreshed every application; entities without one
+    // are in the static layer and their AABBs are computed once. Dynamic entities are tested against both layers,
+    // static entities are never tested against each other. Two colliders only collide if their masks have no bits
+    // in common. Collision is triggered, once per overlapping pair, on the thread that owns the ECS (the thread
+    // running its async task) so handlers can create and destroy entities; a pair is dropped if either of its
+    // entities is destroyed before it is delivered.
+    class collision_detector : public system
+    {
+    public:
+        define_event(Collision, collision, entity_id, entity_id)
+    public:
+        struct statistics
+        {
+            uint32_t dynamicColliders;
+            uint32_t staticColliders;
+            uint32_t treeNodes;
+            uint32_t treeDepth;
+            uint64_t candidatePairs;
+            uint64_t collisionPairs;
+            std::chrono::nanoseconds treeUpdateTime;
+            std::chrono::nanoseconds pairTestTime;
+        };
+    public:
+        typedef aabb_octree<> tree_type;
+    private:
+        struct tracked
+        {
+            bool inTree;
+            bool isStatic;
+            uint64_t mask;
+            aabb bounds;
+            uint32_t query;
+        };
+    public:
+        collision_detector(game::i_ecs& aEcs);
+        ~collision_detector();
+    public:
+        const system_id& id() const override;
+        const i_string& name() const override;
+    public:
+        void apply() override;
+    public:
+        statistics last_statistics() const;
+    public:
+        struct meta
+        {
+            static const neolib::uuid& id()
+            {
+                static const neolib::uuid sId = { 0x2fe5b7d, 0x8819, 0x4841, 0x9563, { 0xc1, 0xb2, 0xf0, 0xd9, 0x24, 0x30 } };
+                return sId;
+            }
+            static const i_string& name()
+            {
+                static const string sName = "Collision Detector";
+                return sName;
+            }
+        };
+    private:
+        tree_type& tree(bool aStatic);
+        tracked& tracking(entity_id aEntity);
+        void remove_destroyed();
+        void untrack(entity_id aEntity);
+        void notify_collisions();
+    private:
+        mutable std::mutex iMutex;
+        tree_type iDynamicTree;
+        tree_type iStaticTree;
+        std::vector<tracked> iTracked;
+        std::vector<entity_id> iDestroyed;
+        std::vector<entity_id> iDynamic;
+        std::vector<std::pair<entity_id, entity_id>> iCollisions;
+        std::deque<std::pair<entity_id, entity_id>> iPendingCollisions;
+        uint32_t iQuery;
+        statistics iStatistics;
+        sink iSink;
+        neolib::callback_timer iNotifier;
+    };
+}
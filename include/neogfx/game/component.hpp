@@ -20,8 +20,12 @@
 
 #include <neogfx/neogfx.hpp>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
 #include <unordered_map>
 #include <string>
+#include <iterator>
 #include <neolib/intrusive_sort.hpp>
 #include <neogfx/game/ecs_ids.hpp>
 #include <neogfx/game/i_component.hpp>
@@ -128,7 +132,7 @@ namespace neogfx::game
             return data_meta_type::id();
         }
     public:
-        std::recursive_mutex& mutex() const
+        std::recursive_mutex& mutex() const override
         {
             return iMutex;
         }
@@ -197,43 +201,166 @@ namespace neogfx::game
         typedef typename component_data_t::size_type reverse_index_t;
         typedef std::vector<reverse_index_t> reverse_indices_t;
         typedef std::vector<reverse_index_t> free_indices_t;
+    private:
+        static constexpr reverse_index_t invalid = ~reverse_index_t{};
     public:
-        typedef std::unique_ptr<self_type> snapshot_ptr;
-        class scoped_snapshot
+        // The records of a static_component as they were when its writer last published them.
+        class records_snapshot
         {
+            friend class static_component<Data>;
         public:
-            scoped_snapshot(self_type& aOwner) :
-                iOwner{ aOwner }
+            bool has_entity_record(entity_id aEntity) const
             {
-                std::scoped_lock<std::recursive_mutex> lock{ iOwner.mutex() };
-                ++iOwner.iUsingSnapshot;
+                return reverse_index(aEntity) != invalid;
             }
-            scoped_snapshot(const scoped_snapshot& aOther) :
-                iOwner{ aOther.iOwner }
+            const data_type& entity_record(entity_id aEntity) const
             {
-                std::scoped_lock<std::recursive_mutex> lock{ iOwner.mutex() };
-                ++iOwner.iUsingSnapshot;
+                auto reverseIndex = reverse_index(aEntity);
+                if (reverseIndex == invalid)
+                    throw entity_record_not_found();
+                return iComponentData[reverseIndex];
             }
-            ~scoped_snapshot()
+            const component_data_t& component_data() const
             {
-                std::scoped_lock<std::recursive_mutex> lock{ iOwner.mutex() };
-                --iOwner.iUsingSnapshot;
+                return iComponentData;
             }
-        public:
-            self_type& data() const
+            const component_data_entities_t& entities() const
+            {
+                return iEntities;
+            }
+        private:
+            reverse_index_t reverse_index(entity_id aEntity) const
             {
-                return *iOwner.iSnapshot;
+                if (iReverseIndices.size() > aEntity)
+                    return iReverseIndices[aEntity];
+                return invalid;
             }
         private:
-            self_type& iOwner;
+            component_data_t iComponentData;
+            component_data_entities_t iEntities;
+            reverse_indices_t iReverseIndices;
         };
+        // A published snapshot is immutable; holding the pointer keeps it alive and stops its buffer being reused.
+        typedef std::shared_ptr<const records_snapshot> snapshot_ptr;
     private:
-        static constexpr reverse_index_t invalid = ~reverse_index_t{};
+        // A buffer may only be reused once its reader count has returned to zero; the count is released by the last
+        // reader and acquired by the writer so the reader's accesses happen before the buffer is overwritten. A
+        // buffer is brought up to date by copying only the slots changed since it was last published.
+        struct snapshot_buffer
+        {
+            records_snapshot records;
+            std::atomic<uint32_t> readers;
+            bool fullCopyRequired;
+            std::vector<reverse_index_t> changedSlots;
+
+            snapshot_buffer() :
+                readers{ 0u }, fullCopyRequired{ true }
+            {
+            }
+        };
+    public:
+        // Iterates the records of live entities only, skipping the slots of destroyed entities that have not yet
+        // been compacted away.
+        template <bool Const>
+        class basic_live_iterator
+        {
+            friend class static_component<Data>;
+            typedef std::conditional_t<Const, const self_type, self_type> owner_type;
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef typename self_type::value_type value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef std::conditional_t<Const, const value_type*, value_type*> pointer;
+            typedef std::conditional_t<Const, const value_type&, value_type&> reference;
+        public:
+            basic_live_iterator() :
+                iOwner{ nullptr }, iIndex{ 0u }
+            {
+            }
+        private:
+            basic_live_iterator(owner_type& aOwner, reverse_index_t aIndex) :
+                iOwner{ &aOwner }, iIndex{ aIndex }
+            {
+                skip();
+            }
+        public:
+            reference operator*() const
+            {
+                if constexpr (Const)
+                    return iOwner->component_data()[iIndex];
+                else
+                    return iOwner->modified_record(iIndex);
+            }
+            pointer operator->() const
+            {
+                return &**this;
+            }
+            entity_id entity() const
+            {
+                return iOwner->entities()[iIndex];
+            }
+            basic_live_iterator& operator++()
+            {
+                ++iIndex;
+                skip();
+                return *this;
+            }
+            basic_live_iterator operator++(int)
+            {
+                auto result = *this;
+                ++*this;
+                return result;
+            }
+            bool operator==(const basic_live_iterator& aOther) const
+            {
+                return iIndex == aOther.iIndex;
+            }
+            bool operator!=(const basic_live_iterator& aOther) const
+            {
+                return !(*this == aOther);
+            }
+        private:
+            void skip()
+            {
+                auto const& entities = iOwner->entities();
+                while (iIndex < entities.size() && entities[iIndex] == null_entity)
+                    ++iIndex;
+            }
+        private:
+            owner_type* iOwner;
+            reverse_index_t iIndex;
+        };
+        typedef basic_live_iterator<true> const_live_iterator;
+        typedef basic_live_iterator<false> live_iterator;
+        template <bool Const>
+        class basic_live_range
+        {
+            typedef std::conditional_t<Const, const self_type, self_type> owner_type;
+        public:
+            basic_live_range(owner_type& aOwner) :
+                iOwner{ aOwner }
+            {
+            }
+        public:
+            basic_live_iterator<Const> begin() const
+            {
+                return basic_live_iterator<Const>{ iOwner, 0u };
+            }
+            basic_live_iterator<Const> end() const
+            {
+                return basic_live_iterator<Const>{ iOwner, iOwner.entities().size() };
+            }
+        private:
+            owner_type& iOwner;
+        };
+        typedef basic_live_range<true> const_live_range;
+        typedef basic_live_range<false> live_range;
     public:
         static_component(game::i_ecs& aEcs) : 
             base_type{ aEcs },
-            iHaveSnapshot{ false },
-            iUsingSnapshot{ 0u }
+            iCompactions{ 0u },
+            iGeneration{ 1u },
+            iLayoutChanged{ false }
         {
         }
         static_component(const self_type& aOther) :
@@ -241,8 +368,9 @@ namespace neogfx::game
             iEntities{ aOther.iEntities },
             iFreeIndices{ aOther.iFreeIndices },
             iReverseIndices{ aOther.iReverseIndices },
-            iHaveSnapshot{ false },
-            iUsingSnapshot{ 0u }
+            iCompactions{ aOther.iCompactions },
+            iGeneration{ 1u },
+            iLayoutChanged{ false }
         {
         }
     public:
@@ -252,6 +380,8 @@ namespace neogfx::game
             iEntities = aRhs.iEntities;    
             iFreeIndices = aRhs.iFreeIndices;
             iReverseIndices = aRhs.iReverseIndices;
+            iCompactions = aRhs.iCompactions;
+            iLayoutChanged = true;
             return *this;
         }
     public:
@@ -266,8 +396,25 @@ namespace neogfx::game
         using base_type::field_type_id;
         using base_type::field_name;
     public:
-        using base_type::component_data;
-        using base_type::operator[];
+        // Records modified through these are published to snapshots; modifying records through the component_data()
+        // container means every record must be copied at the next publication.
+        const component_data_t& component_data() const
+        {
+            return base_type::component_data();
+        }
+        component_data_t& component_data()
+        {
+            iLayoutChanged = true;
+            return base_type::component_data();
+        }
+        const value_type& operator[](reverse_index_t aIndex) const
+        {
+            return base_type::component_data()[aIndex];
+        }
+        value_type& operator[](reverse_index_t aIndex)
+        {
+            return modified_record(aIndex);
+        }
     public:
         entity_id entity(const data_type& aData) const
         {
@@ -284,6 +431,14 @@ namespace neogfx::game
         {
             return iEntities;
         }
+        const_live_range live_records() const
+        {
+            return const_live_range{ *this };
+        }
+        live_range live_records()
+        {
+            return live_range{ *this };
+        }
         const reverse_indices_t& reverse_indices() const
         {
             return iReverseIndices;
@@ -311,10 +466,14 @@ namespace neogfx::game
         }
         value_type& entity_record(entity_id aEntity)
         {
-            return const_cast<value_type&>(to_const(*this).entity_record(aEntity));
+            auto reverseIndex = reverse_index(aEntity);
+            if (reverseIndex == invalid)
+                throw entity_record_not_found();
+            return modified_record(reverseIndex);
         }
         void destroy_entity_record(entity_id aEntity) override
         {
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
             auto reverseIndex = reverse_index(aEntity);
             if (reverseIndex == invalid)
                 throw entity_record_not_found();
@@ -323,30 +482,58 @@ namespace neogfx::game
             entities()[reverseIndex] = null_entity;
             reverse_indices()[aEntity] = invalid;
             free_indices().push_back(reverseIndex);
-            if (have_snapshot())
+            slot_changed(reverseIndex);
+            // the entity's id can be recycled so it mustn't stay visible in the published snapshot
+            auto const published = snapshot();
+            if (published != nullptr && published->has_entity_record(aEntity))
+                publish_snapshot();
+        }
+        component_fragmentation fragmentation() const override
+        {
+            return component_fragmentation{ entities().size(), iFreeIndices.size(), iCompactions };
+        }
+        // Removes the slots of destroyed entities, preserving the order of the remaining records; references to
+        // records are invalidated so the ECS only calls this between scheduler steps, with the component lock held.
+        void compact() override
+        {
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+            if (free_indices().empty())
+                return;
+            reverse_index_t live = 0u;
+            for (reverse_index_t index = 0u; index < entities().size(); ++index)
             {
-                std::scoped_lock<std::recursive_mutex> lock{ mutex() };
-                if (have_snapshot())
+                auto const e = entities()[index];
+                if (e == null_entity)
+                    continue;
+                if (live != index)
                 {
-                    auto ss = snapshot();
-                    ss.data().destroy_entity_record(aEntity);
+                    base_type::component_data()[live] = std::move(base_type::component_data()[index]);
+                    entities()[live] = e;
+                    reverse_indices()[e] = live;
                 }
+                ++live;
             }
-
-            // todo: sort/remove component data of dead entities
+            base_type::component_data().erase(std::next(base_type::component_data().begin(), live), base_type::component_data().end());
+            entities().erase(std::next(entities().begin(), live), entities().end());
+            free_indices().clear();
+            ++iCompactions;
+            iLayoutChanged = true;
         }
         value_type& populate(entity_id aEntity, const value_type& aData)
         {
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
             return do_populate(aEntity, aData);
         }
         value_type& populate(entity_id aEntity, value_type&& aData)
         {
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
             return do_populate(aEntity, aData);
         }
         void* populate(entity_id aEntity, const void* aComponentData, std::size_t aComponentDataSize) override
         {
             if ((aComponentData == nullptr && !is_data_optional()) || aComponentDataSize != sizeof(data_type))
                 throw invalid_data();
+            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
             if (aComponentData != nullptr)
                 return &do_populate(aEntity, *static_cast<const data_type*>(aComponentData));
             else
@@ -355,28 +542,52 @@ namespace neogfx::game
     public:
         bool have_snapshot() const
         {
-            return iHaveSnapshot;
+            return snapshot() != nullptr;
         }
-        void take_snapshot()
+        // Called by the writer once it has completed a frame of updates; a buffer that no reader holds is brought
+        // up to date, by copying only the record slots changed since that buffer was last published, and is then
+        // published with an atomic swap. Destroying a record visible in the published snapshot, or creating one
+        // while a snapshot is published, publishes again so a snapshot never attributes a destroyed entity's record
+        // to a recycled entity id.
+        void publish_snapshot()
         {
             std::scoped_lock<std::recursive_mutex> lock{ mutex() };
-            if (!iUsingSnapshot)
+            for (auto& buffer : iSnapshotBuffers)
             {
-                if (iSnapshot == nullptr)
-                    iSnapshot = snapshot_ptr{ new self_type{*this} };
+                if (iLayoutChanged || buffer->fullCopyRequired || 
+                    buffer->changedSlots.size() + iChangedSlots.size() > entities().size())
+                {
+                    buffer->fullCopyRequired = true;
+                    buffer->changedSlots.clear();
+                }
                 else
-                    *iSnapshot = *this;
-                iHaveSnapshot = true;
+                    buffer->changedSlots.insert(buffer->changedSlots.end(), iChangedSlots.begin(), iChangedSlots.end());
             }
-        }
-        scoped_snapshot snapshot()
-        {
-            std::scoped_lock<std::recursive_mutex> lock{ mutex() };
-            return scoped_snapshot{ *this };
+            iChangedSlots.clear();
+            iLayoutChanged = false;
+            ++iGeneration;
+            auto back = std::find_if(iSnapshotBuffers.begin(), iSnapshotBuffers.end(), 
+                [](const std::shared_ptr<snapshot_buffer>& aBuffer) { return aBuffer->readers.load(std::memory_order_acquire) == 0u; });
+            if (back == iSnapshotBuffers.end())
+                back = iSnapshotBuffers.insert(iSnapshotBuffers.end(), std::make_shared<snapshot_buffer>());
+            auto buffer = *back;
+            update_snapshot(*buffer);
+            buffer->readers.fetch_add(1u, std::memory_order_relaxed);
+            // every copy of the published pointer shares one control block so the buffer is released (and can be
+            // reused) once the last reader's copy has gone and the snapshot has been superseded
+            std::atomic_store(&iSnapshot, snapshot_ptr{ &buffer->records, 
+                [buffer](const records_snapshot*) { buffer->readers.fetch_sub(1u, std::memory_order_release); } });
+        }
+        // Returns the most recently published snapshot without copying or taking the component lock.
+        snapshot_ptr snapshot() const
+        {
+            return std::atomic_load(&iSnapshot);
         }
         template <typename Compare>
         void sort(Compare aComparator)
         {
+            // free slots would otherwise be moved from under the free index list
+            compact();
             neolib::intrusive_sort(base_type::component_data().begin(), base_type::component_data().end(),
                 [this](auto lhs, auto rhs) 
                 { 
@@ -386,13 +597,76 @@ namespace neogfx::game
                     auto& lhsEntity = entities()[lhsIndex];
                     auto& rhsEntity = entities()[rhsIndex];
                     std::swap(lhsEntity, rhsEntity);
-                    if (lhsEntity != invalid)
+                    if (lhsEntity != null_entity)
                         reverse_indices()[lhsEntity] = lhsIndex;
-                    if (rhsEntity != invalid)
+                    if (rhsEntity != null_entity)
                         reverse_indices()[rhsEntity] = rhsIndex;
                 }, aComparator);
+            iLayoutChanged = true;
         }
     private:
+        value_type& modified_record(reverse_index_t aIndex)
+        {
+            slot_changed(aIndex);
+            return base_type::component_data()[aIndex];
+        }
+        void slot_changed(reverse_index_t aIndex)
+        {
+            // nothing to track until a snapshot has been published
+            if (iSnapshotBuffers.empty())
+                return;
+            if (iSlotGenerations.size() <= aIndex)
+                iSlotGenerations.resize(aIndex + 1u, 0u);
+            if (iSlotGenerations[aIndex] != iGeneration)
+            {
+                iSlotGenerations[aIndex] = iGeneration;
+                iChangedSlots.push_back(aIndex);
+            }
+        }
+        void update_snapshot(snapshot_buffer& aBuffer) const
+        {
+            auto& snapshot = aBuffer.records;
+            auto const& records = base_type::component_data();
+            if (aBuffer.fullCopyRequired || snapshot.iEntities.size() > entities().size())
+            {
+                snapshot.iComponentData = records;
+                snapshot.iEntities = entities();
+                snapshot.iReverseIndices = reverse_indices();
+                aBuffer.fullCopyRequired = false;
+                aBuffer.changedSlots.clear();
+                return;
+            }
+            // slots are only added between full copies (compaction and sorting need one)
+            auto const existingSlots = snapshot.iEntities.size();
+            snapshot.iComponentData.insert(snapshot.iComponentData.end(), std::next(records.begin(), existingSlots), records.end());
+            snapshot.iEntities.insert(snapshot.iEntities.end(), std::next(entities().begin(), existingSlots), entities().end());
+            for (auto slot = existingSlots; slot < entities().size(); ++slot)
+                set_snapshot_entity(snapshot, slot);
+            for (auto slot : aBuffer.changedSlots)
+            {
+                if (slot >= existingSlots)
+                    continue;
+                auto const oldEntity = snapshot.iEntities[slot];
+                if (oldEntity != null_entity && snapshot.reverse_index(oldEntity) == slot)
+                    snapshot.iReverseIndices[oldEntity] = invalid;
+                snapshot.iEntities[slot] = entities()[slot];
+                if (entities()[slot] != null_entity)
+                {
+                    snapshot.iComponentData[slot] = records[slot];
+                    set_snapshot_entity(snapshot, slot);
+                }
+            }
+            aBuffer.changedSlots.clear();
+        }
+        static void set_snapshot_entity(records_snapshot& aSnapshot, reverse_index_t aSlot)
+        {
+            auto const entity = aSnapshot.iEntities[aSlot];
+            if (entity == null_entity)
+                return;
+            if (aSnapshot.iReverseIndices.size() <= entity)
+                aSnapshot.iReverseIndices.resize(entity + 1u, invalid);
+            aSnapshot.iReverseIndices[entity] = aSlot;
+        }
         free_indices_t& free_indices()
         {
             return iFreeIndices;
@@ -402,6 +676,15 @@ namespace neogfx::game
         {
             if (has_entity_record(aEntity))
                 return do_update(aEntity, aComponentData);
+            auto& result = do_create(aEntity, std::forward<T>(aComponentData));
+            // a new entity mustn't be missing from the published snapshot nor take over a destroyed entity's record
+            if (have_snapshot())
+                publish_snapshot();
+            return result;
+        }
+        template <typename T>
+        value_type& do_create(entity_id aEntity, T&& aComponentData)
+        {
             reverse_index_t reverseIndex = invalid;
             if (!free_indices().empty())
             {
@@ -435,7 +718,7 @@ namespace neogfx::game
                 entities()[reverseIndex] = null_entity;
                 throw;
             }
-            return base_type::component_data()[reverseIndex];
+            return modified_record(reverseIndex);
         }
         template <typename T>
         value_type& do_update(entity_id aEntity, T&& aComponentData)
@@ -448,9 +731,13 @@ namespace neogfx::game
         component_data_entities_t iEntities;
         free_indices_t iFreeIndices;
         reverse_indices_t iReverseIndices;
-        mutable std::atomic<bool> iHaveSnapshot;
-        mutable std::atomic<uint32_t> iUsingSnapshot;
-        mutable snapshot_ptr iSnapshot;
+        uint64_t iCompactions;
+        uint64_t iGeneration;
+        std::vector<uint64_t> iSlotGenerations;
+        std::vector<reverse_index_t> iChangedSlots;
+        bool iLayoutChanged;
+        std::vector<std::shared_ptr<snapshot_buffer>> iSnapshotBuffers;
+        snapshot_ptr iSnapshot;
     };
 
     template <typename Data>
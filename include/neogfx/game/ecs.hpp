@@ -23,6 +23,7 @@
 #include <neolib/timer.hpp>
 #include <neogfx/core/object.hpp>
 #include <neogfx/game/i_ecs.hpp>
+#include <neogfx/game/system_scheduler.hpp>
 
 namespace neogfx::game
 {
@@ -45,6 +46,7 @@ namespace neogfx::game
         bool all_systems_paused() const override;
         void pause_all_systems() override;
         void resume_all_systems() override;
+        system_timings_t system_timings() const override;
     public:
         const archetype_registry_t& archetypes() const override;
         archetype_registry_t& archetypes() override;
@@ -72,6 +74,8 @@ namespace neogfx::game
         bool system_instantiated(system_id aSystemId) const override;
         const i_system& system(system_id aSystemId) const override;
         i_system& system(system_id aSystemId) override;
+        const game::archetype_storage& archetype_storage() const override;
+        game::archetype_storage& archetype_storage() override;
     public:
         entity_id next_entity_id() override;
         void free_entity_id(entity_id aId) override;
@@ -93,6 +97,7 @@ namespace neogfx::game
     private:
         handle_id next_handle_id();
         void free_handle_id(handle_id aId);
+        void compact_components();
     public:
         using i_ecs::create_entity;
     public:
@@ -120,12 +125,14 @@ namespace neogfx::game
         mutable shared_components_t iSharedComponents;
         system_factories_t iSystemFactories;
         mutable systems_t iSystems;
+        mutable std::recursive_mutex iSystemsMutex;
+        mutable system_scheduler iScheduler;
+        game::archetype_storage iArchetypeStorage;
         entity_id iNextEntityId;
         std::vector<entity_id> iFreedEntityIds;
         handle_id iNextHandleId;
         std::vector<handle_id> iFreedHandleIds;
         handles_t iHandles;
-        neolib::callback_timer iSystemTimer;
         std::atomic<bool> iSystemsPaused;
     };
 }
\ No newline at end of file
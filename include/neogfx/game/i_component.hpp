@@ -19,6 +19,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <mutex>
 #include <neolib/string.hpp>
 #include <neogfx/game/ecs_ids.hpp>
 #include <neogfx/game/i_component_data.hpp>
@@ -34,6 +35,7 @@ namespace neogfx::game
     public:
         virtual game::i_ecs& ecs() const = 0;
         virtual const component_id& id() const = 0;
+        virtual std::recursive_mutex& mutex() const = 0;
     public:
         virtual bool is_data_optional() const = 0;
         virtual const i_string& name() const = 0;
@@ -54,11 +56,20 @@ namespace neogfx::game
         }
     };
 
+    struct component_fragmentation
+    {
+        std::size_t records;
+        std::size_t deadRecords;
+        uint64_t compactions;
+    };
+
     class i_component : public i_component_base
     {
     public:
         virtual bool has_entity_record(entity_id aEntity) const = 0;
         virtual void destroy_entity_record(entity_id aEntity) = 0;
+        virtual component_fragmentation fragmentation() const = 0;
+        virtual void compact() = 0;
     public:
         virtual void* populate(entity_id aEntity, const void* aComponentData, std::size_t aComponentDataSize) = 0;
         template <typename ComponentData>
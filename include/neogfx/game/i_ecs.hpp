@@ -26,6 +26,7 @@
 #include <neogfx/game/ecs_ids.hpp>
 #include <neogfx/game/i_entity_archetype.hpp>
 #include <neogfx/game/component.hpp>
+#include <neogfx/game/archetype_storage.hpp>
 #include <neogfx/game/system.hpp>
 #include <neogfx/game/chrono.hpp>
 
@@ -83,6 +84,8 @@ namespace neogfx::game
         typedef std::map<component_id, std::unique_ptr<i_shared_component>> shared_components_t;
         typedef std::map<system_id, system_factory> system_factories_t;
         typedef std::map<system_id, std::unique_ptr<i_system>> systems_t;
+    public:
+        typedef std::map<system_id, system_timing> system_timings_t;
     public:
         typedef id_t handle_id;
         typedef void* handle_t;
@@ -94,6 +97,7 @@ namespace neogfx::game
         virtual bool all_systems_paused() const = 0;
         virtual void pause_all_systems() = 0;
         virtual void resume_all_systems() = 0;
+        virtual system_timings_t system_timings() const = 0;
     public:
         virtual const archetype_registry_t& archetypes() const = 0;
         virtual archetype_registry_t& archetypes() = 0;
@@ -121,6 +125,8 @@ namespace neogfx::game
         virtual bool system_instantiated(system_id aSystemId) const = 0;
         virtual const i_system& system(system_id aSystemId) const = 0;
         virtual i_system& system(system_id aSystemId) = 0;
+        virtual const game::archetype_storage& archetype_storage() const = 0;
+        virtual game::archetype_storage& archetype_storage() = 0;
     public:
         virtual entity_id next_entity_id() = 0;
         virtual void free_entity_id(entity_id aId) = 0;
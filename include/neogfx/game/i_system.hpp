@@ -19,6 +19,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <chrono>
 #include <neolib/i_set.hpp>
 #include <neolib/string.hpp>
 #include <neogfx/game/ecs_ids.hpp>
@@ -26,6 +27,14 @@
 
 namespace neogfx::game
 {
+    struct system_timing
+    {
+        uint64_t applications;
+        std::chrono::nanoseconds last;
+        std::chrono::nanoseconds peak;
+        std::chrono::nanoseconds total;
+    };
+
     class i_system
     {
     public:
@@ -34,6 +43,10 @@ namespace neogfx::game
     public:
         virtual const neolib::i_set<component_id>& components() const = 0;
         virtual neolib::i_set<component_id>& components() = 0;
+        virtual const neolib::i_set<component_id>& read_components() const = 0;
+        virtual neolib::i_set<component_id>& read_components() = 0;
+        virtual const neolib::i_set<component_id>& write_components() const = 0;
+        virtual neolib::i_set<component_id>& write_components() = 0;
     public:
         virtual const i_component& component(component_id aComponentId) const = 0;
         virtual const i_component& component(component_id aComponentId) = 0;
@@ -26,8 +26,6 @@ namespace neogfx::game
 {
     class simple_physics : public system
     {
-    private:
-        class thread;
     public:
         simple_physics(game::i_ecs& aEcs);
         ~simple_physics();
@@ -36,7 +34,6 @@ namespace neogfx::game
         const i_string& name() const override;
     public:
         void apply() override;
-        void terminate() override;
     public:
         bool universal_gravitation_enabled() const;
         void enable_universal_gravitation();
@@ -56,7 +53,6 @@ namespace neogfx::game
             }
         };
     private:
-        std::unique_ptr<thread> iThread;
         bool iUniversalGravitationEnabled;
     };
 }
\ No newline at end of file
@@ -45,6 +45,10 @@ namespace neogfx::game
     public:
         const neolib::i_set<component_id>& components() const override;
         neolib::i_set<component_id>& components() override;
+        const neolib::i_set<component_id>& read_components() const override;
+        neolib::i_set<component_id>& read_components() override;
+        const neolib::i_set<component_id>& write_components() const override;
+        neolib::i_set<component_id>& write_components() override;
     public:
         const i_component& component(component_id aComponentId) const override;
         i_component& component(component_id aComponentId) override;
@@ -58,6 +62,8 @@ namespace neogfx::game
     private:
         game::i_ecs& iEcs;
         component_list iComponents;
+        component_list iReadComponents;
+        component_list iWriteComponents;
         std::atomic<uint32_t> iPaused;
     };
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+// system_scheduler.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <neogfx/game/ecs_ids.hpp>
+#include <neogfx/game/i_system.hpp>
+
+namespace neogfx::game
+{
+    // Applies systems at a fixed timestep. Systems are grouped into stages from the components they declare they
+    // read and write: the systems of a stage do not conflict and are applied in parallel on a worker pool; stages
+    // are applied in order. A system is placed in the stage after the last earlier-added system it conflicts with
+    // so conflicting systems are always applied in the order they were added. A system that declares no component
+    // access is assumed to conflict with every other system. The driver and worker threads are started when the
+    // first system is added. Maintenance (such as compacting components) is run on the driver thread after every
+    // step, when no system is being applied.
+    class system_scheduler
+    {
+    public:
+        typedef std::chrono::steady_clock clock_type;
+        typedef std::chrono::nanoseconds duration;
+        typedef std::vector<i_system*> stage;
+        typedef std::vector<stage> stages_t;
+        typedef std::map<system_id, system_timing> timings_t;
+        typedef std::function<void()> maintenance_t;
+    public:
+        static constexpr duration DefaultFixedStep = std::chrono::milliseconds{ 10 };
+        static constexpr uint32_t MaxCatchUpSteps = 4u;
+    public:
+        system_scheduler(uint32_t aThreadCount = std::max(1u, std::thread::hardware_concurrency() / 2u), duration aFixedStep = DefaultFixedStep);
+        ~system_scheduler();
+    public:
+        duration fixed_step() const;
+        void set_fixed_step(duration aFixedStep);
+        void add_system(i_system& aSystem);
+        void set_maintenance(maintenance_t aMaintenance);
+        stages_t stages() const;
+        timings_t timings() const;
+        void stop();
+    private:
+        static bool conflicts(const i_system& aLhs, const i_system& aRhs);
+        void start();
+        void drive();
+        void update_stages();
+        void apply_stage(const stage& aStage);
+        void apply_system(i_system& aSystem);
+        void work();
+        bool claim(const stage*& aStage, std::size_t& aTask);
+        void complete();
+    private:
+        mutable std::mutex iMutex;
+        std::condition_variable iTick;
+        std::condition_variable iWorkAvailable;
+        std::condition_variable iStageDone;
+        duration iFixedStep;
+        std::vector<i_system*> iSystems;
+        bool iStagesDirty;
+        stages_t iStages;
+        const stage* iStage;
+        std::size_t iNextTask;
+        std::size_t iPendingTasks;
+        mutable std::mutex iTimingsMutex;
+        timings_t iTimings;
+        maintenance_t iMaintenance;
+        bool iStopping;
+        uint32_t iThreadCount;
+        bool iStarted;
+        std::vector<std::thread> iWorkers;
+        std::thread iDriver;
+    };
+}
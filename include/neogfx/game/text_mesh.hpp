@@ -139,7 +139,12 @@ namespace neogfx::game
                     aEcs.component<mesh_renderer>().populate(aEntity, mesh_renderer{});
                 mf.mesh = mesh{};
                 mr.patches = patches{};
+                // text meshes are transformed freely so their glyphs are rendered from distance fields
+                bool const distanceFieldText = aGraphicsContext.is_distance_field_text_on();
+                aGraphicsContext.distance_field_text_on();
                 auto glyphText = aGraphicsContext.to_multiline_glyph_text(aData.text, service<i_font_manager>().font_from_id(aData.font.ptr->id.cookie()), aData.extents.x, aData.alignment);
+                if (!distanceFieldText)
+                    aGraphicsContext.distance_field_text_off();
                 for (auto const& line : glyphText.lines)
                 {
                     auto mesh_line = [&](const point& aOffset, const material& aMaterial) 
@@ -151,15 +156,19 @@ namespace neogfx::game
                             if (!glyph.is_whitespace())
                             {
                                 auto const& glyphFont = glyph.font(glyphText.glyphText);
-                                auto const& glyphTexture = glyph.glyph_texture(glyphText.glyphText);
+                                auto const& glyphTexture = glyph.distance_field() ? glyph.distance_field_glyph_texture(glyphFont) : glyph.glyph_texture(glyphFont);
+                                scalar const glyphScale = glyph.distance_field() ? glyphFont.distance_field_scale() : 1.0;
+                                point const glyphPlacement = glyphTexture.placement() * glyphScale;
+                                size const glyphExtents = glyphTexture.texture().extents() * glyphScale;
                                 vec3 glyphOrigin(
-                                    pos.x + glyphTexture.placement().x,
+                                    pos.x + glyphPlacement.x,
                                     aGraphicsContext.logical_coordinates().is_game_orientation() ?
-                                        pos.y + (glyphTexture.placement().y + -glyphFont.descender()) :
-                                        pos.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.texture().extents().cy,
+                                        pos.y + (glyphPlacement.y + -glyphFont.descender()) :
+                                        pos.y + glyphFont.height() - (glyphPlacement.y + -glyphFont.descender()) - glyphExtents.cy,
                                     0.0);
-                                add_patch(*mf.mesh, mr, rect{ glyphOrigin, glyphTexture.texture().extents() }, 0.0, glyphTexture.texture());
-                                mr.patches.back().material = material{ aMaterial.color, aMaterial.gradient, aMaterial.sharedTexture, mr.patches.back().material.texture, aMaterial.shaderEffect };
+                                add_patch(*mf.mesh, mr, rect{ glyphOrigin, glyphExtents }, 0.0, glyphTexture.texture());
+                                mr.patches.back().material = material{ aMaterial.color, aMaterial.gradient, aMaterial.sharedTexture, mr.patches.back().material.texture, 
+                                    glyph.distance_field() ? shader_effect::DistanceField : aMaterial.shaderEffect };
                             }
                             pos.x += glyph.advance().cx;
                         }
@@ -0,0 +1,68 @@
+// damage_region.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <vector>
+#include <neogfx/core/geometrical.hpp>
+
+namespace neogfx
+{
+    // A set of (mostly) disjoint rectangles requiring repaint. Rectangles are merged when doing so is cheaper
+    // than painting them separately; the cost of a rectangle is its area plus a fixed per-rectangle overhead
+    // (state changes, scissor, draw call submission) expressed in pixels.
+    class damage_region
+    {
+    public:
+        typedef std::vector<rect> rect_list;
+        typedef rect_list::const_iterator const_iterator;
+    public:
+        static constexpr std::size_t DefaultMaxRects = 16u;
+        static constexpr dimension DefaultRectOverhead = 64.0 * 64.0;
+    public:
+        damage_region(std::size_t aMaxRects = DefaultMaxRects, dimension aRectOverhead = DefaultRectOverhead);
+    public:
+        bool empty() const;
+        std::size_t size() const;
+        const_iterator begin() const;
+        const_iterator end() const;
+        const rect_list& rects() const;
+        const rect& bounding_rect() const;
+        dimension area() const;
+        dimension cost() const;
+        bool intersects(const rect& aRect) const;
+        rect intersection(const rect& aRect) const;
+    public:
+        void add(const rect& aRect);
+        void add(const damage_region& aOther);
+        void clear();
+    private:
+        dimension cost(const rect& aRect) const;
+        bool worth_merging(const rect& aFirst, const rect& aSecond) const;
+        void merge_overlapping(std::size_t aIndex);
+        void merge_cheapest_pair();
+        void update_bounding_rect();
+    private:
+        std::size_t iMaxRects;
+        dimension iRectOverhead;
+        rect_list iRects;
+        rect iBoundingRect;
+    };
+}
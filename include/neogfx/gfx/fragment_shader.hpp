@@ -55,6 +55,7 @@ namespace neogfx
         {
             add_in_variable<vec3f>("Coord"_s, 0u);
             auto& fragColor = add_in_variable<vec4f>("Color"_s, 1u);
+            add_in_variable<vec4f>("ClipRect"_s, 3u);
             add_out_variable<vec4f>("FragColor"_s, 0u).link(fragColor);
         }
     public:
@@ -69,6 +70,10 @@ namespace neogfx
                     {
                         "void standard_fragment_shader(inout vec4 color)\n"
                         "{\n"
+                        "    if (ClipRect.z > ClipRect.x && (\n"
+                        "        gl_FragCoord.x < ClipRect.x || gl_FragCoord.x >= ClipRect.z ||\n"
+                        "        gl_FragCoord.y < ClipRect.y || gl_FragCoord.y >= ClipRect.w))\n"
+                        "        discard;\n"
                         "}\n"_s
                     };
                     aOutput += code;
@@ -151,6 +156,28 @@ namespace neogfx
         cache_uniform(uTextureEffect)
     };
 
+    constexpr uint32_t BLUR_KERNEL_MAX_RADIUS = 16;
+    constexpr uint32_t BLUR_KERNEL_SIZE = BLUR_KERNEL_MAX_RADIUS * 2 + 1;
+
+    class standard_blur_shader : public standard_fragment_shader<i_blur_shader>
+    {
+    public:
+        standard_blur_shader(const std::string& aName = "standard_blur_shader");
+    public:
+        void generate_code(const i_shader_program& aProgram, shader_language aLanguage, i_string& aOutput) const override;
+    public:
+        bool blur_active() const override;
+        void clear_blur() override;
+        void set_blur(blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma) override;
+    private:
+        std::array<float, BLUR_KERNEL_SIZE> iKernel;
+    private:
+        cache_uniform(uBlurDirection)
+        cache_uniform(uBlurRadius)
+        cache_uniform(uBlurKernel)
+        cache_uniform(uBlurEnabled)
+    };
+
     class standard_glyph_shader : public standard_fragment_shader<i_glyph_shader>
     {
     public:
@@ -160,12 +187,16 @@ namespace neogfx
     public:
         void clear_glyph() override;
         void set_first_glyph(const i_rendering_context& aContext, const glyph& aGlyph) override;
+        void set_distance_field_effect(scalar aDilation, scalar aSoftness) override;
     private:
         cache_uniform(uGlyphRenderTargetExtents)
         cache_uniform(uGlyphGuiCoordinates)
         cache_uniform(uGlyphRenderOutput)
         cache_uniform(uGlyphSubpixel)
         cache_uniform(uGlyphSubpixelFormat)
+        cache_uniform(uGlyphDistanceField)
+        cache_uniform(uGlyphDistanceFieldDilation)
+        cache_uniform(uGlyphDistanceFieldSoftness)
         cache_uniform(uGlyphEnabled)
     };
 
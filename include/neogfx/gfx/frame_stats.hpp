@@ -0,0 +1,81 @@
+// frame_stats.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <array>
+#include <chrono>
+#include <neogfx/gfx/graphics_operations.hpp>
+
+namespace neogfx
+{
+    enum class flush_reason : uint32_t
+    {
+        Requested,              // graphics_context::flush()
+        TargetDeactivating,     // render target switched whilst operations were queued
+        VertexBufferFull,       // vertices drawn early as the current vertex buffer segment was full
+        COUNT
+    };
+
+    // Counters for a single rendered frame (one window render), accumulated by the rendering engine.
+    struct frame_stats
+    {
+        typedef std::chrono::nanoseconds duration;
+
+        uint64_t frame = 0u;
+        std::array<uint32_t, graphics_operation::operation_type::DrawMesh + 1u> operations = {}; // enqueued, indexed by operation_type
+        uint32_t batches = 0u;
+        uint32_t drawCalls = 0u;
+        uint64_t verticesStreamed = 0u;
+        uint64_t bytesStreamed = 0u; // vertex buffer bytes fenced for the GPU
+        uint32_t fences = 0u;
+        uint32_t fenceWaits = 0u; // vertex buffer segments the CPU had to wait for
+        duration fenceWaitTime = {};
+        uint32_t segmentsRecycled = 0u;
+        uint64_t instances = 0u; // drawn by instanced draw calls
+        std::array<uint32_t, static_cast<std::size_t>(flush_reason::COUNT)> flushes = {}; // indexed by flush_reason
+        uint32_t textureUploads = 0u;
+        uint64_t textureUploadTexels = 0u;
+        uint32_t shaderProgramSwitches = 0u;
+        uint64_t repaintedPixels = 0u; // damaged area repainted by widgets
+        uint64_t presentedPixels = 0u; // area blitted to the window
+        duration paintTime = {}; // widget rendering excluding queue flushes
+        duration flushTime = {};
+        duration swapTime = {}; // presenting the frame
+
+        uint32_t total_operations() const
+        {
+            uint32_t result = 0u;
+            for (auto count : operations)
+                result += count;
+            return result;
+        }
+        uint32_t total_flushes() const
+        {
+            uint32_t result = 0u;
+            for (auto count : flushes)
+                result += count;
+            return result;
+        }
+    };
+
+    std::string to_string(flush_reason aReason);
+    std::string to_string(const frame_stats& aStats);
+}
@@ -38,6 +38,7 @@ namespace neogfx
         graphics_context(const i_surface& aSurface, const font& aDefaultFont, type aType = type::Attached);
         graphics_context(const i_widget& aWidget, type aType = type::Attached);
         graphics_context(const i_texture& aTexture, type aType = type::Attached);
+        graphics_context(const i_render_target& aTarget, type aType = type::Attached);
         graphics_context(const graphics_context& aOther);
         virtual ~graphics_context();
         // i_rendering_context
@@ -98,6 +99,9 @@ namespace neogfx
         bool is_subpixel_rendering_on() const override;
         void subpixel_rendering_on() const override;
         void subpixel_rendering_off() const override;
+        bool is_distance_field_text_on() const override;
+        void distance_field_text_on() const override;
+        void distance_field_text_off() const override;
         void clear(const color& aColor, const std::optional<scalar>& aZpos = std::optional<scalar>{}) const override;
         void clear_depth_buffer() const override;
         void clear_stencil_buffer() const override;
@@ -197,6 +201,10 @@ namespace neogfx
     public:
         bool device_metrics_available() const override;
         const i_device_metrics& device_metrics() const override;
+        // own
+    public:
+        point target_origin() const;
+        void set_target_origin(const point& aTargetOrigin);
     protected:
         bool attached() const;
         i_rendering_context& native_context() const;
@@ -205,6 +213,9 @@ namespace neogfx
     private:
         glyph_text to_glyph_text_impl(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, std::function<font(std::string::size_type)> aFontSelector) const;
         glyph_text to_glyph_text_impl(std::u32string::const_iterator aTextBegin, std::u32string::const_iterator aTextEnd, std::function<font(std::u32string::size_type)> aFontSelector) const;
+        template <typename Iter>
+        glyph_text to_cached_glyph_text(Iter aTextBegin, Iter aTextEnd, const font& aFont) const;
+        void draw_blur_pass(const rect& aDestinationRect, const i_texture& aSource, const rect& aSourceRect, blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma) const;
         // attributes
     private:
         type iType;
@@ -212,6 +223,7 @@ namespace neogfx
         mutable std::unique_ptr<i_rendering_context> iNativeGraphicsContext;
         mutable font iDefaultFont;
         mutable point iOrigin;
+        point iTargetOrigin;
         mutable size iExtents;
         mutable int32_t iLayer;
         mutable std::optional<neogfx::logical_coordinate_system> iLogicalCoordinateSystem;
@@ -221,6 +233,7 @@ namespace neogfx
         mutable neogfx::blending_mode iBlendingMode;
         mutable neogfx::smoothing_mode iSmoothingMode;
         mutable bool iSubpixelRendering;
+        mutable bool iDistanceFieldText;
         mutable std::optional<std::pair<bool, char>> iMnemonic;
         mutable std::optional<std::string> iPassword;
         struct glyph_text_data;
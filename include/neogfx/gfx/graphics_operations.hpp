@@ -96,6 +96,18 @@ namespace neogfx
         {
         };
 
+        struct blur_on
+        {
+            blurring_algorithm algorithm;
+            vec2 direction;
+            uint32_t radius;
+            double sigma;
+        };
+
+        struct blur_off
+        {
+        };
+
         struct subpixel_rendering_on
         {
         };
@@ -256,6 +268,8 @@ namespace neogfx
             pop_logical_operation,
             line_stipple_on,
             line_stipple_off,
+            blur_on,
+            blur_off,
             subpixel_rendering_on,
             subpixel_rendering_off,
             clear,
@@ -297,6 +311,8 @@ namespace neogfx
             PopLogicalOperation,
             LineStippleOn,
             LineStippleOff,
+            BlurOn,
+            BlurOff,
             SubpixelRenderingOn,
             SubpixelRenderingOff,
             Clear,
@@ -328,5 +344,24 @@ namespace neogfx
 
         typedef std::vector<operation> queue;
         typedef std::pair<operation const*, operation const*> batch;
+        // the clip rectangle (if any) in effect for each operation of a queue
+        typedef std::vector<optional_rect> clip_list;
+
+        // Conservative (logical coordinate) bounds of what a drawing operation can touch; std::nullopt if
+        // the operation is not a drawing operation or its extent is unknown (e.g. draw_entities).
+        optional_rect bounding_rect(const operation& aOperation);
+
+        // Reorders the queue so that batchable drawing operations become adjacent (and so are submitted
+        // as a single draw call) without changing the result: an operation is only moved in front of
+        // operations it does not overlap and never across a state changing operation.
+        void compile(queue& aQueue);
+        // As above but the clip rectangle of each operation has been resolved (and will be applied by the
+        // renderer) so scissor operations are not barriers; the clip list is reordered along with the queue.
+        void compile(queue& aQueue, clip_list& aClips);
+
+        // When enabled compile() writes the draw calls (batches) before and after compilation to std::cerr.
+        bool dump_batches();
+        void set_dump_batches(bool aDumpBatches);
+        void dump(std::ostream& aStream, const queue& aQueue);
     }
 }
\ No newline at end of file
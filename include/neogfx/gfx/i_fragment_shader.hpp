@@ -63,6 +63,17 @@ namespace neogfx
         virtual void set_effect(shader_effect aEffect) = 0;
     };
 
+    class i_blur_shader : public i_fragment_shader
+    {
+        typedef i_blur_shader self_type;
+    public:
+        typedef self_type abstract_type;
+    public:
+        virtual bool blur_active() const = 0;
+        virtual void clear_blur() = 0;
+        virtual void set_blur(blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma) = 0;
+    };
+
     class i_glyph_shader : public i_fragment_shader
     {
         typedef i_texture_shader self_type;
@@ -71,6 +82,7 @@ namespace neogfx
     public:
         virtual void clear_glyph() = 0;
         virtual void set_first_glyph(const i_rendering_context& aContext, const glyph& aGlyph) = 0;
+        virtual void set_distance_field_effect(scalar aDilation, scalar aSoftness) = 0;
     };
 
     class i_stipple_shader : public i_fragment_shader
@@ -123,6 +123,9 @@ namespace neogfx
         virtual bool is_subpixel_rendering_on() const = 0;
         virtual void subpixel_rendering_on() const = 0;
         virtual void subpixel_rendering_off() const = 0;
+        virtual bool is_distance_field_text_on() const = 0;
+        virtual void distance_field_text_on() const = 0;
+        virtual void distance_field_text_off() const = 0;
         virtual void clear(const color& aColor, const std::optional<scalar>& aZpos = std::optional<scalar>{}) const = 0;
         virtual void clear_depth_buffer() const = 0;
         virtual void clear_stencil_buffer() const = 0;
@@ -27,6 +27,7 @@
 #include <neogfx/hid/i_surface_window.hpp>
 #include <neogfx/gfx/i_shader.hpp>
 #include <neogfx/gfx/i_standard_shader_program.hpp>
+#include <neogfx/gfx/frame_stats.hpp>
 
 namespace neogfx
 {
@@ -55,6 +56,7 @@ namespace neogfx
         // events
     public:
         declare_event(subpixel_rendering_changed)
+        declare_event(frame_completed, const neogfx::frame_stats&)
         // exceptions
     public:
         struct failed_to_initialize : std::runtime_error { failed_to_initialize() : std::runtime_error("neogfx::i_rendering_engine::failed_to_initialize") {} };
@@ -135,5 +137,12 @@ namespace neogfx
         virtual void register_frame_counter(i_widget& aWidget, uint32_t aDuration) = 0;
         virtual void unregister_frame_counter(i_widget& aWidget, uint32_t aDuration) = 0;
         virtual uint32_t frame_counter(uint32_t aDuration) const = 0;
+    public:
+        virtual const neogfx::frame_stats& frame_stats() const = 0;
+        virtual neogfx::frame_stats& frame_stats() = 0;
+        virtual const neogfx::frame_stats& last_frame_stats() const = 0;
+        virtual void end_frame() = 0;
+        virtual bool frame_stats_overlay_enabled() const = 0;
+        virtual void enable_frame_stats_overlay(bool aEnable) = 0;
     };
 }
\ No newline at end of file
@@ -25,6 +25,17 @@
 
 namespace neogfx
 {
+    struct texture_atlas_stats
+    {
+        uint32_t pages;
+        uint32_t subTextures;
+        dimension capacity;
+        dimension used;
+        dimension reusable;
+        double occupancy;
+        double fragmentation;
+    };
+
     class i_texture_atlas
     {
     public:
@@ -36,5 +47,8 @@ namespace neogfx
         virtual i_sub_texture& create_sub_texture(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat = texture_data_format::RGBA) = 0;
         virtual i_sub_texture& create_sub_texture(const i_image& aImage) = 0;
         virtual void destroy_sub_texture(i_sub_texture& aSubTexture) = 0;
+    public:
+        virtual texture_atlas_stats stats() const = 0;
+        virtual void compact() = 0;
     };
 }
\ No newline at end of file
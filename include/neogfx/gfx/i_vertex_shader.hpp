@@ -33,6 +33,7 @@ namespace neogfx
     public:
         virtual void set_projection_matrix(const optional_mat44& aProjectionMatrix) = 0;
         virtual void set_transformation_matrix(const optional_mat44& aProjectionMatrix) = 0;
+        virtual void set_instanced(bool aInstanced) = 0;
     };
 
     struct no_standard_vertex_matrices : std::logic_error { no_standard_vertex_matrices() : std::logic_error{ "neogfx::no_standard_vertex_matrices" } {} };
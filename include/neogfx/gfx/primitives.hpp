@@ -65,13 +65,15 @@ namespace neogfx
         ColorizeMaximum    = 2,
         ColorizeSpot       = 3,
         Monochrome         = 4,
-        Ignore             = 5
+        Ignore             = 5,
+        DistanceField      = 6
     };
 
     enum class blurring_algorithm
     {
         None,
-        Gaussian
+        Gaussian,
+        Box
     };
 
     typedef neolib::variant<color, gradient, texture, std::pair<texture, rect>, sub_texture, std::pair<sub_texture, rect>> brush;
@@ -1,6 +1,6 @@
 // rect_pack.hpp
 /*
- *  Based on public domain code @ http://blackpawn.com/texts/lightmaps/default.html.
+ *  Skyline bottom-left rectangle packer with reuse of freed rectangles.
  *
  *  This implementation written by Leigh Johnston.
  *
@@ -34,7 +34,7 @@
 */
 
 #include <neogfx/neogfx.hpp>
-#include <boost/pool/pool_alloc.hpp>
+#include <vector>
 #include <neogfx/core/geometrical.hpp>
 
 #pragma once
@@ -44,50 +44,36 @@ namespace neogfx
     class rect_pack
     {
     private:
-        class node
+        struct segment
         {
-        public:
-            typedef boost::fast_pool_allocator<node, boost::default_user_allocator_new_delete, boost::details::pool::null_mutex> allocator_type;
-        public:
-            node(const rect& aRect, allocator_type& aAllocator) :
-                iAllocator{ aAllocator }, iInUse { false }, iChildren{}, iRect{ aRect }
-            {
-            }
-            ~node()
-            {
-                if (iChildren[0] != nullptr)
-                {
-                    iAllocator.destroy(iChildren[0]);
-                    iAllocator.deallocate(iChildren[0]);
-                }
-                if (iChildren[1] != nullptr)
-                {
-                    iAllocator.destroy(iChildren[1]);
-                    iAllocator.deallocate(iChildren[1]);
-                }
-            }
-        public:
-            bool is_leaf() const 
-            {
-                return iChildren[0] == nullptr;
-            }
-            const neogfx::rect& rect() const
-            {
-                return iRect;
-            }
-            node* insert(const size& aElementSize);
-        private:
-            allocator_type& iAllocator;
-            bool iInUse;
-            std::array<node*, 2> iChildren;
-            neogfx::rect iRect;
+            dimension x;
+            dimension y;
+            dimension width;
         };
+        typedef std::vector<segment> skyline;
+        typedef std::vector<rect> free_list;
     public:
         rect_pack(const size& aDimensions);
+    public:
+        const size& dimensions() const;
+        dimension used_area() const;
+        dimension free_area() const;
+        dimension reusable_area() const;
+        bool empty() const;
     public:
         bool insert(const size& aElementSize, rect& aResult);
+        void remove(const rect& aElement);
+        void reset();
+    private:
+        bool insert_free(const size& aElementSize, rect& aResult);
+        bool insert_skyline(const size& aElementSize, rect& aResult);
+        bool fits(std::size_t aSegment, const size& aElementSize, dimension& aY) const;
+        void add_free(const rect& aFree);
     private:
-        node::allocator_type iAllocator;
-        node iRoot;
+        size iDimensions;
+        skyline iSkyline;
+        free_list iFree;
+        dimension iUsedArea;
+        std::size_t iUsedCount;
     };
-}
\ No newline at end of file
+}
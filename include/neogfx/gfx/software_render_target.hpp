@@ -0,0 +1,81 @@
+// software_render_target.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/core/color.hpp>
+#include <neogfx/gfx/i_render_target.hpp>
+#include <neogfx/gfx/image.hpp>
+
+namespace neogfx
+{
+    // An offscreen render target backed by an in-memory RGBA8 framebuffer which is rasterized on the CPU;
+    // it does not require a GPU or a native window. It is drawn to directly with a graphics_context and is not
+    // a rendering engine: it has no texture, cannot host windows or widget trees and operations that need a
+    // rendering engine or a target texture (texture brushes, blur, entities) are unsupported.
+    class software_render_target : public i_render_target
+    {
+    public:
+        define_declared_event(TargetActivating, target_activating)
+        define_declared_event(TargetActivated, target_activated)
+        define_declared_event(TargetDeactivating, target_deactivating)
+        define_declared_event(TargetDeactivated, target_deactivated)
+    public:
+        struct no_target_texture : std::logic_error { no_target_texture() : std::logic_error("neogfx::software_render_target::no_target_texture") {} };
+    public:
+        software_render_target(const size& aExtents, dimension aDpiScaleFactor = 1.0, const color& aClearColor = color{ vec4{ 0.0, 0.0, 0.0, 0.0 } });
+        ~software_render_target();
+    public:
+        const i_image& image() const;
+        i_image& image();
+        dimension dpi_scale_factor() const;
+    public:
+        render_target_type target_type() const override;
+        void* target_handle() const override;
+        const i_texture& target_texture() const override;
+        size target_extents() const override;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const override;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem) override;
+        neogfx::logical_coordinates logical_coordinates() const override;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) override;
+    public:
+        bool target_active() const override;
+        void activate_target() const override;
+        void deactivate_target() const override;
+    public:
+        color read_pixel(const point& aPosition) const override;
+    public:
+        std::unique_ptr<i_rendering_context> create_graphics_context(blending_mode aBlendingMode = blending_mode::Default) const override;
+    public:
+        dimension horizontal_dpi() const override;
+        dimension vertical_dpi() const override;
+        dimension ppi() const override;
+        bool metrics_available() const override;
+        size extents() const override;
+        dimension em_size() const override;
+    private:
+        neogfx::image iImage;
+        dimension iDpiScaleFactor;
+        neogfx::logical_coordinate_system iLogicalCoordinateSystem;
+        std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
+        mutable bool iActive;
+    };
+}
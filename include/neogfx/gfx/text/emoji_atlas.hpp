@@ -37,6 +37,7 @@ namespace neogfx
     public:
         virtual bool is_emoji(char32_t aCodePoint) const;
         virtual bool is_emoji(const std::u32string& aCodePoints) const;
+        virtual const code_point_bitset& emoji_presence() const;
         virtual emoji_id emoji(char32_t aCodePoint, dimension aDesiredSize) const;
         virtual emoji_id emoji(const std::u32string& aCodePoints, dimension aDesiredSize = 64) const;
         virtual const i_texture& emoji_texture(emoji_id aId) const;
@@ -45,5 +46,6 @@ namespace neogfx
         std::unique_ptr<i_texture_atlas> iTextureAtlas;
         emojis iEmojis;
         mutable std::unordered_map<std::u32string, std::optional<emoji_id>> iEmojiMap;
+        code_point_bitset iEmojiPresence;
     };
 }
\ No newline at end of file
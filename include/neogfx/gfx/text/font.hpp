@@ -188,6 +188,9 @@ namespace neogfx
         point_size fixed_size(uint32_t aFixedSizeIndex) const;
     public:
         const i_glyph_texture& glyph_texture(const glyph& aGlyph) const;
+        const i_glyph_texture& distance_field_glyph_texture(const glyph& aGlyph) const;
+        dimension distance_field_scale() const;
+        dimension distance_field_spread() const;
     public:
         bool operator==(const font& aRhs) const;
         bool operator!=(const font& aRhs) const;
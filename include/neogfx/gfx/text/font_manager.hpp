@@ -21,17 +21,20 @@
 
 #include <neogfx/neogfx.hpp>
 #include <set>
+#include <map>
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include <neolib/jar.hpp>
 #include <neolib/string_ci.hpp>
 #include <neogfx/gfx/texture_atlas.hpp>
 #include <neogfx/gfx/text/emoji_atlas.hpp>
+#include <neogfx/gfx/text/glyph_text_cache.hpp>
 #include <neogfx/gfx/text/i_font_manager.hpp>
 
 namespace neogfx
 {
     class native_font;
+    class glyph_rasterizer;
 
     class fallback_font_info : public i_fallback_font_info
     {
@@ -91,8 +94,27 @@ namespace neogfx
     public:
         const i_texture_atlas& glyph_atlas() const override;
         i_texture_atlas& glyph_atlas() override;
+        const i_texture_atlas& distance_field_atlas() const override;
+        i_texture_atlas& distance_field_atlas() override;
         const i_emoji_atlas& emoji_atlas() const override;
         i_emoji_atlas& emoji_atlas() override;
+        const neogfx::glyph_text_cache& glyph_text_cache() const override;
+        neogfx::glyph_text_cache& glyph_text_cache() override;
+    public:
+        neogfx::glyph_rasterization glyph_rasterization() const override;
+        void set_glyph_rasterization(neogfx::glyph_rasterization aMode) override;
+        void prefetch_glyphs(const font& aFont, const std::u32string& aCodePoints) override;
+        void placeholder_glyph_drawn(const i_render_target& aTarget, const i_native_font_face& aFace, const glyph& aGlyph, const rect& aRect) override;
+        void invalidate_rasterized_glyphs() override;
+        void upload_rasterized_glyphs() override;
+    public:
+        dimension glyph_atlas_budget() const override;
+        void set_glyph_atlas_budget(dimension aArea) override;
+        void advance_glyph_use_generation() override;
+        void evict_glyphs() override;
+    private:
+        neogfx::glyph_rasterizer& glyph_rasterizer();
+        void forget_placeholder_glyphs(font_id aFaceId);
     private:
         i_native_font& find_font(const std::string& aFamilyName, const std::string& aStyleName, font::point_size aSize);
         i_native_font& find_best_font(const std::string& aFamilyName, neogfx::font_style aStyle, font::point_size aSize);
@@ -112,6 +134,12 @@ namespace neogfx
     private:
         id_cache iIdCache;
         texture_atlas iGlyphAtlas;
+        dimension iGlyphAtlasBudget;
+        texture_atlas iDistanceFieldAtlas;
         neogfx::emoji_atlas iEmojiAtlas;
+        neogfx::glyph_text_cache iGlyphTextCache;
+        neogfx::glyph_rasterization iGlyphRasterization;
+        std::unique_ptr<neogfx::glyph_rasterizer> iGlyphRasterizer;
+        std::map<std::pair<font_id, uint32_t>, std::vector<std::pair<const i_render_target*, rect>>> iPlaceholderGlyphs;
     };
 }
\ No newline at end of file
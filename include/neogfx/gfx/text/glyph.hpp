@@ -106,7 +106,8 @@ namespace neogfx
         {
             Underline = 0x01,
             Subpixel = 0x02,
-            Mnemonic = 0x04
+            Mnemonic = 0x04,
+            DistanceField = 0x08
         };
     public:
         typedef uint32_t value_type;
@@ -291,7 +292,13 @@ namespace neogfx
             if (iExtents == basic_size<float>{})
             {
                 auto const& ourFont = (aFont ? aFont : font_specified() ? font() : optional_font{});
-                if (has_font_glyph())
+                if (has_font_glyph() && distance_field())
+                {
+                    auto const& distanceFieldTexture = distance_field_glyph_texture(*ourFont);
+                    iExtents = size{ static_cast<float>(offset().cx + (distanceFieldTexture.placement().x + distanceFieldTexture.texture().extents().cx) * ourFont->distance_field_scale() - 
+                        ourFont->distance_field_spread()), ourFont->height() };
+                }
+                else if (has_font_glyph())
                     iExtents = size{ static_cast<float>(offset().cx + glyph_texture(*ourFont).placement().x + glyph_texture(*ourFont).texture().extents().cx), ourFont->height() };
                 else
                     iExtents = size{ advance().cx, ourFont && !is_emoji() ? ourFont->height() : advance().cx };
@@ -334,6 +341,14 @@ namespace neogfx
         { 
             iFlags = static_cast<flags_e>(aMnemonic ? iFlags | Mnemonic : iFlags & ~Mnemonic); 
         }
+        bool distance_field() const 
+        { 
+            return (iFlags & DistanceField) == DistanceField; 
+        }
+        void set_distance_field(bool aDistanceField) 
+        { 
+            iFlags = static_cast<flags_e>(aDistanceField ? iFlags | DistanceField : iFlags & ~DistanceField); 
+        }
         void kerning_adjust(float aAdjust) 
         { 
             iAdvance.cx += aAdjust; 
@@ -350,6 +365,14 @@ namespace neogfx
         {
             return aFont.glyph_texture(*this);
         }
+        const i_glyph_texture& distance_field_glyph_texture() const
+        {
+            return distance_field_glyph_texture(font());
+        }
+        const i_glyph_texture& distance_field_glyph_texture(const neogfx::font& aFont) const
+        {
+            return aFont.distance_field_glyph_texture(*this);
+        }
     private:
         character_type iType;
         value_type iValue;
@@ -0,0 +1,106 @@
+// glyph_text_cache.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <neogfx/gfx/text/glyph.hpp>
+
+namespace neogfx
+{
+    // Least recently used cache of shaped text (the result of graphics_context::to_glyph_text for a single font)
+    // so that text which has not changed since the last frame is not converted, classified and shaped again.
+    // Cached text refers to its fonts by id only (fonts are resolved from their ids when the text is used) so the
+    // cache does not keep fonts alive; entries are invalidated when any font they use is retired.
+    class glyph_text_cache
+    {
+    public:
+        static constexpr std::size_t DefaultMemoryBudget = 4u * 1024u * 1024u;
+        static constexpr std::size_t MaxTextLength = 1024u; // longer text is shaped without caching
+    public:
+        struct key
+        {
+            std::string text; // UTF-8 or, if utf32 is set, the bytes of the UTF-32 text
+            bool utf32;
+            font_id fontId;
+            font_style style;
+            bool subpixel;
+            bool distanceField;
+            std::optional<std::string> passwordMask;
+            std::optional<std::pair<bool, char>> mnemonic;
+            bool guiOrientation;
+
+            bool operator==(const key& aOther) const
+            {
+                return text == aOther.text && utf32 == aOther.utf32 && fontId == aOther.fontId && style == aOther.style &&
+                    subpixel == aOther.subpixel && distanceField == aOther.distanceField && passwordMask == aOther.passwordMask && mnemonic == aOther.mnemonic &&
+                    guiOrientation == aOther.guiOrientation;
+            }
+        };
+        struct statistics
+        {
+            uint64_t hits = 0u;
+            uint64_t misses = 0u;
+            uint64_t evictions = 0u;
+            std::size_t entries = 0u;
+            std::size_t bytes = 0u;
+        };
+    private:
+        struct key_hash
+        {
+            std::size_t operator()(const key& aKey) const;
+        };
+        struct entry
+        {
+            key cacheKey;
+            glyph_text text;
+            std::vector<font_id> fonts; // the key's font and any fallback fonts used
+            std::size_t bytes;
+        };
+        typedef std::list<entry> entry_list;
+        typedef std::unordered_map<key, entry_list::iterator, key_hash> entry_index;
+    public:
+        glyph_text_cache(std::size_t aMemoryBudget = DefaultMemoryBudget);
+        ~glyph_text_cache();
+    public:
+        static bool cacheable(std::size_t aTextLength);
+    public:
+        std::size_t memory_budget() const;
+        void set_memory_budget(std::size_t aMemoryBudget);
+        statistics stats() const;
+        void reset_stats();
+    public:
+        bool find(const key& aKey, glyph_text& aResult);
+        void insert(const key& aKey, const glyph_text& aText);
+        void invalidate(font_id aFontId);
+        void clear();
+    private:
+        void evict(std::size_t aMemoryBudget);
+    private:
+        mutable std::mutex iMutex;
+        std::size_t iMemoryBudget;
+        entry_list iEntries; // most recently used first
+        entry_index iIndex;
+        statistics iStats;
+    };
+}
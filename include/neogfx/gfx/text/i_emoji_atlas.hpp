@@ -28,11 +28,13 @@ namespace neogfx
     {
     public:
         typedef uint32_t emoji_id;
+        typedef std::vector<uint64_t> code_point_bitset;
     public:
         struct emoji_not_found : std::logic_error { emoji_not_found() : std::logic_error("neogfx::i_emoji_atlas::emoji_not_found") {} };
     public:
         virtual bool is_emoji(char32_t aCodePoint) const = 0;
         virtual bool is_emoji(const std::u32string& aCodePoints) const = 0;
+        virtual const code_point_bitset& emoji_presence() const = 0;
         virtual emoji_id emoji(char32_t aCodePoint, dimension aDesiredSize) const = 0;
         virtual emoji_id emoji(const std::u32string& aCodePoints, dimension aDesiredSize) const = 0;
         virtual const i_texture& emoji_texture(emoji_id aId) const = 0;
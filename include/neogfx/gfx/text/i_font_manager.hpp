@@ -30,8 +30,16 @@ namespace neogfx
     class i_native_font;
     class i_native_font_face;
 
+    class i_render_target;
     class i_texture_atlas;
     class i_emoji_atlas;
+    class glyph_text_cache;
+
+    enum class glyph_rasterization : uint32_t
+    {
+        BlockOnDemand,
+        RenderWhenReady
+    };
 
     class i_fallback_font_info
     {
@@ -80,7 +88,23 @@ namespace neogfx
     public:
         virtual const i_texture_atlas& glyph_atlas() const = 0;
         virtual i_texture_atlas& glyph_atlas() = 0;
+        virtual const i_texture_atlas& distance_field_atlas() const = 0;
+        virtual i_texture_atlas& distance_field_atlas() = 0;
         virtual const i_emoji_atlas& emoji_atlas() const = 0;
         virtual i_emoji_atlas& emoji_atlas() = 0;
+        virtual const neogfx::glyph_text_cache& glyph_text_cache() const = 0;
+        virtual neogfx::glyph_text_cache& glyph_text_cache() = 0;
+    public:
+        virtual neogfx::glyph_rasterization glyph_rasterization() const = 0;
+        virtual void set_glyph_rasterization(neogfx::glyph_rasterization aMode) = 0;
+        virtual void prefetch_glyphs(const font& aFont, const std::u32string& aCodePoints) = 0;
+        virtual void placeholder_glyph_drawn(const i_render_target& aTarget, const i_native_font_face& aFace, const glyph& aGlyph, const rect& aRect) = 0;
+        virtual void invalidate_rasterized_glyphs() = 0;
+        virtual void upload_rasterized_glyphs() = 0;
+    public:
+        virtual dimension glyph_atlas_budget() const = 0;
+        virtual void set_glyph_atlas_budget(dimension aArea) = 0;
+        virtual void advance_glyph_use_generation() = 0;
+        virtual void evict_glyphs() = 0;
     };
 }
\ No newline at end of file
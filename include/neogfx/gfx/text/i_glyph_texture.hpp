@@ -47,5 +47,6 @@ namespace neogfx
         virtual bool subpixel() const = 0;
         virtual const point& placement() const = 0;
         virtual glyph_pixel_mode pixel_mode() const = 0;
+        virtual bool placeholder() const = 0;
     };
 }
\ No newline at end of file
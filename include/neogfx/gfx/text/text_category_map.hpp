@@ -20,6 +20,8 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <array>
+#include <map>
 #include "glyph.hpp"
 #include "i_emoji_atlas.hpp"
 
@@ -1971,30 +1973,87 @@ namespace neogfx
             { 0x100001, text_category::Unknown },
             { 0x10FFFD, text_category::LTR }
         };
-    }
 
-    inline text_category get_text_category(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd)
-    {
-        char32_t ch = aCodePoint[0];
-        if (aEmojiAtlas.is_emoji(ch))
+        // Two-level lookup table expanded from text_category_MAP on first use: the code point space is split
+        // into 256 code point blocks and identical blocks (most of Unicode) share storage.
+        class text_category_table
+        {
+        public:
+            static constexpr uint32_t BlockBits = 8u;
+            static constexpr uint32_t BlockSize = 1u << BlockBits;
+            static constexpr uint32_t CodePointLimit = 0x110000u;
+        public:
+            static const text_category_table& instance()
+            {
+                static const text_category_table sTable;
+                return sTable;
+            }
+        private:
+            text_category_table()
+            {
+                std::map<std::array<text_category, BlockSize>, uint16_t> blockIds;
+                std::array<text_category, BlockSize> block;
+                auto const mapEnd = std::end(text_category_MAP);
+                auto range = std::begin(text_category_MAP);
+                for (uint32_t blockIndex = 0u; blockIndex < iIndex.size(); ++blockIndex)
+                {
+                    for (uint32_t offset = 0u; offset < BlockSize; ++offset)
+                    {
+                        auto const codePoint = (blockIndex << BlockBits) | offset;
+                        while (std::next(range) != mapEnd && std::next(range)->first <= codePoint)
+                            ++range;
+                        block[offset] = range->second;
+                    }
+                    auto existing = blockIds.find(block);
+                    if (existing == blockIds.end())
+                    {
+                        existing = blockIds.emplace(block, static_cast<uint16_t>(blockIds.size())).first;
+                        iBlocks.insert(iBlocks.end(), block.begin(), block.end());
+                    }
+                    iIndex[blockIndex] = existing->second;
+                }
+                iLatin1 = &iBlocks[static_cast<std::size_t>(iIndex[0]) << BlockBits];
+            }
+            text_category_table(const text_category_table&) = delete;
+        public:
+            text_category operator[](char32_t aCodePoint) const
+            {
+                if (aCodePoint < BlockSize)
+                    return iLatin1[aCodePoint];
+                if (aCodePoint >= CodePointLimit)
+                    return text_category::Unknown;
+                return iBlocks[(static_cast<std::size_t>(iIndex[aCodePoint >> BlockBits]) << BlockBits) | (aCodePoint & (BlockSize - 1u))];
+            }
+        private:
+            std::array<uint16_t, CodePointLimit / BlockSize> iIndex;
+            std::vector<text_category> iBlocks;
+            const text_category* iLatin1;
+        };
+
+        inline bool is_emoji(const i_emoji_atlas::code_point_bitset& aEmojiPresence, char32_t aCodePoint)
         {
-            if (aCodePoint + 1 == aCodePointEnd || aCodePoint[1] != 0xEF0E)
-                return text_category::Emoji;
-            return text_category::LTR;
+            auto const word = static_cast<std::size_t>(aCodePoint >> 6u);
+            return word < aEmojiPresence.size() && ((aEmojiPresence[word] >> (aCodePoint & 63u)) & 1u) != 0u;
         }
-        else if (ch == 0xFE0F || ch == 0xFE0E)
-            return text_category::Control;
-        const detail::text_category_MAP_VALUE_TYPE* rangeStart = std::lower_bound(
-            &detail::text_category_MAP[0], 
-            &detail::text_category_MAP[0] + sizeof(detail::text_category_MAP) / sizeof(detail::text_category_MAP[0]),
-            detail::text_category_MAP_VALUE_TYPE(ch, text_category::Unknown),
-            [](const detail::text_category_MAP_VALUE_TYPE& lhs, const detail::text_category_MAP_VALUE_TYPE& rhs) -> bool
+
+        inline text_category get_text_category(const text_category_table& aTable, const i_emoji_atlas::code_point_bitset& aEmojiPresence, const char32_t* aCodePoint, const char32_t* aCodePointEnd)
         {
-            return lhs.first < rhs.first;
-        });
-        if (rangeStart != &detail::text_category_MAP[0] && ch < rangeStart->first)
-            --rangeStart;
-        return rangeStart->second;
+            char32_t const ch = aCodePoint[0];
+            if (is_emoji(aEmojiPresence, ch))
+            {
+                if (aCodePoint + 1 == aCodePointEnd || aCodePoint[1] != 0xEF0E)
+                    return text_category::Emoji;
+                return text_category::LTR;
+            }
+            else if (ch == 0xFE0F || ch == 0xFE0E)
+                return text_category::Control;
+            return aTable[ch];
+        }
+    }
+
+    inline text_category get_text_category(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd)
+    {
+        return detail::get_text_category(detail::text_category_table::instance(), aEmojiAtlas.emoji_presence(), aCodePoint, aCodePointEnd);
     }
 
     inline text_category get_text_category(const i_emoji_atlas& aEmojiAtlas, char32_t aCodePoint)
@@ -2002,9 +2061,18 @@ namespace neogfx
         return get_text_category(aEmojiAtlas, &aCodePoint, &aCodePoint + 1);
     }
 
-    inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd, text_direction aExistingDirection)
+    // Classifies a whole run of code points; the table and emoji presence set are fetched once rather than per code point.
+    inline void classify(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePointBegin, const char32_t* aCodePointEnd, text_category* aResult)
+    {
+        auto const& table = detail::text_category_table::instance();
+        auto const& emojiPresence = aEmojiAtlas.emoji_presence();
+        for (auto codePoint = aCodePointBegin; codePoint != aCodePointEnd; ++codePoint)
+            *aResult++ = detail::get_text_category(table, emojiPresence, codePoint, aCodePointEnd);
+    }
+
+    inline text_direction get_text_direction(text_category aCategory, text_direction aExistingDirection)
     {
-        switch (get_text_category(aEmojiAtlas, aCodePoint, aCodePointEnd))
+        switch (aCategory)
         {
         case text_category::LTR:
             return text_direction::LTR;
@@ -2032,6 +2100,11 @@ namespace neogfx
         }
     }
 
+    inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, const char32_t* aCodePoint, const char32_t* aCodePointEnd, text_direction aExistingDirection)
+    {
+        return get_text_direction(get_text_category(aEmojiAtlas, aCodePoint, aCodePointEnd), aExistingDirection);
+    }
+
     inline text_direction get_text_direction(const i_emoji_atlas& aEmojiAtlas, char32_t aCodePoint, text_direction aExistingDirection)
     {
         return get_text_direction(aEmojiAtlas, &aCodePoint, &aCodePoint + 1, aExistingDirection);
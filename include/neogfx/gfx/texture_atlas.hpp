@@ -21,8 +21,6 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
-#include <set>
-#include <tuple>
 #include "i_texture_atlas.hpp"
 #include "i_texture_manager.hpp"
 #include "texture.hpp"
@@ -36,31 +34,7 @@ namespace neogfx
     class texture_atlas : public i_texture_atlas
     {
     private:
-        struct fragments
-        {
-            struct fragment_less_than
-            {
-                bool operator()(const rect& aLhs, const rect& aRhs) const
-                {
-                    return std::forward_as_tuple(aLhs.width() * aLhs.height(), aLhs.top_left()) <
-                        std::forward_as_tuple(aRhs.width() * aRhs.height(), aRhs.top_left());
-                }
-            };
-            rect_pack pack;
-            std::set<rect, fragment_less_than> used;
-            std::set<rect, fragment_less_than> freed; // todo: use this when bin pack is full
-            bool insert(const size& aSize, rect& aResult)
-            {
-                if (pack.insert(aSize, aResult))
-                {
-                    used.insert(aResult);
-                    return true;
-                }
-                else
-                    return false;
-            }
-        };
-        typedef std::pair<texture, fragments> page;
+        typedef std::pair<texture, rect_pack> page;
         typedef std::list<page> pages;
         typedef std::pair<pages::iterator, neogfx::sub_texture> entry;
         typedef std::unordered_map<texture_id, entry> entries;
@@ -72,6 +46,9 @@ namespace neogfx
         virtual i_sub_texture& create_sub_texture(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat = texture_data_format::RGBA);
         virtual i_sub_texture& create_sub_texture(const i_image& aImage);
         virtual void destroy_sub_texture(i_sub_texture& aSubTexture);
+    public:
+        virtual texture_atlas_stats stats() const;
+        virtual void compact();
     private:
         const size& page_size() const;
         pages::iterator create_page(dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat);
@@ -97,6 +97,7 @@ namespace neogfx
     public:
         void set_projection_matrix(const optional_mat44& aProjectionMatrix) override;
         void set_transformation_matrix(const optional_mat44& aTransformationMatrix) override;
+        void set_instanced(bool aInstanced) override;
     public:
         void prepare_uniforms(const i_rendering_context& aContext, i_shader_program& aProgram) override;
         void generate_code(const i_shader_program& aProgram, shader_language aLanguage, i_string& aOutput) const override;
@@ -106,6 +107,7 @@ namespace neogfx
     private:
         cache_uniform(uProjectionMatrix)
         cache_uniform(uTransformationMatrix)
+        cache_uniform(uInstanced)
         optional_logical_coordinates iLogicalCoordinates;
         optional_vec2 iOffset;
     };
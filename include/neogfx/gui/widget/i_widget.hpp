@@ -155,6 +155,8 @@ namespace neogfx
         virtual void set_opacity(double aOpacity) = 0;
         virtual double transparency() const = 0;
         virtual void set_transparency(double aTransparency) = 0;
+        virtual bool layer() const = 0;
+        virtual void set_layer(bool aLayer) = 0;
         virtual bool has_foreground_color() const = 0;
         virtual color foreground_color() const = 0;
         virtual void set_foreground_color(const optional_color& aForegroundColor = optional_color{}) = 0;
@@ -0,0 +1,118 @@
+// mapped_text_view.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <list>
+#include <unordered_map>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <neolib/timer.hpp>
+#include <neogfx/gfx/text/glyph.hpp>
+#include "scrollable_widget.hpp"
+
+namespace neogfx
+{
+    // Read-only viewer for documents too large to hold in a text_edit (e.g. log files of hundreds of MB).
+    // The file is memory mapped and a sparse line index is built in the background; only the lines near
+    // the viewport are shaped and the shaped lines are held in a bounded LRU cache.
+    class mapped_text_view : public scrollable_widget
+    {
+    public:
+        define_event(Opened, opened)
+        define_event(Closed, closed)
+        define_event(Indexed, indexed)
+    public:
+        typedef uint64_t line_index;
+        typedef uint64_t offset_type;
+    public:
+        static constexpr line_index LinesPerCheckpoint = 64u;
+        static constexpr std::size_t DefaultCachedLineLimit = 1024u;
+        static constexpr std::size_t DefaultLineLengthLimit = 16u * 1024u;
+    public:
+        struct failed_to_open_file : std::runtime_error { failed_to_open_file(const std::string& aPath) : std::runtime_error("neogfx::mapped_text_view::failed_to_open_file: " + aPath) {} };
+    private:
+        struct shaped_line
+        {
+            line_index line;
+            glyph_text text;
+            size extents;
+        };
+        typedef std::list<shaped_line> shaped_line_list;
+        typedef std::unordered_map<line_index, shaped_line_list::iterator> shaped_line_map;
+    public:
+        mapped_text_view(frame_style aFrameStyle = frame_style::SolidFrame);
+        mapped_text_view(i_widget& aParent, frame_style aFrameStyle = frame_style::SolidFrame);
+        mapped_text_view(i_layout& aLayout, frame_style aFrameStyle = frame_style::SolidFrame);
+        ~mapped_text_view();
+    public:
+        void open(const std::string& aPath);
+        void close();
+        bool is_open() const;
+        const std::string& path() const;
+        offset_type file_size() const;
+        bool indexing() const;
+        line_index indexed_lines() const;
+        line_index estimated_lines() const;
+        std::string line(line_index aLine) const;
+    public:
+        std::size_t cached_line_limit() const;
+        void set_cached_line_limit(std::size_t aLimit);
+        std::size_t line_length_limit() const;
+        void set_line_length_limit(std::size_t aLimit);
+    public:
+        void paint(i_graphics_context& aGraphicsContext) const override;
+    public:
+        void set_font(const optional_font& aFont) override;
+    public:
+        neogfx::scrolling_disposition scrolling_disposition() const override;
+    protected:
+        void update_scrollbar_visibility(usv_stage_e aStage) override;
+    private:
+        void init();
+        void index_lines();
+        void indexing_progress();
+        std::pair<const char*, const char*> line_bounds(line_index aLine) const;
+        const shaped_line& shape_line(i_graphics_context& aGraphicsContext, line_index aLine) const;
+        void clear_shaped_lines();
+        dimension line_height() const;
+    private:
+        std::string iPath;
+        boost::iostreams::mapped_file_source iFile;
+        mutable std::mutex iIndexMutex;
+        std::vector<offset_type> iCheckpoints;
+        std::atomic<line_index> iIndexedLines;
+        std::atomic<offset_type> iIndexedBytes;
+        std::atomic<bool> iIndexing;
+        std::atomic<bool> iStopIndexing;
+        std::thread iIndexer;
+        neolib::callback_timer iProgressUpdater;
+        line_index iReportedLines;
+        mutable shaped_line_list iShapedLines;
+        mutable shaped_line_map iShapedLineMap;
+        mutable dimension iWidestLine;
+        dimension iReportedWidestLine;
+        std::size_t iCachedLineLimit;
+        std::size_t iLineLengthLimit;
+        sink iSink;
+    };
+}
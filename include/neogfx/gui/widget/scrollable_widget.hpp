@@ -97,8 +97,11 @@ namespace neogfx
     protected:
         virtual void update_scrollbar_visibility();
         virtual void update_scrollbar_visibility(usv_stage_e aStage);
+        virtual bool can_scroll_by_copy() const;
     protected:
         void init_scrollbars();
+    private:
+        bool scroll_by_copy(const point& aDelta);
     private:
         scrollbar iVerticalScrollbar;
         scrollbar iHorizontalScrollbar;
@@ -20,6 +20,8 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <deque>
+#include <set>
 #include <boost/pool/pool_alloc.hpp>
 #include <neolib/tag_array.hpp>
 #include <neolib/segmented_array.hpp>
@@ -375,17 +377,19 @@ namespace neogfx
                         dimension cy = glyph.extents(glyphFont).cy;
                         if (i == glyphsStartIndex || cy != previousHeight)
                         {
-                            iHeights[i] = cy;
+                            iHeights[i - glyphsStartIndex] = cy;
                             previousHeight = cy;
                         }
                     }
-                    iHeights[end_index()] = 0.0;
+                    iHeights[glyphsEndIndex - glyphsStartIndex] = 0.0;
                 }
+                // heights are keyed by paragraph relative glyph index so they survive edits to earlier paragraphs
+                auto const startIndex = start_index();
                 dimension result = 0.0;
-                auto start = iHeights.lower_bound(aStart - parent().iGlyphs.begin());
-                if (start != iHeights.begin() && aStart < parent().iGlyphs.begin() + start->first)
+                auto start = iHeights.lower_bound((aStart - parent().iGlyphs.begin()) - startIndex);
+                if (start != iHeights.begin() && aStart < parent().iGlyphs.begin() + startIndex + start->first)
                     --start;
-                auto stop = iHeights.lower_bound(aEnd - parent().iGlyphs.begin());
+                auto stop = iHeights.lower_bound((aEnd - parent().iGlyphs.begin()) - startIndex);
                 if (start == stop && stop != iHeights.end())
                     ++stop;
                 for (auto i = start; i != stop; ++i)
@@ -399,32 +403,100 @@ namespace neogfx
         };
         struct glyph_line
         {
-            std::pair<glyph_paragraphs::size_type, glyph_paragraphs::const_iterator> paragraph;
-            std::pair<document_glyphs::size_type, document_glyphs::const_iterator> lineStart;
-            std::pair<document_glyphs::size_type, document_glyphs::const_iterator> lineEnd;
+            glyph_paragraphs::size_type paragraph;
+            document_glyphs::size_type lineStart;
+            document_glyphs::size_type lineEnd;
             coordinate ypos;
             size extents;
         };
         typedef std::vector<glyph_line> glyph_lines;
         class glyph_column : public column_info
         {
+        private:
+            // an edit moves every line after it; rather than updating all of those lines the move is recorded
+            // and applied to the lines from 'from' onwards as they are read (see line())
+            struct line_shift
+            {
+                glyph_lines::size_type from;
+                std::ptrdiff_t paragraphs;
+                std::ptrdiff_t glyphs;
+                coordinate y;
+            };
         public:
             glyph_column() :
-                iWidth(0.0)
+                iShift{}, iWidth(0.0)
             {
             }
         public:
             const glyph_lines& lines() const { return iLines; }
-            glyph_lines& lines() { return iLines; }
+            glyph_line line(glyph_lines::const_iterator aLine) const { return line(static_cast<glyph_lines::size_type>(aLine - iLines.begin())); }
+            glyph_lines::const_iterator line_at_ypos(coordinate aYpos) const;
+            glyph_lines::const_iterator line_at_glyph(document_glyphs::size_type aGlyph) const;
+            glyph_lines::const_iterator line_at_paragraph(glyph_paragraphs::size_type aParagraph) const;
+            dimension widest_line() const { return iLineWidths.empty() ? 0.0 : *iLineWidths.rbegin(); }
+            void set_lines(glyph_lines&& aLines);
+            void replace_lines(glyph_lines::const_iterator aFirst, glyph_lines::const_iterator aLast, const glyph_lines& aNewLines,
+                std::ptrdiff_t aParagraphs, std::ptrdiff_t aGlyphs, coordinate aY);
+            void clear_lines();
             dimension width() const { return iWidth; }
             void set_width(dimension aWidth) { iWidth = aWidth; }
+        private:
+            glyph_line line(glyph_lines::size_type aLine) const;
+            bool shifted() const { return iShift.paragraphs != 0 || iShift.glyphs != 0 || iShift.y != 0.0; }
+            void apply_shift(glyph_lines::size_type aFirst, glyph_lines::size_type aLast, std::ptrdiff_t aParagraphs, std::ptrdiff_t aGlyphs, coordinate aY);
+            void shift_lines(glyph_lines::size_type aFrom, std::ptrdiff_t aParagraphs, std::ptrdiff_t aGlyphs, coordinate aY);
         private:
             glyph_lines iLines;
+            line_shift iShift;
+            std::multiset<dimension> iLineWidths;
             dimension iWidth;
         };
         typedef std::vector<glyph_column> glyph_columns;
+        struct paragraph_edit
+        {
+            glyph_paragraphs::size_type firstParagraph;
+            glyph_paragraphs::size_type oldParagraphs;
+            glyph_paragraphs::size_type newParagraphs;
+            document_glyphs::size_type oldGlyphs;
+            document_glyphs::size_type newGlyphs;
+        };
+        struct line_layout
+        {
+            dimension availableWidth;
+            dimension availableHeight;
+            bool verticalScrollbar;
+            bool horizontalScrollbar;
+            dimension trailingHeight;
+        };
     public:
         typedef document_text::size_type position_type;
+    private:
+        struct text_operation
+        {
+            enum type_e
+            {
+                Insert,
+                Delete
+            };
+            typedef std::vector<std::pair<document_text::tag_type, std::u32string>> run_list;
+            type_e type;
+            position_type position;
+            run_list runs;
+            position_type length() const
+            {
+                position_type result = 0;
+                for (auto const& run : runs)
+                    result += run.second.size();
+                return result;
+            }
+        };
+        struct undo_group
+        {
+            std::vector<text_operation> operations;
+            std::size_t memory;
+        };
+        typedef std::deque<undo_group> undo_stack;
+        static constexpr std::size_t DefaultUndoMemoryLimit = 16u * 1024u * 1024u;
     public:
         struct bad_column_index : std::logic_error { bad_column_index() : std::logic_error("neogfx::text_edit::bad_column_index") {} }; 
         // text_edit
@@ -515,6 +587,9 @@ namespace neogfx
         std::size_t insert_text(const std::string& aText, bool aMoveCursor = false);
         std::size_t insert_text(const std::string& aText, const style& aStyle, bool aMoveCursor = false);
         void delete_text(position_type aStart, position_type aEnd);
+        std::size_t undo_memory_limit() const;
+        void set_undo_memory_limit(std::size_t aLimit);
+        void clear_undo();
         std::size_t columns() const;
         void set_columns(std::size_t aColumnCount);
         void remove_columns();
@@ -558,6 +633,10 @@ namespace neogfx
         std::size_t do_insert_text(const std::string& aText, const style& aStyle, bool aMoveCursor, bool aClearFirst);
         void delete_any_selection();
         void notify_text_changed();
+        text_operation::run_list text_runs(position_type aStart, position_type aEnd) const;
+        void record(text_operation&& aOperation);
+        bool coalesce(const text_operation& aOperation);
+        void apply(const text_operation& aOperation, bool aUndo);
         std::pair<position_type, position_type> related_glyphs(position_type aGlyphPosition) const;
         bool same_paragraph(position_type aFirstGlyphPos, position_type aSecondGlyphPos) const;
         glyph_paragraphs::const_iterator character_to_paragraph(position_type aCharacterPos) const;
@@ -565,8 +644,11 @@ namespace neogfx
         document_glyphs::const_iterator to_glyph(document_text::const_iterator aWhere) const;
         std::pair<document_text::size_type, document_text::size_type> from_glyph(document_glyphs::const_iterator aWhere) const;
         void refresh_paragraph(document_text::const_iterator aWhere, ptrdiff_t aDelta);
+        std::pair<glyph_paragraphs::size_type, document_glyphs::size_type> shape_paragraphs(document_text::const_iterator aStart, document_text::const_iterator aEnd, document_glyphs::size_type aGlyphPosition, glyph_paragraphs::const_iterator aNextParagraph);
         void refresh_columns();
         void refresh_lines();
+        bool refresh_lines(const paragraph_edit& aEdit);
+        void layout_paragraph(glyph_paragraphs::iterator aParagraph, glyph_lines& aLines, point& aPosition, dimension aAvailableWidth);
         void animate();
         void update_cursor();
         void make_cursor_visible(bool aForcePreviewScroll = false);
@@ -584,13 +666,14 @@ namespace neogfx
         mutable neogfx::cursor iCursor;
         style_list iStyles;
         std::u32string iNormalizedTextBuffer;
-        document_text iPreviousText;
         document_text iText;
         mutable std::optional<std::string> iUtf8TextCache;
         document_glyphs iGlyphs;
         glyph_paragraphs iGlyphParagraphs;
         glyph_columns iGlyphColumns;
         size iTextExtents;
+        std::optional<paragraph_edit> iParagraphEdit;
+        std::optional<line_layout> iLineLayout;
         uint64_t iCursorAnimationStartTime;
         typedef std::pair<position_type, position_type> find_span;
         typedef std::map<
@@ -614,6 +697,12 @@ namespace neogfx
         uint32_t iSuppressTextChangedNotification;
         uint32_t iWantedToNotfiyTextChanged;
         bool iOutOfMemory;
+        undo_stack iUndoStack;
+        undo_stack iRedoStack;
+        std::size_t iUndoMemory;
+        std::size_t iUndoMemoryLimit;
+        bool iJoinUndoGroup;
+        bool iCoalesceUndo;
     public:
         define_property(property_category::other, bool, ReadOnly, read_only, false)
         define_property(property_category::other, bool, WordWrap, word_wrap, iType == MultiLine)
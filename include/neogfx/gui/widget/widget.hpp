@@ -23,6 +23,7 @@
 #include <neolib/timer.hpp>
 #include <neogfx/core/object.hpp>
 #include <neogfx/core/property.hpp>
+#include <neogfx/gfx/texture.hpp>
 #include <neogfx/gui/layout/layout_item.hpp>
 #include <neogfx/gui/widget/i_widget.hpp>
 
@@ -188,6 +189,8 @@ namespace neogfx
         void set_opacity(double aOpacity) override;
         double transparency() const override;
         void set_transparency(double aTransparency) override;
+        bool layer() const override;
+        void set_layer(bool aLayer) override;
         bool has_foreground_color() const override;
         color foreground_color() const override;
         void set_foreground_color(const optional_color& aForegroundColor = optional_color{}) override;
@@ -248,6 +251,8 @@ namespace neogfx
     public:
         const i_widget& widget_for_mouse_event(const point& aPosition, bool aForHitTest = false) const override;
         i_widget& widget_for_mouse_event(const point& aPosition, bool aForHitTest = false) override;
+    private:
+        void render_layer(i_graphics_context& aGraphicsContext) const;
         // helpers
     public:
         using i_widget::set_size_policy;
@@ -273,6 +278,9 @@ namespace neogfx
         mutable std::pair<optional_rect, optional_rect> iDefaultClipRect;
         mutable optional_point iOrigin;
         optional_point iCapturePosition;
+        mutable optional_texture iLayerTexture;
+        mutable optional_rect iLayerClipRect;
+        mutable bool iLayerDirty;
         // properties / anchors
     public:
         define_property(property_category::hard_geometry, optional_logical_coordinate_system, LogicalCoordinateSystem, logical_coordinate_system)
@@ -280,6 +288,7 @@ namespace neogfx
         define_property(property_category::other_appearance, bool, Enabled, enabled, true)
         define_property(property_category::other, neogfx::focus_policy, FocusPolicy, focus_policy, neogfx::focus_policy::NoFocus)
         define_property(property_category::other_appearance, double, Opacity, opacity, 1.0)
+        define_property(property_category::other_appearance, bool, Layer, layer, false)
         define_property(property_category::color, optional_color, ForegroundColor, foreground_color)
         define_property(property_category::color, optional_color, BackgroundColor, background_color)
         define_property(property_category::font, optional_font, Font, font)
@@ -26,6 +26,7 @@
 #include <neogfx/core/event.hpp>
 #include <neogfx/gui/window/window_bits.hpp>
 #include <neogfx/gfx/primitives.hpp>
+#include <neogfx/gfx/damage_region.hpp>
 #include "mouse.hpp"
 
 namespace neogfx
@@ -85,10 +86,14 @@ namespace neogfx
         virtual void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) = 0;
         virtual void layout_surface() = 0;
         virtual void invalidate_surface(const rect& aInvalidatedRect, bool aInternal = true) = 0;
+        virtual void scroll_surface(const rect& aArea, const point& aDelta) = 0;
         virtual bool has_invalidated_area() const = 0;
         virtual const rect& invalidated_area() const = 0;
+        virtual const damage_region& invalidated_region() const = 0;
         virtual rect validate() = 0;
         virtual double rendering_priority() const = 0;
+        virtual uint64_t repainted_pixels() const = 0;
+        virtual uint64_t presented_pixels() const = 0;
         virtual void render_surface() = 0;
         virtual void pause_rendering() = 0;
         virtual void resume_rendering() = 0;
@@ -67,10 +67,14 @@ namespace neogfx
         void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates) override;
         void layout_surface() override;
         void invalidate_surface(const rect& aInvalidatedRect, bool aInternal = true) override;
+        void scroll_surface(const rect& aArea, const point& aDelta) override;
         bool has_invalidated_area() const override;
         const rect& invalidated_area() const override;
+        const damage_region& invalidated_region() const override;
         rect validate() override;
         double rendering_priority() const override;
+        uint64_t repainted_pixels() const override;
+        uint64_t presented_pixels() const override;
         void render_surface() override;
         void pause_rendering() override;
         void resume_rendering() override;
@@ -156,5 +160,6 @@ namespace neogfx
         std::optional<char32_t> iSurrogatePairPart;
         i_widget* iCapturingWidget;
         i_widget* iClickedWidget;
+        mutable const rect* iRenderingArea;
     };
 }
\ No newline at end of file
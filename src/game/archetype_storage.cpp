@@ -0,0 +1,329 @@
+// archetype_storage.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <algorithm>
+#include <neogfx/game/archetype_storage.hpp>
+
+namespace neogfx::game
+{
+    namespace
+    {
+        std::vector<component_id> signature_key(const archetype_table::signature_t& aSignature)
+        {
+            std::vector<component_id> key;
+            for (auto c : aSignature)
+                key.push_back(c->id);
+            return key;
+        }
+    }
+
+    archetype_table::archetype_table(const signature_t& aSignature) :
+        iSignature{ aSignature }, iChunkCapacity{ 0u }, iChunkBlocks{ 0u }, iSize{ 0u }
+    {
+        std::size_t rowSize = sizeof(entity_id);
+        for (auto c : iSignature)
+            rowSize += c->size;
+        iChunkCapacity = std::max<std::size_t>(ChunkSize / rowSize, 1u);
+        auto layout = [&]()
+        {
+            iColumnOffsets.clear();
+            std::size_t offset = sizeof(entity_id) * iChunkCapacity;
+            for (auto c : iSignature)
+            {
+                offset = (offset + c->alignment - 1u) / c->alignment * c->alignment;
+                iColumnOffsets.push_back(offset);
+                offset += c->size * iChunkCapacity;
+            }
+            return offset;
+        };
+        // alignment padding may push the columns past the end of the chunk
+        while (layout() > ChunkSize && iChunkCapacity > 1u)
+            --iChunkCapacity;
+        iChunkBlocks = (layout() + sizeof(block) - 1u) / sizeof(block);
+    }
+
+    archetype_table::~archetype_table()
+    {
+        for (row_t row = 0; row < iSize; ++row)
+            for (std::size_t c = 0; c < iSignature.size(); ++c)
+                iSignature[c]->destroy(element(row, c));
+    }
+
+    const archetype_table::signature_t& archetype_table::signature() const
+    {
+        return iSignature;
+    }
+
+    bool archetype_table::has_column(const component_id& aComponentId) const
+    {
+        auto existing = std::lower_bound(iSignature.begin(), iSignature.end(), aComponentId,
+            [](const component_column* aColumn, const component_id& aId) { return aColumn->id < aId; });
+        return existing != iSignature.end() && (*existing)->id == aComponentId;
+    }
+
+    std::size_t archetype_table::column_index(const component_id& aComponentId) const
+    {
+        auto existing = std::lower_bound(iSignature.begin(), iSignature.end(), aComponentId,
+            [](const component_column* aColumn, const component_id& aId) { return aColumn->id < aId; });
+        if (existing == iSignature.end() || (*existing)->id != aComponentId)
+            throw column_not_found();
+        return static_cast<std::size_t>(std::distance(iSignature.begin(), existing));
+    }
+
+    bool archetype_table::contains(const std::vector<component_id>& aComponentIds) const
+    {
+        return std::all_of(aComponentIds.begin(), aComponentIds.end(), [this](const component_id& aId) { return has_column(aId); });
+    }
+
+    std::size_t archetype_table::chunk_capacity() const
+    {
+        return iChunkCapacity;
+    }
+
+    std::size_t archetype_table::chunk_count() const
+    {
+        return (iSize + iChunkCapacity - 1u) / iChunkCapacity;
+    }
+
+    std::size_t archetype_table::size() const
+    {
+        return iSize;
+    }
+
+    std::size_t archetype_table::chunk_size(std::size_t aChunk) const
+    {
+        return std::min(iChunkCapacity, iSize - aChunk * iChunkCapacity);
+    }
+
+    const entity_id* archetype_table::entities(std::size_t aChunk) const
+    {
+        return reinterpret_cast<const entity_id*>(iChunks[aChunk].get());
+    }
+
+    entity_id archetype_table::entity(row_t aRow) const
+    {
+        return entities(aRow / iChunkCapacity)[aRow % iChunkCapacity];
+    }
+
+    void* archetype_table::column(std::size_t aChunk, std::size_t aColumn) const
+    {
+        return reinterpret_cast<std::byte*>(iChunks[aChunk].get()) + iColumnOffsets[aColumn];
+    }
+
+    void* archetype_table::element(row_t aRow, std::size_t aColumn) const
+    {
+        return static_cast<std::byte*>(column(aRow / iChunkCapacity, aColumn)) + (aRow % iChunkCapacity) * iSignature[aColumn]->size;
+    }
+
+    void archetype_table::reserve(std::size_t aRows)
+    {
+        while (iChunks.size() * iChunkCapacity < aRows)
+            iChunks.push_back(chunk{ new block[iChunkBlocks] });
+    }
+
+    archetype_table::row_t archetype_table::append(entity_id aEntity)
+    {
+        reserve(iSize + 1u);
+        auto const row = iSize++;
+        const_cast<entity_id*>(entities(row / iChunkCapacity))[row % iChunkCapacity] = aEntity;
+        return row;
+    }
+
+    entity_id archetype_table::remove(row_t aRow, bool aDestroyData)
+    {
+        if (aDestroyData)
+            for (std::size_t c = 0; c < iSignature.size(); ++c)
+                iSignature[c]->destroy(element(aRow, c));
+        auto const last = iSize - 1u;
+        entity_id moved = null_entity;
+        if (aRow != last)
+        {
+            for (std::size_t c = 0; c < iSignature.size(); ++c)
+            {
+                iSignature[c]->move_construct(element(aRow, c), element(last, c));
+                iSignature[c]->destroy(element(last, c));
+            }
+            moved = entity(last);
+            const_cast<entity_id*>(entities(aRow / iChunkCapacity))[aRow % iChunkCapacity] = moved;
+        }
+        --iSize;
+        // keep one spare chunk so that an entity moving back and forth does not thrash the allocator
+        while (iChunks.size() > chunk_count() + 1u)
+            iChunks.pop_back();
+        return moved;
+    }
+
+    archetype_table* archetype_table::add_edge(const component_id& aComponentId) const
+    {
+        auto existing = iAddEdges.find(aComponentId);
+        return existing != iAddEdges.end() ? existing->second : nullptr;
+    }
+
+    void archetype_table::set_add_edge(const component_id& aComponentId, archetype_table& aTable)
+    {
+        iAddEdges[aComponentId] = &aTable;
+    }
+
+    archetype_table* archetype_table::remove_edge(const component_id& aComponentId) const
+    {
+        auto existing = iRemoveEdges.find(aComponentId);
+        return existing != iRemoveEdges.end() ? existing->second : nullptr;
+    }
+
+    void archetype_table::set_remove_edge(const component_id& aComponentId, archetype_table& aTable)
+    {
+        iRemoveEdges[aComponentId] = &aTable;
+    }
+
+    archetype_storage::archetype_storage()
+    {
+    }
+
+    archetype_storage::~archetype_storage()
+    {
+        clear();
+    }
+
+    std::recursive_mutex& archetype_storage::mutex() const
+    {
+        return iMutex;
+    }
+
+    const archetype_storage::tables_t& archetype_storage::tables() const
+    {
+        return iTables;
+    }
+
+    bool archetype_storage::has_entity(entity_id aEntity) const
+    {
+        return aEntity < iLocations.size() && iLocations[aEntity].table != nullptr;
+    }
+
+    const archetype_storage::location& archetype_storage::entity_location(entity_id aEntity) const
+    {
+        if (!has_entity(aEntity))
+            throw entity_record_not_found();
+        return iLocations[aEntity];
+    }
+
+    void archetype_storage::destroy_entity(entity_id aEntity)
+    {
+        std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+        if (!has_entity(aEntity))
+            return;
+        auto& l = iLocations[aEntity];
+        relocate_last(*l.table, l.table->remove(l.row), l.row);
+        l = location{};
+    }
+
+    void archetype_storage::clear()
+    {
+        std::scoped_lock<std::recursive_mutex> lock{ mutex() };
+        iTables.clear();
+        iLocations.clear();
+    }
+
+    archetype_table& archetype_storage::table(const archetype_table::signature_t& aSignature)
+    {
+        auto key = signature_key(aSignature);
+        auto existing = iTables.find(key);
+        if (existing != iTables.end())
+            return *existing->second;
+        return *iTables.emplace(std::move(key), std::make_unique<archetype_table>(aSignature)).first->second;
+    }
+
+    archetype_table& archetype_storage::add_table(entity_id aEntity, const component_column& aColumn)
+    {
+        if (!has_entity(aEntity))
+            return table(archetype_table::signature_t{ &aColumn });
+        auto& from = *iLocations[aEntity].table;
+        if (auto existing = from.add_edge(aColumn.id))
+            return *existing;
+        auto signature = from.signature();
+        signature.insert(std::upper_bound(signature.begin(), signature.end(), &aColumn,
+            [](const component_column* aLhs, const component_column* aRhs) { return aLhs->id < aRhs->id; }), &aColumn);
+        auto& to = table(signature);
+        from.set_add_edge(aColumn.id, to);
+        to.set_remove_edge(aColumn.id, from);
+        return to;
+    }
+
+    archetype_table& archetype_storage::remove_table(archetype_table& aFrom, const component_column& aColumn)
+    {
+        if (auto existing = aFrom.remove_edge(aColumn.id))
+            return *existing;
+        auto signature = aFrom.signature();
+        signature.erase(signature.begin() + aFrom.column_index(aColumn.id));
+        auto& to = table(signature);
+        aFrom.set_remove_edge(aColumn.id, to);
+        to.set_add_edge(aColumn.id, aFrom);
+        return to;
+    }
+
+    archetype_storage::location& archetype_storage::move_entity(entity_id aEntity, archetype_table& aTo, const std::optional<component_id>& aDestroyed)
+    {
+        if (iLocations.size() <= aEntity)
+            iLocations.resize(aEntity + 1u, location{});
+        auto& l = iLocations[aEntity];
+        auto const toRow = aTo.append(aEntity);
+        if (l.table != nullptr)
+        {
+            auto& from = *l.table;
+            for (std::size_t c = 0; c < from.signature().size(); ++c)
+            {
+                auto const& column = *from.signature()[c];
+                if (aDestroyed == column.id)
+                    continue;
+                if (aTo.has_column(column.id))
+                    column.move_construct(aTo.element(toRow, aTo.column_index(column.id)), from.element(l.row, c));
+                column.destroy(from.element(l.row, c));
+            }
+            relocate_last(from, from.remove(l.row, false), l.row);
+        }
+        l = location{ &aTo, toRow };
+        return l;
+    }
+
+    void archetype_storage::move_entities(const std::vector<entity_id>& aEntities, const std::function<archetype_table&(entity_id)>& aTarget,
+        const std::function<void(archetype_table&, archetype_table::row_t)>& aConstruct)
+    {
+        // entities sharing a source table share a target table so each group is moved with a single table lookup
+        // and a single reservation
+        std::map<archetype_table*, std::vector<entity_id>> groups;
+        for (auto e : aEntities)
+            groups[has_entity(e) ? iLocations[e].table : nullptr].push_back(e);
+        for (auto const& group : groups)
+        {
+            auto& to = aTarget(group.second[0]);
+            to.reserve(to.size() + group.second.size());
+            for (auto e : group.second)
+            {
+                auto const& l = move_entity(e, to);
+                aConstruct(*l.table, l.row);
+            }
+        }
+    }
+
+    void archetype_storage::relocate_last(archetype_table& aTable, entity_id aMoved, archetype_table::row_t aRow)
+    {
+        if (aMoved != null_entity)
+            iLocations[aMoved] = location{ &aTable, aRow };
+    }
+}
@@ -0,0 +1,250 @@
+// collision_detector.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/game/ecs.hpp>
+#include <neogfx/game/ecs_helpers.hpp>
+#include <neogfx/game/broadphase_collider.hpp>
+#include <neogfx/game/mesh_filter.hpp>
+#include <neogfx/game/rigid_body.hpp>
+#include <neogfx/game/collision_detector.hpp>
+
+namespace neogfx::game
+{
+    namespace
+    {
+        std::optional<aabb> bounding_box(const mesh_filter& aFilter, const rigid_body* aRigidBody)
+        {
+            auto const* mesh = aFilter.mesh != std::nullopt ? &*aFilter.mesh : aFilter.sharedMesh.ptr;
+            if (mesh == nullptr || mesh->vertices.empty())
+                return {};
+            auto const transformation = (aFilter.transformation != std::nullopt ? *aFilter.transformation : mat44::identity()) *
+                (aRigidBody != nullptr ? to_transformation_matrix(*aRigidBody) : mat44::identity());
+            auto const first = transformation * mesh->vertices[0];
+            aabb result{ first, first };
+            for (auto const& v : mesh->vertices)
+            {
+                auto const transformed = transformation * v;
+                result.min = result.min.min(transformed);
+                result.max = result.max.max(transformed);
+            }
+            return result;
+        }
+    }
+
+    collision_detector::collision_detector(game::i_ecs& aEcs) :
+        system{ aEcs }, iQuery{ 0u }, iStatistics{},
+        iNotifier{ service<neolib::async_task>(), [this](neolib::callback_timer& aTimer)
+        {
+            aTimer.again();
+            notify_collisions();
+        }, 10, true }
+    {
+        Collision.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
+        read_components().insert(rigid_body::meta::id());
+        read_components().insert(mesh_filter::meta::id());
+        write_components().insert(broadphase_collider::meta::id());
+        iSink += ecs().entity_destroyed([this](entity_id aEntity)
+        {
+            std::scoped_lock<std::mutex> lock{ iMutex };
+            iDestroyed.push_back(aEntity);
+            // the entity's id can be recycled so undelivered collisions involving it must not be reported
+            iPendingCollisions.erase(std::remove_if(iPendingCollisions.begin(), iPendingCollisions.end(), 
+                [aEntity](const std::pair<entity_id, entity_id>& aCollision) { return aCollision.first == aEntity || aCollision.second == aEntity; }), 
+                iPendingCollisions.end());
+        });
+    }
+
+    collision_detector::~collision_detector()
+    {
+    }
+
+    const system_id& collision_detector::id() const
+    {
+        return meta::id();
+    }
+
+    const i_string& collision_detector::name() const
+    {
+        return meta::name();
+    }
+
+    void collision_detector::apply()
+    {
+        if (paused())
+            return;
+        if (!ecs().component_instantiated<broadphase_collider>() || !ecs().component_instantiated<mesh_filter>())
+            return;
+
+        auto const updateStart = std::chrono::steady_clock::now();
+        remove_destroyed();
+
+        statistics latest{};
+        iDynamic.clear();
+        iCollisions.clear();
+        {
+            component_scoped_lock<broadphase_collider> lgColliders{ ecs() };
+            component_scoped_lock<mesh_filter> lgFilters{ ecs() };
+            auto& colliders = ecs().component<broadphase_collider>();
+            auto const& filters = ecs().component<mesh_filter>();
+            auto const* rigidBodies = ecs().component_instantiated<rigid_body>() ? &ecs().component<rigid_body>() : nullptr;
+            std::optional<component_scoped_lock<rigid_body>> lgRigidBodies;
+            if (rigidBodies != nullptr)
+                lgRigidBodies.emplace(ecs());
+
+            auto const liveColliders = colliders.live_records();
+            for (auto c = liveColliders.begin(); c != liveColliders.end(); ++c)
+            {
+                auto const entity = c.entity();
+                auto& collider = *c;
+                auto& t = tracking(entity);
+                bool const isStatic = rigidBodies == nullptr || !rigidBodies->has_entity_record(entity);
+                if (t.inTree && t.isStatic != isStatic)
+                    untrack(entity);
+                t.mask = collider.mask;
+                if (isStatic)
+                {
+                    ++latest.staticColliders;
+                    if (t.inTree)
+                        continue;
+                }
+                if (!filters.has_entity_record(entity))
+                {
+                    untrack(entity);
+                    continue;
+                }
+                auto const bounds = bounding_box(filters.entity_record(entity), isStatic ? nullptr : &rigidBodies->entity_record(entity));
+                if (bounds == std::nullopt)
+                {
+                    untrack(entity);
+                    continue;
+                }
+                if (!t.inTree)
+                    tree(isStatic).insert(entity, *bounds);
+                else
+                    tree(isStatic).update(entity, t.bounds, *bounds);
+                t.inTree = true;
+                t.isStatic = isStatic;
+                t.bounds = *bounds;
+                collider.previousAabb = collider.currentAabb;
+                collider.currentAabb = *bounds;
+                if (!isStatic)
+                    iDynamic.push_back(entity);
+            }
+            latest.dynamicColliders = static_cast<uint32_t>(iDynamic.size());
+            latest.treeNodes = iDynamicTree.count() + iStaticTree.count();
+            latest.treeDepth = std::max(iDynamicTree.depth(), iStaticTree.depth());
+
+            auto const pairStart = std::chrono::steady_clock::now();
+            latest.treeUpdateTime = std::chrono::duration_cast<std::chrono::nanoseconds>(pairStart - updateStart);
+            for (auto candidate : iDynamic)
+            {
+                auto const& candidateTracking = iTracked[candidate];
+                // an entity can be in more than one leaf so each query is stamped to report each pair only once
+                if (++iQuery == 0u)
+                {
+                    for (auto& t : iTracked)
+                        t.query = 0u;
+                    iQuery = 1u;
+                }
+                auto const visitor = [&](bool aStatic)
+                {
+                    return [&, aStatic](const tree_type::object& aHit)
+                    {
+                        if (aHit.id == candidate || (!aStatic && aHit.id < candidate))
+                            return;
+                        auto& hitTracking = iTracked[aHit.id];
+                        if (hitTracking.query == iQuery)
+                            return;
+                        hitTracking.query = iQuery;
+                        ++latest.candidatePairs;
+                        if ((candidateTracking.mask & hitTracking.mask) != 0u || !colliders.has_entity_record(aHit.id))
+                            return;
+                        ++latest.collisionPairs;
+                        iCollisions.emplace_back(candidate, aHit.id);
+                    };
+                };
+                iDynamicTree.visit(candidateTracking.bounds, visitor(false));
+                iStaticTree.visit(candidateTracking.bounds, visitor(true));
+            }
+            latest.pairTestTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - pairStart);
+        }
+
+        // entity creation and destruction isn't synchronized with the scheduler's threads so collisions are queued
+        // for delivery on the thread that owns the ECS, where handlers are free to create and destroy entities
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        iStatistics = latest;
+        iPendingCollisions.insert(iPendingCollisions.end(), iCollisions.begin(), iCollisions.end());
+    }
+
+    collision_detector::statistics collision_detector::last_statistics() const
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        return iStatistics;
+    }
+
+    collision_detector::tree_type& collision_detector::tree(bool aStatic)
+    {
+        return aStatic ? iStaticTree : iDynamicTree;
+    }
+
+    collision_detector::tracked& collision_detector::tracking(entity_id aEntity)
+    {
+        if (iTracked.size() <= aEntity)
+            iTracked.resize(aEntity + 1u, tracked{});
+        return iTracked[aEntity];
+    }
+
+    void collision_detector::remove_destroyed()
+    {
+        std::vector<entity_id> destroyed;
+        {
+            std::scoped_lock<std::mutex> lock{ iMutex };
+            destroyed.swap(iDestroyed);
+        }
+        for (auto e : destroyed)
+            if (e < iTracked.size())
+                untrack(e);
+    }
+
+    void collision_detector::notify_collisions()
+    {
+        // one pair at a time as a handler can destroy entities of the pairs that follow
+        for (;;)
+        {
+            std::pair<entity_id, entity_id> collision;
+            {
+                std::scoped_lock<std::mutex> lock{ iMutex };
+                if (iPendingCollisions.empty())
+                    return;
+                collision = iPendingCollisions.front();
+                iPendingCollisions.pop_front();
+            }
+            Collision.trigger(collision.first, collision.second);
+        }
+    }
+
+    void collision_detector::untrack(entity_id aEntity)
+    {
+        auto& t = iTracked[aEntity];
+        if (t.inTree)
+            tree(t.isStatic).remove(aEntity, t.bounds);
+        t.inTree = false;
+    }
+}
@@ -153,11 +153,13 @@ namespace neogfx::game
 
     bool ecs::system_instantiated(system_id aSystemId) const
     {
+        std::scoped_lock<std::recursive_mutex> lock{ iSystemsMutex };
         return systems().find(aSystemId) != systems().end();
     }
 
     const i_system& ecs::system(system_id aSystemId) const
     {
+        std::scoped_lock<std::recursive_mutex> lock{ iSystemsMutex };
         auto existingSystem = systems().find(aSystemId);
         if (existingSystem != systems().end())
             return *existingSystem->second;
@@ -167,6 +169,7 @@ namespace neogfx::game
             auto& newSystem = *iSystems.emplace(aSystemId, existingFactory->second()).first->second;
             if (all_systems_paused())
                 newSystem.pause();
+            iScheduler.add_system(newSystem);
             return newSystem;
         }
         throw system_not_found();
@@ -177,6 +180,16 @@ namespace neogfx::game
         return const_cast<i_system&>(to_const(*this).system(aSystemId));
     }
 
+    const game::archetype_storage& ecs::archetype_storage() const
+    {
+        return iArchetypeStorage;
+    }
+
+    game::archetype_storage& ecs::archetype_storage()
+    {
+        return iArchetypeStorage;
+    }
+
     entity_id ecs::next_entity_id()
     {
         if (!iFreedEntityIds.empty())
@@ -197,21 +210,9 @@ namespace neogfx::game
 
     ecs::ecs(ecs_flags aCreationFlags) :
         iFlags{ aCreationFlags }, iNextEntityId { null_entity }, iNextHandleId{ null_id },
-        iSystemTimer
-        {
-            service<neolib::async_task>(),
-            [this](neolib::callback_timer& aTimer)
-            {
-                aTimer.again();
-                for (auto& system : systems())
-                {
-                    // todo: system application dependency / ordering
-                    system.second->apply();
-                }
-            }, 1, true
-        },
         iSystemsPaused{ false }
     {
+        iScheduler.set_maintenance([this]() { compact_components(); });
         if ((flags() & ecs_flags::PopulateEntityInfo) == ecs_flags::PopulateEntityInfo)
         {
             register_component<entity_info>();
@@ -221,6 +222,8 @@ namespace neogfx::game
 
     ecs::~ecs()
     {
+        iScheduler.stop();
+        std::scoped_lock<std::recursive_mutex> lock{ iSystemsMutex };
         for (auto& system : systems())
             system.second->terminate();
     }
@@ -245,6 +248,7 @@ namespace neogfx::game
         for (auto& component : iComponents)
             if (component.second->has_entity_record(aEntityId))
                 component.second->destroy_entity_record(aEntityId);
+        iArchetypeStorage.destroy_entity(aEntityId);
         free_entity_id(aEntityId);
     }
 
@@ -255,6 +259,8 @@ namespace neogfx::game
 
     void ecs::pause_all_systems()
     {
+        // systems can be instantiated by other systems on the scheduler's threads
+        std::scoped_lock<std::recursive_mutex> lock{ iSystemsMutex };
         if (iSystemsPaused)
             return;
         for (auto& s : systems())
@@ -264,6 +270,7 @@ namespace neogfx::game
 
     void ecs::resume_all_systems()
     {
+        std::scoped_lock<std::recursive_mutex> lock{ iSystemsMutex };
         if (!iSystemsPaused)
             return;
         for (auto& s : systems())
@@ -271,6 +278,11 @@ namespace neogfx::game
         iSystemsPaused = false;
     }
 
+    ecs::system_timings_t ecs::system_timings() const
+    {
+        return iScheduler.timings();
+    }
+
     bool ecs::archetype_registered(const i_entity_archetype& aArchetype) const
     {
         return archetypes().find(aArchetype.id()) != archetypes().end();
@@ -370,4 +382,44 @@ namespace neogfx::game
     {
         iFreedHandleIds.push_back(aId);
     }
+
+    void ecs::compact_components()
+    {
+        // called by the scheduler between steps so no system holds a reference to a record; compaction moves records
+        // so the locks of every component being compacted are held throughout and anything else reading component
+        // data (other than from a published snapshot) must hold the component's lock
+        thread_local std::vector<i_component*> fragmented;
+        fragmented.clear();
+        for (auto& component : components())
+        {
+            auto const fragmentation = component.second->fragmentation();
+            if (fragmentation.deadRecords >= 64u && fragmentation.deadRecords * 4u >= fragmentation.records)
+                fragmented.push_back(&*component.second);
+        }
+        if (fragmented.empty())
+            return;
+        // other threads take component locks in their own order so all are acquired or none are held
+        std::vector<std::unique_lock<std::recursive_mutex>> locks;
+        locks.reserve(fragmented.size());
+        for (std::size_t first = 0u;;)
+        {
+            locks.clear();
+            locks.emplace_back(fragmented[first]->mutex());
+            std::size_t busy = first;
+            for (std::size_t c = 0u; c < fragmented.size() && busy == first; ++c)
+                if (c != first)
+                {
+                    locks.emplace_back(fragmented[c]->mutex(), std::try_to_lock);
+                    if (!locks.back().owns_lock())
+                        busy = c;
+                }
+            if (busy == first)
+                break;
+            // wait on the busy lock next time rather than spinning
+            first = busy;
+            std::this_thread::yield();
+        }
+        for (auto component : fragmented)
+            component->compact();
+    }
 }
\ No newline at end of file
@@ -22,12 +22,14 @@
 #include <neolib/thread.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/game_world.hpp>
+#include <neogfx/game/clock.hpp>
 
 namespace neogfx::game
 {
     game_world::game_world(game::i_ecs& aEcs) :
         system{ aEcs }
     {
+        read_components().insert(clock::meta::id());
         ApplyingPhysics.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
         PhysicsApplied.set_trigger_type(neolib::event_trigger_type::SynchronousDontQueue);
     }
@@ -19,7 +19,6 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
-#include <neolib/async_thread.hpp>
 #include <neogfx/game/ecs.hpp>
 #include <neogfx/game/game_world.hpp>
 #include <neogfx/game/clock.hpp>
@@ -30,25 +29,6 @@
 
 namespace neogfx::game
 {
-    class simple_physics::thread : public neolib::async_thread
-    {
-    public:
-        thread(simple_physics& aOwner) : neolib::async_thread{ "neogfx::game::simple_physics::thread" }, iOwner{ aOwner }
-        {
-            start();
-        }
-    public:
-        void do_work() override
-        {
-            async_thread::do_work();
-            iOwner.apply();
-            iOwner.yield();
-        }
-    private:
-        simple_physics& iOwner;
-    };
-
-
     simple_physics::simple_physics(game::i_ecs& aEcs) :
         system{ aEcs }, iUniversalGravitationEnabled{ false }
     {
@@ -58,7 +38,9 @@ namespace neogfx::game
             ecs().register_shared_component<physics>();
         if (ecs().shared_component<physics>().component_data().empty())
             ecs().populate_shared<physics>("Standard Universe", physics{ 6.67408e-11 });
-        iThread = std::make_unique<thread>(*this);
+        read_components().insert(physics::meta::id());
+        write_components().insert(rigid_body::meta::id());
+        write_components().insert(clock::meta::id());
     }
 
     simple_physics::~simple_physics()
@@ -81,39 +63,33 @@ namespace neogfx::game
             return;
         if (paused())
             return;
-        if (!iThread->in()) // ignore ECS apply request (we have our own thread that does this)
-            return;
         auto& worldClock = ecs().shared_component<clock>().component_data().begin()->second;
         auto& physicalConstants = ecs().shared_component<physics>().component_data().begin()->second;
         auto uniformGravity = physicalConstants.uniformGravity != std::nullopt ?
             *physicalConstants.uniformGravity : vec3{};
         auto now = ecs().system<time>().system_time();
         auto& rigidBodies = ecs().component<rigid_body>();
+        bool stepped = false;
         while (worldClock.time <= now)
         {
-            yield();
+            stepped = true;
             component_scoped_lock<rigid_body> lgRigidBodies{ ecs() };
             ecs().system<game_world>().ApplyingPhysics.trigger(worldClock.time);
             bool useUniversalGravitation = (universal_gravitation_enabled() && physicalConstants.gravitationalConstant != 0.0);
             if (useUniversalGravitation)
                 rigidBodies.sort([](const rigid_body& lhs, const rigid_body& rhs) { return lhs.mass > rhs.mass; });
+            auto liveBodies = rigidBodies.live_records();
             auto firstMassless = useUniversalGravitation ?
-                std::find_if(rigidBodies.component_data().begin(), rigidBodies.component_data().end(), [](const rigid_body& body) { return body.mass == 0.0; }) :
-                rigidBodies.component_data().begin();
-            for (auto& rigidBody1 : rigidBodies.component_data())
+                std::find_if(liveBodies.begin(), liveBodies.end(), [](const rigid_body& body) { return body.mass == 0.0; }) :
+                liveBodies.begin();
+            for (auto& rigidBody1 : liveBodies)
             {
-                auto entity1 = rigidBodies.entity(rigidBody1);
-                if (entity1 == null_entity)
-                    continue; // todo: add support for skip iterators
                 vec3 totalForce = rigidBody1.mass * uniformGravity;
                 if (useUniversalGravitation)
                 {
-                    for (auto iterRigidBody2 = rigidBodies.component_data().begin(); iterRigidBody2 != firstMassless; ++iterRigidBody2)
+                    for (auto iterRigidBody2 = liveBodies.begin(); iterRigidBody2 != firstMassless; ++iterRigidBody2)
                     {
                         auto& rigidBody2 = *iterRigidBody2;
-                        auto entity2 = rigidBodies.entity(rigidBody2);
-                        if (entity2 == null_entity)
-                            continue; // todo: add support for skip iterators
                         vec3 distance = rigidBody1.position - rigidBody2.position;
                         if (distance.magnitude() > 0.0) // avoid division by zero or rigidBody1 == rigidBody2
                             totalForce += -physicalConstants.gravitationalConstant * rigidBody2.mass * rigidBody1.mass * distance / std::pow(distance.magnitude(), 3.0);
@@ -134,12 +110,9 @@ namespace neogfx::game
             shared_component_scoped_lock<clock> lgClock{ ecs() };
             worldClock.time += worldClock.timeStep;
         }
-    }
-
-    void simple_physics::terminate()
-    {
-        if (!iThread->aborted())
-            iThread->abort();
+        // readers (e.g. the renderer) see only completed steps
+        if (stepped)
+            rigidBodies.publish_snapshot();
     }
 
     bool simple_physics::universal_gravitation_enabled() const
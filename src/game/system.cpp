@@ -32,12 +32,12 @@ namespace neogfx::game
     }
 
     system::system(const system& aOther) :
-        iEcs{ aOther.iEcs }, iComponents{ aOther.iComponents }, iPaused{ 0u }
+        iEcs{ aOther.iEcs }, iComponents{ aOther.iComponents }, iReadComponents{ aOther.iReadComponents }, iWriteComponents{ aOther.iWriteComponents }, iPaused{ 0u }
     {
     }
 
     system::system(system&& aOther) :
-        iEcs{ aOther.iEcs }, iComponents{ std::move(aOther.iComponents) }, iPaused{ 0u }
+        iEcs{ aOther.iEcs }, iComponents{ std::move(aOther.iComponents) }, iReadComponents{ std::move(aOther.iReadComponents) }, iWriteComponents{ std::move(aOther.iWriteComponents) }, iPaused{ 0u }
     {
     }
 
@@ -56,6 +56,26 @@ namespace neogfx::game
         return iComponents;
     }
 
+    const neolib::i_set<component_id>& system::read_components() const
+    {
+        return iReadComponents;
+    }
+
+    neolib::i_set<component_id>& system::read_components()
+    {
+        return iReadComponents;
+    }
+
+    const neolib::i_set<component_id>& system::write_components() const
+    {
+        return iWriteComponents;
+    }
+
+    neolib::i_set<component_id>& system::write_components()
+    {
+        return iWriteComponents;
+    }
+
     const i_component& system::component(component_id aComponentId) const
     {
         return ecs().component(aComponentId);
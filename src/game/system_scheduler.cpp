@@ -0,0 +1,279 @@
+// system_scheduler.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <set>
+#include <neogfx/game/system_scheduler.hpp>
+
+namespace neogfx::game
+{
+    namespace
+    {
+        std::set<component_id> to_set(const neolib::i_set<component_id>& aComponents)
+        {
+            std::set<component_id> result;
+            for (auto const& c : aComponents)
+                result.insert(c);
+            return result;
+        }
+
+        bool intersects(const std::set<component_id>& aLhs, const std::set<component_id>& aRhs)
+        {
+            auto l = aLhs.begin();
+            auto r = aRhs.begin();
+            while (l != aLhs.end() && r != aRhs.end())
+            {
+                if (*l < *r)
+                    ++l;
+                else if (*r < *l)
+                    ++r;
+                else
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    system_scheduler::system_scheduler(uint32_t aThreadCount, duration aFixedStep) :
+        iFixedStep{ aFixedStep }, iStagesDirty{ false }, iStage{ nullptr }, iNextTask{ 0u }, iPendingTasks{ 0u }, iStopping{ false },
+        iThreadCount{ aThreadCount }, iStarted{ false }
+    {
+    }
+
+    system_scheduler::~system_scheduler()
+    {
+        stop();
+    }
+
+    system_scheduler::duration system_scheduler::fixed_step() const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        return iFixedStep;
+    }
+
+    void system_scheduler::set_fixed_step(duration aFixedStep)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        iFixedStep = aFixedStep;
+    }
+
+    void system_scheduler::add_system(i_system& aSystem)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        iSystems.push_back(&aSystem);
+        iStagesDirty = true;
+        if (!iStarted && !iStopping)
+            start();
+    }
+
+    void system_scheduler::set_maintenance(maintenance_t aMaintenance)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        iMaintenance = aMaintenance;
+    }
+
+    system_scheduler::stages_t system_scheduler::stages() const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        return iStages;
+    }
+
+    system_scheduler::timings_t system_scheduler::timings() const
+    {
+        std::unique_lock<std::mutex> lock{ iTimingsMutex };
+        return iTimings;
+    }
+
+    void system_scheduler::stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            if (iStopping)
+                return;
+            iStopping = true;
+        }
+        iTick.notify_all();
+        iWorkAvailable.notify_all();
+        if (iDriver.joinable())
+            iDriver.join();
+        for (auto& w : iWorkers)
+            w.join();
+    }
+
+    bool system_scheduler::conflicts(const i_system& aLhs, const i_system& aRhs)
+    {
+        auto const lhsReads = to_set(aLhs.read_components());
+        auto const lhsWrites = to_set(aLhs.write_components());
+        auto const rhsReads = to_set(aRhs.read_components());
+        auto const rhsWrites = to_set(aRhs.write_components());
+        if ((lhsReads.empty() && lhsWrites.empty()) || (rhsReads.empty() && rhsWrites.empty()))
+            return true;
+        return intersects(lhsWrites, rhsWrites) || intersects(lhsWrites, rhsReads) || intersects(lhsReads, rhsWrites);
+    }
+
+    void system_scheduler::start()
+    {
+        // called with iMutex held; the threads block on it until the caller releases it
+        iStarted = true;
+        for (uint32_t i = 0u; i < iThreadCount; ++i)
+            iWorkers.emplace_back([this]() { work(); });
+        iDriver = std::thread{ [this]() { drive(); } };
+    }
+
+    void system_scheduler::drive()
+    {
+        duration accumulator{};
+        auto lastTick = clock_type::now();
+        std::unique_lock<std::mutex> lock{ iMutex };
+        while (!iStopping)
+        {
+            iTick.wait_until(lock, lastTick + (iFixedStep - accumulator), [this]() { return iStopping; });
+            if (iStopping)
+                break;
+            auto const now = clock_type::now();
+            accumulator += std::chrono::duration_cast<duration>(now - lastTick);
+            lastTick = now;
+            if (iStagesDirty)
+                update_stages();
+            uint32_t steps = 0u;
+            while (accumulator >= iFixedStep && steps++ < MaxCatchUpSteps && !iStopping)
+            {
+                accumulator -= iFixedStep;
+                for (auto const& s : iStages)
+                {
+                    lock.unlock();
+                    apply_stage(s);
+                    lock.lock();
+                }
+                if (iMaintenance)
+                {
+                    auto const maintenance = iMaintenance;
+                    lock.unlock();
+                    maintenance();
+                    lock.lock();
+                }
+            }
+            // if we cannot keep up then drop the backlog rather than falling ever further behind
+            if (accumulator >= iFixedStep)
+                accumulator = accumulator % iFixedStep;
+        }
+    }
+
+    void system_scheduler::update_stages()
+    {
+        iStages.clear();
+        std::vector<std::size_t> stageOf;
+        for (std::size_t s = 0u; s < iSystems.size(); ++s)
+        {
+            std::size_t stageIndex = 0u;
+            for (std::size_t earlier = 0u; earlier < s; ++earlier)
+                if (conflicts(*iSystems[earlier], *iSystems[s]))
+                    stageIndex = std::max(stageIndex, stageOf[earlier] + 1u);
+            stageOf.push_back(stageIndex);
+            if (iStages.size() <= stageIndex)
+                iStages.resize(stageIndex + 1u);
+            iStages[stageIndex].push_back(iSystems[s]);
+        }
+        iStagesDirty = false;
+    }
+
+    void system_scheduler::apply_stage(const stage& aStage)
+    {
+        if (aStage.size() == 1u || iWorkers.empty())
+        {
+            for (auto s : aStage)
+                apply_system(*s);
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            iStage = &aStage;
+            iNextTask = 0u;
+            iPendingTasks = aStage.size();
+        }
+        iWorkAvailable.notify_all();
+        // the driver takes a share of the stage rather than waiting idle
+        const stage* claimedStage;
+        std::size_t task;
+        while (claim(claimedStage, task))
+        {
+            apply_system(*(*claimedStage)[task]);
+            complete();
+        }
+        std::unique_lock<std::mutex> lock{ iMutex };
+        iStageDone.wait(lock, [this]() { return iPendingTasks == 0u; });
+        iStage = nullptr;
+    }
+
+    void system_scheduler::apply_system(i_system& aSystem)
+    {
+        if (aSystem.paused())
+            return;
+        auto const start = clock_type::now();
+        aSystem.apply();
+        auto const elapsed = std::chrono::duration_cast<duration>(clock_type::now() - start);
+        std::unique_lock<std::mutex> lock{ iTimingsMutex };
+        auto& timing = iTimings.emplace(aSystem.id(), system_timing{}).first->second;
+        ++timing.applications;
+        timing.last = elapsed;
+        timing.peak = std::max(timing.peak, elapsed);
+        timing.total += elapsed;
+    }
+
+    void system_scheduler::work()
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock{ iMutex };
+                iWorkAvailable.wait(lock, [this]() { return iStopping || (iStage != nullptr && iNextTask < iStage->size()); });
+                if (iStopping)
+                    return;
+            }
+            const stage* claimedStage;
+            std::size_t task;
+            while (claim(claimedStage, task))
+            {
+                apply_system(*(*claimedStage)[task]);
+                complete();
+            }
+        }
+    }
+
+    bool system_scheduler::claim(const stage*& aStage, std::size_t& aTask)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        if (iStage == nullptr || iNextTask >= iStage->size())
+            return false;
+        aStage = iStage;
+        aTask = iNextTask++;
+        return true;
+    }
+
+    void system_scheduler::complete()
+    {
+        bool stageDone;
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            stageDone = (--iPendingTasks == 0u);
+        }
+        if (stageDone)
+            iStageDone.notify_all();
+    }
+}
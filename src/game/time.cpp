@@ -29,6 +29,7 @@ namespace neogfx::game
     time::time(game::i_ecs& aEcs) :
         system{ aEcs }
     {
+        read_components().insert(clock::meta::id());
         if (!ecs().shared_component_registered<clock>())
         {
             ecs().register_shared_component<clock>();
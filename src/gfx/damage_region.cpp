@@ -0,0 +1,185 @@
+// damage_region.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/damage_region.hpp>
+
+namespace neogfx
+{
+    damage_region::damage_region(std::size_t aMaxRects, dimension aRectOverhead) :
+        iMaxRects{ std::max<std::size_t>(aMaxRects, 1u) }, iRectOverhead{ aRectOverhead }
+    {
+    }
+
+    bool damage_region::empty() const
+    {
+        return iRects.empty();
+    }
+
+    std::size_t damage_region::size() const
+    {
+        return iRects.size();
+    }
+
+    damage_region::const_iterator damage_region::begin() const
+    {
+        return iRects.begin();
+    }
+
+    damage_region::const_iterator damage_region::end() const
+    {
+        return iRects.end();
+    }
+
+    const damage_region::rect_list& damage_region::rects() const
+    {
+        return iRects;
+    }
+
+    const rect& damage_region::bounding_rect() const
+    {
+        return iBoundingRect;
+    }
+
+    dimension damage_region::area() const
+    {
+        dimension result = 0.0;
+        for (auto const& r : iRects)
+            result += r.cx * r.cy;
+        return result;
+    }
+
+    dimension damage_region::cost() const
+    {
+        return area() + iRectOverhead * iRects.size();
+    }
+
+    bool damage_region::intersects(const rect& aRect) const
+    {
+        if (empty() || iBoundingRect.intersection(aRect).empty())
+            return false;
+        for (auto const& r : iRects)
+            if (!r.intersection(aRect).empty())
+                return true;
+        return false;
+    }
+
+    rect damage_region::intersection(const rect& aRect) const
+    {
+        std::optional<rect> result;
+        for (auto const& r : iRects)
+        {
+            auto const part = r.intersection(aRect);
+            if (part.empty())
+                continue;
+            result = (result == std::nullopt ? part : result->combine(part));
+        }
+        return result != std::nullopt ? *result : rect{};
+    }
+
+    void damage_region::add(const rect& aRect)
+    {
+        if (aRect.cx <= 0.0 || aRect.cy <= 0.0)
+            return;
+        // round outwards to whole pixels so that the region always covers all of the damaged area
+        rect const newRect{ std::floor(aRect.x), std::floor(aRect.y), std::ceil(aRect.x + aRect.cx), std::ceil(aRect.y + aRect.cy) };
+        for (auto const& r : iRects)
+            if (r.contains(newRect))
+                return;
+        iRects.push_back(newRect);
+        merge_overlapping(iRects.size() - 1u);
+        while (iRects.size() > iMaxRects)
+            merge_cheapest_pair();
+        update_bounding_rect();
+    }
+
+    void damage_region::add(const damage_region& aOther)
+    {
+        for (auto const& r : aOther)
+            add(r);
+    }
+
+    void damage_region::clear()
+    {
+        iRects.clear();
+        iBoundingRect = rect{};
+    }
+
+    dimension damage_region::cost(const rect& aRect) const
+    {
+        return aRect.cx * aRect.cy + iRectOverhead;
+    }
+
+    bool damage_region::worth_merging(const rect& aFirst, const rect& aSecond) const
+    {
+        return cost(aFirst.combine(aSecond)) <= cost(aFirst) + cost(aSecond);
+    }
+
+    void damage_region::merge_overlapping(std::size_t aIndex)
+    {
+        // merging can grow a rectangle into its neighbours so keep going until nothing changes
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            for (std::size_t i = 0u; i < iRects.size(); ++i)
+            {
+                if (i == aIndex)
+                    continue;
+                if (iRects[aIndex].contains(iRects[i]) || worth_merging(iRects[aIndex], iRects[i]))
+                {
+                    iRects[aIndex] = iRects[aIndex].combine(iRects[i]);
+                    iRects.erase(iRects.begin() + i);
+                    if (i < aIndex)
+                        --aIndex;
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    void damage_region::merge_cheapest_pair()
+    {
+        std::size_t bestFirst = 0u;
+        std::size_t bestSecond = 1u;
+        std::optional<dimension> bestPenalty;
+        for (std::size_t i = 0u; i < iRects.size(); ++i)
+            for (std::size_t j = i + 1u; j < iRects.size(); ++j)
+            {
+                auto const penalty = cost(iRects[i].combine(iRects[j])) - cost(iRects[i]) - cost(iRects[j]);
+                if (bestPenalty == std::nullopt || penalty < *bestPenalty)
+                {
+                    bestPenalty = penalty;
+                    bestFirst = i;
+                    bestSecond = j;
+                }
+            }
+        iRects[bestFirst] = iRects[bestFirst].combine(iRects[bestSecond]);
+        iRects.erase(iRects.begin() + bestSecond);
+        merge_overlapping(bestFirst);
+    }
+
+    void damage_region::update_bounding_rect()
+    {
+        iBoundingRect = rect{};
+        for (auto const& r : iRects)
+            iBoundingRect = (iBoundingRect.empty() ? r : iBoundingRect.combine(r));
+    }
+}
@@ -416,6 +416,12 @@ namespace neogfx
                 "            break;\n"
                 "        case 5:\n" // effect: Ignore
                 "            break;\n"
+                "        case 6:\n" // effect: DistanceField
+                "            {\n"
+                "                float w = max(fwidth(texel.a), 0.0001) * 0.5;\n"
+                "                color = vec4(1.0, 1.0, 1.0, smoothstep(0.5 - w, 0.5 + w, texel.a)) * color;\n"
+                "            }\n"
+                "            break;\n"
                 "        }\n"
                 "    }\n"
                 "}\n"_s
@@ -452,6 +458,85 @@ namespace neogfx
             uTextureEnabled = false;
     }
 
+    standard_blur_shader::standard_blur_shader(const std::string& aName) :
+        standard_fragment_shader<i_blur_shader>{ aName }, iKernel{}
+    {
+        disable();
+    }
+
+    void standard_blur_shader::generate_code(const i_shader_program& aProgram, shader_language aLanguage, i_string& aOutput) const
+    {
+        standard_fragment_shader<i_blur_shader>::generate_code(aProgram, aLanguage, aOutput);
+        if (aLanguage == shader_language::Glsl)
+        {
+            static const string code
+            {
+                "vec4 blur_texel(vec2 coord)\n"
+                "{\n"
+                "    if (uTextureMultisample < 5)\n" // Scaled
+                "        return texture(tex, coord).rgba;\n"
+                "    return texelFetch(texMS, ivec2(coord * uTextureExtents), gl_SampleID).rgba;\n"
+                "}\n"
+                "\n"
+                "void standard_blur_shader(inout vec4 color)\n"
+                "{\n"
+                "    if (uBlurEnabled)\n"
+                "    {\n"
+                "        vec2 texelStep = uBlurDirection / uTextureExtents;\n"
+                "        vec4 sum = vec4(0.0);\n"
+                "        for (int i = -uBlurRadius; i <= uBlurRadius; ++i)\n"
+                "            sum += blur_texel(TexCoord + texelStep * float(i)) * uBlurKernel[i + uBlurRadius];\n"
+                "        color = sum * color;\n"
+                "    }\n"
+                "}\n"_s
+            };
+            aOutput += code;
+        }
+        else
+            throw unsupported_shader_language();
+    }
+
+    bool standard_blur_shader::blur_active() const
+    {
+        return !uBlurEnabled.uniform().value().empty() &&
+            uBlurEnabled.uniform().value().get<bool>();
+    }
+
+    void standard_blur_shader::clear_blur()
+    {
+        uBlurEnabled = false;
+    }
+
+    void standard_blur_shader::set_blur(blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma)
+    {
+        enable();
+        // one dimension of a separable kernel; the caller renders a second pass in the orthogonal direction
+        int32_t radius = static_cast<int32_t>(std::min(aRadius, BLUR_KERNEL_MAX_RADIUS));
+        iKernel.fill(0.0f);
+        if (aAlgorithm == blurring_algorithm::Gaussian && aSigma > 0.0)
+        {
+            float sum = 0.0f;
+            for (int32_t i = -radius; i <= radius; ++i)
+                sum += (iKernel[i + radius] = static_cast<float>(std::exp(-(i * i) / (2.0 * aSigma * aSigma))));
+            for (int32_t i = -radius; i <= radius; ++i)
+                iKernel[i + radius] /= sum;
+        }
+        else if (aAlgorithm == blurring_algorithm::Box)
+        {
+            for (int32_t i = -radius; i <= radius; ++i)
+                iKernel[i + radius] = 1.0f / static_cast<float>(radius * 2 + 1);
+        }
+        else
+        {
+            radius = 0;
+            iKernel[0] = 1.0f;
+        }
+        uBlurDirection = aDirection.as<float>();
+        uBlurRadius = radius;
+        uBlurKernel = shader_float_array{ &iKernel[0], &iKernel[0] + iKernel.size() };
+        uBlurEnabled = true;
+    }
+
     standard_glyph_shader::standard_glyph_shader(const std::string& aName) :
         standard_fragment_shader<i_glyph_shader>{ aName }
     {
@@ -484,7 +569,17 @@ namespace neogfx
                 "    if (uGlyphEnabled)\n"
                 "    {\n"
                 "        float a = 0.0;\n"
-                "        if (uGlyphSubpixel)\n"
+                "        if (uGlyphDistanceField)\n"
+                "        {\n"
+                "            float d = texture(tex, TexCoord).r;\n"
+                "            float w = max(fwidth(d), 0.0001) * 0.5 + uGlyphDistanceFieldSoftness;\n"
+                "            float edge = 0.5 - uGlyphDistanceFieldDilation;\n"
+                "            a = smoothstep(edge - w, edge + w, d);\n"
+                "            if (a == 0)\n"
+                "                discard;\n"
+                "            color = vec4(color.xyz, color.a * a);\n"
+                "        }\n"
+                "        else if (uGlyphSubpixel)\n"
                 "        {\n"
                 "            vec4 aaaAlpha = texture(tex, TexCoord);\n"
                 "            if (aaaAlpha.rgb == vec3(1.0, 1.0, 1.0))\n"
@@ -532,17 +627,28 @@ namespace neogfx
     void standard_glyph_shader::set_first_glyph(const i_rendering_context& aContext, const glyph& aGlyph)
     {
         enable();
-        bool subpixelRender = aGlyph.subpixel() && aGlyph.glyph_texture().subpixel();
+        bool const distanceField = aGlyph.distance_field();
+        bool const subpixel = !distanceField && aGlyph.glyph_texture().subpixel();
+        bool const subpixelRender = aGlyph.subpixel() && subpixel;
         if (subpixelRender)
             aContext.render_target().target_texture().bind(7);
         uGlyphRenderTargetExtents = aContext.render_target().extents().to_vec2().as<int32_t>();
         uGlyphGuiCoordinates = aContext.logical_coordinates().is_gui_orientation();
         uGlyphRenderOutput = sampler2DMS{ 7 };
-        uGlyphSubpixel = aGlyph.glyph_texture().subpixel();
+        uGlyphSubpixel = subpixel;
         uGlyphSubpixelFormat = subpixelRender ? aContext.subpixel_format() : subpixel_format::None;
+        uGlyphDistanceField = distanceField;
+        uGlyphDistanceFieldDilation = 0.0f;
+        uGlyphDistanceFieldSoftness = 0.0f;
         uGlyphEnabled = true;
     }
 
+    void standard_glyph_shader::set_distance_field_effect(scalar aDilation, scalar aSoftness)
+    {
+        uGlyphDistanceFieldDilation = static_cast<float>(aDilation);
+        uGlyphDistanceFieldSoftness = static_cast<float>(aSoftness);
+    }
+
     standard_stipple_shader::standard_stipple_shader(const std::string& aName) :
         standard_fragment_shader<i_stipple_shader>{ aName }, iPosition{ 0.0 }
     {
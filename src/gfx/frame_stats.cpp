@@ -0,0 +1,62 @@
+// frame_stats.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <sstream>
+#include <iomanip>
+#include <neogfx/gfx/frame_stats.hpp>
+
+namespace neogfx
+{
+    std::string to_string(flush_reason aReason)
+    {
+        switch (aReason)
+        {
+        case flush_reason::Requested: return "Requested";
+        case flush_reason::TargetDeactivating: return "TargetDeactivating";
+        case flush_reason::VertexBufferFull: return "VertexBufferFull";
+        default: return "";
+        }
+    }
+
+    std::string to_string(const frame_stats& aStats)
+    {
+        auto const ms = [](frame_stats::duration aDuration)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(aDuration).count() / 1000.0;
+        };
+        std::ostringstream result;
+        result << std::fixed << std::setprecision(2);
+        result << "frame " << aStats.frame << "\n";
+        result << "paint " << ms(aStats.paintTime) << " ms, flush " << ms(aStats.flushTime) << " ms, swap " << ms(aStats.swapTime) << " ms\n";
+        result << "operations " << aStats.total_operations() << ", batches " << aStats.batches << ", draw calls " << aStats.drawCalls << ", vertices " << aStats.verticesStreamed << ", instances " << aStats.instances << "\n";
+        result << "streamed " << aStats.bytesStreamed << " bytes, fences " << aStats.fences << ", fence waits " << aStats.fenceWaits << " (" << ms(aStats.fenceWaitTime) << " ms), segments recycled " << aStats.segmentsRecycled << "\n";
+        result << "flushes " << aStats.total_flushes();
+        for (std::size_t reason = 0; reason < aStats.flushes.size(); ++reason)
+            if (aStats.flushes[reason] != 0u)
+                result << ", " << to_string(static_cast<flush_reason>(reason)) << " " << aStats.flushes[reason];
+        result << "\n";
+        result << "pixels repainted " << aStats.repaintedPixels << ", presented " << aStats.presentedPixels << "\n";
+        result << "texture uploads " << aStats.textureUploads << " (" << aStats.textureUploadTexels << " texels), shader program switches " << aStats.shaderProgramSwitches << "\n";
+        for (std::size_t op = 0; op < aStats.operations.size(); ++op)
+            if (aStats.operations[op] != 0u)
+                result << graphics_operation::to_string(static_cast<graphics_operation::operation_type>(op)) << " " << aStats.operations[op] << "\n";
+        return result.str();
+    }
+}
@@ -41,6 +41,7 @@
 #include <neogfx/gfx/i_texture.hpp>
 #include <neogfx/gui/widget/i_widget.hpp>
 #include <neogfx/gfx/text/text_category_map.hpp>
+#include <neogfx/gfx/text/glyph_text_cache.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
 #include <neogfx/game/mesh.hpp>
@@ -50,6 +51,11 @@
 
 namespace neogfx
 {
+    namespace
+    {
+        constexpr uint32_t BLUR_DOWNSAMPLE_THRESHOLD = 8u;
+    }
+
     struct graphics_context::glyph_text_data
     {
         struct cluster
@@ -60,6 +66,7 @@ namespace neogfx
         typedef std::vector<cluster> cluster_map_t;
         mutable cluster_map_t iClusterMap;
         mutable std::vector<character_type> iTextDirections;
+        mutable std::vector<text_category> iTextCategories;
         mutable std::u32string iCodePointsBuffer;
         typedef std::tuple<const char32_t*, const char32_t*, text_direction, bool, hb_script_t> glyph_run;
         typedef std::vector<glyph_run> run_list;
@@ -74,6 +81,7 @@ namespace neogfx
         iNativeGraphicsContext{ nullptr },
         iDefaultFont{},
         iOrigin{ 0.0, 0.0 },
+        iTargetOrigin{},
         iExtents{ aSurface.extents() },
         iLayer{ 0 },
         iSnapToPixel{ false },
@@ -81,6 +89,7 @@ namespace neogfx
         iBlendingMode{ neogfx::blending_mode::Default },
         iSmoothingMode{ neogfx::smoothing_mode::None },
         iSubpixelRendering{ service<i_rendering_engine>().is_subpixel_rendering_on() },
+        iDistanceFieldText{ false },
         iGlyphTextData{ std::make_unique<glyph_text_data>() }
     {
     }
@@ -91,6 +100,7 @@ namespace neogfx
         iNativeGraphicsContext{ nullptr },
         iDefaultFont{ aDefaultFont },
         iOrigin{ 0.0, 0.0 },
+        iTargetOrigin{},
         iExtents{ aSurface.extents() },
         iLayer{ 0 },
         iSnapToPixel{ false },
@@ -98,6 +108,7 @@ namespace neogfx
         iBlendingMode{ neogfx::blending_mode::Default },
         iSmoothingMode{ neogfx::smoothing_mode::None },
         iSubpixelRendering{ service<i_rendering_engine>().is_subpixel_rendering_on() },
+        iDistanceFieldText{ false },
         iGlyphTextData{ std::make_unique<glyph_text_data>() }
     {
     }
@@ -108,6 +119,7 @@ namespace neogfx
         iNativeGraphicsContext{ nullptr },
         iDefaultFont{ aWidget.font() },
         iOrigin{ aWidget.origin() },
+        iTargetOrigin{},
         iExtents{ aWidget.extents() },
         iLayer{ 0 },
         iSnapToPixel{ false },
@@ -115,6 +127,7 @@ namespace neogfx
         iBlendingMode{ neogfx::blending_mode::Default },
         iSmoothingMode{ neogfx::smoothing_mode::None },
         iSubpixelRendering{ service<i_rendering_engine>().is_subpixel_rendering_on() },
+        iDistanceFieldText{ false },
         iGlyphTextData{ std::make_unique<glyph_text_data>() }
     {
         set_logical_coordinate_system(aWidget.logical_coordinate_system());
@@ -126,6 +139,7 @@ namespace neogfx
         iNativeGraphicsContext{ nullptr },
         iDefaultFont{ font() },
         iOrigin{},
+        iTargetOrigin{},
         iExtents{ aTexture.extents() },
         iLayer{ 0 },
         iSnapToPixel{ false },
@@ -133,6 +147,26 @@ namespace neogfx
         iBlendingMode{ neogfx::blending_mode::Default },
         iSmoothingMode{ neogfx::smoothing_mode::None },
         iSubpixelRendering{ service<i_rendering_engine>().is_subpixel_rendering_on() },
+        iDistanceFieldText{ false },
+        iGlyphTextData{ std::make_unique<glyph_text_data>() }
+    {
+    }
+
+    graphics_context::graphics_context(const i_render_target& aTarget, type aType) :
+        iType{ aType },
+        iRenderTarget{ aTarget },
+        iNativeGraphicsContext{ nullptr },
+        iDefaultFont{ font() },
+        iOrigin{},
+        iTargetOrigin{},
+        iExtents{ aTarget.extents() },
+        iLayer{ 0 },
+        iSnapToPixel{ false },
+        iOpacity{ 1.0 },
+        iBlendingMode{ neogfx::blending_mode::Default },
+        iSmoothingMode{ neogfx::smoothing_mode::None },
+        iSubpixelRendering{ false },
+        iDistanceFieldText{ false },
         iGlyphTextData{ std::make_unique<glyph_text_data>() }
     {
     }
@@ -142,7 +176,8 @@ namespace neogfx
         iRenderTarget{ aOther.iRenderTarget },
         iNativeGraphicsContext{ aOther.iNativeGraphicsContext != nullptr ? aOther.native_context().clone() : nullptr },
         iDefaultFont{ aOther.iDefaultFont },
-        iOrigin{ aOther.origin() },
+        iOrigin{ aOther.iOrigin },
+        iTargetOrigin{ aOther.iTargetOrigin },
         iExtents{ aOther.extents() },
         iLayer{ 0 },
         iLogicalCoordinateSystem{ aOther.iLogicalCoordinateSystem },
@@ -152,6 +187,7 @@ namespace neogfx
         iBlendingMode{ neogfx::blending_mode::Default },
         iSmoothingMode{ neogfx::smoothing_mode::None },
         iSubpixelRendering{ service<i_rendering_engine>().is_subpixel_rendering_on() },
+        iDistanceFieldText{ aOther.iDistanceFieldText },
         iGlyphTextData{ std::make_unique<glyph_text_data>() }
     {
     }
@@ -370,12 +406,12 @@ namespace neogfx
 
     void graphics_context::set_origin(const point& aOrigin) const
     {
-        iOrigin = to_device_units(aOrigin);
+        iOrigin = to_device_units(aOrigin) - iTargetOrigin;
     }
 
     point graphics_context::origin() const
     {
-        return from_device_units(iOrigin);
+        return from_device_units(iOrigin + iTargetOrigin);
     }
 
     void graphics_context::set_pixel(const point& aPoint, const color& aColor) const
@@ -512,7 +548,7 @@ namespace neogfx
 
     size graphics_context::text_extent(const std::string& aText, const font& aFont) const
     {
-        return text_extent(aText.begin(), aText.end(), [&aFont](std::u32string::size_type) { return aFont; });
+        return text_extent(aText.begin(), aText.end(), aFont);
     }
 
     size graphics_context::text_extent(const std::string& aText, std::function<font(std::string::size_type)> aFontSelector) const
@@ -522,7 +558,7 @@ namespace neogfx
 
     size graphics_context::text_extent(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, const font& aFont) const
     {
-        return text_extent(aTextBegin, aTextEnd, [&aFont](std::u32string::size_type) { return aFont; });
+        return glyph_text_extent(to_glyph_text(aTextBegin, aTextEnd, aFont));
     }
 
     size graphics_context::text_extent(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, std::function<font(std::string::size_type)> aFontSelector) const
@@ -532,7 +568,7 @@ namespace neogfx
 
     size graphics_context::multiline_text_extent(const std::string& aText, const font& aFont) const
     {
-        return multiline_text_extent(aText, [&aFont](std::u32string::size_type) { return aFont; }, 0);
+        return multiline_text_extent(aText, aFont, 0);
     }
 
     size graphics_context::multiline_text_extent(const std::string& aText, std::function<font(std::string::size_type)> aFontSelector) const
@@ -542,7 +578,7 @@ namespace neogfx
 
     size graphics_context::multiline_text_extent(const std::string& aText, const font& aFont, dimension aMaxWidth) const
     {
-        return multiline_text_extent(aText, [&aFont](std::u32string::size_type) { return aFont; }, aMaxWidth);
+        return multiline_glyph_text_extent(to_glyph_text(aText.begin(), aText.end(), aFont), aMaxWidth);
     }
         
     size graphics_context::multiline_text_extent(const std::string& aText, std::function<font(std::string::size_type)> aFontSelector, dimension aMaxWidth) const
@@ -718,6 +754,20 @@ namespace neogfx
         return *this;
     }
 
+    point graphics_context::target_origin() const
+    {
+        return from_device_units(iTargetOrigin);
+    }
+
+    void graphics_context::set_target_origin(const point& aTargetOrigin)
+    {
+        // where the render target's top-left lies in the coordinate space origins are specified in; lets a
+        // texture stand in for part of a larger surface (e.g. a widget layer) without its clients knowing
+        auto const origin = this->origin();
+        iTargetOrigin = to_device_units(aTargetOrigin);
+        set_origin(origin);
+    }
+
     bool graphics_context::attached() const
     {
         return iType == type::Attached;
@@ -851,6 +901,21 @@ namespace neogfx
         }
     }
 
+    bool graphics_context::is_distance_field_text_on() const
+    {
+        return iDistanceFieldText;
+    }
+
+    void graphics_context::distance_field_text_on() const
+    {
+        iDistanceFieldText = true;
+    }
+
+    void graphics_context::distance_field_text_off() const
+    {
+        iDistanceFieldText = false;
+    }
+
     void graphics_context::clear(const color& aColor, const std::optional<scalar>& aZpos) const
     {
         if (aZpos == std::nullopt)
@@ -877,12 +942,58 @@ namespace neogfx
 
     void graphics_context::blur(const rect& aDestinationRect, const i_graphics_context& aSource, const rect& aSourceRect, blurring_algorithm aAlgorithm, uint32_t aParameter1, double aParameter2) const
     {
-        // todo
-        scoped_scissor ss{ *this, aDestinationRect };
-        dimension const w = aParameter1;
-        for (coordinate y = -w; y <= w; y += 1.0)
-            for (coordinate x = -w; x <= w; x += 1.0)
-                blit(aDestinationRect + point{ x, y }, aSource, aSourceRect);
+        if (aAlgorithm == blurring_algorithm::None || aParameter1 == 0u)
+        {
+            blit(aDestinationRect, aSource, aSourceRect);
+            return;
+        }
+        // separable blur: a horizontal pass into an intermediate buffer followed by a vertical pass; large radii
+        // are blurred at a reduced resolution (and upsampled when blitting the result) to bound the kernel size
+        uint32_t const downsample = aParameter1 > BLUR_DOWNSAMPLE_THRESHOLD ? (aParameter1 + BLUR_DOWNSAMPLE_THRESHOLD - 1u) / BLUR_DOWNSAMPLE_THRESHOLD : 1u;
+        uint32_t const passRadius = (aParameter1 + downsample - 1u) / downsample;
+        double const passSigma = aParameter2 * passRadius / 3.0;
+        auto const& sourceTexture = aSource.render_target().target_texture();
+        size const passExtents = (aSourceRect.extents() / static_cast<dimension>(downsample)).ceil();
+        rect const passRect{ point{}, passExtents };
+        // the intermediate buffers are sampled linearly so that reduced resolution passes and the upsampling blit are
+        // filtered; ping-pong buffers are shared (and cleared when taken) so if the source or the destination is itself
+        // a linearly sampled ping-pong buffer then larger (and so distinct) buffers are used
+        auto& renderingEngine = service<i_rendering_engine>();
+        auto const destinationTexture = dynamic_cast<const i_texture*>(&render_target());
+        auto const in_use = [&](const i_texture& aBuffer)
+        {
+            return aBuffer.id() == sourceTexture.id() || (destinationTexture != nullptr && aBuffer.id() == destinationTexture->id());
+        };
+        size bufferExtents = passExtents;
+        for (;;)
+        {
+            auto const& buffer1 = renderingEngine.ping_pong_buffer1(bufferExtents, texture_sampling::Normal);
+            auto const& buffer2 = renderingEngine.ping_pong_buffer2(bufferExtents, texture_sampling::Normal);
+            if (!in_use(buffer1) && !in_use(buffer2))
+                break;
+            bufferExtents = bufferExtents.max(buffer1.extents().max(buffer2.extents())) + size{ 1.0, 1.0 };
+        }
+        auto buffers = ping_pong_buffers(bufferExtents, texture_sampling::Normal);
+        auto const& horizontal = static_cast<const graphics_context&>(*buffers.first);
+        {
+            scoped_render_target srt{ horizontal.render_target() };
+            horizontal.draw_blur_pass(passRect, sourceTexture, aSourceRect, aAlgorithm, vec2{ static_cast<scalar>(downsample), 0.0 }, passRadius, passSigma);
+        }
+        if (downsample == 1u)
+        {
+            scoped_scissor ss{ *this, aDestinationRect };
+            draw_blur_pass(aDestinationRect, horizontal.render_target().target_texture(), passRect, aAlgorithm, vec2{ 0.0, 1.0 }, passRadius, passSigma);
+        }
+        else
+        {
+            auto const& vertical = static_cast<const graphics_context&>(*buffers.second);
+            {
+                scoped_render_target srt{ vertical.render_target() };
+                vertical.draw_blur_pass(passRect, horizontal.render_target().target_texture(), passRect, aAlgorithm, vec2{ 0.0, 1.0 }, passRadius, passSigma);
+            }
+            scoped_scissor ss{ *this, aDestinationRect };
+            blit(aDestinationRect, vertical, passRect);
+        }
     }
 
     glyph_text graphics_context::to_glyph_text(const std::string& aText, const font& aFont) const
@@ -892,7 +1003,7 @@ namespace neogfx
 
     glyph_text graphics_context::to_glyph_text(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, const font& aFont) const
     {
-        return to_glyph_text(aTextBegin, aTextEnd, [&aFont](std::string::size_type) { return aFont; });
+        return to_cached_glyph_text(aTextBegin, aTextEnd, aFont);
     }
 
     glyph_text graphics_context::to_glyph_text(std::string::const_iterator aTextBegin, std::string::const_iterator aTextEnd, std::function<font(std::string::size_type)> aFontSelector) const
@@ -907,7 +1018,7 @@ namespace neogfx
 
     glyph_text graphics_context::to_glyph_text(std::u32string::const_iterator aTextBegin, std::u32string::const_iterator aTextEnd, const font& aFont) const
     {
-        return to_glyph_text(aTextBegin, aTextEnd, [&aFont](std::u32string::size_type) { return aFont; });
+        return to_cached_glyph_text(aTextBegin, aTextEnd, aFont);
     }
 
     glyph_text graphics_context::to_glyph_text(std::u32string::const_iterator aTextBegin, std::u32string::const_iterator aTextEnd, std::function<font(std::u32string::size_type)> aFontSelector) const
@@ -1127,6 +1238,14 @@ namespace neogfx
             iPassword = std::nullopt;
     }
 
+    void graphics_context::draw_blur_pass(const rect& aDestinationRect, const i_texture& aSource, const rect& aSourceRect, blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma) const
+    {
+        scoped_blending_mode sbm{ *this, neogfx::blending_mode::Blit };
+        native_context().enqueue(graphics_operation::blur_on{ aAlgorithm, aDirection, aRadius, aSigma });
+        draw_texture(aDestinationRect, aSource, aSourceRect, optional_color{}, shader_effect::Ignore);
+        native_context().enqueue(graphics_operation::blur_off{});
+    }
+
     void graphics_context::draw_texture(const point& aPoint, const i_texture& aTexture, const optional_color& aColor, shader_effect aShaderEffect) const
     {
         draw_texture(rect{ aPoint, aTexture.extents() }, aTexture, aColor, aShaderEffect);
@@ -1431,7 +1550,10 @@ namespace neogfx
         auto& runs = iGlyphTextData->iRuns;
         runs.clear();
         auto const& emojiAtlas = service<i_font_manager>().emoji_atlas();
-        text_category previousCategory = get_text_category(emojiAtlas, codePoints, codePoints + codePointCount);
+        auto& textCategories = iGlyphTextData->iTextCategories;
+        textCategories.resize(codePointCount);
+        classify(emojiAtlas, codePoints, codePoints + codePointCount, textCategories.data());
+        text_category previousCategory = textCategories[0];
         if (iMnemonic != std::nullopt && codePoints[0] == static_cast<char32_t>(iMnemonic->second))
             previousCategory = text_category::Mnemonic;
         text_direction previousDirection = (previousCategory != text_category::RTL ? text_direction::LTR : text_direction::RTL);
@@ -1475,7 +1597,7 @@ namespace neogfx
             }
 
             hb_unicode_funcs_t* unicodeFuncs = static_cast<native_font_face::hb_handle*>(currentFont.native_font_face().aux_handle())->unicodeFuncs;
-            text_category currentCategory = get_text_category(emojiAtlas, codePoints + codePointIndex, codePoints + codePointCount);
+            text_category currentCategory = textCategories[codePointIndex];
             if (iMnemonic != std::nullopt && codePoints[codePointIndex] == static_cast<char32_t>(iMnemonic->second))
                 currentCategory = text_category::Mnemonic;
             text_direction currentDirection = previousDirection;
@@ -1569,7 +1691,7 @@ namespace neogfx
                 {
                     for (std::size_t j = codePointIndex + 1; j <= lastCodePointIndex; ++j)
                     {
-                        text_direction nextDirection = bidi_check(get_text_category(emojiAtlas, codePoints + j, codePoints + codePointCount), get_text_direction(emojiAtlas, codePoints + j, codePoints + codePointCount, currentDirection));
+                        text_direction nextDirection = bidi_check(textCategories[j], get_text_direction(textCategories[j], currentDirection));
                         if (nextDirection == text_direction::RTL)
                             break;
                         else if (nextDirection == text_direction::LTR || (j == lastCodePointIndex && currentLineHasLTR))
@@ -1694,15 +1816,27 @@ namespace neogfx
                     result.back().set_value(emojiAtlas.emoji(aTextBegin[startCluster], font.height()));
                 if ((aFontSelector(startCluster).style() & font_style::Underline) == font_style::Underline)
                     result.back().set_underline(true);
-                if (is_subpixel_rendering_on() && !font.is_bitmap_font())
+                if (is_distance_field_text_on() && !font.is_bitmap_font())
+                    result.back().set_distance_field(true);
+                else if (is_subpixel_rendering_on() && !font.is_bitmap_font())
                     result.back().set_subpixel(true);
                 if (drawMnemonic && ((j == 0 && std::get<2>(runs[i]) == text_direction::LTR) || (j == shapes.glyph_count() - 1 && std::get<2>(runs[i]) == text_direction::RTL)))
                     result.back().set_mnemonic(true);
                 if (result.back().category() != text_category::Whitespace && result.back().category() != text_category::Emoji)
                 {
                     auto& glyph = result.back();
-                    if (glyph.advance() != advance.ceil())
+                    if (glyph.advance() != advance.ceil() && glyph.distance_field())
+                    {
+                        auto visibleAdvance = std::ceil(glyph.extents(aFontSelector(startCluster)).cx);
+                        if (visibleAdvance > advance.cx)
+                        {
+                            advance.cx = visibleAdvance;
+                            glyph.set_advance(advance);
+                        }
+                    }
+                    else if (glyph.advance() != advance.ceil())
                     {
+                        glyph_rasterizer::scoped_blocking sb;
                         const i_glyph_texture& glyphTexture = aFontSelector(startCluster).native_font_face().glyph_texture(glyph);
                         auto visibleAdvance = std::ceil(glyph.offset().cx + glyphTexture.placement().x + glyphTexture.texture().extents().cx);
                         if (visibleAdvance > advance.cx)
@@ -1779,4 +1913,31 @@ namespace neogfx
         }
         return std::move(result);
     }
+    template <typename Iter>
+    glyph_text graphics_context::to_cached_glyph_text(Iter aTextBegin, Iter aTextEnd, const font& aFont) const
+    {
+        typedef typename std::iterator_traits<Iter>::value_type character_type;
+        auto const length = static_cast<std::size_t>(std::distance(aTextBegin, aTextEnd));
+        if (!glyph_text_cache::cacheable(length))
+            return to_glyph_text_impl(aTextBegin, aTextEnd, [&aFont](std::size_t) { return aFont; });
+        glyph_text_cache::key const key
+        {
+            std::string{ reinterpret_cast<const char*>(&*aTextBegin), length * sizeof(character_type) },
+            sizeof(character_type) != sizeof(char),
+            aFont.id(),
+            aFont.style(),
+            is_subpixel_rendering_on(),
+            is_distance_field_text_on(),
+            password() ? std::optional<std::string>{ password_mask() } : std::optional<std::string>{},
+            iMnemonic,
+            logical_coordinates().is_gui_orientation()
+        };
+        auto& cache = service<i_font_manager>().glyph_text_cache();
+        glyph_text result;
+        if (cache.find(key, result))
+            return result;
+        result = to_glyph_text_impl(aTextBegin, aTextEnd, [&aFont](std::size_t) { return aFont; });
+        cache.insert(key, result);
+        return result;
+    }
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <iostream>
 #include <neogfx/gfx/graphics_operations.hpp>
 #include "native/i_native_texture.hpp"
 
@@ -45,6 +46,8 @@ namespace neogfx
             case PopLogicalOperation: return "PopLogicalOperation";
             case LineStippleOn: return "LineStippleOn";
             case LineStippleOff: return "LineStippleOff";
+            case BlurOn: return "BlurOn";
+            case BlurOff: return "BlurOff";
             case SubpixelRenderingOn: return "SubpixelRenderingOn";
             case SubpixelRenderingOff: return "SubpixelRenderingOff";
             case Clear: return "Clear";
@@ -156,5 +159,314 @@ namespace neogfx
                 return false;
             }
         }
+
+        namespace
+        {
+            // how far ahead of a batch start the compiler will look for batchable operations
+            constexpr std::size_t ReorderWindow = 256;
+
+            bool sDumpBatches = false;
+
+            rect circle_bounds(const point& aCentre, dimension aRadius)
+            {
+                return rect{ aCentre - point{ aRadius, aRadius }, size{ aRadius * 2.0, aRadius * 2.0 } };
+            }
+
+            rect shape_bounds(const game::mesh& aMesh, const vec3& aPosition)
+            {
+                auto result = game::bounding_rect(aMesh);
+                result.x += aPosition.x;
+                result.y += aPosition.y;
+                return result;
+            }
+
+            bool overlapping(const rect& aLeft, const rect& aRight)
+            {
+                return aLeft.x < aRight.x + aRight.cx && aRight.x < aLeft.x + aLeft.cx &&
+                    aLeft.y < aRight.y + aRight.cy && aRight.y < aLeft.y + aLeft.cy;
+            }
+
+            rect intersected(const rect& aLeft, const rect& aRight)
+            {
+                point const topLeft{ std::max(aLeft.x, aRight.x), std::max(aLeft.y, aRight.y) };
+                point const bottomRight{ std::min(aLeft.x + aLeft.cx, aRight.x + aRight.cx), std::min(aLeft.y + aLeft.cy, aRight.y + aRight.cy) };
+                return rect{ topLeft, size{ std::max(bottomRight.x - topLeft.x, 0.0), std::max(bottomRight.y - topLeft.y, 0.0) } };
+            }
+
+            rect combined(const rect& aLeft, const rect& aRight)
+            {
+                point const topLeft{ std::min(aLeft.x, aRight.x), std::min(aLeft.y, aRight.y) };
+                point const bottomRight{ std::max(aLeft.x + aLeft.cx, aRight.x + aRight.cx), std::max(aLeft.y + aLeft.cy, aRight.y + aRight.cy) };
+                return rect{ topLeft, size{ bottomRight.x - topLeft.x, bottomRight.y - topLeft.y } };
+            }
+
+            bool drawing_operation(const operation& aOperation)
+            {
+                return aOperation.index() >= operation_type::SetPixel && aOperation.index() != operation_type::DrawEntities;
+            }
+
+            bool scissor_operation(const operation& aOperation)
+            {
+                return aOperation.index() == operation_type::ScissorOn || aOperation.index() == operation_type::ScissorOff;
+            }
+        }
+
+        optional_rect bounding_rect(const operation& aOperation)
+        {
+            optional_rect result;
+            switch (static_cast<operation_type>(aOperation.index()))
+            {
+            case operation_type::SetPixel:
+                result = rect{ static_variant_cast<const set_pixel&>(aOperation).point, size{ 1.0, 1.0 } };
+                break;
+            case operation_type::DrawPixel:
+                result = rect{ static_variant_cast<const draw_pixel&>(aOperation).point, size{ 1.0, 1.0 } };
+                break;
+            case operation_type::DrawLine:
+                {
+                    auto const& op = static_variant_cast<const draw_line&>(aOperation);
+                    result = inflate_rect(rect{ op.from, op.to }, op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::DrawRect:
+                {
+                    auto const& op = static_variant_cast<const draw_rect&>(aOperation);
+                    result = inflate_rect(op.rect, op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::DrawRoundedRect:
+                {
+                    auto const& op = static_variant_cast<const draw_rounded_rect&>(aOperation);
+                    result = inflate_rect(op.rect, op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::DrawCircle:
+                {
+                    auto const& op = static_variant_cast<const draw_circle&>(aOperation);
+                    result = inflate_rect(circle_bounds(op.centre, op.radius), op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::DrawArc:
+                {
+                    auto const& op = static_variant_cast<const draw_arc&>(aOperation);
+                    result = inflate_rect(circle_bounds(op.centre, op.radius), op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::DrawPath:
+                {
+                    auto const& op = static_variant_cast<const draw_path&>(aOperation);
+                    result = inflate_rect(op.path.bounding_rect(), op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::DrawShape:
+                {
+                    auto const& op = static_variant_cast<const draw_shape&>(aOperation);
+                    result = inflate_rect(shape_bounds(op.mesh, op.position), op.pen.width(), op.pen.width());
+                }
+                break;
+            case operation_type::FillRect:
+                result = static_variant_cast<const fill_rect&>(aOperation).rect;
+                break;
+            case operation_type::FillRoundedRect:
+                result = static_variant_cast<const fill_rounded_rect&>(aOperation).rect;
+                break;
+            case operation_type::FillCircle:
+                {
+                    auto const& op = static_variant_cast<const fill_circle&>(aOperation);
+                    result = circle_bounds(op.centre, op.radius);
+                }
+                break;
+            case operation_type::FillArc:
+                {
+                    auto const& op = static_variant_cast<const fill_arc&>(aOperation);
+                    result = circle_bounds(op.centre, op.radius);
+                }
+                break;
+            case operation_type::FillPath:
+                result = static_variant_cast<const fill_path&>(aOperation).path.bounding_rect();
+                break;
+            case operation_type::FillShape:
+                {
+                    auto const& op = static_variant_cast<const fill_shape&>(aOperation);
+                    result = shape_bounds(op.mesh, op.position);
+                }
+                break;
+            case operation_type::DrawGlyph:
+                {
+                    // glyph placement depends on the texture and on the logical coordinate orientation so
+                    // allow a full line height either side of the glyph cell
+                    auto const& op = static_variant_cast<const draw_glyph&>(aOperation);
+                    auto const height = op.glyph.font().height();
+                    auto const effectWidth = op.appearance.effect() ? op.appearance.effect()->width() : 0.0;
+                    result = inflate_rect(
+                        rect{ point{ op.point }, size{ op.glyph.advance().cx, height } },
+                        height + effectWidth, height + effectWidth);
+                }
+                break;
+            case operation_type::DrawMesh:
+                {
+                    auto const& op = static_variant_cast<const draw_mesh&>(aOperation);
+                    result = game::bounding_rect(op.transformation * op.mesh.vertices);
+                }
+                break;
+            default:
+                break;
+            }
+            // allow for anti-aliasing and pixel snapping
+            if (result)
+                result->inflate(1.0, 1.0);
+            return result;
+        }
+
+        namespace
+        {
+            void do_compile(queue& aQueue, clip_list* aClips)
+            {
+                if (dump_batches())
+                {
+                    std::cerr << "graphics_operation::compile: before:" << std::endl;
+                    dump(std::cerr, aQueue);
+                }
+
+                thread_local queue tCompiled;
+                thread_local clip_list tCompiledClips;
+                thread_local std::vector<optional_rect> tBounds;
+                thread_local std::vector<bool> tEmitted;
+                thread_local std::vector<rect> tSkipped;
+
+                tCompiled.clear();
+                tCompiled.reserve(aQueue.size());
+                tCompiledClips.clear();
+
+                // with resolved clip rectangles a scissor operation no longer affects the operations around it
+                auto const segment_member = [aClips](const operation& aOperation)
+                {
+                    return drawing_operation(aOperation) || (aClips != nullptr && scissor_operation(aOperation));
+                };
+                auto const emit = [&](std::size_t aIndex)
+                {
+                    tCompiled.push_back(std::move(aQueue[aIndex]));
+                    if (aClips != nullptr)
+                        tCompiledClips.push_back((*aClips)[aIndex]);
+                };
+
+                for (std::size_t segmentStart = 0; segmentStart != aQueue.size();)
+                {
+                    // state changing (and unbounded) operations are barriers: never reorder across them
+                    if (!segment_member(aQueue[segmentStart]))
+                    {
+                        emit(segmentStart++);
+                        continue;
+                    }
+                    auto segmentEnd = segmentStart + 1;
+                    while (segmentEnd != aQueue.size() && segment_member(aQueue[segmentEnd]))
+                        ++segmentEnd;
+                    if (segmentEnd - segmentStart == 1)
+                    {
+                        emit(segmentStart);
+                        segmentStart = segmentEnd;
+                        continue;
+                    }
+
+                    tBounds.clear();
+                    tEmitted.assign(segmentEnd - segmentStart, false);
+                    for (auto op = segmentStart; op != segmentEnd; ++op)
+                    {
+                        auto bounds = bounding_rect(aQueue[op]);
+                        if (bounds && aClips != nullptr && (*aClips)[op])
+                            bounds = intersected(*bounds, *(*aClips)[op]);
+                        tBounds.push_back(bounds);
+                    }
+
+                    for (auto op = segmentStart; op != segmentEnd; ++op)
+                    {
+                        if (tEmitted[op - segmentStart])
+                            continue;
+                        tEmitted[op - segmentStart] = true;
+                        auto const batchStart = tCompiled.size();
+                        emit(op);
+                        // an operation that cannot be batched with its own kind will not gain anything
+                        if (!batchable(tCompiled[batchStart], tCompiled[batchStart]))
+                            continue;
+                        tSkipped.clear();
+                        optional_rect skippedBounds;
+                        for (auto candidate = op + 1; candidate != segmentEnd && candidate - op <= ReorderWindow; ++candidate)
+                        {
+                            if (tEmitted[candidate - segmentStart] || scissor_operation(aQueue[candidate]))
+                                continue;
+                            auto const& candidateBounds = tBounds[candidate - segmentStart];
+                            if (!candidateBounds)
+                                break;
+                            bool canMove = batchable(tCompiled[batchStart], aQueue[candidate]);
+                            if (canMove && skippedBounds && overlapping(*skippedBounds, *candidateBounds))
+                                for (auto const& skipped : tSkipped)
+                                    if (overlapping(skipped, *candidateBounds))
+                                    {
+                                        canMove = false;
+                                        break;
+                                    }
+                            if (canMove)
+                            {
+                                tEmitted[candidate - segmentStart] = true;
+                                emit(candidate);
+                            }
+                            else
+                            {
+                                tSkipped.push_back(*candidateBounds);
+                                skippedBounds = skippedBounds ? combined(*skippedBounds, *candidateBounds) : *candidateBounds;
+                            }
+                        }
+                    }
+                    segmentStart = segmentEnd;
+                }
+
+                aQueue.swap(tCompiled);
+                tCompiled.clear();
+                if (aClips != nullptr)
+                    aClips->swap(tCompiledClips);
+
+                if (dump_batches())
+                {
+                    std::cerr << "graphics_operation::compile: after:" << std::endl;
+                    dump(std::cerr, aQueue);
+                }
+            }
+        }
+
+        void compile(queue& aQueue)
+        {
+            do_compile(aQueue, nullptr);
+        }
+
+        void compile(queue& aQueue, clip_list& aClips)
+        {
+            do_compile(aQueue, &aClips);
+        }
+
+        bool dump_batches()
+        {
+            return sDumpBatches;
+        }
+
+        void set_dump_batches(bool aDumpBatches)
+        {
+            sDumpBatches = aDumpBatches;
+        }
+
+        void dump(std::ostream& aStream, const queue& aQueue)
+        {
+            std::size_t drawCalls = 0;
+            for (auto batchStart = aQueue.begin(); batchStart != aQueue.end();)
+            {
+                auto batchEnd = std::next(batchStart);
+                while (batchEnd != aQueue.end() && batchable(*batchStart, *batchEnd))
+                    ++batchEnd;
+                if (drawing_operation(*batchStart) || batchStart->index() == operation_type::DrawEntities)
+                    ++drawCalls;
+                aStream << "  " << to_string(static_cast<operation_type>(batchStart->index())) << " x " << (batchEnd - batchStart) << std::endl;
+                batchStart = batchEnd;
+            }
+            aStream << "  (" << aQueue.size() << " operation(s), " << drawCalls << " draw call(s))" << std::endl;
+        }
     }
 }
\ No newline at end of file
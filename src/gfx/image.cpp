@@ -40,7 +40,7 @@ namespace neogfx
         iSampling{ aSampling }
     {
         resize(aSize);
-        for (coordinate y = 0.0; y < aSize.cx; ++y)
+        for (coordinate y = 0.0; y < aSize.cy; ++y)
             for (coordinate x = 0.0; x < aSize.cx; ++x)
                 set_pixel(point{ x, y }, aColor);
     }
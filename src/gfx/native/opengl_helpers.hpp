@@ -20,8 +20,13 @@
 #pragma once
 
 #include <neogfx/neogfx.hpp>
+#include <array>
+#include <list>
+#include <map>
+#include <chrono>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
+#include <neogfx/game/mesh.hpp>
 #include "opengl.hpp"
 
 namespace neogfx
@@ -248,6 +253,13 @@ namespace neogfx
 
     class opengl_standard_vertex_arrays
     {
+    public:
+        // The vertex buffer is a ring of segments; a segment is only rewritten once the fence placed after
+        // the last draw sourcing it has signalled so the CPU can fill one segment while the GPU reads others.
+        // Each segment is its own buffer holding only the vertices written to it (its used count) so moving
+        // to the next segment never pads the remainder of the previous one.
+        static constexpr std::size_t SegmentCount = 3u;
+        static constexpr std::size_t SegmentCapacity = 16384u;
     public:
         // Formally this is being far too clever for one's own good as formally this is UB (Undefined Behaviour)
         // as I am treating non-POD (vec3) as POD (by mapping it to OpenGL). May need to rethink this...
@@ -256,6 +268,7 @@ namespace neogfx
             vec3f xyz;
             vec4f rgba;
             vec2f st;
+            vec4f clip; // window coordinates (left, bottom, right, top); unclipped if right <= left
             vertex(const vec3f& xyz = vec3f{}) :
                 xyz{ xyz }
             {
@@ -269,6 +282,7 @@ namespace neogfx
                 static constexpr std::size_t xyz = 0u;
                 static constexpr std::size_t rgba = xyz + sizeof(decltype(vertex::xyz));
                 static constexpr std::size_t st = rgba + sizeof(decltype(vertex::rgba));
+                static constexpr std::size_t clip = st + sizeof(decltype(vertex::st));
             };
         };
         typedef std::vector<vertex, opengl_buffer_allocator<vertex>> vertex_array;
@@ -284,11 +298,11 @@ namespace neogfx
         public:
             const vertex_array& vertices() const
             {
-                return iParent.iVertices;
+                return iParent.vertices();
             }
             vertex_array& vertices()
             {
-                return iParent.iVertices;
+                return iParent.vertices();
             }
             const optional_mat44& transformation() const
             {
@@ -298,10 +312,18 @@ namespace neogfx
             {
                 iParent.iTransformation = aTransformation;
             }
+            std::size_t room() const
+            {
+                return iParent.room();
+            }
             void execute()
             {
                 iParent.execute();
             }
+            void next_segment()
+            {
+                iParent.next_segment();
+            }
         private:
             opengl_standard_vertex_arrays& iParent;
         };
@@ -314,7 +336,8 @@ namespace neogfx
                 iVertexBuffer{ aVertexBuffer },
                 iCapacity{ aVertexBuffer.size() },
                 iVertexPositionAttribArray{ aVertexBuffer, false, sizeof(vertex), vertex::offset::xyz, aShaderProgram, "VertexPosition" },
-                iVertexColorAttribArray{ aVertexBuffer, false, sizeof(vertex), vertex::offset::rgba, aShaderProgram, "VertexColor" }
+                iVertexColorAttribArray{ aVertexBuffer, false, sizeof(vertex), vertex::offset::rgba, aShaderProgram, "VertexColor" },
+                iVertexClipRectAttribArray{ aVertexBuffer, false, sizeof(vertex), vertex::offset::clip, aShaderProgram, "VertexClipRect" }
             {
                 if (aWithTextureCoords)
                     iVertexTextureCoordAttribArray.emplace(aVertexBuffer, false, sizeof(vertex), vertex::offset::st, aShaderProgram, "VertexTextureCoord");
@@ -338,13 +361,24 @@ namespace neogfx
             opengl_vertex_array iVao;
             opengl_vertex_attrib_array<vertex, decltype(vertex::xyz)> iVertexPositionAttribArray;
             opengl_vertex_attrib_array<vertex, decltype(vertex::rgba)> iVertexColorAttribArray;
+            opengl_vertex_attrib_array<vertex, decltype(vertex::clip)> iVertexClipRectAttribArray;
             std::optional<opengl_vertex_attrib_array<vertex, decltype(vertex::st)>> iVertexTextureCoordAttribArray;
         };
     public:
         opengl_standard_vertex_arrays() :
-            iShaderProgram{ nullptr }
+            iShaderProgram{ nullptr },
+            iSegmentFences{},
+            iSegment{ 0u },
+            iFencedUpTo{ 0u }
         {
-            iVertices.reserve(16384);
+            for (auto& segment : iSegments)
+                segment.reserve(SegmentCapacity);
+        }
+        ~opengl_standard_vertex_arrays()
+        {
+            for (auto& fence : iSegmentFences)
+                if (fence != nullptr)
+                    glDeleteSync(fence);
         }
     public:
         void instantiate(i_rendering_context& aContext, i_shader_program& aShaderProgram)
@@ -355,27 +389,80 @@ namespace neogfx
         {
             do_instantiate(aContext, aShaderProgram, true);
         }
+        // fence the draws submitted so far; does not wait for the GPU
         void execute()
         {
-            GLsync sync;
-            glCheck(sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
-            glCheck(glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, ~0ull));
-            glCheck(glDeleteSync(sync));
+            if (vertices().size() > iFencedUpTo)
+            {
+                service<i_rendering_engine>().frame_stats().bytesStreamed += (vertices().size() - iFencedUpTo) * sizeof(vertex);
+                iFencedUpTo = vertices().size();
+            }
+            auto& fence = iSegmentFences[iSegment];
+            if (fence != nullptr)
+                glCheck(glDeleteSync(fence));
+            glCheck(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+            ++service<i_rendering_engine>().frame_stats().fences;
+        }
+        // continue writing at the start of the next segment once the GPU has finished reading it
+        void next_segment()
+        {
+            execute();
+            iSegment = (iSegment + 1u) % SegmentCount;
+            wait_for_segment(iSegment);
+            vertices().clear();
+            iFencedUpTo = 0u;
+            ++service<i_rendering_engine>().frame_stats().segmentsRecycled;
         }
         std::size_t capacity() const
         {
-            return iVertices.capacity();
+            return SegmentCapacity;
+        }
+        std::size_t room() const
+        {
+            return SegmentCapacity - vertices().size();
+        }
+    private:
+        const vertex_array& vertices() const
+        {
+            return iSegments[iSegment];
+        }
+        vertex_array& vertices()
+        {
+            return iSegments[iSegment];
+        }
+        void wait_for_segment(std::size_t aSegment)
+        {
+            auto& fence = iSegmentFences[aSegment];
+            if (fence == nullptr)
+                return;
+            GLenum result;
+            glCheck(result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0u));
+            if (result == GL_TIMEOUT_EXPIRED)
+            {
+                auto& stats = service<i_rendering_engine>().frame_stats();
+                ++stats.fenceWaits;
+                auto const waitStart = std::chrono::high_resolution_clock::now();
+                glCheck(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, ~0ull));
+                stats.fenceWaitTime += std::chrono::duration_cast<frame_stats::duration>(std::chrono::high_resolution_clock::now() - waitStart);
+            }
+            glCheck(glDeleteSync(fence));
+            fence = nullptr;
         }
     private:
         void do_instantiate(i_rendering_context& aContext, i_shader_program& aShaderProgram, bool aWithTextureCoords)
         {
-            if (iInstance.get() == nullptr || iInstance->capacity() < iVertices.capacity() || iShaderProgram != &aShaderProgram || iInstance->has_texture_coords() != aWithTextureCoords)
+            // each segment has its own buffer and so its own vertex array object
+            auto& segmentInstance = iInstances[iSegment];
+            if (segmentInstance.get() == nullptr || segmentInstance->capacity() < vertices().capacity() || iShaderProgram != &aShaderProgram || segmentInstance->has_texture_coords() != aWithTextureCoords)
             {
+                if (iShaderProgram != &aShaderProgram)
+                    for (auto& i : iInstances)
+                        i.reset();
                 iShaderProgram = &aShaderProgram;
-                iInstance.reset();
-                iInstance = std::make_unique<instance>(aShaderProgram, vertex_array::allocator_type::buffer(&iVertices[0]), aWithTextureCoords);
+                segmentInstance.reset();
+                segmentInstance = std::make_unique<instance>(aShaderProgram, vertex_array::allocator_type::buffer(vertices().data()), aWithTextureCoords);
             }
-            //iInstance->flush_buffer(iVertices.size());
+            //segmentInstance->flush_buffer(vertices().size());
             if (aShaderProgram.vertex_shader().has_standard_vertex_matrices())
             {
                 auto& standardMatrices = aShaderProgram.vertex_shader().standard_vertex_matrices();
@@ -385,9 +472,168 @@ namespace neogfx
         }
     private:
         i_shader_program* iShaderProgram;
-        std::unique_ptr<instance> iInstance;
-        vertex_array iVertices;
+        std::array<std::unique_ptr<instance>, SegmentCount> iInstances;
+        std::array<vertex_array, SegmentCount> iSegments;
         optional_mat44 iTransformation;
+        std::array<GLsync, SegmentCount> iSegmentFences;
+        std::size_t iSegment;
+        std::size_t iFencedUpTo;
+    };
+
+    // Shared meshes uploaded once (expanded to triangles with texture coordinates already mapped into the storage of
+    // the texture they are drawn with) and drawn with glDrawArraysInstanced; transformation, color and clip rectangle
+    // are streamed per instance. Uploaded meshes are keyed on the address of the shared mesh and keep a copy of its
+    // content which is compared on a hit so a mesh that is edited in place or freed and reallocated at the same address
+    // is uploaded again. The least recently used mesh is evicted when the cache is full.
+    class opengl_instanced_meshes
+    {
+    public:
+        static constexpr std::size_t MaxMeshes = 1024u;
+    public:
+        struct vertex
+        {
+            vec3f xyz;
+            vec2f st;
+            struct offset
+            {
+                static constexpr std::size_t xyz = 0u;
+                static constexpr std::size_t st = xyz + sizeof(decltype(vertex::xyz));
+            };
+        };
+        typedef std::vector<vertex> vertex_list;
+        struct instance
+        {
+            mat44f transformation;
+            vec4f rgba;
+            vec4f clip;
+            struct offset
+            {
+                static constexpr std::size_t transformation = 0u;
+                static constexpr std::size_t rgba = transformation + sizeof(decltype(instance::transformation));
+                static constexpr std::size_t clip = rgba + sizeof(decltype(instance::rgba));
+            };
+        };
+        typedef std::vector<instance> instance_list;
+        // texture coordinate mapping (coefficient, offset, storage extents) a mesh is uploaded with
+        typedef std::array<double, 6> uv_mapping;
+        // shared mesh and the texture coordinate mapping it was uploaded with
+        typedef std::pair<const game::mesh*, uv_mapping> mesh_key;
+    private:
+        struct mesh
+        {
+            mesh_key key;
+            game::mesh content;
+            GLuint vertexBuffer;
+            GLuint vertexArray;
+            GLsizei vertexCount;
+        };
+        typedef std::list<mesh> mesh_list; // most recently used first
+    public:
+        opengl_instanced_meshes() :
+            iInstanceBuffer{ 0 }
+        {
+        }
+        ~opengl_instanced_meshes()
+        {
+            clear();
+            if (iInstanceBuffer != 0)
+                glDeleteBuffers(1, &iInstanceBuffer);
+        }
+    public:
+        bool has_mesh(const mesh_key& aKey, const game::mesh& aMesh)
+        {
+            auto existing = iIndex.find(aKey);
+            if (existing == iIndex.end())
+                return false;
+            auto const& content = existing->second->content;
+            if (content.vertices != aMesh.vertices || content.uv != aMesh.uv || content.faces != aMesh.faces)
+                return false;
+            iMeshes.splice(iMeshes.begin(), iMeshes, existing->second);
+            return true;
+        }
+        void add_mesh(const mesh_key& aKey, const game::mesh& aMesh, const vertex_list& aVertices, const i_shader_program& aShaderProgram)
+        {
+            if (iInstanceBuffer == 0)
+                glCheck(glGenBuffers(1, &iInstanceBuffer));
+            auto existing = iIndex.find(aKey);
+            if (existing != iIndex.end())
+                remove(existing);
+            else if (iMeshes.size() >= MaxMeshes)
+                remove(iIndex.find(iMeshes.back().key));
+            GLint previousVertexArray;
+            glCheck(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray));
+            GLint previousBuffer;
+            glCheck(glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer));
+            iMeshes.push_front(mesh{ aKey, aMesh, 0, 0, static_cast<GLsizei>(aVertices.size()) });
+            auto& newMesh = iMeshes.front();
+            iIndex.emplace(aKey, iMeshes.begin());
+            glCheck(glGenBuffers(1, &newMesh.vertexBuffer));
+            glCheck(glBindBuffer(GL_ARRAY_BUFFER, newMesh.vertexBuffer));
+            glCheck(glBufferData(GL_ARRAY_BUFFER, aVertices.size() * sizeof(vertex), aVertices.data(), GL_STATIC_DRAW));
+            glCheck(glGenVertexArrays(1, &newMesh.vertexArray));
+            glCheck(glBindVertexArray(newMesh.vertexArray));
+            auto const program = to_gl_handle<GLuint>(aShaderProgram.handle());
+            auto attribute = [&](const char* aName, GLint aSize, std::size_t aStride, std::size_t aOffset, GLuint aDivisor, GLuint aLocations = 1u)
+            {
+                GLint location;
+                glCheck(location = glGetAttribLocation(program, aName));
+                if (location == -1)
+                    return;
+                for (GLuint i = 0u; i < aLocations; ++i)
+                {
+                    auto const index = static_cast<GLuint>(location) + i;
+                    glCheck(glVertexAttribPointer(index, aSize, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(aStride), reinterpret_cast<const GLvoid*>(aOffset + i * aSize * sizeof(float))));
+                    glCheck(glVertexAttribDivisor(index, aDivisor));
+                    glCheck(glEnableVertexAttribArray(index));
+                }
+            };
+            attribute("VertexPosition", 3, sizeof(vertex), vertex::offset::xyz, 0u);
+            attribute("VertexTextureCoord", 2, sizeof(vertex), vertex::offset::st, 0u);
+            glCheck(glBindBuffer(GL_ARRAY_BUFFER, iInstanceBuffer));
+            attribute("VertexColor", 4, sizeof(instance), instance::offset::rgba, 1u);
+            attribute("VertexClipRect", 4, sizeof(instance), instance::offset::clip, 1u);
+            attribute("VertexInstanceTransformation", 4, sizeof(instance), instance::offset::transformation, 1u, 4u);
+            glCheck(glBindVertexArray(static_cast<GLuint>(previousVertexArray)));
+            glCheck(glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previousBuffer)));
+        }
+        // the standard shader program must already be instantiated with instancing enabled
+        void draw(const mesh_key& aKey, const instance_list& aInstances)
+        {
+            auto const& m = *iIndex.at(aKey);
+            GLint previousVertexArray;
+            glCheck(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVertexArray));
+            GLint previousBuffer;
+            glCheck(glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previousBuffer));
+            glCheck(glBindVertexArray(m.vertexArray));
+            glCheck(glBindBuffer(GL_ARRAY_BUFFER, iInstanceBuffer));
+            glCheck(glBufferData(GL_ARRAY_BUFFER, aInstances.size() * sizeof(instance), aInstances.data(), GL_STREAM_DRAW));
+            glCheck(glDrawArraysInstanced(GL_TRIANGLES, 0, m.vertexCount, static_cast<GLsizei>(aInstances.size())));
+            glCheck(glBindVertexArray(static_cast<GLuint>(previousVertexArray)));
+            glCheck(glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(previousBuffer)));
+        }
+        void clear()
+        {
+            for (auto& m : iMeshes)
+                destroy(m);
+            iMeshes.clear();
+            iIndex.clear();
+        }
+    private:
+        void remove(std::map<mesh_key, mesh_list::iterator>::iterator aIndexEntry)
+        {
+            destroy(*aIndexEntry->second);
+            iMeshes.erase(aIndexEntry->second);
+            iIndex.erase(aIndexEntry);
+        }
+        static void destroy(mesh& aMesh)
+        {
+            glDeleteVertexArrays(1, &aMesh.vertexArray);
+            glDeleteBuffers(1, &aMesh.vertexBuffer);
+        }
+    private:
+        mesh_list iMeshes;
+        std::map<mesh_key, mesh_list::iterator> iIndex;
+        GLuint iInstanceBuffer;
     };
 
     class use_shader_program
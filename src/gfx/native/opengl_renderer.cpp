@@ -78,7 +78,8 @@ namespace neogfx
         iLimitFrameRate{ true },
         iFrameRateLimit{ 60u },
         iSubpixelRendering{ false },
-        iLastGameRenderTime{ 0ull }
+        iLastGameRenderTime{ 0ull },
+        iFrameStatsOverlay{ false }
     {
 #ifdef _WIN32
         SetProcessDpiAwareness(PROCESS_PER_MONITOR_DPI_AWARE);
@@ -113,6 +114,7 @@ namespace neogfx
     {
         // We explictly destroy these OpenGL objects here when context should still exist
         iVertexArrays = std::nullopt;
+        iInstancedMeshes = std::nullopt;
         iFontManager = std::nullopt;
         iTextureManager = std::nullopt;
         iShaderPrograms.clear();
@@ -247,6 +249,13 @@ namespace neogfx
         return const_cast<opengl_standard_vertex_arrays&>(to_const(*this).vertex_arrays());
     }
 
+    opengl_instanced_meshes& opengl_renderer::instanced_meshes()
+    {
+        if (iInstancedMeshes == std::nullopt)
+            iInstancedMeshes.emplace();
+        return *iInstancedMeshes;
+    }
+
     i_texture& opengl_renderer::ping_pong_buffer1(const size& aExtents, texture_sampling aSampling)
     {
         auto& bufferTexture = create_ping_pong_buffer(iPingPongBuffer1s, aExtents, aSampling);
@@ -361,6 +370,42 @@ namespace neogfx
         return 0;
     }    
     
+    const neogfx::frame_stats& opengl_renderer::frame_stats() const
+    {
+        return iFrameStats;
+    }
+
+    neogfx::frame_stats& opengl_renderer::frame_stats()
+    {
+        return iFrameStats;
+    }
+
+    const neogfx::frame_stats& opengl_renderer::last_frame_stats() const
+    {
+        return iLastFrameStats;
+    }
+
+    void opengl_renderer::end_frame()
+    {
+        iLastFrameStats = iFrameStats;
+        iFrameStats = neogfx::frame_stats{};
+        iFrameStats.frame = iLastFrameStats.frame + 1u;
+        FrameCompleted.trigger(iLastFrameStats);
+    }
+
+    bool opengl_renderer::frame_stats_overlay_enabled() const
+    {
+        return iFrameStatsOverlay;
+    }
+
+    void opengl_renderer::enable_frame_stats_overlay(bool aEnable)
+    {
+        if (iFrameStatsOverlay == aEnable)
+            return;
+        iFrameStatsOverlay = aEnable;
+        service<i_surface_manager>().invalidate_surfaces();
+    }
+
     i_texture& opengl_renderer::create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, texture_sampling aSampling)
     {
         auto existing = aBufferList.lower_bound(std::make_pair(aSampling, aExtents));
@@ -55,6 +55,7 @@ namespace neogfx
         // events
     public:
         define_declared_event(SubpixelRenderingChanged, subpixel_rendering_changed)
+        define_declared_event(FrameCompleted, frame_completed, const neogfx::frame_stats&)
         // exceptions
     public:
         struct shader_program_error : i_rendering_engine::shader_program_error {
@@ -101,6 +102,7 @@ namespace neogfx
     public:
         const opengl_standard_vertex_arrays & vertex_arrays() const override;
         opengl_standard_vertex_arrays& vertex_arrays() override;
+        opengl_instanced_meshes& instanced_meshes();
     public:
         i_texture& ping_pong_buffer1(const size& aExtents, texture_sampling aSampling = texture_sampling::Multisample) override;
         i_texture& ping_pong_buffer2(const size& aExtents, texture_sampling aSampling = texture_sampling::Multisample) override;
@@ -121,6 +123,14 @@ namespace neogfx
         void register_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
         void unregister_frame_counter(i_widget& aWidget, uint32_t aDuration) override;
         uint32_t frame_counter(uint32_t aDuration) const override;
+    public:
+        const neogfx::frame_stats& frame_stats() const override;
+        neogfx::frame_stats& frame_stats() override;
+        const neogfx::frame_stats& last_frame_stats() const override;
+        void end_frame() override;
+        bool frame_stats_overlay_enabled() const override;
+        void enable_frame_stats_overlay(bool aEnable) override;
+    public:
         i_texture& create_ping_pong_buffer(ping_pong_buffers_t& aBufferList, const size& aExtents, texture_sampling aSampling);
     private:
         neogfx::renderer iRenderer;
@@ -131,10 +141,14 @@ namespace neogfx
         uint32_t iFrameRateLimit;
         bool iSubpixelRendering;
         mutable std::optional<opengl_standard_vertex_arrays> iVertexArrays;
+        std::optional<opengl_instanced_meshes> iInstancedMeshes;
         uint64_t iLastGameRenderTime;
         std::map<uint32_t, neogfx::frame_counter> iFrameCounters;
         ping_pong_buffers_t iPingPongBuffer1s;
         ping_pong_buffers_t iPingPongBuffer2s;
         ref_ptr<i_standard_shader_program> iDefaultShaderProgram;
+        neogfx::frame_stats iFrameStats;
+        neogfx::frame_stats iLastFrameStats;
+        bool iFrameStatsOverlay;
     };
 }
\ No newline at end of file
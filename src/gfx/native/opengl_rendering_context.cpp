@@ -31,9 +31,11 @@
 #include <neogfx/game/text_mesh.hpp>
 #include <neogfx/game/ecs_helpers.hpp>
 #include <neogfx/game/entity_info.hpp>
+#include <neogfx/game/simple_physics.hpp>
 #include "../../hid/native/i_native_surface.hpp"
 #include "i_native_texture.hpp"
 #include "../text/native/i_native_font_face.hpp"
+#include "opengl_renderer.hpp"
 #include "opengl_rendering_context.hpp"
 #include "opengl_vertex_arrays.hpp"
 
@@ -223,6 +225,79 @@ namespace neogfx
                 }
             }
         }
+
+        // runs of at least this many consecutive entities sharing a mesh are drawn with a single instanced draw call
+        constexpr std::size_t InstancingThreshold = 8u;
+
+        const game::texture* mesh_texture(const game::material& aMaterial)
+        {
+            if (aMaterial.texture != std::nullopt)
+                return &*aMaterial.texture;
+            else if (aMaterial.sharedTexture != std::nullopt)
+                return aMaterial.sharedTexture->ptr;
+            else
+                return nullptr;
+        }
+
+        texture_sampling mesh_texture_sampling(const game::texture& aTexture)
+        {
+            auto const& texture = *service<i_texture_manager>().find_texture(aTexture.id.cookie());
+            return aTexture.sampling != std::nullopt ? *aTexture.sampling : texture.sampling();
+        }
+
+        bool instanceable(const opengl_rendering_context::mesh_drawable& aDrawable)
+        {
+            if (aDrawable.filter->mesh != std::nullopt || aDrawable.filter->sharedMesh.ptr == nullptr)
+                return false;
+            auto const& renderer = *aDrawable.renderer;
+            if (!renderer.patches.empty() || renderer.barrier || renderer.material.gradient != std::nullopt)
+                return false;
+            auto const texture = mesh_texture(renderer.material);
+            if (texture != nullptr)
+            {
+                // scaled sampling depends on the output size of each instance
+                auto const sampling = mesh_texture_sampling(*texture);
+                if (sampling == texture_sampling::Scaled || sampling == texture_sampling::Multisample)
+                    return false;
+            }
+            return true;
+        }
+
+        opengl_instanced_meshes::uv_mapping instanced_mesh_uv_mapping(const opengl_rendering_context::mesh_drawable& aDrawable)
+        {
+            opengl_instanced_meshes::uv_mapping result = {};
+            auto const texture = mesh_texture(aDrawable.renderer->material);
+            if (texture != nullptr)
+            {
+                auto const& nativeTexture = *service<i_texture_manager>().find_texture(texture->id.cookie());
+                vec2 uvFixupOffset;
+                if (texture->type == texture_type::Texture)
+                    uvFixupOffset = vec2{ 1.0, 1.0 };
+                else if (texture->subTexture == std::nullopt)
+                    uvFixupOffset = nativeTexture.as_sub_texture().atlas_location().top_left().to_vec2();
+                else
+                    uvFixupOffset = texture->subTexture->min;
+                auto const storageExtents = nativeTexture.storage_extents().to_vec2();
+                result = { texture->extents.x, texture->extents.y, uvFixupOffset.x, uvFixupOffset.y, storageExtents.x, storageExtents.y };
+            }
+            return result;
+        }
+
+        bool same_instance_batch(const opengl_rendering_context::mesh_drawable& aFirst, const opengl_rendering_context::mesh_drawable& aNext)
+        {
+            if (aFirst.filter->sharedMesh.ptr != aNext.filter->sharedMesh.ptr || !instanceable(aNext))
+                return false;
+            auto const& firstMaterial = aFirst.renderer->material;
+            auto const& nextMaterial = aNext.renderer->material;
+            if (!game::batchable(firstMaterial, nextMaterial))
+                return false;
+            auto const firstTexture = mesh_texture(firstMaterial);
+            auto const nextTexture = mesh_texture(nextMaterial);
+            if (firstTexture == nullptr)
+                return nextTexture == nullptr;
+            return nextTexture != nullptr && firstTexture->id.cookie() == nextTexture->id.cookie() &&
+                instanced_mesh_uv_mapping(aFirst) == instanced_mesh_uv_mapping(aNext);
+        }
     }
 
     opengl_rendering_context::opengl_rendering_context(const i_render_target& aTarget, neogfx::blending_mode aBlendingMode) :
@@ -240,7 +315,7 @@ namespace neogfx
         set_smoothing_mode(neogfx::smoothing_mode::AntiAlias);
         iSink += render_target().target_deactivating([this]() 
         { 
-            flush(); 
+            flush(flush_reason::TargetDeactivating); 
         });
     }
 
@@ -260,7 +335,7 @@ namespace neogfx
         set_smoothing_mode(neogfx::smoothing_mode::AntiAlias);
         iSink += render_target().target_deactivating([this]()
         {
-            flush();
+            flush(flush_reason::TargetDeactivating);
         });
     }
 
@@ -281,7 +356,7 @@ namespace neogfx
         set_smoothing_mode(aOther.smoothing_mode());
         iSink += render_target().target_deactivating([this]()
         {
-            flush();
+            flush(flush_reason::TargetDeactivating);
         });
     }
 
@@ -393,22 +468,73 @@ namespace neogfx
         scoped_render_target srt{ render_target() };
 
         queue().push_back(aOperation);
+        ++rendering_engine().frame_stats().operations[aOperation.index()];
     }
 
     void opengl_rendering_context::flush()
+    {
+        flush(flush_reason::Requested);
+    }
+
+    void opengl_rendering_context::flush(flush_reason aReason)
     {
         if (queue().empty())
             return;
 
+        auto& stats = rendering_engine().frame_stats();
+        ++stats.flushes[static_cast<std::size_t>(aReason)];
+        auto const flushStart = std::chrono::high_resolution_clock::now();
+
         set_blending_mode(blending_mode());
 
+        // resolve the clip rectangle in effect for each operation; clipping is then done by the standard
+        // shader program (per vertex clip rectangle) so scissor operations need not break batches
+        iClips.clear();
+        {
+            thread_local std::vector<rect> tScissorRects;
+            tScissorRects = iScissorRects;
+            auto resolve = [&]() -> optional_rect
+            {
+                optional_rect result;
+                for (auto const& rect : tScissorRects)
+                    result = (result != std::nullopt ? result->intersection(rect) : rect);
+                return result;
+            };
+            auto clip = scissor_rect();
+            for (auto const& op : queue())
+            {
+                if (op.index() == graphics_operation::operation_type::ScissorOn)
+                {
+                    tScissorRects.push_back(static_variant_cast<const graphics_operation::scissor_on&>(op).rect);
+                    clip = resolve();
+                }
+                else if (op.index() == graphics_operation::operation_type::ScissorOff)
+                {
+                    if (!tScissorRects.empty())
+                        tScissorRects.pop_back();
+                    clip = resolve();
+                }
+                iClips.push_back(clip);
+            }
+        }
+
+        graphics_operation::compile(queue(), iClips);
+
         for (auto batchStart = queue().begin(); batchStart != queue().end();)
         {
+            // only these batch handlers apply the clip rectangle of each operation themselves
+            bool const clipPerOperation =
+                batchStart->index() == graphics_operation::operation_type::FillRect ||
+                batchStart->index() == graphics_operation::operation_type::FillShape ||
+                batchStart->index() == graphics_operation::operation_type::DrawGlyph;
             auto batchEnd = std::next(batchStart);
-            while (batchEnd != queue().end() && graphics_operation::batchable(*batchStart, *batchEnd))
+            while (batchEnd != queue().end() && graphics_operation::batchable(*batchStart, *batchEnd) &&
+                (clipPerOperation || iClips[batchEnd - queue().begin()] == iClips[batchStart - queue().begin()]))
                 ++batchEnd;
             graphics_operation::batch const opBatch{ &*batchStart, &*batchStart + (batchEnd - batchStart) };
             batchStart = batchEnd;
+            ++stats.batches;
+            apply_clip(*opBatch.first);
             switch (opBatch.first->index())
             {
             case graphics_operation::operation_type::SetLogicalCoordinateSystem:
@@ -465,6 +591,15 @@ namespace neogfx
             case graphics_operation::operation_type::LineStippleOff:
                 line_stipple_off();
                 break;
+            case graphics_operation::operation_type::BlurOn:
+                {
+                    auto const& bo = static_variant_cast<const graphics_operation::blur_on&>(*(std::prev(opBatch.second)));
+                    blur_on(bo.algorithm, bo.direction, bo.radius, bo.sigma);
+                }
+                break;
+            case graphics_operation::operation_type::BlurOff:
+                blur_off();
+                break;
             case graphics_operation::operation_type::SubpixelRenderingOn:
                 subpixel_rendering_on();
                 break;
@@ -472,13 +607,20 @@ namespace neogfx
                 subpixel_rendering_off();
                 break;
             case graphics_operation::operation_type::Clear:
+                // glClear is not affected by the shader so fall back to real scissoring
+                apply_scissor(operation_clip(*opBatch.first));
                 clear(static_variant_cast<const graphics_operation::clear&>(*(std::prev(opBatch.second))).color);
+                apply_scissor(std::nullopt);
                 break;
             case graphics_operation::operation_type::ClearDepthBuffer:
+                apply_scissor(operation_clip(*opBatch.first));
                 clear_depth_buffer();
+                apply_scissor(std::nullopt);
                 break;
             case graphics_operation::operation_type::ClearStencilBuffer:
+                apply_scissor(operation_clip(*opBatch.first));
                 clear_stencil_buffer();
+                apply_scissor(std::nullopt);
                 break;
             case graphics_operation::operation_type::SetPixel:
                 for (auto op = opBatch.first; op != opBatch.second; ++op)
@@ -589,13 +731,17 @@ namespace neogfx
             }
         }
         queue().clear();
+        iClips.clear();
+        set_vertex_clip(scissor_rect());
+
+        stats.flushTime += std::chrono::duration_cast<frame_stats::duration>(std::chrono::high_resolution_clock::now() - flushStart);
     }
 
     void opengl_rendering_context::scissor_on(const rect& aRect)
     {
         iScissorRects.push_back(aRect);
         iScissorRect = std::nullopt;
-        apply_scissor();
+        set_vertex_clip(scissor_rect());
     }
 
     void opengl_rendering_context::scissor_off()
@@ -603,7 +749,7 @@ namespace neogfx
         if (!iScissorRects.empty())
             iScissorRects.pop_back();
         iScissorRect = std::nullopt;
-        apply_scissor();
+        set_vertex_clip(scissor_rect());
     }
 
     const optional_rect& opengl_rendering_context::scissor_rect() const
@@ -619,9 +765,47 @@ namespace neogfx
         return iScissorRect;
     }
 
-    void opengl_rendering_context::apply_scissor()
+    const vec4f& opengl_rendering_context::vertex_clip() const
+    {
+        return iVertexClip;
+    }
+
+    optional_rect opengl_rendering_context::operation_clip(const graphics_operation::operation& aOperation) const
+    {
+        if (!queue().empty() && &aOperation >= &queue().front() && &aOperation <= &queue().back())
+        {
+            auto const index = static_cast<std::size_t>(&aOperation - &queue().front());
+            if (index < iClips.size())
+                return iClips[index];
+        }
+        return scissor_rect();
+    }
+
+    void opengl_rendering_context::apply_clip(const graphics_operation::operation& aOperation)
+    {
+        set_vertex_clip(operation_clip(aOperation));
+    }
+
+    void opengl_rendering_context::set_vertex_clip(const optional_rect& aClipRect)
     {
-        auto sr = scissor_rect();
+        if (aClipRect != std::nullopt)
+        {
+            float const x = static_cast<float>(std::ceil(aClipRect->x));
+            float const y = static_cast<float>(logical_coordinates().is_gui_orientation() ? std::ceil(rendering_area(false).cy - aClipRect->cy - aClipRect->y) : aClipRect->y);
+            float const cx = static_cast<float>(std::ceil(aClipRect->cx));
+            float const cy = static_cast<float>(std::ceil(aClipRect->cy));
+            if (cx > 0.0f && cy > 0.0f)
+                iVertexClip = vec4f{{ x, y, x + cx, y + cy }};
+            else
+                iVertexClip = vec4f{{ -2.0f, -2.0f, -1.0f, -1.0f }}; // clip everything
+        }
+        else
+            iVertexClip = vec4f{};
+    }
+
+    void opengl_rendering_context::apply_scissor(const optional_rect& aScissorRect)
+    {
+        auto const& sr = aScissorRect;
         if (sr != std::nullopt)
         {
             glCheck(glEnable(GL_SCISSOR_TEST));
@@ -773,6 +957,16 @@ namespace neogfx
         rendering_engine().default_shader_program().stipple_shader().clear_stipple();
     }
 
+    void opengl_rendering_context::blur_on(blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma)
+    {
+        rendering_engine().default_shader_program().blur_shader().set_blur(aAlgorithm, aDirection, aRadius, aSigma);
+    }
+
+    void opengl_rendering_context::blur_off()
+    {
+        rendering_engine().default_shader_program().blur_shader().clear_blur();
+    }
+
     bool opengl_rendering_context::is_subpixel_rendering_on() const
     {
         return iSubpixelRendering;
@@ -1070,30 +1264,45 @@ namespace neogfx
         neolib::scoped_flag snap{ iSnapToPixel, false };
 
         iRenderingEngine.want_game_mode();
-        aEcs.component<game::rigid_body>().take_snapshot();
-        auto rigidBodiesSnapshot = aEcs.component<game::rigid_body>().snapshot();
-        auto const& rigidBodies = rigidBodiesSnapshot.data();
+        // physics publishes a snapshot of rigid bodies after each step; only take one here if nothing else will
+        auto& liveRigidBodies = aEcs.component<game::rigid_body>();
+        if (!aEcs.system_instantiated<game::simple_physics>() || aEcs.system<game::simple_physics>().paused() || !liveRigidBodies.have_snapshot())
+            liveRigidBodies.publish_snapshot();
+        auto const rigidBodiesSnapshot = liveRigidBodies.snapshot();
+        auto const& rigidBodies = *rigidBodiesSnapshot;
         thread_local std::vector<mesh_drawable> drawables;
-        for (auto entity : aEcs.component<game::mesh_renderer>().entities())
+        thread_local std::vector<game::entity_id> culled;
         {
-            if (entity == game::null_entity)
-                continue; // todo: sort/remove and/or create skipping iterator
-            #ifndef NDEBUG
-            if (aEcs.component<game::entity_info>().entity_record(entity).debug)
-                std::cerr << "Rendering debug entity..." << std::endl;
-            #endif
-            drawables.emplace_back(
-                aEcs.component<game::mesh_filter>().entity_record(entity), 
-                aEcs.component<game::mesh_renderer>().entity_record(entity),
-                rigidBodies.has_entity_record(entity) ? 
-                    to_transformation_matrix(rigidBodies.entity_record(entity)) : mat44::identity(),
-                entity);
+            // systems update components on worker threads and the ECS compacts them between steps, both under the
+            // component lock, so the records we draw from are read with those locks held
+            game::component_scoped_lock<game::mesh_renderer> lgMeshRenderers{ aEcs };
+            game::component_scoped_lock<game::mesh_filter> lgMeshFilters{ aEcs };
+            auto& meshFilterComponent = aEcs.component<game::mesh_filter>();
+            auto const meshRenderers = aEcs.component<game::mesh_renderer>().live_records();
+            for (auto iterMeshRenderer = meshRenderers.begin(); iterMeshRenderer != meshRenderers.end(); ++iterMeshRenderer)
+            {
+                auto const entity = iterMeshRenderer.entity();
+                #ifndef NDEBUG
+                if (aEcs.component<game::entity_info>().entity_record(entity).debug)
+                    std::cerr << "Rendering debug entity..." << std::endl;
+                #endif
+                drawables.emplace_back(
+                    meshFilterComponent.entity_record(entity), 
+                    *iterMeshRenderer,
+                    rigidBodies.has_entity_record(entity) ? 
+                        to_transformation_matrix(rigidBodies.entity_record(entity)) : mat44::identity(),
+                    entity);
+            }
+            draw_meshes(drawables.data(), drawables.data() + drawables.size(), aTransformation);
+            for (auto const& d : drawables)
+                if (!d.drawn && d.renderer->destroyOnFustrumCull)
+                    culled.push_back(d.entity);
+            drawables.clear();
         }
-        draw_meshes(&*drawables.begin(), &*drawables.begin() + drawables.size(), aTransformation);
-        for (auto const& d : drawables)
-            if (!d.drawn && d.renderer->destroyOnFustrumCull)
-                aEcs.destroy_entity(d.entity);
-        drawables.clear();
+        // culled entities are destroyed once the component locks are released
+        for (auto entity : culled)
+            aEcs.destroy_entity(entity);
+        culled.clear();
     }
 
     void opengl_rendering_context::fill_rect(const rect& aRect, const brush& aFill, scalar aZpos)
@@ -1120,6 +1329,7 @@ namespace neogfx
 
             for (auto op = aFillRectOps.first; op != aFillRectOps.second; ++op)
             {
+                apply_clip(*op);
                 auto& drawOp = static_variant_cast<const graphics_operation::fill_rect&>(*op);
                 auto rectVertices = rect_vertices(drawOp.rect, mesh_type::Triangles, drawOp.zpos);
                 for (const auto& v : rectVertices)
@@ -1283,6 +1493,7 @@ namespace neogfx
             use_vertex_arrays vertexArrays{ *this, GL_TRIANGLES };
             for (auto op = aFillShapeOps.first; op != aFillShapeOps.second; ++op)
             {
+                apply_clip(*op);
                 auto& drawOp = static_variant_cast<const graphics_operation::fill_shape&>(*op);
                 auto const& vertices = drawOp.mesh.vertices;
                 auto const& uv = drawOp.mesh.uv;
@@ -1326,16 +1537,21 @@ namespace neogfx
 
         thread_local std::vector<game::mesh_filter> meshFilters;
         thread_local std::vector<game::mesh_renderer> meshRenderers;
+        thread_local std::vector<vec4f> meshClips;
         thread_local std::vector<mesh_drawable> drawables;
 
         auto draw = [&]()
         {
             for (std::size_t i = 0; i < meshFilters.size(); ++i)
+            {
                 drawables.emplace_back(meshFilters[i], meshRenderers[i]);
+                drawables.back().clip = meshClips[i];
+            }
             if (!drawables.empty())
                 draw_meshes(&*drawables.begin(), &*drawables.begin() + drawables.size(), mat44::identity());
             meshFilters.clear();
             meshRenderers.clear();
+            meshClips.clear();
             drawables.clear();
         };
 
@@ -1348,6 +1564,7 @@ namespace neogfx
             case 1: // Paper (glyph background) and emoji
                 for (auto op = aDrawGlyphOps.first; op != aDrawGlyphOps.second; ++op)
                 {
+                    apply_clip(*op);
                     auto& drawOp = static_variant_cast<const graphics_operation::draw_glyph&>(*op);
 
                     if (!drawOp.glyph.is_whitespace() && !drawOp.glyph.is_emoji())
@@ -1365,6 +1582,8 @@ namespace neogfx
                             drawOp.point.z);
 
                         meshFilters.push_back(game::mesh_filter{ {}, mesh });
+
+                        meshClips.push_back(vertex_clip());
                         meshRenderers.push_back(
                             game::mesh_renderer{
                                 game::material{
@@ -1395,6 +1614,7 @@ namespace neogfx
                         auto const& emojiAtlas = rendering_engine().font_manager().emoji_atlas();
                         auto const& emojiTexture = emojiAtlas.emoji_texture(drawOp.glyph.value()).as_sub_texture();
                         meshFilters.push_back(game::mesh_filter{ game::shared<game::mesh>{}, mesh });
+                        meshClips.push_back(vertex_clip());
                         meshRenderers.push_back(game::mesh_renderer{ game::material{ {}, {}, {}, to_ecs_component(emojiTexture) } });
                     }
                 }
@@ -1404,46 +1624,88 @@ namespace neogfx
                 {
                     draw();
                     bool updateGlyphShader = true;
+                    std::optional<bool> glyphShaderDistanceField;
+                    std::optional<std::pair<scalar, scalar>> glyphShaderDistanceFieldEffect;
                     for (auto op = aDrawGlyphOps.first; op != aDrawGlyphOps.second; ++op)
                     {
+                        apply_clip(*op);
                         auto const& drawOp = static_variant_cast<const graphics_operation::draw_glyph&>(*op);
 
                         if (drawOp.glyph.is_whitespace() || drawOp.glyph.is_emoji())
                             continue;
 
-                        auto const& glyphTexture = drawOp.glyph.glyph_texture();
+                        auto const& glyphFont = drawOp.glyph.font();
+
+                        // distance field glyphs are rendered at a fixed size and scaled to the font's size
+                        bool const distanceField = drawOp.glyph.distance_field();
+                        auto const& glyphTexture = distanceField ? drawOp.glyph.distance_field_glyph_texture(glyphFont) : drawOp.glyph.glyph_texture(glyphFont);
+                        scalar const glyphScale = distanceField ? glyphFont.distance_field_scale() : 1.0;
+                        point const glyphPlacement = glyphTexture.placement() * glyphScale;
+                        size const glyphExtents = glyphTexture.texture().extents() * glyphScale;
+
+                        if (pass == 3 && glyphTexture.placeholder())
+                        {
+                            // the glyph cell is repainted once the glyph has been rasterized; allow for overhang and effects
+                            rect placeholderRect{ point{ drawOp.point }, size{ drawOp.glyph.advance().cx, glyphFont.height() } };
+                            if (logical_coordinates().is_game_orientation())
+                                placeholderRect.y = render_target().target_extents().cy - placeholderRect.bottom();
+                            auto const effectWidth = drawOp.appearance.effect() ? drawOp.appearance.effect()->width() : 0.0;
+                            placeholderRect.inflate(glyphFont.height() / 2.0 + effectWidth, effectWidth);
+                            rendering_engine().font_manager().placeholder_glyph_drawn(render_target(), glyphFont.native_font_face(), drawOp.glyph, placeholderRect);
+                        }
 
-                        bool const renderEffects = !drawOp.appearance.only_calculate_effect() && drawOp.appearance.effect() && drawOp.appearance.effect()->type() == text_effect_type::Outline;
+                        bool const renderEffects = !drawOp.appearance.only_calculate_effect() && drawOp.appearance.effect() && 
+                            (drawOp.appearance.effect()->type() == text_effect_type::Outline || (distanceField && drawOp.appearance.effect()->type() == text_effect_type::Glow));
                         if (!renderEffects && pass == 2)
                             continue;
 
+                        if (!updateGlyphShader && glyphShaderDistanceField != distanceField)
+                        {
+                            draw();
+                            updateGlyphShader = true;
+                        }
                         if (updateGlyphShader)
                         {
                             updateGlyphShader = false;
                             rendering_engine().default_shader_program().glyph_shader().set_first_glyph(*this, drawOp.glyph);
+                            glyphShaderDistanceField = distanceField;
+                            glyphShaderDistanceFieldEffect = std::make_pair(0.0, 0.0);
+                        }
+                        if (pass == 2 && distanceField)
+                        {
+                            // an outline dilates the field; a glow additionally softens it
+                            auto const dilation = std::min(drawOp.appearance.effect()->width() / (2.0 * glyphFont.distance_field_spread()), 0.5);
+                            auto const effect = drawOp.appearance.effect()->type() == text_effect_type::Glow ?
+                                std::make_pair(dilation * 0.5, dilation * 0.5) : std::make_pair(dilation, 0.0);
+                            if (glyphShaderDistanceFieldEffect != effect)
+                            {
+                                draw();
+                                rendering_engine().default_shader_program().glyph_shader().set_distance_field_effect(effect.first, effect.second);
+                                glyphShaderDistanceFieldEffect = effect;
+                            }
                         }
 
                         bool const subpixelRender = drawOp.glyph.subpixel() && glyphTexture.subpixel();
 
-                        auto const& glyphFont = drawOp.glyph.font();
-
                         vec3 glyphOrigin{
-                            drawOp.point.x + glyphTexture.placement().x,
+                            drawOp.point.x + glyphPlacement.x,
                             logical_coordinates().is_game_orientation() ?
-                                drawOp.point.y + (glyphTexture.placement().y + -glyphFont.descender()) :
-                                drawOp.point.y + glyphFont.height() - (glyphTexture.placement().y + -glyphFont.descender()) - glyphTexture.texture().extents().cy,
+                                drawOp.point.y + (glyphPlacement.y + -glyphFont.descender()) :
+                                drawOp.point.y + glyphFont.height() - (glyphPlacement.y + -glyphFont.descender()) - glyphExtents.cy,
                             drawOp.point.z };
 
                         if (pass == 2)
                         {
-                            auto const scanlineOffsets = (pass == 2 ? static_cast<uint32_t>(drawOp.appearance.effect()->width()) * 2u + 1u : 1u);
+                            // a distance field effect is a single quad as the field's spread already covers it
+                            auto const effectWidth = distanceField ? 0.0 : drawOp.appearance.effect()->width();
+                            auto const scanlineOffsets = static_cast<uint32_t>(effectWidth) * 2u + 1u;
                             auto const offsets = scanlineOffsets * scanlineOffsets;
-                            point const offsetOrigin{ pass == 2 ? -drawOp.appearance.effect()->width() : 0.0, pass == 2 ? -drawOp.appearance.effect()->width() : 0.0 };
+                            point const offsetOrigin{ -effectWidth, -effectWidth };
                             for (uint32_t offset = 0; offset < offsets; ++offset)
                             {
                                 rect const outputRect = {
                                         point{ glyphOrigin } + offsetOrigin + point{ static_cast<coordinate>(offset % scanlineOffsets), static_cast<coordinate>(offset / scanlineOffsets) },
-                                        glyphTexture.texture().extents() };
+                                        glyphExtents };
                                 bool haveGradient = drawOp.appearance.effect() && std::holds_alternative<gradient>(drawOp.appearance.effect()->color());
                                 if (haveGradient)
                                 {
@@ -1462,6 +1724,7 @@ namespace neogfx
                                         mesh_type::Triangles,
                                         drawOp.point.z);
                                 meshFilters.push_back(game::mesh_filter{ {}, mesh });
+                                meshClips.push_back(vertex_clip());
                                 if (std::holds_alternative<color>(drawOp.appearance.effect()->color()))
                                     meshRenderers.push_back(
                                         game::mesh_renderer{
@@ -1494,7 +1757,7 @@ namespace neogfx
                         }
                         else
                         {
-                            rect const outputRect = { point{ glyphOrigin }, glyphTexture.texture().extents() };
+                            rect const outputRect = { point{ glyphOrigin }, glyphExtents };
                             bool haveGradient = std::holds_alternative<gradient>(drawOp.appearance.ink());
                             if (haveGradient)
                             {
@@ -1513,6 +1776,7 @@ namespace neogfx
                                     mesh_type::Triangles,
                                     drawOp.point.z);
                             meshFilters.push_back(game::mesh_filter{ {}, mesh });
+                            meshClips.push_back(vertex_clip());
                             if (std::holds_alternative<color>(drawOp.appearance.ink()))
                                 meshRenderers.push_back(
                                     game::mesh_renderer{
@@ -1575,6 +1839,27 @@ namespace neogfx
 
         for (auto m = aFirst; m != aLast; ++m)
         {
+            if (instanceable(*m))
+            {
+                auto runEnd = std::next(m);
+                while (runEnd != aLast && same_instance_batch(*m, *runEnd))
+                    ++runEnd;
+                if (static_cast<std::size_t>(std::distance(m, runEnd)) >= InstancingThreshold)
+                {
+                    // draw what has been patched so far first to preserve painter's order
+                    if (!patch.items.empty())
+                    {
+                        draw_patch(patch);
+                        patch.xyz.clear();
+                        patch.uv.clear();
+                        patch.items.clear();
+                    }
+                    draw_instanced(m, runEnd, aTransformation);
+                    m = std::prev(runEnd);
+                    continue;
+                }
+            }
+
             auto& mesh = *m;
             auto const& untransformed = (mesh.filter->mesh != std::nullopt ?
                 *mesh.filter->mesh : *mesh.filter->sharedMesh.ptr).vertices;
@@ -1601,7 +1886,8 @@ namespace neogfx
                 patch.items.emplace_back(mesh, offsetVertices, offsetTextureVertices, meshPatch.material, meshPatch.faces);
         }
 
-        draw_patch(patch);
+        if (!patch.items.empty())
+            draw_patch(patch);
     }
 
     void opengl_rendering_context::draw_patch(patch_drawable& aPatch)
@@ -1610,6 +1896,7 @@ namespace neogfx
         neolib::scoped_flag snap{ iSnapToPixel, false };
 
         auto const logicalCoordinates = logical_coordinates();
+        auto const previousVertexClip = vertex_clip();
 
         auto const& vertices = aPatch.xyz;
         auto const& textureVertices = aPatch.uv;
@@ -1660,31 +1947,8 @@ namespace neogfx
                 if (item->has_texture())
                 {
                     auto const& texture = *service<i_texture_manager>().find_texture(item->texture().id.cookie());
-
                     textureStorageExtents = texture.storage_extents().to_vec2();
-
-                    glCheck(glActiveTexture(sampling != texture_sampling::Multisample ? GL_TEXTURE1 : GL_TEXTURE2));
-
-                    previousTexture.emplace(0);
-                    glCheck(glGetIntegerv(sampling != texture_sampling::Multisample ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_2D_MULTISAMPLE, &*previousTexture));
-                    glCheck(glBindTexture(sampling != texture_sampling::Multisample ? GL_TEXTURE_2D : GL_TEXTURE_2D_MULTISAMPLE, static_cast<GLuint>(texture.native_handle())));
-                    if (sampling != texture_sampling::Multisample)
-                    {
-                        glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, sampling != texture_sampling::Nearest && sampling != texture_sampling::Data ? 
-                            GL_LINEAR : 
-                            GL_NEAREST));
-                        glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, sampling == texture_sampling::NormalMipmap ? 
-                            GL_LINEAR_MIPMAP_LINEAR : 
-                            sampling != texture_sampling::Nearest && sampling != texture_sampling::Data ? 
-                                GL_LINEAR : 
-                                GL_NEAREST));
-                    }
-
-                    rendering_engine().default_shader_program().texture_shader().set_texture(texture);
-                    rendering_engine().default_shader_program().texture_shader().set_effect(batchMaterial.shaderEffect != std::nullopt ?
-                        *batchMaterial.shaderEffect : shader_effect::None);
-                    if (texture.sampling() == texture_sampling::Multisample && render_target().target_texture().sampling() == texture_sampling::Multisample)
-                        enable_sample_shading(1.0);
+                    previousTexture = bind_mesh_texture(texture, sampling, batchMaterial);
                 }
                 else
                     rendering_engine().default_shader_program().texture_shader().clear_texture();
@@ -1715,6 +1979,8 @@ namespace neogfx
                     auto const offsetTextureVertices = item->offsetTextureVertices;
                     auto const& faces = *item->faces;
 
+                    iVertexClip = item->mesh->clip != std::nullopt ? *item->mesh->clip : previousVertexClip;
+
                     color colorizationColor{ 0xFF, 0xFF, 0xFF, 0xFF };
                     if (material.color != std::nullopt)
                         colorizationColor = material.color->rgba;
@@ -1749,9 +2015,145 @@ namespace neogfx
             }
 
             if (previousTexture != std::nullopt)
-                glCheck(glBindTexture(sampling != texture_sampling::Multisample ? GL_TEXTURE_2D : GL_TEXTURE_2D_MULTISAMPLE, static_cast<GLuint>(*previousTexture)));
+                unbind_mesh_texture(*previousTexture, sampling);
 
             disable_sample_shading();
         }
+
+        iVertexClip = previousVertexClip;
+    }
+
+    void opengl_rendering_context::draw_instanced(mesh_drawable* aFirst, mesh_drawable* aLast, const mat44& aTransformation)
+    {
+        use_shader_program usp{ *this, rendering_engine().default_shader_program() };
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+
+        auto& meshes = static_cast<opengl_renderer&>(rendering_engine()).instanced_meshes();
+        auto& shaderProgram = rendering_engine().default_shader_program();
+
+        auto const& first = *aFirst;
+        auto const& sharedMesh = *first.filter->sharedMesh.ptr;
+        auto const& material = first.renderer->material;
+        auto const meshTexture = mesh_texture(material);
+        opengl_instanced_meshes::mesh_key const key{ &sharedMesh, instanced_mesh_uv_mapping(first) };
+
+        if (!meshes.has_mesh(key, sharedMesh))
+        {
+            auto const uvFixupCoefficient = vec2{ key.second[0], key.second[1] };
+            auto const uvFixupOffset = vec2{ key.second[2], key.second[3] };
+            auto const textureStorageExtents = vec2{ key.second[4], key.second[5] };
+            thread_local opengl_instanced_meshes::vertex_list vertices;
+            vertices.clear();
+            for (auto const& face : sharedMesh.faces)
+                for (auto faceVertexIndex : face)
+                {
+                    vec2 uv = {};
+                    if (meshTexture != nullptr)
+                        uv = (sharedMesh.uv[faceVertexIndex].scale(uvFixupCoefficient) + uvFixupOffset).scale(1.0 / textureStorageExtents);
+                    vertices.push_back(opengl_instanced_meshes::vertex{ sharedMesh.vertices[faceVertexIndex].as<float>(), uv.as<float>() });
+                }
+            meshes.add_mesh(key, sharedMesh, vertices, shaderProgram);
+        }
+
+        auto const logicalCoordinates = logical_coordinates();
+        auto const visibleMin = logicalCoordinates.bottomLeft.min(logicalCoordinates.topRight);
+        auto const visibleMax = logicalCoordinates.bottomLeft.max(logicalCoordinates.topRight);
+        auto const meshBoundingRect = game::bounding_rect(sharedMesh);
+
+        thread_local opengl_instanced_meshes::instance_list instances;
+        instances.clear();
+        for (auto m = aFirst; m != aLast; ++m)
+        {
+            auto& mesh = *m;
+            auto const transformation = aTransformation * (mesh.filter->transformation != std::nullopt ? *mesh.filter->transformation : mat44::identity()) * mesh.transformation;
+            // an instance counts as drawn if its transformed bounding rectangle touches the visible area
+            vec3 const corners[] =
+            {
+                transformation * vec3{ meshBoundingRect.left(), meshBoundingRect.top(), 0.0 },
+                transformation * vec3{ meshBoundingRect.right(), meshBoundingRect.top(), 0.0 },
+                transformation * vec3{ meshBoundingRect.left(), meshBoundingRect.bottom(), 0.0 },
+                transformation * vec3{ meshBoundingRect.right(), meshBoundingRect.bottom(), 0.0 }
+            };
+            vec2 transformedMin = corners[0].xy;
+            vec2 transformedMax = corners[0].xy;
+            for (auto const& corner : corners)
+            {
+                transformedMin = transformedMin.min(vec2{ corner.xy });
+                transformedMax = transformedMax.max(vec2{ corner.xy });
+            }
+            if (transformedMin.x <= visibleMax.x && transformedMax.x >= visibleMin.x &&
+                transformedMin.y <= visibleMax.y && transformedMax.y >= visibleMin.y)
+                mesh.drawn = true;
+            color colorizationColor{ 0xFF, 0xFF, 0xFF, 0xFF };
+            if (mesh.renderer->material.color != std::nullopt)
+                colorizationColor = mesh.renderer->material.color->rgba;
+            instances.push_back(opengl_instanced_meshes::instance{
+                transformation.as<float>(),
+                vec4f{ {
+                    colorizationColor.red<float>(),
+                    colorizationColor.green<float>(),
+                    colorizationColor.blue<float>(),
+                    colorizationColor.alpha<float>() * static_cast<float>(iOpacity)} },
+                mesh.clip != std::nullopt ? *mesh.clip : vertex_clip() });
+        }
+
+        std::optional<GLint> previousTexture;
+        texture_sampling sampling = texture_sampling::Normal;
+        if (meshTexture != nullptr)
+        {
+            sampling = mesh_texture_sampling(*meshTexture);
+            previousTexture = bind_mesh_texture(*service<i_texture_manager>().find_texture(meshTexture->id.cookie()), sampling, material);
+        }
+        else
+            shaderProgram.texture_shader().clear_texture();
+
+        auto& standardMatrices = shaderProgram.vertex_shader().standard_vertex_matrices();
+        standardMatrices.set_transformation_matrix(std::nullopt);
+        standardMatrices.set_instanced(true);
+        shaderProgram.instantiate(*this);
+        meshes.draw(key, instances);
+        standardMatrices.set_instanced(false);
+
+        auto& stats = rendering_engine().frame_stats();
+        ++stats.drawCalls;
+        stats.instances += instances.size();
+
+        if (previousTexture != std::nullopt)
+            unbind_mesh_texture(*previousTexture, sampling);
+
+        disable_sample_shading();
+    }
+
+    GLint opengl_rendering_context::bind_mesh_texture(const i_texture& aTexture, texture_sampling aSampling, const game::material& aMaterial)
+    {
+        glCheck(glActiveTexture(aSampling != texture_sampling::Multisample ? GL_TEXTURE1 : GL_TEXTURE2));
+
+        GLint previousTexture = 0;
+        glCheck(glGetIntegerv(aSampling != texture_sampling::Multisample ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_2D_MULTISAMPLE, &previousTexture));
+        glCheck(glBindTexture(aSampling != texture_sampling::Multisample ? GL_TEXTURE_2D : GL_TEXTURE_2D_MULTISAMPLE, static_cast<GLuint>(aTexture.native_handle())));
+        if (aSampling != texture_sampling::Multisample)
+        {
+            glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, aSampling != texture_sampling::Nearest && aSampling != texture_sampling::Data ? 
+                GL_LINEAR : 
+                GL_NEAREST));
+            glCheck(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, aSampling == texture_sampling::NormalMipmap ? 
+                GL_LINEAR_MIPMAP_LINEAR : 
+                aSampling != texture_sampling::Nearest && aSampling != texture_sampling::Data ? 
+                    GL_LINEAR : 
+                    GL_NEAREST));
+        }
+
+        rendering_engine().default_shader_program().texture_shader().set_texture(aTexture);
+        rendering_engine().default_shader_program().texture_shader().set_effect(aMaterial.shaderEffect != std::nullopt ?
+            *aMaterial.shaderEffect : shader_effect::None);
+        if (aTexture.sampling() == texture_sampling::Multisample && render_target().target_texture().sampling() == texture_sampling::Multisample)
+            enable_sample_shading(1.0);
+
+        return previousTexture;
+    }
+
+    void opengl_rendering_context::unbind_mesh_texture(GLint aPreviousTexture, texture_sampling aSampling)
+    {
+        glCheck(glBindTexture(aSampling != texture_sampling::Multisample ? GL_TEXTURE_2D : GL_TEXTURE_2D_MULTISAMPLE, static_cast<GLuint>(aPreviousTexture)));
     }
 }
\ No newline at end of file
@@ -86,6 +86,7 @@ namespace neogfx
             mat44 transformation;
             game::entity_id entity;
             bool drawn;
+            std::optional<vec4f> clip;
             mesh_drawable(
                 game::mesh_filter const& filter, 
                 game::mesh_renderer const& renderer,
@@ -173,6 +174,7 @@ namespace neogfx
         void scissor_on(const rect& aRect);
         void scissor_off();
         const optional_rect& scissor_rect() const;
+        const vec4f& vertex_clip() const;
         bool multisample() const;
         void set_multisample(bool aMultisample);
         void enable_sample_shading(double aSampleShadingRate);
@@ -186,6 +188,8 @@ namespace neogfx
         void pop_logical_operation();
         void line_stipple_on(scalar aFactor, uint16_t aPattern, scalar aPosition);
         void line_stipple_off();
+        void blur_on(blurring_algorithm aAlgorithm, const vec2& aDirection, uint32_t aRadius, double aSigma);
+        void blur_off();
         bool is_subpixel_rendering_on() const;
         void subpixel_rendering_on();
         void subpixel_rendering_off();
@@ -214,11 +218,18 @@ namespace neogfx
         void draw_mesh(const game::mesh_filter& aMeshFilter, const game::mesh_renderer& aMeshRenderer, const mat44& aTransformation);
         void draw_meshes(mesh_drawable* aFirst, mesh_drawable* aLast, const mat44& aTransformation);
         void draw_patch(patch_drawable& aPatch);
+        void draw_instanced(mesh_drawable* aFirst, mesh_drawable* aLast, const mat44& aTransformation);
     public:
         neogfx::subpixel_format subpixel_format() const override;
     private:
-        void apply_scissor();
+        optional_rect operation_clip(const graphics_operation::operation& aOperation) const;
+        void flush(flush_reason aReason);
+        void apply_clip(const graphics_operation::operation& aOperation);
+        void set_vertex_clip(const optional_rect& aClipRect);
+        void apply_scissor(const optional_rect& aScissorRect);
         void apply_logical_operation();
+        GLint bind_mesh_texture(const i_texture& aTexture, texture_sampling aSampling, const game::material& aMaterial);
+        void unbind_mesh_texture(GLint aPreviousTexture, texture_sampling aSampling);
     private:
         i_rendering_engine& iRenderingEngine;
         const i_render_target& iTarget;
@@ -235,6 +246,8 @@ namespace neogfx
         std::list<use_shader_program> iShaderProgramStack;
         std::vector<rect> iScissorRects;
         mutable optional_rect iScissorRect;
+        graphics_operation::clip_list iClips;
+        vec4f iVertexClip;
         GLint iPreviousTexture;
         font iLastDrawGlyphFallbackFont;
         std::optional<uint8_t> iLastDrawGlyphFallbackFontIndex;
@@ -19,6 +19,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <neolib/set.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
 #include "opengl_shader_program.hpp"
 
 namespace neogfx
@@ -126,6 +127,7 @@ namespace neogfx
         {
             glCheck(glUseProgram(gl_handle()));
             set_active();
+            ++service<i_rendering_engine>().frame_stats().shaderProgramSwitches;
         }
     }
 
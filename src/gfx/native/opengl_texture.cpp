@@ -242,6 +242,8 @@ namespace neogfx
                                     data[(iSize.cy + 1 - y) * iStorageSize.cx + x][c] = imageData[(y - 1) * iSize.cx * 4 + (x - 1) * 4 + c] / 255.0f;
                     }
                     glCheck(glTexImage2D(GL_TEXTURE_2D, 0, std::get<0>(to_gl_enum(iDataFormat, kDataType)), static_cast<GLsizei>(iStorageSize.cx), static_cast<GLsizei>(iStorageSize.cy), 0, std::get<1>(to_gl_enum(iDataFormat, kDataType)), std::get<2>(to_gl_enum(iDataFormat, kDataType)), &data[0]));
+                    ++service<i_rendering_engine>().frame_stats().textureUploads;
+                    service<i_rendering_engine>().frame_stats().textureUploadTexels += static_cast<uint64_t>(iStorageSize.cx * iStorageSize.cy);
                     if (sampling() == texture_sampling::NormalMipmap)
                     {
                         glCheck(glGenerateMipmap(GL_TEXTURE_2D));
@@ -375,6 +377,8 @@ namespace neogfx
             GLint previousPackAlignment;
             glCheck(glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousPackAlignment))
             glCheck(glPixelStorei(GL_UNPACK_ALIGNMENT, aPackAlignment));
+            ++service<i_rendering_engine>().frame_stats().textureUploads;
+            service<i_rendering_engine>().frame_stats().textureUploadTexels += static_cast<uint64_t>(aRect.cx * aRect.cy);
             if (sampling() != texture_sampling::Data)
             {
                 glCheck(glTexSubImage2D(to_gl_enum(sampling()), 0,
@@ -44,8 +44,10 @@ namespace neogfx
                 iStart{ static_cast<GLint>(iUse.vertices().size()) }, 
                 iUseBarrier{ aUseBarrier }
             {
-                if (!room_for(aNeed) || aUseBarrier)
+                if (!room_for(aNeed))
                     execute();
+                else if (aUseBarrier)
+                    iUse.execute();
                 set_transformation(optional_mat44{});
                 if (!room_for(aNeed))
                     throw not_enough_room();
@@ -58,8 +60,10 @@ namespace neogfx
                 iStart{ static_cast<GLint>(iUse.vertices().size()) },
                 iUseBarrier{ aUseBarrier }
             {
-                if (!room_for(aNeed) || aUseBarrier)
+                if (!room_for(aNeed))
                     execute();
+                else if (aUseBarrier)
+                    iUse.execute();
                 set_transformation(aTransformation);
                 if (!room_for(aNeed))
                     throw not_enough_room();
@@ -72,8 +76,10 @@ namespace neogfx
                 iStart{ static_cast<GLint>(iUse.vertices().size()) },
                 iUseBarrier{ aUseBarrier }
             {
-                if (!room_for(aNeed) || aUseBarrier)
+                if (!room_for(aNeed))
                     execute();
+                else if (aUseBarrier)
+                    iUse.execute();
                 set_transformation(optional_mat44{});
                 if (!room_for(aNeed))
                     throw not_enough_room();
@@ -86,8 +92,10 @@ namespace neogfx
                 iStart{ static_cast<GLint>(iUse.vertices().size()) },
                 iUseBarrier{ aUseBarrier }
             {
-                if (!room_for(aNeed) || aUseBarrier)
+                if (!room_for(aNeed))
                     execute();
+                else if (aUseBarrier)
+                    iUse.execute();
                 set_transformation(aTransformation);
                 if (!room_for(aNeed))
                     throw not_enough_room();
@@ -160,6 +168,7 @@ namespace neogfx
                 if (!room_for(1))
                     execute();
                 vertices().push_back(aVertex);
+                vertices().back().clip = iParent.vertex_clip();
             }
             template <typename... Args>
             void emplace_back(Args&&... args)
@@ -167,24 +176,31 @@ namespace neogfx
                 if (!room_for(1))
                     execute();
                 vertices().emplace_back(std::forward<Args>(args)...);
+                vertices().back().clip = iParent.vertex_clip();
             }
             template <typename Iter>
             iterator insert(const_iterator aPos, Iter aFirst, Iter aLast)
             {
-                if (room_for(std::distance(aFirst, aLast)))
-                    return vertices().insert(aPos, aFirst, aLast);
+                auto const count = static_cast<std::size_t>(std::distance(aFirst, aLast));
+                iterator result;
+                if (room_for(count))
+                    result = vertices().insert(aPos, aFirst, aLast);
                 else
                 {
+                    // the buffer is mapped and may be in use by the GPU so it cannot be grown here
                     execute();
-                    if (!room_for(std::distance(aFirst, aLast)))
-                        vertices().reserve(std::distance(aFirst, aLast));
-                    return vertices().insert(vertices().begin(), aFirst, aLast);
+                    if (!room_for(count))
+                        throw not_enough_room();
+                    result = vertices().insert(vertices().end(), aFirst, aLast);
                 }
+                for (auto v = result; v != std::next(result, count); ++v)
+                    v->clip = iParent.vertex_clip();
+                return result;
             }
         public:
             std::size_t room() const
             {
-                return vertices().capacity() - vertices().size();
+                return iUse.room();
             }
             bool room_for(std::size_t aAmount) const
             {
@@ -192,10 +208,10 @@ namespace neogfx
             }
             void execute()
             {
+                ++iParent.rendering_engine().frame_stats().flushes[static_cast<std::size_t>(flush_reason::VertexBufferFull)];
                 draw();
-                iUse.execute();
-                iUse.vertices().clear();
-                iStart = 0;
+                iUse.next_segment();
+                iStart = static_cast<GLint>(vertices().size());
             }
             void draw()
             {
@@ -214,8 +230,11 @@ namespace neogfx
                     iParent.rendering_engine().vertex_arrays().instantiate(iParent, iParent.rendering_engine().active_shader_program());
                 else
                     iParent.rendering_engine().vertex_arrays().instantiate_with_texture_coords(iParent, iParent.rendering_engine().active_shader_program());
+                auto& stats = iParent.rendering_engine().frame_stats();
+                stats.verticesStreamed += aCount;
                 if (!iUseBarrier && mode() == translated_mode())
                 {
+                    ++stats.drawCalls;
                     glCheck(glDrawArrays(translated_mode(), iStart, static_cast<GLsizei>(aCount)));
                     iStart += static_cast<GLint>(aCount);
                 }
@@ -230,6 +249,7 @@ namespace neogfx
                     while (aCount > 0)
                     {
                         auto amount = std::min(chunk, aCount);
+                        ++stats.drawCalls;
                         glCheck(glDrawArrays(translated_mode(), iStart, static_cast<GLsizei>(amount)));
                         iStart += static_cast<GLint>(amount);
                         aCount -= amount;
@@ -0,0 +1,1180 @@
+// software_rendering_context.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <cstring>
+#include <map>
+#include <list>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEOGFX_SOFTWARE_RENDERER_SSE2
+#include <emmintrin.h>
+#endif
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <neolib/scoped.hpp>
+#include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/shapes.hpp>
+#include <neogfx/gfx/text/glyph.hpp>
+#include <neogfx/gfx/text/font.hpp>
+#include "../text/native/i_native_font_face.hpp"
+#include "software_rendering_context.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        // exact x / 255 (rounded) for x in [0, 255 * 255]
+        inline uint32_t div255(uint32_t aValue)
+        {
+            aValue += 128u;
+            return (aValue + (aValue >> 8u)) >> 8u;
+        }
+
+        inline uint8_t to_coverage(float aCoverage)
+        {
+            return static_cast<uint8_t>(aCoverage * 255.0f + 0.5f);
+        }
+
+        struct software_glyph
+        {
+            std::weak_ptr<i_native_font_face> face;
+            int32_t width = 0;
+            int32_t rows = 0;
+            point placement;
+            std::vector<uint8_t> coverage;
+        };
+
+        // Glyph coverage bitmaps rendered with FreeType directly as the glyph textures held by the font
+        // manager live in GPU memory. Least recently used bitmaps are discarded once the cache exceeds
+        // its byte budget; a returned reference remains valid until the next call.
+        const software_glyph& rasterize_glyph(const glyph& aGlyph, const font& aFont)
+        {
+            typedef std::pair<const i_native_font_face*, glyph::value_type> key_type;
+            typedef std::list<std::pair<key_type, software_glyph>> lru_list;
+            std::size_t const MaxCacheBytes = 4u * 1024u * 1024u;
+            thread_local lru_list tGlyphs;
+            thread_local std::map<key_type, lru_list::iterator> tGlyphIndex;
+            thread_local std::size_t tCacheBytes = 0u;
+            auto const face = aFont.native_font_face_ptr();
+            key_type const key{ &*face, aGlyph.value() };
+            auto existing = tGlyphIndex.find(key);
+            if (existing != tGlyphIndex.end())
+            {
+                tGlyphs.splice(tGlyphs.begin(), tGlyphs, existing->second);
+                if (!existing->second->second.face.expired())
+                    return existing->second->second;
+                // face destroyed and its address reused: rasterize afresh
+                tCacheBytes -= existing->second->second.coverage.size();
+                existing->second->second = software_glyph{};
+            }
+            else
+            {
+                existing = tGlyphIndex.emplace(key, tGlyphs.emplace(tGlyphs.begin(), key, software_glyph{})).first;
+                tCacheBytes += sizeof(lru_list::value_type);
+            }
+            while (tCacheBytes > MaxCacheBytes && tGlyphs.size() > 1u)
+            {
+                auto& lru = tGlyphs.back();
+                tCacheBytes -= sizeof(lru_list::value_type) + lru.second.coverage.size();
+                tGlyphIndex.erase(lru.first);
+                tGlyphs.pop_back();
+            }
+            auto& result = existing->second->second;
+            result.face = face;
+            auto const handle = static_cast<FT_Face>(face->handle());
+            if (FT_Load_Glyph(handle, aGlyph.value(), FT_LOAD_DEFAULT | FT_LOAD_NO_BITMAP) != FT_Err_Ok ||
+                FT_Render_Glyph(handle->glyph, FT_RENDER_MODE_NORMAL) != FT_Err_Ok)
+                return result;
+            FT_Bitmap const& bitmap = handle->glyph->bitmap;
+            result.width = static_cast<int32_t>(bitmap.width);
+            result.rows = static_cast<int32_t>(bitmap.rows);
+            result.placement = point{
+                handle->glyph->metrics.horiBearingX / 64.0,
+                (handle->glyph->metrics.horiBearingY - handle->glyph->metrics.height) / 64.0 };
+            result.coverage.resize(static_cast<std::size_t>(result.width * result.rows));
+            for (int32_t y = 0; y < result.rows; ++y)
+            {
+                auto const source = bitmap.buffer + static_cast<std::ptrdiff_t>(y) * bitmap.pitch;
+                auto const destination = &result.coverage[static_cast<std::size_t>(y * result.width)];
+                for (int32_t x = 0; x < result.width; ++x)
+                {
+                    switch (bitmap.pixel_mode)
+                    {
+                    case FT_PIXEL_MODE_GRAY:
+                        destination[x] = source[x];
+                        break;
+                    case FT_PIXEL_MODE_MONO:
+                        destination[x] = ((source[x / 8] >> (7 - x % 8)) & 1) ? 0xFF : 0x00;
+                        break;
+                    default:
+                        destination[x] = 0x00;
+                        break;
+                    }
+                }
+            }
+            tCacheBytes += result.coverage.size();
+            return result;
+        }
+
+        // signed area/coverage accumulation (as used by font-rs): each edge deposits the change in
+        // coverage it causes into the cells it crosses; a running sum along each scanline yields the
+        // exact area coverage of every pixel for any mix of contours.
+        class coverage_accumulator
+        {
+        public:
+            coverage_accumulator(std::vector<float>& aBuffer, int32_t aWidth, int32_t aHeight) :
+                iBuffer{ aBuffer }, iWidth{ aWidth }, iHeight{ aHeight }, iStride{ aWidth + 2 }
+            {
+                iBuffer.assign(static_cast<std::size_t>(iStride * iHeight), 0.0f);
+            }
+        public:
+            int32_t width() const
+            {
+                return iWidth;
+            }
+            int32_t height() const
+            {
+                return iHeight;
+            }
+            const float* row(int32_t aY) const
+            {
+                return &iBuffer[static_cast<std::size_t>(aY * iStride)];
+            }
+            void add_edge(const vec2& aFrom, const vec2& aTo)
+            {
+                // split at the horizontal bounds then clamp: anything to the left of the region becomes a
+                // vertical edge on its boundary and so still contributes coverage to the whole scanline
+                auto from = aFrom;
+                scalar const right = static_cast<scalar>(iWidth);
+                std::array<scalar, 2> const boundaries = aFrom.x < aTo.x ? std::array<scalar, 2>{ 0.0, right } : std::array<scalar, 2>{ right, 0.0 };
+                for (auto const boundary : boundaries)
+                {
+                    if ((from.x < boundary) != (aTo.x < boundary))
+                    {
+                        auto const t = (boundary - from.x) / (aTo.x - from.x);
+                        vec2 const mid{ boundary, from.y + (aTo.y - from.y) * t };
+                        add_clamped_line(from, mid);
+                        from = mid;
+                    }
+                }
+                add_clamped_line(from, aTo);
+            }
+        private:
+            void add_clamped_line(const vec2& aFrom, const vec2& aTo)
+            {
+                auto const clamp = [&](scalar aX) { return static_cast<float>(std::max<scalar>(0.0, std::min<scalar>(iWidth, aX))); };
+                add_line(clamp(aFrom.x), static_cast<float>(aFrom.y), clamp(aTo.x), static_cast<float>(aTo.y));
+            }
+            void add_line(float aX0, float aY0, float aX1, float aY1)
+            {
+                if (aY0 == aY1)
+                    return;
+                float direction = 1.0f;
+                if (aY0 > aY1)
+                {
+                    std::swap(aX0, aX1);
+                    std::swap(aY0, aY1);
+                    direction = -1.0f;
+                }
+                float const dxdy = (aX1 - aX0) / (aY1 - aY0);
+                float x = aX0;
+                if (aY0 < 0.0f)
+                    x -= aY0 * dxdy;
+                int32_t const yStart = std::max(0, static_cast<int32_t>(std::floor(aY0)));
+                int32_t const yEnd = std::min(iHeight, static_cast<int32_t>(std::ceil(aY1)));
+                for (int32_t y = yStart; y < yEnd; ++y)
+                {
+                    float* const line = &iBuffer[static_cast<std::size_t>(y * iStride)];
+                    float const dy = std::min(static_cast<float>(y + 1), aY1) - std::max(static_cast<float>(y), aY0);
+                    float const xNext = std::max(0.0f, std::min(static_cast<float>(iWidth), x + dxdy * dy));
+                    float const d = dy * direction;
+                    float const left = std::min(x, xNext);
+                    float const right = std::max(x, xNext);
+                    float const leftFloor = std::floor(left);
+                    int32_t const leftIndex = static_cast<int32_t>(leftFloor);
+                    float const rightCeil = std::ceil(right);
+                    int32_t const rightIndex = static_cast<int32_t>(rightCeil);
+                    if (rightIndex <= leftIndex + 1)
+                    {
+                        float const mid = 0.5f * (x + xNext) - leftFloor;
+                        line[leftIndex] += d - d * mid;
+                        line[leftIndex + 1] += d * mid;
+                    }
+                    else
+                    {
+                        float const s = 1.0f / (right - left);
+                        float const leftFraction = left - leftFloor;
+                        float const a0 = 0.5f * s * (1.0f - leftFraction) * (1.0f - leftFraction);
+                        float const rightFraction = right - rightCeil + 1.0f;
+                        float const am = 0.5f * s * rightFraction * rightFraction;
+                        line[leftIndex] += d * a0;
+                        if (rightIndex == leftIndex + 2)
+                            line[leftIndex + 1] += d * (1.0f - a0 - am);
+                        else
+                        {
+                            float const a1 = s * (1.5f - leftFraction);
+                            line[leftIndex + 1] += d * (a1 - a0);
+                            for (int32_t xi = leftIndex + 2; xi < rightIndex - 1; ++xi)
+                                line[xi] += d * s;
+                            float const a2 = a1 + static_cast<float>(rightIndex - leftIndex - 3) * s;
+                            line[rightIndex - 1] += d * (1.0f - a2 - am);
+                        }
+                        line[rightIndex] += d * am;
+                    }
+                    x = xNext;
+                }
+            }
+        private:
+            std::vector<float>& iBuffer;
+            int32_t iWidth;
+            int32_t iHeight;
+            int32_t iStride;
+        };
+
+        void add_contour(software_rendering_context::contour_list& aContours, const vertices& aVertices, std::size_t aFirst = 0u)
+        {
+            aContours.emplace_back();
+            for (auto v = std::next(aVertices.begin(), aFirst); v != aVertices.end(); ++v)
+                aContours.back().push_back(vec2{ v->x, v->y });
+        }
+
+        scalar signed_area(const software_rendering_context::contour& aContour)
+        {
+            scalar result = 0.0;
+            for (std::size_t i = 0u; i < aContour.size(); ++i)
+            {
+                auto const& p0 = aContour[i];
+                auto const& p1 = aContour[(i + 1u) % aContour.size()];
+                result += p0.x * p1.y - p1.x * p0.y;
+            }
+            return result * 0.5;
+        }
+    }
+
+    class software_rendering_context::paint
+    {
+    public:
+        paint(const color& aColor, double aOpacity) :
+            iSolid{ aColor.with_combined_alpha(aOpacity) }
+        {
+        }
+        paint(const gradient& aGradient, const rect& aBoundingRect, double aOpacity) :
+            iDirection{ aGradient.direction() },
+            iBoundingRect{ aBoundingRect }
+        {
+            for (std::size_t i = 0u; i < iLut.size(); ++i)
+                iLut[i] = aGradient.at(static_cast<double>(i) / (iLut.size() - 1u)).with_combined_alpha(aOpacity);
+        }
+    public:
+        static std::optional<paint> from(const brush& aBrush, const rect& aBoundingRect, double aOpacity)
+        {
+            if (std::holds_alternative<color>(aBrush))
+                return paint{ static_variant_cast<const color&>(aBrush), aOpacity };
+            else if (std::holds_alternative<gradient>(aBrush))
+                return paint{ static_variant_cast<const gradient&>(aBrush), aBoundingRect, aOpacity };
+            // texture brushes would require a CPU copy of GPU resident textures
+            return {};
+        }
+    public:
+        bool is_solid() const
+        {
+            return iSolid != std::nullopt;
+        }
+        const color& solid() const
+        {
+            return *iSolid;
+        }
+        const color& at(int32_t aX, int32_t aY) const
+        {
+            if (is_solid())
+                return solid();
+            auto const cx = std::max(iBoundingRect.cx, 1.0);
+            auto const cy = std::max(iBoundingRect.cy, 1.0);
+            auto const dx = (aX + 0.5 - iBoundingRect.x) / cx;
+            auto const dy = (aY + 0.5 - iBoundingRect.y) / cy;
+            scalar position = 0.0;
+            switch (iDirection)
+            {
+            case gradient_direction::Vertical:
+                position = dy;
+                break;
+            case gradient_direction::Horizontal:
+                position = dx;
+                break;
+            case gradient_direction::Diagonal:
+                position = (dx + dy) / 2.0;
+                break;
+            case gradient_direction::Rectangular:
+                position = std::max(std::abs(dx - 0.5), std::abs(dy - 0.5)) * 2.0;
+                break;
+            case gradient_direction::Radial:
+                position = std::sqrt((dx - 0.5) * (dx - 0.5) + (dy - 0.5) * (dy - 0.5)) * 2.0;
+                break;
+            }
+            position = std::max(0.0, std::min(1.0, position));
+            return iLut[static_cast<std::size_t>(position * (iLut.size() - 1u) + 0.5)];
+        }
+    private:
+        std::optional<color> iSolid;
+        gradient_direction iDirection = gradient_direction::Vertical;
+        rect iBoundingRect;
+        std::array<color, 256> iLut;
+    };
+
+    software_rendering_context::software_rendering_context(const software_render_target& aTarget, neogfx::blending_mode aBlendingMode) :
+        iTarget{ aTarget },
+        iFramebuffer{ const_cast<software_render_target&>(aTarget).image() },
+        iOpacity{ 1.0 },
+        iBlendingMode{ aBlendingMode },
+        iSmoothingMode{ neogfx::smoothing_mode::AntiAlias },
+        iSnapToPixel{ false }
+    {
+        iSink += render_target().target_deactivating([this]()
+        {
+            flush();
+        });
+    }
+
+    software_rendering_context::software_rendering_context(const software_rendering_context& aOther) :
+        iTarget{ aOther.iTarget },
+        iFramebuffer{ aOther.iFramebuffer },
+        iLogicalCoordinateSystem{ aOther.iLogicalCoordinateSystem },
+        iLogicalCoordinates{ aOther.iLogicalCoordinates },
+        iOpacity{ 1.0 },
+        iBlendingMode{ aOther.iBlendingMode },
+        iSmoothingMode{ aOther.iSmoothingMode },
+        iSnapToPixel{ false }
+    {
+        iSink += render_target().target_deactivating([this]()
+        {
+            flush();
+        });
+    }
+
+    software_rendering_context::~software_rendering_context()
+    {
+    }
+
+    std::unique_ptr<i_rendering_context> software_rendering_context::clone() const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context(*this));
+    }
+
+    i_rendering_engine& software_rendering_context::rendering_engine()
+    {
+        // the service is the GPU engine (if there is one) which knows nothing of this context's target
+        throw no_rendering_engine();
+    }
+
+    const i_render_target& software_rendering_context::render_target() const
+    {
+        return iTarget;
+    }
+
+    const i_render_target& software_rendering_context::render_target()
+    {
+        return iTarget;
+    }
+
+    rect software_rendering_context::rendering_area(bool aConsiderScissor) const
+    {
+        if (scissor_rect() == std::nullopt || !aConsiderScissor)
+            return rect{ point{}, render_target().target_extents() };
+        else
+            return *scissor_rect();
+    }
+
+    const graphics_operation::queue& software_rendering_context::queue() const
+    {
+        return iQueue;
+    }
+
+    graphics_operation::queue& software_rendering_context::queue()
+    {
+        return iQueue;
+    }
+
+    void software_rendering_context::enqueue(const graphics_operation::operation& aOperation)
+    {
+        queue().push_back(aOperation);
+    }
+
+    void software_rendering_context::flush()
+    {
+        if (queue().empty())
+            return;
+
+        for (auto batchStart = queue().begin(); batchStart != queue().end();)
+        {
+            auto batchEnd = std::next(batchStart);
+            while (batchEnd != queue().end() && graphics_operation::batchable(*batchStart, *batchEnd))
+                ++batchEnd;
+            graphics_operation::batch const opBatch{ &*batchStart, &*batchStart + (batchEnd - batchStart) };
+            batchStart = batchEnd;
+            switch (opBatch.first->index())
+            {
+            case graphics_operation::operation_type::SetLogicalCoordinateSystem:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_logical_coordinate_system(static_variant_cast<const graphics_operation::set_logical_coordinate_system&>(*op).system);
+                break;
+            case graphics_operation::operation_type::SetLogicalCoordinates:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_logical_coordinates(static_variant_cast<const graphics_operation::set_logical_coordinates&>(*op).coordinates);
+                break;
+            case graphics_operation::operation_type::ScissorOn:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    scissor_on(static_variant_cast<const graphics_operation::scissor_on&>(*op).rect);
+                break;
+            case graphics_operation::operation_type::ScissorOff:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    (void)op;
+                    scissor_off();
+                }
+                break;
+            case graphics_operation::operation_type::SnapToPixelOn:
+                set_snap_to_pixel(true);
+                break;
+            case graphics_operation::operation_type::SnapToPixelOff:
+                set_snap_to_pixel(false);
+                break;
+            case graphics_operation::operation_type::SetOpacity:
+                set_opacity(static_variant_cast<const graphics_operation::set_opacity&>(*(std::prev(opBatch.second))).opacity);
+                break;
+            case graphics_operation::operation_type::SetBlendingMode:
+                set_blending_mode(static_variant_cast<const graphics_operation::set_blending_mode&>(*(std::prev(opBatch.second))).blendingMode);
+                break;
+            case graphics_operation::operation_type::SetSmoothingMode:
+                set_smoothing_mode(static_variant_cast<const graphics_operation::set_smoothing_mode&>(*(std::prev(opBatch.second))).smoothingMode);
+                break;
+            case graphics_operation::operation_type::PushLogicalOperation:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    push_logical_operation(static_variant_cast<const graphics_operation::push_logical_operation&>(*op).logicalOperation);
+                break;
+            case graphics_operation::operation_type::PopLogicalOperation:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    (void)op;
+                    pop_logical_operation();
+                }
+                break;
+            case graphics_operation::operation_type::LineStippleOn:
+            case graphics_operation::operation_type::LineStippleOff:
+            case graphics_operation::operation_type::BlurOn:
+            case graphics_operation::operation_type::BlurOff:
+            case graphics_operation::operation_type::SubpixelRenderingOn:
+            case graphics_operation::operation_type::SubpixelRenderingOff:
+            case graphics_operation::operation_type::ClearDepthBuffer:
+            case graphics_operation::operation_type::ClearStencilBuffer:
+                // not supported by the software renderer (no depth/stencil buffers or shader effects)
+                break;
+            case graphics_operation::operation_type::Clear:
+                clear(static_variant_cast<const graphics_operation::clear&>(*(std::prev(opBatch.second))).color);
+                break;
+            case graphics_operation::operation_type::SetPixel:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    set_pixel(static_variant_cast<const graphics_operation::set_pixel&>(*op).point, static_variant_cast<const graphics_operation::set_pixel&>(*op).color);
+                break;
+            case graphics_operation::operation_type::DrawPixel:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    draw_pixel(static_variant_cast<const graphics_operation::draw_pixel&>(*op).point, static_variant_cast<const graphics_operation::draw_pixel&>(*op).color);
+                break;
+            case graphics_operation::operation_type::DrawLine:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_line&>(*op);
+                    draw_line(args.from, args.to, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_rect&>(*op);
+                    draw_rect(args.rect, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawRoundedRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_rounded_rect&>(*op);
+                    draw_rounded_rect(args.rect, args.radius, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawCircle:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_circle&>(*op);
+                    draw_circle(args.centre, args.radius, args.pen, args.startAngle);
+                }
+                break;
+            case graphics_operation::operation_type::DrawArc:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_arc&>(*op);
+                    draw_arc(args.centre, args.radius, args.startAngle, args.endAngle, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawPath:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_path&>(*op);
+                    draw_path(args.path, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawShape:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_shape&>(*op);
+                    draw_shape(args.mesh, args.position, args.pen);
+                }
+                break;
+            case graphics_operation::operation_type::DrawEntities:
+                // entities are rendered with GPU resident textures
+                break;
+            case graphics_operation::operation_type::FillRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::fill_rect&>(*op);
+                    fill_rect(args.rect, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillRoundedRect:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::fill_rounded_rect&>(*op);
+                    fill_rounded_rect(args.rect, args.radius, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillCircle:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::fill_circle&>(*op);
+                    fill_circle(args.centre, args.radius, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillArc:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::fill_arc&>(*op);
+                    fill_arc(args.centre, args.radius, args.startAngle, args.endAngle, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::FillPath:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                    fill_path(static_variant_cast<const graphics_operation::fill_path&>(*op).path, static_variant_cast<const graphics_operation::fill_path&>(*op).fill);
+                break;
+            case graphics_operation::operation_type::FillShape:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::fill_shape&>(*op);
+                    fill_shape(args.mesh, args.position, args.fill);
+                }
+                break;
+            case graphics_operation::operation_type::DrawGlyph:
+                draw_glyph(opBatch);
+                break;
+            case graphics_operation::operation_type::DrawMesh:
+                for (auto op = opBatch.first; op != opBatch.second; ++op)
+                {
+                    const auto& args = static_variant_cast<const graphics_operation::draw_mesh&>(*op);
+                    draw_mesh(args.mesh, args.material, args.transformation);
+                }
+                break;
+            }
+        }
+        queue().clear();
+    }
+
+    neogfx::logical_coordinate_system software_rendering_context::logical_coordinate_system() const
+    {
+        if (iLogicalCoordinateSystem != std::nullopt)
+            return *iLogicalCoordinateSystem;
+        return render_target().logical_coordinate_system();
+    }
+
+    void software_rendering_context::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem)
+    {
+        iLogicalCoordinateSystem = aSystem;
+    }
+
+    logical_coordinates software_rendering_context::logical_coordinates() const
+    {
+        if (iLogicalCoordinates != std::nullopt)
+            return *iLogicalCoordinates;
+        auto result = render_target().logical_coordinates();
+        if (logical_coordinate_system() != render_target().logical_coordinate_system())
+        {
+            switch (logical_coordinate_system())
+            {
+            case neogfx::logical_coordinate_system::Specified:
+                break;
+            case neogfx::logical_coordinate_system::AutomaticGame:
+                if (render_target().logical_coordinate_system() == neogfx::logical_coordinate_system::AutomaticGui)
+                    std::swap(result.bottomLeft.y, result.topRight.y);
+                break;
+            case neogfx::logical_coordinate_system::AutomaticGui:
+                std::swap(result.bottomLeft.y, result.topRight.y);
+                break;
+            }
+        }
+        return result;
+    }
+
+    void software_rendering_context::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates)
+    {
+        iLogicalCoordinates = aCoordinates;
+    }
+
+    vec2 software_rendering_context::offset() const
+    {
+        return (iOffset != std::nullopt ? *iOffset : vec2{}) + (snap_to_pixel() ? 0.5 : 0.0);
+    }
+
+    void software_rendering_context::set_offset(const optional_vec2& aOffset)
+    {
+        iOffset = aOffset;
+    }
+
+    bool software_rendering_context::snap_to_pixel() const
+    {
+        return iSnapToPixel;
+    }
+
+    void software_rendering_context::set_snap_to_pixel(bool aSnapToPixel)
+    {
+        iSnapToPixel = aSnapToPixel;
+    }
+
+    void software_rendering_context::scissor_on(const rect& aRect)
+    {
+        iScissorRects.push_back(aRect);
+        iScissorRect = std::nullopt;
+    }
+
+    void software_rendering_context::scissor_off()
+    {
+        if (!iScissorRects.empty())
+            iScissorRects.pop_back();
+        iScissorRect = std::nullopt;
+    }
+
+    const optional_rect& software_rendering_context::scissor_rect() const
+    {
+        if (iScissorRect == std::nullopt && !iScissorRects.empty())
+        {
+            iScissorRect = iScissorRects.front();
+            for (auto const& rect : iScissorRects)
+                iScissorRect = iScissorRect->intersection(rect);
+        }
+        return iScissorRect;
+    }
+
+    void software_rendering_context::set_opacity(double aOpacity)
+    {
+        iOpacity = aOpacity;
+    }
+
+    neogfx::blending_mode software_rendering_context::blending_mode() const
+    {
+        return iBlendingMode;
+    }
+
+    void software_rendering_context::set_blending_mode(neogfx::blending_mode aBlendingMode)
+    {
+        iBlendingMode = aBlendingMode;
+    }
+
+    neogfx::smoothing_mode software_rendering_context::smoothing_mode() const
+    {
+        return iSmoothingMode;
+    }
+
+    void software_rendering_context::set_smoothing_mode(neogfx::smoothing_mode aSmoothingMode)
+    {
+        iSmoothingMode = aSmoothingMode;
+    }
+
+    void software_rendering_context::push_logical_operation(logical_operation aLogicalOperation)
+    {
+        iLogicalOperationStack.push_back(aLogicalOperation);
+    }
+
+    void software_rendering_context::pop_logical_operation()
+    {
+        if (!iLogicalOperationStack.empty())
+            iLogicalOperationStack.pop_back();
+    }
+
+    void software_rendering_context::clear(const color& aColor)
+    {
+        auto const clip = clip_rect();
+        auto const stride = static_cast<int32_t>(iFramebuffer.extents().cx);
+        auto const pixels = static_cast<uint8_t*>(iFramebuffer.pixels());
+        auto const previousBlendingMode = iBlendingMode;
+        iBlendingMode = neogfx::blending_mode::Blit;
+        for (int32_t y = clip.y; y < clip.bottom(); ++y)
+            fill_solid_span(pixels + (static_cast<std::ptrdiff_t>(y) * stride + clip.x) * 4, clip.cx, aColor, 0xFF);
+        iBlendingMode = previousBlendingMode;
+    }
+
+    void software_rendering_context::set_pixel(const point& aPoint, const color& aColor)
+    {
+        auto const previousBlendingMode = iBlendingMode;
+        iBlendingMode = neogfx::blending_mode::Blit;
+        draw_pixel(aPoint, aColor);
+        iBlendingMode = previousBlendingMode;
+    }
+
+    void software_rendering_context::draw_pixel(const point& aPoint, const color& aColor)
+    {
+        fill_rect(rect{ aPoint, size{ 1.0, 1.0 } }, aColor);
+    }
+
+    void software_rendering_context::draw_line(const point& aFrom, const point& aTo, const pen& aPen)
+    {
+        stroke(vertices{ aFrom.to_vec3(), aTo.to_vec3() }, false, aPen, rect{ aFrom, aTo });
+    }
+
+    void software_rendering_context::draw_rect(const rect& aRect, const pen& aPen)
+    {
+        // the pen is drawn inside the rectangle, matching pixel snapped output of the OpenGL renderer
+        auto const outer = to_device(aRect);
+        auto const inner = deflate_rect(outer, aPen.width(), aPen.width());
+        contour_list contours;
+        contours.push_back(contour{ outer.top_left().to_vec2(), outer.top_right().to_vec2(), outer.bottom_right().to_vec2(), outer.bottom_left().to_vec2() });
+        if (inner.cx > 0.0 && inner.cy > 0.0)
+            contours.push_back(contour{ inner.top_left().to_vec2(), inner.bottom_left().to_vec2(), inner.bottom_right().to_vec2(), inner.top_right().to_vec2() });
+        auto const p = paint::from(to_brush(aPen.color()), outer, iOpacity);
+        if (!p)
+            return;
+        auto const previousSmoothingMode = iSmoothingMode;
+        iSmoothingMode = neogfx::smoothing_mode::None;
+        fill(contours, *p);
+        iSmoothingMode = previousSmoothingMode;
+    }
+
+    void software_rendering_context::draw_rounded_rect(const rect& aRect, dimension aRadius, const pen& aPen)
+    {
+        stroke(rounded_rect_vertices(aRect, aRadius, mesh_type::Outline), true, aPen, aRect);
+    }
+
+    void software_rendering_context::draw_circle(const point& aCentre, dimension aRadius, const pen& aPen, angle aStartAngle)
+    {
+        stroke(circle_vertices(aCentre, aRadius, aStartAngle, mesh_type::Outline), true, aPen, rect{ aCentre - point{ aRadius, aRadius }, size{ aRadius * 2.0 } });
+    }
+
+    void software_rendering_context::draw_arc(const point& aCentre, dimension aRadius, angle aStartAngle, angle aEndAngle, const pen& aPen)
+    {
+        stroke(arc_vertices(aCentre, aRadius, aStartAngle, aEndAngle, aCentre, mesh_type::Outline), false, aPen, rect{ aCentre - point{ aRadius, aRadius }, size{ aRadius * 2.0 } });
+    }
+
+    void software_rendering_context::draw_path(const path& aPath, const pen& aPen)
+    {
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() < 2)
+                continue;
+            vertices points;
+            for (auto const& p : subPath)
+                points.push_back(xyz{ p.x + aPath.position().x, p.y + aPath.position().y });
+            stroke(points, aPath.shape() == path_shape::LineLoop || aPath.shape() == path_shape::ConvexPolygon, aPen, aPath.bounding_rect());
+        }
+    }
+
+    void software_rendering_context::draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen)
+    {
+        vertices points;
+        for (auto const& v : aMesh.vertices)
+            points.push_back(v + aPosition);
+        if (!points.empty())
+            stroke(points, true, aPen, rect{ point{ aPosition }, size{} });
+    }
+
+    void software_rendering_context::fill_rect(const rect& aRect, const brush& aFill)
+    {
+        auto const deviceRect = to_device(aRect);
+        auto const p = paint::from(aFill, deviceRect, iOpacity);
+        if (!p)
+            return;
+        // pixel centre sampling (as for non-multisampled OpenGL rasterization) so that rectangles aligned to
+        // whole pixels produce no partially covered edges
+        rect_i32 const pixelRect{
+            point_i32{ static_cast<int32_t>(std::floor(deviceRect.x + 0.5)), static_cast<int32_t>(std::floor(deviceRect.y + 0.5)) },
+            point_i32{ static_cast<int32_t>(std::floor(deviceRect.right() + 0.5)), static_cast<int32_t>(std::floor(deviceRect.bottom() + 0.5)) } };
+        auto const area = pixelRect.intersection(clip_rect());
+        if (area.cx <= 0 || area.cy <= 0)
+            return;
+        iCoverage.assign(static_cast<std::size_t>(area.cx), 1.0f);
+        for (int32_t y = area.y; y < area.bottom(); ++y)
+            fill_span(area.x, y, area.cx, &iCoverage[0], *p);
+    }
+
+    void software_rendering_context::fill_rounded_rect(const rect& aRect, dimension aRadius, const brush& aFill)
+    {
+        auto const p = paint::from(aFill, to_device(aRect), iOpacity);
+        if (!p)
+            return;
+        contour_list contours;
+        add_contour(contours, rounded_rect_vertices(aRect, aRadius, mesh_type::Outline));
+        for (auto& v : contours.back())
+            v = to_device(v);
+        fill(contours, *p);
+    }
+
+    void software_rendering_context::fill_circle(const point& aCentre, dimension aRadius, const brush& aFill)
+    {
+        auto const p = paint::from(aFill, to_device(rect{ aCentre - point{ aRadius, aRadius }, size{ aRadius * 2.0 } }), iOpacity);
+        if (!p)
+            return;
+        contour_list contours;
+        add_contour(contours, circle_vertices(aCentre, aRadius, 0.0, mesh_type::Outline));
+        for (auto& v : contours.back())
+            v = to_device(v);
+        fill(contours, *p);
+    }
+
+    void software_rendering_context::fill_arc(const point& aCentre, dimension aRadius, angle aStartAngle, angle aEndAngle, const brush& aFill)
+    {
+        auto const p = paint::from(aFill, to_device(rect{ aCentre - point{ aRadius, aRadius }, size{ aRadius * 2.0 } }), iOpacity);
+        if (!p)
+            return;
+        contour_list contours;
+        add_contour(contours, arc_vertices(aCentre, aRadius, aStartAngle, aEndAngle, aCentre, mesh_type::TriangleFan));
+        for (auto& v : contours.back())
+            v = to_device(v);
+        fill(contours, *p);
+    }
+
+    void software_rendering_context::fill_path(const path& aPath, const brush& aFill)
+    {
+        auto const p = paint::from(aFill, to_device(aPath.bounding_rect()), iOpacity);
+        if (!p)
+            return;
+        contour_list contours;
+        for (auto const& subPath : aPath.sub_paths())
+        {
+            if (subPath.size() < 3)
+                continue;
+            contours.emplace_back();
+            for (auto const& v : subPath)
+                contours.back().push_back(to_device(vec2{ v.x + aPath.position().x, v.y + aPath.position().y }));
+        }
+        fill(contours, *p);
+    }
+
+    void software_rendering_context::fill_shape(const game::mesh& aMesh, const vec3& aPosition, const brush& aFill)
+    {
+        auto const vertex = [&](uint32_t aIndex)
+        {
+            return to_device(vec2{ aMesh.vertices[aIndex].x + aPosition.x, aMesh.vertices[aIndex].y + aPosition.y });
+        };
+        contour_list contours;
+        std::optional<rect> boundingRect;
+        for (auto const& face : aMesh.faces)
+        {
+            contours.push_back(contour{ vertex(face[0]), vertex(face[1]), vertex(face[2]) });
+            // adjacent triangles must share orientation for their common edges to cancel
+            if (signed_area(contours.back()) < 0.0)
+                std::swap(contours.back()[1], contours.back()[2]);
+            for (auto const& v : contours.back())
+                boundingRect = (boundingRect == std::nullopt ? rect{ point{ v }, size{} } : boundingRect->combine(rect{ point{ v }, size{} }));
+        }
+        if (boundingRect == std::nullopt)
+            return;
+        auto const p = paint::from(aFill, *boundingRect, iOpacity);
+        if (p)
+            fill(contours, *p);
+    }
+
+    void software_rendering_context::draw_glyph(const graphics_operation::batch& aDrawGlyphOps)
+    {
+        neolib::scoped_flag snap{ iSnapToPixel, false };
+
+        auto const draw = [&](const software_glyph& aGlyph, const rect& aGlyphRect, const color_or_gradient& aInk)
+        {
+            auto const p = paint::from(to_brush(aInk), aGlyphRect, iOpacity);
+            if (!p)
+                return;
+            auto const originX = static_cast<int32_t>(std::floor(aGlyphRect.x + 0.5));
+            auto const originY = static_cast<int32_t>(std::floor(aGlyphRect.y + 0.5));
+            auto const area = rect_i32{ point_i32{ originX, originY }, size_i32{ aGlyph.width, aGlyph.rows } }.intersection(clip_rect());
+            if (area.cx <= 0 || area.cy <= 0)
+                return;
+            iCoverage.resize(static_cast<std::size_t>(area.cx));
+            for (int32_t y = area.y; y < area.bottom(); ++y)
+            {
+                auto const source = &aGlyph.coverage[static_cast<std::size_t>((y - originY) * aGlyph.width + (area.x - originX))];
+                for (int32_t x = 0; x < area.cx; ++x)
+                    iCoverage[x] = source[x] / 255.0f;
+                fill_span(area.x, y, area.cx, &iCoverage[0], *p);
+            }
+        };
+
+        for (auto op = aDrawGlyphOps.first; op != aDrawGlyphOps.second; ++op)
+        {
+            auto const& drawOp = static_variant_cast<const graphics_operation::draw_glyph&>(*op);
+            font const& glyphFont = drawOp.glyph.font();
+            if (drawOp.appearance.paper() != std::nullopt)
+                fill_rect(rect{ point{ drawOp.point }, size{ drawOp.glyph.advance().cx, glyphFont.height() } }, to_brush(*drawOp.appearance.paper()));
+            // emoji are only available as GPU resident textures
+            if (drawOp.glyph.is_whitespace() || drawOp.glyph.is_emoji())
+                continue;
+            auto const& glyph = rasterize_glyph(drawOp.glyph, glyphFont);
+            if (glyph.coverage.empty())
+                continue;
+            size const glyphExtents{ static_cast<dimension>(glyph.width), static_cast<dimension>(glyph.rows) };
+            auto const glyphRect = to_device(logical_coordinates().is_game_orientation() ?
+                rect{ point{ drawOp.point.x + glyph.placement.x, drawOp.point.y + (glyph.placement.y + -glyphFont.descender()) }, glyphExtents } :
+                rect{ point{ drawOp.point.x + glyph.placement.x, drawOp.point.y + glyphFont.height() - (glyph.placement.y + -glyphFont.descender()) - glyphExtents.cy }, glyphExtents });
+            bool const renderEffects = !drawOp.appearance.only_calculate_effect() && drawOp.appearance.effect() && drawOp.appearance.effect()->type() == text_effect_type::Outline;
+            if (renderEffects)
+            {
+                auto const effectWidth = static_cast<int32_t>(drawOp.appearance.effect()->width());
+                for (int32_t dy = -effectWidth; dy <= effectWidth; ++dy)
+                    for (int32_t dx = -effectWidth; dx <= effectWidth; ++dx)
+                        draw(glyph, glyphRect + point{ static_cast<coordinate>(dx), static_cast<coordinate>(dy) }, drawOp.appearance.effect()->color());
+            }
+            if (!drawOp.appearance.only_calculate_effect())
+                draw(glyph, glyphRect, drawOp.appearance.ink());
+        }
+    }
+
+    void software_rendering_context::draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation)
+    {
+        // textured meshes would require a CPU copy of GPU resident textures
+        if (aMaterial.texture != std::nullopt || aMaterial.sharedTexture != std::nullopt)
+            return;
+        game::mesh transformed{ {}, {}, aMesh.faces };
+        for (auto const& v : aMesh.vertices)
+            transformed.vertices.push_back(aTransformation * v);
+        if (aMaterial.gradient != std::nullopt)
+        {
+            auto stops = gradient::color_stop_list{};
+            for (std::size_t i = 0u; i < aMaterial.gradient->colorStops.size(); ++i)
+                stops.emplace_back(aMaterial.gradient->colorStopPositions[i], color{ aMaterial.gradient->colorStops[i].rgba });
+            fill_shape(transformed, vec3{}, gradient{ stops });
+        }
+        else
+            fill_shape(transformed, vec3{}, aMaterial.color != std::nullopt ? color{ aMaterial.color->rgba } : color::White);
+    }
+
+    neogfx::subpixel_format software_rendering_context::subpixel_format() const
+    {
+        return neogfx::subpixel_format::None;
+    }
+
+    vec2 software_rendering_context::to_device(const vec2& aPoint) const
+    {
+        auto const& coordinates = logical_coordinates();
+        auto const extents = render_target().target_extents();
+        auto const point = aPoint + (iOffset != std::nullopt ? *iOffset : vec2{});
+        return vec2{
+            (point.x - coordinates.bottomLeft.x) / (coordinates.topRight.x - coordinates.bottomLeft.x) * extents.cx,
+            (point.y - coordinates.topRight.y) / (coordinates.bottomLeft.y - coordinates.topRight.y) * extents.cy };
+    }
+
+    rect software_rendering_context::to_device(const rect& aRect) const
+    {
+        auto const p0 = to_device(vec2{ aRect.x, aRect.y });
+        auto const p1 = to_device(vec2{ aRect.x + aRect.cx, aRect.y + aRect.cy });
+        return rect{ point{ std::min(p0.x, p1.x), std::min(p0.y, p1.y) }, point{ std::max(p0.x, p1.x), std::max(p0.y, p1.y) } };
+    }
+
+    rect_i32 software_rendering_context::clip_rect() const
+    {
+        rect_i32 const framebuffer{ point_i32{}, size_i32{ iFramebuffer.extents() } };
+        if (scissor_rect() == std::nullopt)
+            return framebuffer;
+        auto scissor = *scissor_rect();
+        if (logical_coordinates().is_game_orientation())
+            scissor.y = rendering_area(false).cy - scissor.cy - scissor.y;
+        scissor = scissor.ceil();
+        return framebuffer.intersection(rect_i32{
+            point_i32{ static_cast<int32_t>(scissor.x), static_cast<int32_t>(scissor.y) },
+            size_i32{ static_cast<int32_t>(scissor.cx), static_cast<int32_t>(scissor.cy) } });
+    }
+
+    void software_rendering_context::stroke(const vertices& aVertices, bool aClosed, const pen& aPen, const rect& aBoundingRect)
+    {
+        auto const p = paint::from(to_brush(aPen.color()), to_device(aBoundingRect), iOpacity);
+        if (!p || aPen.width() <= 0.0)
+            return;
+        // odd width lines on whole pixel coordinates are centred on pixels when snapping
+        vec2 const snapOffset = snap_to_pixel() && static_cast<int32_t>(aPen.width()) % 2 == 1 ? vec2{ 0.5, 0.5 } : vec2{};
+        auto const halfWidth = aPen.width() / 2.0;
+        contour_list contours;
+        auto const segments = aClosed ? aVertices.size() : aVertices.size() - 1u;
+        for (std::size_t i = 0u; i < segments; ++i)
+        {
+            auto const from = to_device(vec2{ aVertices[i].x, aVertices[i].y }) + snapOffset;
+            auto const to = to_device(vec2{ aVertices[(i + 1u) % aVertices.size()].x, aVertices[(i + 1u) % aVertices.size()].y }) + snapOffset;
+            auto const delta = to - from;
+            auto const length = delta.magnitude();
+            if (length == 0.0)
+                continue;
+            // segment quads all share the same orientation so overlapping joins do not cancel
+            vec2 const normal{ -delta.y / length * halfWidth, delta.x / length * halfWidth };
+            contours.push_back(contour{ from + normal, to + normal, to - normal, from - normal });
+        }
+        fill(contours, *p);
+    }
+
+    void software_rendering_context::fill(const contour_list& aContours, const paint& aPaint)
+    {
+        std::optional<std::pair<vec2, vec2>> bounds;
+        for (auto const& c : aContours)
+            for (auto const& v : c)
+            {
+                if (bounds == std::nullopt)
+                    bounds.emplace(v, v);
+                bounds->first = vec2{ std::min(bounds->first.x, v.x), std::min(bounds->first.y, v.y) };
+                bounds->second = vec2{ std::max(bounds->second.x, v.x), std::max(bounds->second.y, v.y) };
+            }
+        if (bounds == std::nullopt)
+            return;
+        auto const clip = clip_rect();
+        rect_i32 const area = clip.intersection(rect_i32{
+            point_i32{ static_cast<int32_t>(std::floor(bounds->first.x)), static_cast<int32_t>(std::floor(bounds->first.y)) },
+            point_i32{ static_cast<int32_t>(std::ceil(bounds->second.x)), static_cast<int32_t>(std::ceil(bounds->second.y)) } });
+        if (area.cx <= 0 || area.cy <= 0)
+            return;
+        coverage_accumulator accumulator{ iAccumulation, area.cx, area.cy };
+        vec2 const origin{ static_cast<scalar>(area.x), static_cast<scalar>(area.y) };
+        for (auto const& c : aContours)
+            for (std::size_t i = 0u; i < c.size(); ++i)
+                accumulator.add_edge(c[i] - origin, c[(i + 1u) % c.size()] - origin);
+        bool const antiAlias = (smoothing_mode() == neogfx::smoothing_mode::AntiAlias);
+        iCoverage.resize(static_cast<std::size_t>(area.cx));
+        for (int32_t y = 0; y < area.cy; ++y)
+        {
+            auto const row = accumulator.row(y);
+            float sum = 0.0f;
+            for (int32_t x = 0; x < area.cx; ++x)
+            {
+                sum += row[x];
+                auto const coverage = std::min(1.0f, std::abs(sum));
+                iCoverage[x] = antiAlias ? coverage : (coverage >= 0.5f ? 1.0f : 0.0f);
+            }
+            fill_span(area.x, area.y + y, area.cx, &iCoverage[0], aPaint);
+        }
+    }
+
+    void software_rendering_context::fill_span(int32_t aX, int32_t aY, int32_t aCount, const float* aCoverage, const paint& aPaint)
+    {
+        auto const stride = static_cast<int32_t>(iFramebuffer.extents().cx);
+        auto const row = static_cast<uint8_t*>(iFramebuffer.pixels()) + (static_cast<std::ptrdiff_t>(aY) * stride + aX) * 4;
+        for (int32_t i = 0; i < aCount;)
+        {
+            auto const coverage = to_coverage(aCoverage[i]);
+            if (coverage == 0x00)
+            {
+                ++i;
+                continue;
+            }
+            if (coverage == 0xFF && aPaint.is_solid() && iLogicalOperationStack.empty())
+            {
+                auto runEnd = i + 1;
+                while (runEnd < aCount && to_coverage(aCoverage[runEnd]) == 0xFF)
+                    ++runEnd;
+                fill_solid_span(row + static_cast<std::ptrdiff_t>(i) * 4, runEnd - i, aPaint.solid(), 0xFF);
+                i = runEnd;
+                continue;
+            }
+            blend_pixel(row + static_cast<std::ptrdiff_t>(i) * 4, aPaint.at(aX + i, aY), coverage);
+            ++i;
+        }
+    }
+
+    void software_rendering_context::fill_solid_span(uint8_t* aPixels, int32_t aCount, const color& aColor, uint8_t aCoverage)
+    {
+        bool const replace = (iBlendingMode != neogfx::blending_mode::Default);
+        auto const alpha = replace ? aColor.alpha() : static_cast<uint8_t>(div255(aColor.alpha() * aCoverage));
+        if (!replace && alpha == 0x00)
+            return;
+        if (aCoverage != 0xFF || !iLogicalOperationStack.empty())
+        {
+            for (int32_t i = 0; i < aCount; ++i)
+                blend_pixel(aPixels + static_cast<std::ptrdiff_t>(i) * 4, aColor, aCoverage);
+            return;
+        }
+        uint8_t const source[4] = { aColor.red(), aColor.green(), aColor.blue(), replace ? alpha : static_cast<uint8_t>(0xFF) };
+        uint32_t sourcePixel;
+        std::memcpy(&sourcePixel, source, sizeof(sourcePixel));
+        int32_t i = 0;
+        if (replace || alpha == 0xFF)
+        {
+#ifdef NEOGFX_SOFTWARE_RENDERER_SSE2
+            __m128i const fill = _mm_set1_epi32(static_cast<int>(sourcePixel));
+            for (; i + 4 <= aCount; i += 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(aPixels + static_cast<std::ptrdiff_t>(i) * 4), fill);
+#endif
+            for (; i < aCount; ++i)
+                std::memcpy(aPixels + static_cast<std::ptrdiff_t>(i) * 4, &sourcePixel, sizeof(sourcePixel));
+            return;
+        }
+        // constant alpha source-over; the alpha channel of the source is treated as opaque so the destination
+        // alpha becomes a + d * (1 - a)
+#ifdef NEOGFX_SOFTWARE_RENDERER_SSE2
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const sourceAlpha = _mm_set1_epi16(static_cast<short>(alpha));
+        __m128i const inverseAlpha = _mm_set1_epi16(static_cast<short>(0xFF - alpha));
+        __m128i const sourceTerm = _mm_add_epi16(
+            _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(sourcePixel)), zero), sourceAlpha),
+            _mm_set1_epi16(128));
+        for (; i + 4 <= aCount; i += 4)
+        {
+            auto const destination = reinterpret_cast<__m128i*>(aPixels + static_cast<std::ptrdiff_t>(i) * 4);
+            __m128i const pixels = _mm_loadu_si128(destination);
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), inverseAlpha), sourceTerm);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), inverseAlpha), sourceTerm);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128(destination, _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; i < aCount; ++i)
+        {
+            auto const destination = aPixels + static_cast<std::ptrdiff_t>(i) * 4;
+            for (std::size_t channel = 0u; channel < 4u; ++channel)
+                destination[channel] = static_cast<uint8_t>(div255(source[channel] * alpha + destination[channel] * (0xFFu - alpha)));
+        }
+    }
+
+    void software_rendering_context::blend_pixel(uint8_t* aPixel, const color& aColor, uint8_t aCoverage)
+    {
+        if (!iLogicalOperationStack.empty() && iLogicalOperationStack.back() == logical_operation::Xor)
+        {
+            aPixel[0] ^= aColor.red();
+            aPixel[1] ^= aColor.green();
+            aPixel[2] ^= aColor.blue();
+            return;
+        }
+        uint32_t const source[4] = { aColor.red(), aColor.green(), aColor.blue(), aColor.alpha() };
+        if (iBlendingMode != neogfx::blending_mode::Default)
+        {
+            for (std::size_t channel = 0u; channel < 4u; ++channel)
+                aPixel[channel] = static_cast<uint8_t>(div255(source[channel] * aCoverage + aPixel[channel] * (0xFFu - aCoverage)));
+            return;
+        }
+        auto const alpha = div255(source[3] * aCoverage);
+        for (std::size_t channel = 0u; channel < 3u; ++channel)
+            aPixel[channel] = static_cast<uint8_t>(div255(source[channel] * alpha + aPixel[channel] * (0xFFu - alpha)));
+        aPixel[3] = static_cast<uint8_t>(alpha + div255(aPixel[3] * (0xFFu - alpha)));
+    }
+}
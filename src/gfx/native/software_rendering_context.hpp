@@ -0,0 +1,124 @@
+// software_rendering_context.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/i_rendering_context.hpp>
+#include <neogfx/gfx/software_render_target.hpp>
+#include <neogfx/game/mesh.hpp>
+#include <neogfx/game/material.hpp>
+
+namespace neogfx
+{
+    // Consumes the graphics operation queue and rasterizes it on the CPU into the framebuffer of a
+    // software_render_target. Coverage is computed analytically (signed area accumulation) so anti-aliased
+    // output does not require multisampling. It is not part of a rendering engine so has none to return.
+    class software_rendering_context : public i_rendering_context
+    {
+    public:
+        struct no_rendering_engine : std::logic_error { no_rendering_engine() : std::logic_error("neogfx::software_rendering_context::no_rendering_engine") {} };
+    public:
+        typedef std::vector<vec2> contour;
+        typedef std::vector<contour> contour_list;
+    private:
+        class paint;
+    public:
+        software_rendering_context(const software_render_target& aTarget, blending_mode aBlendingMode = blending_mode::Default);
+        software_rendering_context(const software_rendering_context& aOther);
+        ~software_rendering_context();
+    public:
+        std::unique_ptr<i_rendering_context> clone() const override;
+    public:
+        i_rendering_engine& rendering_engine() override;
+        const i_render_target& render_target() const override;
+        const i_render_target& render_target() override;
+        rect rendering_area(bool aConsiderScissor = true) const override;
+    public:
+        const graphics_operation::queue& queue() const override;
+        graphics_operation::queue& queue() override;
+        void enqueue(const graphics_operation::operation& aOperation) override;
+        void flush() override;
+    public:
+        neogfx::logical_coordinate_system logical_coordinate_system() const;
+        void set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem);
+        neogfx::logical_coordinates logical_coordinates() const override;
+        void set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates);
+        vec2 offset() const override;
+        void set_offset(const optional_vec2& aOffset) override;
+        bool snap_to_pixel() const;
+        void set_snap_to_pixel(bool aSnapToPixel);
+        void scissor_on(const rect& aRect);
+        void scissor_off();
+        const optional_rect& scissor_rect() const;
+        void set_opacity(double aOpacity);
+        neogfx::blending_mode blending_mode() const;
+        void set_blending_mode(neogfx::blending_mode aBlendingMode);
+        neogfx::smoothing_mode smoothing_mode() const;
+        void set_smoothing_mode(neogfx::smoothing_mode aSmoothingMode);
+        void push_logical_operation(logical_operation aLogicalOperation);
+        void pop_logical_operation();
+        void clear(const color& aColor);
+        void set_pixel(const point& aPoint, const color& aColor);
+        void draw_pixel(const point& aPoint, const color& aColor);
+        void draw_line(const point& aFrom, const point& aTo, const pen& aPen);
+        void draw_rect(const rect& aRect, const pen& aPen);
+        void draw_rounded_rect(const rect& aRect, dimension aRadius, const pen& aPen);
+        void draw_circle(const point& aCentre, dimension aRadius, const pen& aPen, angle aStartAngle);
+        void draw_arc(const point& aCentre, dimension aRadius, angle aStartAngle, angle aEndAngle, const pen& aPen);
+        void draw_path(const path& aPath, const pen& aPen);
+        void draw_shape(const game::mesh& aMesh, const vec3& aPosition, const pen& aPen);
+        void fill_rect(const rect& aRect, const brush& aFill);
+        void fill_rounded_rect(const rect& aRect, dimension aRadius, const brush& aFill);
+        void fill_circle(const point& aCentre, dimension aRadius, const brush& aFill);
+        void fill_arc(const point& aCentre, dimension aRadius, angle aStartAngle, angle aEndAngle, const brush& aFill);
+        void fill_path(const path& aPath, const brush& aFill);
+        void fill_shape(const game::mesh& aMesh, const vec3& aPosition, const brush& aFill);
+        void draw_glyph(const graphics_operation::batch& aDrawGlyphOps);
+        void draw_mesh(const game::mesh& aMesh, const game::material& aMaterial, const mat44& aTransformation);
+    public:
+        neogfx::subpixel_format subpixel_format() const override;
+    private:
+        vec2 to_device(const vec2& aPoint) const;
+        rect to_device(const rect& aRect) const;
+        rect_i32 clip_rect() const;
+        void stroke(const vertices& aVertices, bool aClosed, const pen& aPen, const rect& aBoundingRect);
+        void fill(const contour_list& aContours, const paint& aPaint);
+        void fill_span(int32_t aX, int32_t aY, int32_t aCount, const float* aCoverage, const paint& aPaint);
+        void fill_solid_span(uint8_t* aPixels, int32_t aCount, const color& aColor, uint8_t aCoverage);
+        void blend_pixel(uint8_t* aPixel, const color& aColor, uint8_t aCoverage);
+    private:
+        const software_render_target& iTarget;
+        i_image& iFramebuffer;
+        mutable std::optional<neogfx::logical_coordinate_system> iLogicalCoordinateSystem;
+        mutable std::optional<neogfx::logical_coordinates> iLogicalCoordinates;
+        double iOpacity;
+        neogfx::blending_mode iBlendingMode;
+        neogfx::smoothing_mode iSmoothingMode;
+        std::vector<logical_operation> iLogicalOperationStack;
+        std::vector<rect> iScissorRects;
+        mutable optional_rect iScissorRect;
+        graphics_operation::queue iQueue;
+        std::vector<float> iAccumulation;
+        std::vector<float> iCoverage;
+        sink iSink;
+        optional_vec2 iOffset;
+        bool iSnapToPixel;
+    };
+}
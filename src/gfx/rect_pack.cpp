@@ -1,6 +1,6 @@
 // rect_pack.cpp
 /*
- *  Based on public domain code @ http://blackpawn.com/texts/lightmaps/default.html.
+ *  Skyline bottom-left rectangle packer with reuse of freed rectangles.
  *
  *  This implementation written by Leigh Johnston.
  *
@@ -38,52 +38,185 @@
 
 namespace neogfx
 {
-    rect_pack::node* rect_pack::node::insert(const size& aElementSize)
+    rect_pack::rect_pack(const size& aDimensions) :
+        iDimensions{ aDimensions }, iUsedArea{ 0.0 }, iUsedCount{ 0u }
+    {
+        reset();
+    }
+
+    const size& rect_pack::dimensions() const
+    {
+        return iDimensions;
+    }
+
+    dimension rect_pack::used_area() const
+    {
+        return iUsedArea;
+    }
+
+    dimension rect_pack::free_area() const
+    {
+        return iDimensions.cx * iDimensions.cy - iUsedArea;
+    }
+
+    dimension rect_pack::reusable_area() const
+    {
+        dimension result = 0.0;
+        for (auto const& free : iFree)
+            result += free.cx * free.cy;
+        return result;
+    }
+
+    bool rect_pack::empty() const
+    {
+        return iUsedCount == 0u;
+    }
+
+    bool rect_pack::insert(const size& aElementSize, rect& aResult)
+    {
+        if (!insert_free(aElementSize, aResult) && !insert_skyline(aElementSize, aResult))
+            return false;
+        iUsedArea += aElementSize.cx * aElementSize.cy;
+        ++iUsedCount;
+        return true;
+    }
+
+    void rect_pack::remove(const rect& aElement)
+    {
+        iUsedArea -= aElement.cx * aElement.cy;
+        if (--iUsedCount == 0u)
+            reset();
+        else
+            add_free(aElement);
+    }
+
+    void rect_pack::reset()
     {
-        if (!is_leaf())
+        iSkyline.assign(1, segment{ 0.0, 0.0, iDimensions.cx });
+        iFree.clear();
+        iUsedArea = 0.0;
+        iUsedCount = 0u;
+    }
+
+    bool rect_pack::insert_free(const size& aElementSize, rect& aResult)
+    {
+        // best area fit amongst freed rectangles; the remainder is split along the shorter leftover axis
+        auto best = iFree.end();
+        for (auto free = iFree.begin(); free != iFree.end(); ++free)
+            if (free->cx >= aElementSize.cx && free->cy >= aElementSize.cy && 
+                (best == iFree.end() || free->cx * free->cy < best->cx * best->cy))
+                best = free;
+        if (best == iFree.end())
+            return false;
+        rect const free = *best;
+        iFree.erase(best);
+        aResult = rect{ point{ free.x, free.y }, aElementSize };
+        auto const dw = free.cx - aElementSize.cx;
+        auto const dh = free.cy - aElementSize.cy;
+        if (dw > dh)
         {
-            auto result = iChildren[0]->insert(aElementSize);
-            if (result != nullptr)
-                return result;
-            return iChildren[1]->insert(aElementSize);
+            add_free(rect{ point{ free.x + aElementSize.cx, free.y }, size{ dw, free.cy } });
+            add_free(rect{ point{ free.x, free.y + aElementSize.cy }, size{ aElementSize.cx, dh } });
         }
-        if (iInUse)
-            return nullptr;
-        if (iRect.extents().cx < aElementSize.cx || iRect.extents().cy < aElementSize.cy)
-            return nullptr;
-        else if (iRect.extents() == aElementSize)
+        else
         {
-            iInUse = true;
-            return this;
+            add_free(rect{ point{ free.x, free.y + aElementSize.cy }, size{ free.cx, dh } });
+            add_free(rect{ point{ free.x + aElementSize.cx, free.y }, size{ dw, aElementSize.cy } });
         }
-        auto dw = iRect.width() - aElementSize.cx;
-        auto dh = iRect.height() - aElementSize.cy;
-        neogfx::rect rcChild0 = dw > dh ?
-            neogfx::rect{ iRect.left(), iRect.top(), iRect.left() + aElementSize.cx, iRect.bottom() } :
-            neogfx::rect{ iRect.left(), iRect.top(), iRect.right(), iRect.top() + aElementSize.cy };
-        neogfx::rect rcChild1 = dw > dh ?
-            neogfx::rect{ iRect.left() + aElementSize.cx, iRect.top(), iRect.right(), iRect.bottom() } :
-            neogfx::rect{ iRect.left(), iRect.top() + aElementSize.cy, iRect.right(), iRect.bottom() };
-        iChildren[0] = iAllocator.allocate(1);
-        iChildren[1] = iAllocator.allocate(1);
-        iAllocator.construct(iChildren[0], rcChild0, iAllocator);
-        iAllocator.construct(iChildren[1], rcChild1, iAllocator);
-        return iChildren[0]->insert(aElementSize);
+        return true;
     }
 
-    rect_pack::rect_pack(const size& aDimensions) :
-        iRoot{ rect{ point{}, aDimensions }, iAllocator }
+    bool rect_pack::insert_skyline(const size& aElementSize, rect& aResult)
     {
+        std::optional<std::size_t> bestSegment;
+        dimension bestY = 0.0;
+        dimension bestTop = 0.0;
+        for (std::size_t s = 0; s < iSkyline.size(); ++s)
+        {
+            dimension y;
+            if (fits(s, aElementSize, y) && (bestSegment == std::nullopt || y + aElementSize.cy < bestTop))
+            {
+                bestSegment = s;
+                bestY = y;
+                bestTop = y + aElementSize.cy;
+            }
+        }
+        if (bestSegment == std::nullopt)
+            return false;
+        aResult = rect{ point{ iSkyline[*bestSegment].x, bestY }, aElementSize };
+        // space trapped beneath the new element is handed to the free list so it can be reused
+        auto const right = aResult.x + aElementSize.cx;
+        auto s = *bestSegment;
+        while (s < iSkyline.size() && iSkyline[s].x < right)
+        {
+            auto& existing = iSkyline[s];
+            auto const existingRight = existing.x + existing.width;
+            if (existing.y < bestY)
+                add_free(rect{ point{ existing.x, existing.y }, size{ std::min(existingRight, right) - existing.x, bestY - existing.y } });
+            if (existingRight > right)
+            {
+                existing.width = existingRight - right;
+                existing.x = right;
+                break;
+            }
+            iSkyline.erase(iSkyline.begin() + s);
+        }
+        iSkyline.insert(iSkyline.begin() + *bestSegment, segment{ aResult.x, bestTop, aElementSize.cx });
+        for (std::size_t m = 0; m + 1 < iSkyline.size();)
+        {
+            if (iSkyline[m].y == iSkyline[m + 1].y)
+            {
+                iSkyline[m].width += iSkyline[m + 1].width;
+                iSkyline.erase(iSkyline.begin() + m + 1);
+            }
+            else
+                ++m;
+        }
+        return true;
     }
 
-    bool rect_pack::insert(const size& aElementSize, rect& aResult)
+    bool rect_pack::fits(std::size_t aSegment, const size& aElementSize, dimension& aY) const
+    {
+        auto const x = iSkyline[aSegment].x;
+        if (x + aElementSize.cx > iDimensions.cx)
+            return false;
+        aY = 0.0;
+        auto widthLeft = aElementSize.cx;
+        for (auto s = aSegment; widthLeft > 0.0; ++s)
+        {
+            if (s >= iSkyline.size())
+                return false;
+            aY = std::max(aY, iSkyline[s].y);
+            if (aY + aElementSize.cy > iDimensions.cy)
+                return false;
+            widthLeft -= iSkyline[s].width;
+        }
+        return true;
+    }
+
+    void rect_pack::add_free(const rect& aFree)
     {
-        auto result = iRoot.insert(aElementSize);
-        if (result != nullptr)
+        if (aFree.cx <= 0.0 || aFree.cy <= 0.0)
+            return;
+        rect merged = aFree;
+        for (bool mergedAny = true; mergedAny;)
         {
-            aResult = result->rect();
-            return true;
+            mergedAny = false;
+            for (auto free = iFree.begin(); free != iFree.end(); ++free)
+            {
+                bool const sameRow = free->y == merged.y && free->cy == merged.cy && 
+                    (free->x + free->cx == merged.x || merged.x + merged.cx == free->x);
+                bool const sameColumn = free->x == merged.x && free->cx == merged.cx && 
+                    (free->y + free->cy == merged.y || merged.y + merged.cy == free->y);
+                if (sameRow || sameColumn)
+                {
+                    merged = rect{ point{ std::min(merged.x, free->x), std::min(merged.y, free->y) }, size{ sameRow ? merged.cx + free->cx : merged.cx, sameColumn ? merged.cy + free->cy : merged.cy } };
+                    iFree.erase(free);
+                    mergedAny = true;
+                    break;
+                }
+            }
         }
-        return false;
+        iFree.push_back(merged);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,183 @@
+// software_render_target.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/gfx/software_render_target.hpp>
+#include "native/software_rendering_context.hpp"
+
+namespace neogfx
+{
+    software_render_target::software_render_target(const size& aExtents, dimension aDpiScaleFactor, const color& aClearColor) :
+        iImage{ aDpiScaleFactor, texture_sampling::Nearest },
+        iDpiScaleFactor{ aDpiScaleFactor },
+        iLogicalCoordinateSystem{ neogfx::logical_coordinate_system::AutomaticGui },
+        iActive{ false }
+    {
+        iImage.resize(aExtents.ceil());
+        auto pixel = static_cast<uint8_t*>(iImage.pixels());
+        auto const pixelEnd = pixel + static_cast<std::size_t>(iImage.extents().cx * iImage.extents().cy) * 4u;
+        for (; pixel != pixelEnd; pixel += 4)
+        {
+            pixel[0] = aClearColor.red();
+            pixel[1] = aClearColor.green();
+            pixel[2] = aClearColor.blue();
+            pixel[3] = aClearColor.alpha();
+        }
+    }
+
+    software_render_target::~software_render_target()
+    {
+    }
+
+    const i_image& software_render_target::image() const
+    {
+        return iImage;
+    }
+
+    i_image& software_render_target::image()
+    {
+        return iImage;
+    }
+
+    dimension software_render_target::dpi_scale_factor() const
+    {
+        return iDpiScaleFactor;
+    }
+
+    render_target_type software_render_target::target_type() const
+    {
+        return render_target_type::Texture;
+    }
+
+    void* software_render_target::target_handle() const
+    {
+        return const_cast<void*>(iImage.cpixels());
+    }
+
+    const i_texture& software_render_target::target_texture() const
+    {
+        throw no_target_texture();
+    }
+
+    size software_render_target::target_extents() const
+    {
+        return extents();
+    }
+
+    logical_coordinate_system software_render_target::logical_coordinate_system() const
+    {
+        return iLogicalCoordinateSystem;
+    }
+
+    void software_render_target::set_logical_coordinate_system(neogfx::logical_coordinate_system aSystem)
+    {
+        iLogicalCoordinateSystem = aSystem;
+    }
+
+    logical_coordinates software_render_target::logical_coordinates() const
+    {
+        if (iLogicalCoordinates != std::nullopt)
+            return *iLogicalCoordinates;
+        neogfx::logical_coordinates result;
+        switch (iLogicalCoordinateSystem)
+        {
+        case neogfx::logical_coordinate_system::Specified:
+            throw logical_coordinates_not_specified();
+            break;
+        case neogfx::logical_coordinate_system::AutomaticGui:
+            result.bottomLeft = vec2{ 0.0, extents().cy };
+            result.topRight = vec2{ extents().cx, 0.0 };
+            break;
+        case neogfx::logical_coordinate_system::AutomaticGame:
+            result.bottomLeft = vec2{ 0.0, 0.0 };
+            result.topRight = vec2{ extents().cx, extents().cy };
+            break;
+        }
+        return result;
+    }
+
+    void software_render_target::set_logical_coordinates(const neogfx::logical_coordinates& aCoordinates)
+    {
+        iLogicalCoordinates = aCoordinates;
+    }
+
+    bool software_render_target::target_active() const
+    {
+        return iActive;
+    }
+
+    void software_render_target::activate_target() const
+    {
+        // no rendering engine context is involved so activation only notifies observers
+        if (iActive)
+            return;
+        TargetActivating.trigger();
+        iActive = true;
+        TargetActivated.trigger();
+    }
+
+    void software_render_target::deactivate_target() const
+    {
+        if (!iActive)
+            throw not_active();
+        TargetDeactivating.trigger();
+        iActive = false;
+        TargetDeactivated.trigger();
+    }
+
+    color software_render_target::read_pixel(const point& aPosition) const
+    {
+        return iImage.get_pixel(aPosition);
+    }
+
+    std::unique_ptr<i_rendering_context> software_render_target::create_graphics_context(blending_mode aBlendingMode) const
+    {
+        return std::unique_ptr<i_rendering_context>(new software_rendering_context{ *this, aBlendingMode });
+    }
+
+    dimension software_render_target::horizontal_dpi() const
+    {
+        return dpi_scale_factor() * 96.0;
+    }
+
+    dimension software_render_target::vertical_dpi() const
+    {
+        return dpi_scale_factor() * 96.0;
+    }
+
+    dimension software_render_target::ppi() const
+    {
+        return size{ horizontal_dpi(), vertical_dpi() }.magnitude() / std::sqrt(2.0);
+    }
+
+    bool software_render_target::metrics_available() const
+    {
+        return true;
+    }
+
+    size software_render_target::extents() const
+    {
+        return iImage.extents();
+    }
+
+    dimension software_render_target::em_size() const
+    {
+        return 0.0;
+    }
+}
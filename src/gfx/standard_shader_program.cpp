@@ -32,6 +32,7 @@ namespace neogfx
             iDefaultShader = static_cast<i_fragment_shader&>(add_shader(neolib::make_ref<standard_fragment_shader<>>().as<i_shader>()));
             iGradientShader = static_cast<i_gradient_shader&>(add_shader(neolib::make_ref<standard_gradient_shader>().as<i_shader>()));
             iTextureShader = static_cast<i_texture_shader&>(add_shader(neolib::make_ref<standard_texture_shader>().as<i_shader>()));
+            iBlurShader = static_cast<i_blur_shader&>(add_shader(neolib::make_ref<standard_blur_shader>().as<i_shader>()));
             iGlyphShader = static_cast<i_glyph_shader&>(add_shader(neolib::make_ref<standard_glyph_shader>().as<i_shader>()));
             iStippleShader = static_cast<i_stipple_shader&>(add_shader(neolib::make_ref<standard_stipple_shader>().as<i_shader>()));
         }
@@ -66,6 +67,20 @@ namespace neogfx
         return *iTextureShader;
     }
 
+    const i_blur_shader& standard_shader_program::blur_shader() const
+    {
+        if (iBlurShader != nullptr)
+            return *iBlurShader;
+        throw no_blur_shader();
+    }
+
+    i_blur_shader& standard_shader_program::blur_shader()
+    {
+        if (iBlurShader != nullptr)
+            return *iBlurShader;
+        throw no_blur_shader();
+    }
+
     const i_glyph_shader& standard_shader_program::glyph_shader() const
     {
         if (iGlyphShader != nullptr)
@@ -73,6 +73,13 @@ namespace neogfx
                             {
                                 iEmojis[codePoints][size] = filePath;
                                 iEmojiMap[codePoints] = std::optional<emoji_id>{};
+                                if (codePoints.size() == 1u)
+                                {
+                                    auto const word = static_cast<std::size_t>(codePoints[0] >> 6u);
+                                    if (iEmojiPresence.size() <= word)
+                                        iEmojiPresence.resize(word + 1u);
+                                    iEmojiPresence[word] |= (1ull << (codePoints[0] & 63u));
+                                }
                             }
                         }
                     }
@@ -86,9 +93,8 @@ namespace neogfx
 
     bool emoji_atlas::is_emoji(char32_t aCodePoint) const
     {
-        std::u32string str;
-        str += aCodePoint;
-        return is_emoji(str);
+        auto const word = static_cast<std::size_t>(aCodePoint >> 6u);
+        return word < iEmojiPresence.size() && ((iEmojiPresence[word] >> (aCodePoint & 63u)) & 1u) != 0u;
     }
 
     bool emoji_atlas::is_emoji(const std::u32string& aCodePoints) const
@@ -96,6 +102,11 @@ namespace neogfx
         return iEmojiMap.find(aCodePoints) != iEmojiMap.end();
     }
 
+    const emoji_atlas::code_point_bitset& emoji_atlas::emoji_presence() const
+    {
+        return iEmojiPresence;
+    }
+
     emoji_atlas::emoji_id emoji_atlas::emoji(char32_t aCodePoint, dimension aDesiredSize) const
     {
         std::u32string str;
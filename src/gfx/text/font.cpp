@@ -607,6 +607,21 @@ namespace neogfx
         return native_font_face().glyph_texture(aGlyph);
     }
 
+    const i_glyph_texture& font::distance_field_glyph_texture(const glyph& aGlyph) const
+    {
+        return native_font_face().distance_field_glyph_texture(aGlyph);
+    }
+
+    dimension font::distance_field_scale() const
+    {
+        return native_font_face().distance_field_scale();
+    }
+
+    dimension font::distance_field_spread() const
+    {
+        return native_font_face().distance_field_spread();
+    }
+
     bool font::operator==(const font& aRhs) const
     {
         return iInstance->native_font_face().handle() == aRhs.iInstance->native_font_face().handle() &&
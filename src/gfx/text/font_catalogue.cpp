@@ -0,0 +1,232 @@
+// font_catalogue.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <fstream>
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <neolib/string_ci.hpp>
+#include FT_TRUETYPE_TABLES_H
+#include "font_catalogue.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        template <typename T>
+        void write(std::ostream& aStream, const T& aValue)
+        {
+            aStream.write(reinterpret_cast<const char*>(&aValue), sizeof(aValue));
+        }
+
+        void write(std::ostream& aStream, const std::string& aValue)
+        {
+            write(aStream, static_cast<uint32_t>(aValue.size()));
+            aStream.write(aValue.data(), aValue.size());
+        }
+
+        template <typename T>
+        bool read(std::istream& aStream, T& aValue)
+        {
+            return !!aStream.read(reinterpret_cast<char*>(&aValue), sizeof(aValue));
+        }
+
+        bool read(std::istream& aStream, std::string& aValue)
+        {
+            uint32_t length;
+            if (!read(aStream, length) || length > 0x10000u)
+                return false;
+            aValue.resize(length);
+            return !!aStream.read(&aValue[0], length);
+        }
+
+        const char sMagic[4] = { 'n', 'g', 'f', 'c' };
+    }
+
+    font_catalogue::font_catalogue(const std::string& aPath) :
+        iPath{ aPath }, iDirty{ false }
+    {
+        load();
+    }
+
+    const font_catalogue::statistics& font_catalogue::stats() const
+    {
+        return iStats;
+    }
+
+    const font_catalogue::entry& font_catalogue::validate(FT_Library aFontLib, const std::string& aFileName, uint64_t aFileSize, int64_t aLastWriteTime)
+    {
+        ++iStats.files;
+        iSeen.insert(aFileName);
+        auto existing = iEntries.find(aFileName);
+        if (existing != iEntries.end() && existing->second.fileSize == aFileSize && existing->second.lastWriteTime == aLastWriteTime)
+            return existing->second;
+        ++iStats.scanned;
+        iDirty = true;
+        auto& newEntry = iEntries[aFileName];
+        newEntry = entry{ aFileSize, aLastWriteTime };
+        newEntry.faces = scan(aFontLib, aFileName, newEntry.familyName);
+        return newEntry;
+    }
+
+    void font_catalogue::save()
+    {
+        for (auto e = iEntries.begin(); e != iEntries.end();)
+        {
+            if (iSeen.find(e->first) == iSeen.end())
+            {
+                ++iStats.removed;
+                iDirty = true;
+                e = iEntries.erase(e);
+            }
+            else
+                ++e;
+        }
+        if (!iDirty)
+            return;
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(boost::filesystem::path{ iPath }.parent_path(), ec);
+        // written to a temporary file which then replaces the catalogue so that a crash or a concurrent startup
+        // never sees a partially written catalogue
+        auto const tempPath = iPath + ".tmp";
+        std::ofstream file{ tempPath, std::ios::out | std::ios::binary | std::ios::trunc };
+        if (!file)
+            return;
+        file.write(sMagic, sizeof(sMagic));
+        write(file, Version);
+        write(file, static_cast<uint32_t>(iEntries.size()));
+        for (auto const& e : iEntries)
+        {
+            write(file, e.first);
+            write(file, e.second.fileSize);
+            write(file, e.second.lastWriteTime);
+            write(file, e.second.familyName);
+            write(file, static_cast<uint32_t>(e.second.faces.size()));
+            for (auto const& f : e.second.faces)
+            {
+                write(file, static_cast<int64_t>(f.index));
+                write(file, f.style);
+                write(file, f.styleName);
+                write(file, f.weight);
+                write(file, f.unicodeRanges);
+            }
+        }
+        file.close();
+        if (!file)
+        {
+            boost::filesystem::remove(tempPath, ec);
+            return;
+        }
+        boost::filesystem::rename(tempPath, iPath, ec);
+        if (ec)
+        {
+            boost::filesystem::remove(tempPath, ec);
+            return;
+        }
+        iDirty = false;
+    }
+
+    font_style font_catalogue::style_from_face(FT_Face aFace)
+    {
+        font_style style = font_style::Invalid;
+        if (aFace->style_flags & FT_STYLE_FLAG_ITALIC)
+            style = static_cast<font_style>(style | font_style::Italic);
+        if (aFace->style_flags & FT_STYLE_FLAG_BOLD)
+            style = static_cast<font_style>(style | font_style::Bold);
+        auto const searchKey = neolib::ci_string{ aFace->style_name };
+        if (searchKey.find("italic") != neolib::ci_string::npos)
+            style |= font_style::Italic;
+        if (searchKey.find("bold") != neolib::ci_string::npos || searchKey.find("heavy") != neolib::ci_string::npos || searchKey.find("black") != neolib::ci_string::npos)
+            style |= font_style::Bold;
+        if (style == font_style::Invalid)
+            style = font_style::Normal;
+        return style;
+    }
+
+    font_weight font_catalogue::weight_from_face(FT_Face aFace)
+    {
+        auto const os2 = static_cast<TT_OS2*>(FT_Get_Sfnt_Table(aFace, FT_SFNT_OS2));
+        if (os2 != nullptr && os2->usWeightClass >= 1u && os2->usWeightClass <= 1000u)
+        {
+            // some older fonts use a 1-9 scale
+            uint32_t const weightClass = os2->usWeightClass < 10u ? os2->usWeightClass * 100u : os2->usWeightClass;
+            return static_cast<font_weight>(std::min(std::max((weightClass + 50u) / 100u, 1u), 9u) * 100u);
+        }
+        return font_info::weight_from_style_name(aFace->style_name != nullptr ? aFace->style_name : "");
+    }
+
+    font_catalogue::face_list font_catalogue::scan(FT_Library aFontLib, const std::string& aFileName, std::string& aFamilyName)
+    {
+        face_list result;
+        FT_Long faceCount = 1;
+        for (FT_Long faceIndex = 0; faceIndex < faceCount; ++faceIndex)
+        {
+            FT_Face face;
+            if (FT_New_Face(aFontLib, aFileName.c_str(), faceIndex, &face) != 0)
+                break;
+            if (faceIndex == 0)
+            {
+                faceCount = face->num_faces;
+                aFamilyName = face->family_name != nullptr ? face->family_name : "";
+            }
+            std::array<uint32_t, 4> unicodeRanges = {};
+            auto const os2 = static_cast<TT_OS2*>(FT_Get_Sfnt_Table(face, FT_SFNT_OS2));
+            if (os2 != nullptr)
+                unicodeRanges = { static_cast<uint32_t>(os2->ulUnicodeRange1), static_cast<uint32_t>(os2->ulUnicodeRange2), 
+                    static_cast<uint32_t>(os2->ulUnicodeRange3), static_cast<uint32_t>(os2->ulUnicodeRange4) };
+            result.push_back(face{ faceIndex, style_from_face(face), face->style_name != nullptr ? face->style_name : "", weight_from_face(face), unicodeRanges });
+            FT_Done_Face(face);
+        }
+        return result;
+    }
+
+    void font_catalogue::load()
+    {
+        std::ifstream file{ iPath, std::ios::in | std::ios::binary };
+        if (!file)
+            return;
+        char magic[sizeof(sMagic)];
+        uint32_t version;
+        uint32_t entryCount;
+        if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), sMagic) || 
+            !read(file, version) || version != Version || !read(file, entryCount))
+            return;
+        entry_map entries;
+        for (uint32_t i = 0u; i < entryCount; ++i)
+        {
+            std::string fileName;
+            entry e;
+            uint32_t faceCount;
+            if (!read(file, fileName) || !read(file, e.fileSize) || !read(file, e.lastWriteTime) || !read(file, e.familyName) || !read(file, faceCount))
+                return;
+            for (uint32_t j = 0u; j < faceCount; ++j)
+            {
+                int64_t index;
+                face f;
+                if (!read(file, index) || !read(file, f.style) || !read(file, f.styleName) || !read(file, f.weight) || !read(file, f.unicodeRanges))
+                    return;
+                f.index = static_cast<FT_Long>(index);
+                e.faces.push_back(f);
+            }
+            entries.emplace(std::move(fileName), std::move(e));
+        }
+        // a truncated or corrupt catalogue is discarded as a whole (above) and rebuilt
+        iEntries = std::move(entries);
+    }
+}
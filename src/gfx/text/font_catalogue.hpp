@@ -0,0 +1,83 @@
+// font_catalogue.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <neogfx/gfx/text/font.hpp>
+
+namespace neogfx
+{
+    // Persistent index of the system font directory (family, styles, weights and coverage of each font file keyed on
+    // path, size and modification time) so that font_manager only has to open font files that have changed
+    // since the index was last saved.
+    class font_catalogue
+    {
+    public:
+        static constexpr uint32_t Version = 2u;
+    public:
+        struct face
+        {
+            FT_Long index;
+            font_style style;
+            std::string styleName;
+            font_weight weight; // OS/2 usWeightClass if present otherwise derived from the style name
+            std::array<uint32_t, 4> unicodeRanges; // OS/2 ulUnicodeRange1-4; all zero if the font has no OS/2 table
+        };
+        typedef std::vector<face> face_list;
+        struct entry
+        {
+            uint64_t fileSize;
+            int64_t lastWriteTime;
+            std::string familyName;
+            face_list faces; // empty if the file is not a loadable font
+        };
+        struct statistics
+        {
+            uint32_t files = 0u;
+            uint32_t scanned = 0u;
+            uint32_t removed = 0u;
+        };
+    private:
+        typedef std::unordered_map<std::string, entry> entry_map;
+    public:
+        font_catalogue(const std::string& aPath);
+    public:
+        const statistics& stats() const;
+    public:
+        const entry& validate(FT_Library aFontLib, const std::string& aFileName, uint64_t aFileSize, int64_t aLastWriteTime);
+        void save();
+    public:
+        static font_style style_from_face(FT_Face aFace);
+        static font_weight weight_from_face(FT_Face aFace);
+        static face_list scan(FT_Library aFontLib, const std::string& aFileName, std::string& aFamilyName);
+    private:
+        void load();
+    private:
+        std::string iPath;
+        entry_map iEntries;
+        std::unordered_set<std::string> iSeen;
+        bool iDirty;
+        statistics iStats;
+    };
+}
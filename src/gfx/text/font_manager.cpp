@@ -25,9 +25,13 @@
 #include FT_LCD_FILTER_H
 #include <neogfx/app/i_app.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
+#include <neogfx/gfx/i_render_target.hpp>
+#include <neogfx/hid/i_surface_manager.hpp>
 #include <neogfx/gfx/text/font_manager.hpp>
 #include "../../gfx/text/native/native_font_face.hpp"
 #include "../../gfx/text/native/native_font.hpp"
+#include "../../hid/native/i_native_surface.hpp"
+#include "font_catalogue.hpp"
 
 namespace neogfx
 {
@@ -126,6 +130,18 @@ namespace neogfx
 #endif
             }
 
+            std::string get_font_catalogue_path()
+            {
+#ifdef WIN32
+                char const* localAppData = std::getenv("LOCALAPPDATA");
+                if (localAppData != nullptr)
+                    return std::string{ localAppData } + "\\neogfx\\font_catalogue.dat";
+                return (boost::filesystem::temp_directory_path() / "neogfx" / "font_catalogue.dat").string();
+#else
+                throw std::logic_error("neogfx::detail::platform_specific::get_font_catalogue_path: Unknown system");
+#endif
+            }
+
             fallback_font_info default_fallback_font_info()
             {
 #ifdef WIN32
@@ -164,34 +180,37 @@ namespace neogfx
         iDefaultSystemFontInfo{ detail::platform_specific::default_system_font_info() },
         iDefaultFallbackFontInfo{ detail::platform_specific::default_fallback_font_info() },
         iGlyphAtlas{ size{1024.0, 1024.0} },
-        iEmojiAtlas{}
+        iGlyphAtlasBudget{ 4.0 * 1024.0 * 1024.0 },
+        iDistanceFieldAtlas{ size{1024.0, 1024.0} },
+        iEmojiAtlas{},
+        iGlyphRasterization{ neogfx::glyph_rasterization::BlockOnDemand },
+        iGlyphRasterizer{ std::make_unique<neogfx::glyph_rasterizer>() }
     {
         FT_Error error = FT_Init_FreeType(&iFontLib);
         if (error)
         {
             throw error_initializing_font_library();
         }
+        font_catalogue catalogue{ detail::platform_specific::get_font_catalogue_path() };
         std::string fontsDirectory = detail::platform_specific::get_system_font_directory();
         for (boost::filesystem::directory_iterator file(fontsDirectory); file != boost::filesystem::directory_iterator(); ++file)
         {
             if (!boost::filesystem::is_regular_file(file->status())) 
                 continue;
-            try
-            {
-                if (is_font_file(file->path().string()))
-                {
-                    auto font = iNativeFonts.emplace(iNativeFonts.end(), iFontLib, file->path().string());
-                    iFontFamilies[neolib::make_ci_string(font->family_name())].push_back(font);
-                }
-            }
-            catch (native_font::failed_to_load_font&)
-            {
-            }
-            catch (...)
-            {
-                throw;
-            }
+            boost::system::error_code ec;
+            auto const fileSize = boost::filesystem::file_size(file->path(), ec);
+            if (ec)
+                continue;
+            auto const lastWriteTime = boost::filesystem::last_write_time(file->path(), ec);
+            if (ec)
+                continue;
+            auto const& entry = catalogue.validate(iFontLib, file->path().string(), static_cast<uint64_t>(fileSize), static_cast<int64_t>(lastWriteTime));
+            if (entry.faces.empty())
+                continue;
+            auto font = iNativeFonts.emplace(iNativeFonts.end(), iFontLib, file->path().string(), entry.familyName, entry.faces);
+            iFontFamilies[neolib::make_ci_string(font->family_name())].push_back(font);
         }
+        catalogue.save();
         for (auto& famlily : iFontFamilies)
             std::sort(famlily.second.begin(), famlily.second.end(),
                 [](auto const& f1, auto const& f2) { return f1->min_style() < f2->min_style() || (f1->min_style() == f2->min_style() && f1->min_weight() < f2->min_weight()); });
@@ -199,9 +218,11 @@ namespace neogfx
 
     font_manager::~font_manager()
     {
+        iGlyphTextCache.clear();
         iIdCache.clear();
         iFontFamilies.clear();
         iNativeFonts.clear();
+        iGlyphRasterizer.reset();
         FT_Done_FreeType(iFontLib);
     }
 
@@ -398,6 +419,16 @@ namespace neogfx
         return iGlyphAtlas;
     }
 
+    const i_texture_atlas& font_manager::distance_field_atlas() const
+    {
+        return iDistanceFieldAtlas;
+    }
+
+    i_texture_atlas& font_manager::distance_field_atlas()
+    {
+        return iDistanceFieldAtlas;
+    }
+
     const i_emoji_atlas& font_manager::emoji_atlas() const
     {
         return iEmojiAtlas;
@@ -408,6 +439,103 @@ namespace neogfx
         return iEmojiAtlas;
     }
 
+    const glyph_text_cache& font_manager::glyph_text_cache() const
+    {
+        return iGlyphTextCache;
+    }
+
+    glyph_text_cache& font_manager::glyph_text_cache()
+    {
+        return iGlyphTextCache;
+    }
+
+    glyph_rasterization font_manager::glyph_rasterization() const
+    {
+        return iGlyphRasterization;
+    }
+
+    void font_manager::set_glyph_rasterization(neogfx::glyph_rasterization aMode)
+    {
+        iGlyphRasterization = aMode;
+    }
+
+    void font_manager::prefetch_glyphs(const font& aFont, const std::u32string& aCodePoints)
+    {
+        static_cast<const native_font_face&>(aFont.native_font_face()).prefetch_glyphs(aCodePoints);
+    }
+
+    void font_manager::placeholder_glyph_drawn(const i_render_target& aTarget, const i_native_font_face& aFace, const glyph& aGlyph, const rect& aRect)
+    {
+        // a texture target can't be traced back to the surface it ends up on so it is recorded as null
+        iPlaceholderGlyphs[std::make_pair(aFace.id(), aGlyph.value())].emplace_back(
+            aTarget.target_type() == render_target_type::Surface ? &aTarget : nullptr, aRect);
+    }
+
+    void font_manager::invalidate_rasterized_glyphs()
+    {
+        auto& surfaceManager = service<i_surface_manager>();
+        for (auto const& ready : iGlyphRasterizer->placeholders_ready())
+        {
+            auto placeholder = iPlaceholderGlyphs.find(std::make_pair(ready.first->id(), ready.second));
+            if (placeholder == iPlaceholderGlyphs.end())
+                continue;
+            for (auto const& drawn : placeholder->second)
+            {
+                if (drawn.first == nullptr)
+                {
+                    surfaceManager.invalidate_surfaces();
+                    continue;
+                }
+                for (std::size_t s = 0; s < surfaceManager.surface_count(); ++s)
+                {
+                    auto& surface = surfaceManager.surface(s);
+                    if (surface.has_native_surface() && static_cast<const i_render_target*>(&surface.native_surface()) == drawn.first)
+                        surface.invalidate_surface(drawn.second, false);
+                }
+            }
+            iPlaceholderGlyphs.erase(placeholder);
+        }
+    }
+
+    void font_manager::forget_placeholder_glyphs(font_id aFaceId)
+    {
+        for (auto placeholder = iPlaceholderGlyphs.begin(); placeholder != iPlaceholderGlyphs.end();)
+            if (placeholder->first.first == aFaceId)
+                placeholder = iPlaceholderGlyphs.erase(placeholder);
+            else
+                ++placeholder;
+    }
+
+    void font_manager::upload_rasterized_glyphs()
+    {
+        native_font_face::upload_rasterized_glyphs();
+    }
+
+    dimension font_manager::glyph_atlas_budget() const
+    {
+        return iGlyphAtlasBudget;
+    }
+
+    void font_manager::set_glyph_atlas_budget(dimension aArea)
+    {
+        iGlyphAtlasBudget = aArea;
+    }
+
+    void font_manager::advance_glyph_use_generation()
+    {
+        native_font_face::advance_glyph_use_generation();
+    }
+
+    void font_manager::evict_glyphs()
+    {
+        native_font_face::evict_glyphs(iGlyphAtlasBudget);
+    }
+
+    glyph_rasterizer& font_manager::glyph_rasterizer()
+    {
+        return *iGlyphRasterizer;
+    }
+
     i_native_font& font_manager::find_font(const std::string& aFamilyName, const std::string& aStyleName, font::point_size aSize)
     {
         auto family = iFontFamilies.find(neolib::make_ci_string(aFamilyName));
@@ -458,7 +586,7 @@ namespace neogfx
             for (uint32_t s = 0; s < f->style_count(); ++s)
             {
                 auto const matchingBits = matching_bits(static_cast<uint32_t>(f->style(s)), static_cast<uint32_t>(aStyle));
-                auto weight = font::weight_from_style_name(f->style_name(s));
+                auto weight = f->weight(s);
                 if (weight <= font_weight::Normal && (
                     bestNormalFont == std::nullopt || 
                     bestNormalFont->first.first < matchingBits ||
@@ -511,7 +639,10 @@ namespace neogfx
         if (--iIdCache[aId].second == 0u)
         {
             if (iIdCache[aId].first.use_count() == 1)
+            {
+                iGlyphTextCache.invalidate(aId);
                 iIdCache.remove(aId);
+            }
         }
     }
 
@@ -541,7 +672,10 @@ namespace neogfx
         {
             auto& cacheEntry = *i;
             if (cacheEntry.first.use_count() == 1 && cacheEntry.second == 0u)
+            {
+                iGlyphTextCache.invalidate(cacheEntry.first.id());
                 i = iIdCache.erase(i);
+            }
             else
                 ++i;
         }
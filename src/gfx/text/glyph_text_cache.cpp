@@ -0,0 +1,166 @@
+// glyph_text_cache.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <algorithm>
+#include <neogfx/gfx/text/glyph_text_cache.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        template <typename T>
+        inline void hash_combine(std::size_t& aSeed, const T& aValue)
+        {
+            aSeed ^= std::hash<T>{}(aValue) + 0x9e3779b9u + (aSeed << 6) + (aSeed >> 2);
+        }
+    }
+
+    std::size_t glyph_text_cache::key_hash::operator()(const key& aKey) const
+    {
+        std::size_t result = std::hash<std::string>{}(aKey.text);
+        hash_combine(result, aKey.fontId);
+        hash_combine(result, static_cast<uint32_t>(aKey.style));
+        hash_combine(result, (aKey.utf32 ? 1u : 0u) | (aKey.subpixel ? 2u : 0u) | (aKey.guiOrientation ? 4u : 0u) | (aKey.passwordMask != std::nullopt ? 8u : 0u) | (aKey.distanceField ? 16u : 0u));
+        if (aKey.mnemonic != std::nullopt)
+            hash_combine(result, aKey.mnemonic->second);
+        return result;
+    }
+
+    glyph_text_cache::glyph_text_cache(std::size_t aMemoryBudget) :
+        iMemoryBudget{ aMemoryBudget }
+    {
+    }
+
+    glyph_text_cache::~glyph_text_cache()
+    {
+        clear();
+    }
+
+    bool glyph_text_cache::cacheable(std::size_t aTextLength)
+    {
+        return aTextLength != 0u && aTextLength <= MaxTextLength;
+    }
+
+    std::size_t glyph_text_cache::memory_budget() const
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        return iMemoryBudget;
+    }
+
+    void glyph_text_cache::set_memory_budget(std::size_t aMemoryBudget)
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        iMemoryBudget = aMemoryBudget;
+        evict(iMemoryBudget);
+    }
+
+    glyph_text_cache::statistics glyph_text_cache::stats() const
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        return iStats;
+    }
+
+    void glyph_text_cache::reset_stats()
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        iStats.hits = 0u;
+        iStats.misses = 0u;
+        iStats.evictions = 0u;
+    }
+
+    bool glyph_text_cache::find(const key& aKey, glyph_text& aResult)
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        auto existing = iIndex.find(aKey);
+        if (existing == iIndex.end())
+        {
+            ++iStats.misses;
+            return false;
+        }
+        ++iStats.hits;
+        iEntries.splice(iEntries.begin(), iEntries, existing->second);
+        aResult = existing->second->text;
+        return true;
+    }
+
+    void glyph_text_cache::insert(const key& aKey, const glyph_text& aText)
+    {
+        std::vector<font_id> fonts{ aKey.fontId };
+        for (auto g = aText.cbegin(); g != aText.cend(); ++g)
+            if (g->has_font() && std::find(fonts.begin(), fonts.end(), g->font_id()) == fonts.end())
+                fonts.push_back(g->font_id());
+        std::size_t const bytes = sizeof(entry) + aKey.text.capacity() + fonts.size() * sizeof(font_id) + std::distance(aText.cbegin(), aText.cend()) * sizeof(glyph);
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        if (bytes > iMemoryBudget)
+            return;
+        auto existing = iIndex.find(aKey);
+        if (existing != iIndex.end())
+        {
+            iStats.bytes -= existing->second->bytes;
+            iEntries.erase(existing->second);
+            iIndex.erase(existing);
+        }
+        evict(iMemoryBudget - bytes);
+        iEntries.push_front(entry{ aKey, aText, std::move(fonts), bytes });
+        // don't keep the text's font cache as it holds font references
+        iEntries.front().text.glyph_font_cache::clear();
+        iIndex.emplace(aKey, iEntries.begin());
+        iStats.bytes += bytes;
+        iStats.entries = iEntries.size();
+    }
+
+    void glyph_text_cache::invalidate(font_id aFontId)
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        for (auto e = iEntries.begin(); e != iEntries.end();)
+        {
+            if (std::find(e->fonts.begin(), e->fonts.end(), aFontId) != e->fonts.end())
+            {
+                iStats.bytes -= e->bytes;
+                iIndex.erase(e->cacheKey);
+                e = iEntries.erase(e);
+            }
+            else
+                ++e;
+        }
+        iStats.entries = iEntries.size();
+    }
+
+    void glyph_text_cache::clear()
+    {
+        std::scoped_lock<std::mutex> lock{ iMutex };
+        iIndex.clear();
+        iEntries.clear();
+        iStats.bytes = 0u;
+        iStats.entries = 0u;
+    }
+
+    void glyph_text_cache::evict(std::size_t aMemoryBudget)
+    {
+        while (!iEntries.empty() && iStats.bytes > aMemoryBudget)
+        {
+            iStats.bytes -= iEntries.back().bytes;
+            iIndex.erase(iEntries.back().cacheKey);
+            iEntries.pop_back();
+            ++iStats.evictions;
+        }
+        iStats.entries = iEntries.size();
+    }
+}
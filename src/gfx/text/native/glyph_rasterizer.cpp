@@ -0,0 +1,602 @@
+// glyph_rasterizer.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <map>
+#include <cstring>
+#include <cmath>
+#if defined(__AVX2__)
+#define NEOGFX_LCD_FILTER_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NEOGFX_LCD_FILTER_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define NEOGFX_LCD_FILTER_NEON
+#include <arm_neon.h>
+#endif
+#include "native_font_face.hpp"
+#include "glyph_rasterizer.hpp"
+
+namespace neogfx
+{
+    namespace
+    {
+        thread_local bool tBlocking = false;
+
+        glyph_pixel_mode to_glyph_pixel_mode(unsigned char aFreeTypePixelMode)
+        {
+            switch (aFreeTypePixelMode)
+            {
+            default:
+            case FT_PIXEL_MODE_NONE:
+                return glyph_pixel_mode::None;
+            case FT_PIXEL_MODE_MONO:
+                return glyph_pixel_mode::Mono;
+            case FT_PIXEL_MODE_GRAY:
+                return glyph_pixel_mode::Gray;
+            case FT_PIXEL_MODE_GRAY2:
+                return glyph_pixel_mode::Gray2Bit;
+            case FT_PIXEL_MODE_GRAY4:
+                return glyph_pixel_mode::Gray4Bit;
+            case FT_PIXEL_MODE_LCD:
+                return glyph_pixel_mode::LCD;
+            case FT_PIXEL_MODE_LCD_V:
+                return glyph_pixel_mode::LCD_V;
+            case FT_PIXEL_MODE_BGRA:
+                return glyph_pixel_mode::BGRA;
+            }
+        }
+
+        // 5-tap sub-pixel FIR filter { 1, 8, 14, 8, 1 } / 32 (i.e. { 0.5, 4, 7, 4, 0.5 } / 16) in 16-bit fixed point with
+        // rounding; taps falling outside the row are clamped to the edge sub-pixel.
+        uint32_t constexpr LcdFilterPadding = 2u;
+        uint32_t constexpr LcdFilterOverrun = 32u;
+
+        inline uint8_t lcd_filter(const uint8_t* aTaps)
+        {
+            uint32_t const sum = aTaps[0] + aTaps[4] + ((aTaps[1] + aTaps[3]) << 3) + aTaps[2] * 14u;
+            return static_cast<uint8_t>((sum + 16u) >> 5);
+        }
+
+        // Copies a row of sub-pixels into a buffer padded (edge clamped) for the filter taps; returns the padded row
+        // and the buffer the filtered row is written to, both with room for a vector overrunning the end of the row.
+        std::pair<const uint8_t*, uint8_t*> pad_lcd_row(const uint8_t* aSource, uint32_t aWidth)
+        {
+            thread_local std::vector<uint8_t> tPadded;
+            thread_local std::vector<uint8_t> tFiltered;
+            tPadded.assign(aWidth + LcdFilterPadding * 2u + LcdFilterOverrun, 0u);
+            tFiltered.resize(aWidth + LcdFilterOverrun);
+            tPadded[0] = tPadded[1] = aSource[0];
+            std::memcpy(&tPadded[LcdFilterPadding], aSource, aWidth);
+            tPadded[aWidth + LcdFilterPadding] = tPadded[aWidth + LcdFilterPadding + 1u] = aSource[aWidth - 1u];
+            return std::make_pair(&tPadded[0], &tFiltered[0]);
+        }
+
+        // Writes a filtered row of sub-pixels into an RGBA row of the upload buffer (alpha untouched).
+        void store_lcd_row(const uint8_t* aFiltered, uint32_t aWidth, uint8_t* aDestination)
+        {
+            for (uint32_t pixel = 0u; pixel < aWidth / 3u; ++pixel)
+            {
+                aDestination[pixel * 4u + 0u] = aFiltered[pixel * 3u + 0u];
+                aDestination[pixel * 4u + 1u] = aFiltered[pixel * 3u + 1u];
+                aDestination[pixel * 4u + 2u] = aFiltered[pixel * 3u + 2u];
+            }
+        }
+
+        float constexpr DistanceFieldFar = 1e20f;
+
+        // One dimensional squared Euclidean distance transform (Felzenszwalb and Huttenlocher) applied in place to
+        // aCount values aStride apart.
+        void distance_transform(float* aValues, uint32_t aCount, std::size_t aStride)
+        {
+            thread_local std::vector<float> tF;
+            thread_local std::vector<float> tZ;
+            thread_local std::vector<uint32_t> tV;
+            tF.resize(aCount);
+            tZ.resize(aCount + 1u);
+            tV.resize(aCount);
+            for (uint32_t q = 0u; q < aCount; ++q)
+                tF[q] = aValues[q * aStride];
+            auto const intersection = [&](uint32_t q, uint32_t p)
+            {
+                return ((tF[q] + static_cast<float>(q) * q) - (tF[p] + static_cast<float>(p) * p)) / (2.0f * q - 2.0f * p);
+            };
+            uint32_t k = 0u;
+            tV[0] = 0u;
+            tZ[0] = -std::numeric_limits<float>::infinity();
+            tZ[1] = std::numeric_limits<float>::infinity();
+            for (uint32_t q = 1u; q < aCount; ++q)
+            {
+                float s = intersection(q, tV[k]);
+                while (s <= tZ[k])
+                    s = intersection(q, tV[--k]);
+                ++k;
+                tV[k] = q;
+                tZ[k] = s;
+                tZ[k + 1u] = std::numeric_limits<float>::infinity();
+            }
+            k = 0u;
+            for (uint32_t q = 0u; q < aCount; ++q)
+            {
+                while (tZ[k + 1u] < static_cast<float>(q))
+                    ++k;
+                auto const d = static_cast<float>(q) - static_cast<float>(tV[k]);
+                aValues[q * aStride] = d * d + tF[tV[k]];
+            }
+        }
+
+        void distance_transform(std::vector<float>& aGrid, uint32_t aWidth, uint32_t aHeight)
+        {
+            for (uint32_t x = 0u; x < aWidth; ++x)
+                distance_transform(&aGrid[x], aHeight, aWidth);
+            for (uint32_t y = 0u; y < aHeight; ++y)
+                distance_transform(&aGrid[static_cast<std::size_t>(y) * aWidth], aWidth, 1u);
+        }
+    }
+
+    struct glyph_rasterizer::worker
+    {
+        typedef std::map<std::pair<const native_font_face*, const FT_Byte*>, FT_Face> face_map;
+
+        std::thread thread;
+        FT_Library library = nullptr;
+        face_map faces;
+        std::vector<const native_font_face*> purge;
+
+        FT_Face face(const task& aTask)
+        {
+            auto existing = faces.find(std::make_pair(aTask.face, aTask.data));
+            if (existing != faces.end())
+                return existing->second;
+            FT_Face newFace;
+            freetypeCheck(FT_New_Memory_Face(library, aTask.data, aTask.dataSize, aTask.faceIndex, &newFace));
+            if (FT_IS_SCALABLE(newFace))
+                FT_Set_Char_Size(newFace, 0, aTask.charSize, aTask.horizontalDpi, aTask.verticalDpi);
+            faces.emplace(std::make_pair(aTask.face, aTask.data), newFace);
+            return newFace;
+        }
+        void purge_faces()
+        {
+            for (auto p : purge)
+                for (auto f = faces.begin(); f != faces.end();)
+                {
+                    if (f->first.first == p)
+                    {
+                        FT_Done_Face(f->second);
+                        f = faces.erase(f);
+                    }
+                    else
+                        ++f;
+                }
+            purge.clear();
+        }
+    };
+
+    glyph_rasterizer::scoped_blocking::scoped_blocking() :
+        iPrevious{ tBlocking }
+    {
+        tBlocking = true;
+    }
+
+    glyph_rasterizer::scoped_blocking::~scoped_blocking()
+    {
+        tBlocking = iPrevious;
+    }
+
+    glyph_rasterizer::glyph_rasterizer(uint32_t aThreadCount) :
+        iThreadCount{ aThreadCount },
+        iWorkersStarted{ false },
+        iStopping{ false }
+    {
+    }
+
+    glyph_rasterizer::~glyph_rasterizer()
+    {
+        {
+            std::unique_lock<std::mutex> lock{ iMutex };
+            iStopping = true;
+            iQueue.clear();
+        }
+        iWorkAvailable.notify_all();
+        for (auto& w : iWorkers)
+        {
+            w->thread.join();
+            w->purge_faces();
+            for (auto& f : w->faces)
+                FT_Done_Face(f.second);
+            FT_Done_FreeType(w->library);
+        }
+    }
+
+    bool glyph_rasterizer::blocking()
+    {
+        return tBlocking;
+    }
+
+    void glyph_rasterizer::lcd_filter_row(const uint8_t* aSource, uint32_t aWidth, uint8_t* aDestination)
+    {
+        if (aWidth == 0u)
+            return;
+        auto const row = pad_lcd_row(aSource, aWidth);
+        const uint8_t* const padded = row.first;
+        uint8_t* const filtered = row.second;
+        uint32_t x = 0u;
+#if defined(NEOGFX_LCD_FILTER_AVX2)
+        __m256i const bias = _mm256_set1_epi16(16);
+        for (; x < aWidth; x += 16u)
+        {
+            auto load = [&](uint32_t aTap) { return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(padded + x + aTap))); };
+            __m256i const c = load(2u);
+            __m256i sum = _mm256_add_epi16(load(0u), load(4u));
+            sum = _mm256_add_epi16(sum, _mm256_slli_epi16(_mm256_add_epi16(load(1u), load(3u)), 3));
+            sum = _mm256_add_epi16(sum, _mm256_sub_epi16(_mm256_slli_epi16(c, 4), _mm256_slli_epi16(c, 1)));
+            sum = _mm256_srli_epi16(_mm256_add_epi16(sum, bias), 5);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(filtered + x),
+                _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+        }
+#elif defined(NEOGFX_LCD_FILTER_SSE2)
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const bias = _mm_set1_epi16(16);
+        auto filter = [&](__m128i a, __m128i b, __m128i c, __m128i d, __m128i e)
+        {
+            __m128i sum = _mm_add_epi16(a, e);
+            sum = _mm_add_epi16(sum, _mm_slli_epi16(_mm_add_epi16(b, d), 3));
+            sum = _mm_add_epi16(sum, _mm_sub_epi16(_mm_slli_epi16(c, 4), _mm_slli_epi16(c, 1)));
+            return _mm_srli_epi16(_mm_add_epi16(sum, bias), 5);
+        };
+        for (; x < aWidth; x += 16u)
+        {
+            __m128i taps[5];
+            for (uint32_t tap = 0u; tap < 5u; ++tap)
+                taps[tap] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(padded + x + tap));
+            __m128i const lo = filter(
+                _mm_unpacklo_epi8(taps[0], zero), _mm_unpacklo_epi8(taps[1], zero), _mm_unpacklo_epi8(taps[2], zero),
+                _mm_unpacklo_epi8(taps[3], zero), _mm_unpacklo_epi8(taps[4], zero));
+            __m128i const hi = filter(
+                _mm_unpackhi_epi8(taps[0], zero), _mm_unpackhi_epi8(taps[1], zero), _mm_unpackhi_epi8(taps[2], zero),
+                _mm_unpackhi_epi8(taps[3], zero), _mm_unpackhi_epi8(taps[4], zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(filtered + x), _mm_packus_epi16(lo, hi));
+        }
+#elif defined(NEOGFX_LCD_FILTER_NEON)
+        for (; x < aWidth; x += 8u)
+        {
+            uint16x8_t sum = vaddl_u8(vld1_u8(padded + x), vld1_u8(padded + x + 4u));
+            sum = vmlaq_n_u16(sum, vaddl_u8(vld1_u8(padded + x + 1u), vld1_u8(padded + x + 3u)), 8u);
+            sum = vmlaq_n_u16(sum, vmovl_u8(vld1_u8(padded + x + 2u)), 14u);
+            vst1_u8(filtered + x, vrshrn_n_u16(sum, 5));
+        }
+#else
+        for (; x < aWidth; ++x)
+            filtered[x] = lcd_filter(padded + x);
+#endif
+        store_lcd_row(filtered, aWidth, aDestination);
+    }
+
+    void glyph_rasterizer::lcd_filter_row_scalar(const uint8_t* aSource, uint32_t aWidth, uint8_t* aDestination)
+    {
+        if (aWidth == 0u)
+            return;
+        auto const row = pad_lcd_row(aSource, aWidth);
+        const uint8_t* const padded = row.first;
+        uint8_t* const filtered = row.second;
+        for (uint32_t x = 0u; x < aWidth; ++x)
+            filtered[x] = lcd_filter(padded + x);
+        store_lcd_row(filtered, aWidth, aDestination);
+    }
+
+    glyph_rasterizer::bitmap glyph_rasterizer::rasterize(FT_Face aFace, glyph_index_t aGlyphIndex)
+    {
+        try
+        {
+            freetypeCheck(FT_Load_Glyph(aFace, aGlyphIndex, FT_LOAD_TARGET_LCD | FT_LOAD_NO_BITMAP));
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_load_glyph_error(fe.what());
+        }
+        try
+        {
+            freetypeCheck(FT_Render_Glyph(aFace->glyph, FT_RENDER_MODE_LCD));
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_render_glyph_error(fe.what());
+        }
+
+        FT_Bitmap& ftBitmap = aFace->glyph->bitmap;
+
+        bitmap result;
+        result.pixelMode = to_glyph_pixel_mode(ftBitmap.pixel_mode);
+        result.subpixel = (result.pixelMode == glyph_pixel_mode::LCD);
+        result.width = ftBitmap.width / (result.subpixel ? 3 : 1);
+        result.height = ftBitmap.rows;
+        result.placement = point{
+            aFace->glyph->metrics.horiBearingX / 64.0,
+            (aFace->glyph->metrics.horiBearingY - aFace->glyph->metrics.height) / 64.0 };
+
+        if (result.subpixel)
+        {
+            result.pixels.resize(static_cast<std::size_t>(result.width) * result.height * 4u);
+            for (uint32_t y = 0; y < ftBitmap.rows; y++)
+                lcd_filter_row(
+                    ftBitmap.buffer + static_cast<std::ptrdiff_t>(ftBitmap.pitch) * y, 
+                    ftBitmap.width, 
+                    &result.pixels[(ftBitmap.rows - 1 - y) * static_cast<std::size_t>(result.width) * 4u]);
+        }
+        else
+        {
+            result.pixels.resize(static_cast<std::size_t>(result.width) * result.height);
+            for (uint32_t y = 0; y < ftBitmap.rows; y++)
+                switch (ftBitmap.pixel_mode)
+                {
+                case FT_PIXEL_MODE_MONO: // 1 bit per pixel monochrome
+                    for (uint32_t x = 0; x < ftBitmap.width; x += 8)
+                        for (uint32_t b = 0; b < std::min(ftBitmap.width - x, 8u); ++b)
+                            result.pixels[(x + b) + (ftBitmap.rows - 1 - y) * static_cast<std::size_t>(result.width)] =
+                                ((ftBitmap.buffer[x / 8 + ftBitmap.pitch * y] & (1 << (7 - b))) != 0 ? 0xFF : 0x00);
+                    break;
+                case FT_PIXEL_MODE_GRAY:
+                default:
+                    for (uint32_t x = 0; x < ftBitmap.width; x++)
+                        result.pixels[x + (ftBitmap.rows - 1 - y) * static_cast<std::size_t>(result.width)] = ftBitmap.buffer[x + ftBitmap.pitch * y];
+                    break;
+                }
+        }
+
+        return result;
+    }
+
+    glyph_rasterizer::bitmap glyph_rasterizer::rasterize_distance_field(FT_Face aFace, glyph_index_t aGlyphIndex)
+    {
+        // aFace is expected to be sized to DistanceFieldEmSize pixels per em; hinting is disabled as the field is
+        // rendered at arbitrary scales
+        try
+        {
+            freetypeCheck(FT_Load_Glyph(aFace, aGlyphIndex, FT_LOAD_NO_HINTING | FT_LOAD_NO_BITMAP));
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_load_glyph_error(fe.what());
+        }
+        try
+        {
+            freetypeCheck(FT_Render_Glyph(aFace->glyph, FT_RENDER_MODE_NORMAL));
+        }
+        catch (freetype_error fe)
+        {
+            throw native_font_face::freetype_render_glyph_error(fe.what());
+        }
+
+        FT_Bitmap& ftBitmap = aFace->glyph->bitmap;
+
+        uint32_t const spread = DistanceFieldSpread;
+        bitmap result;
+        result.subpixel = false;
+        result.pixelMode = glyph_pixel_mode::Gray;
+        result.width = ftBitmap.width + spread * 2u;
+        result.height = ftBitmap.rows + spread * 2u;
+        result.placement = point{
+            aFace->glyph->metrics.horiBearingX / 64.0 - spread,
+            (aFace->glyph->metrics.horiBearingY - aFace->glyph->metrics.height) / 64.0 - spread };
+
+        // coverage of the padded bitmap, top-down
+        std::size_t const count = static_cast<std::size_t>(result.width) * result.height;
+        thread_local std::vector<float> tCoverage;
+        thread_local std::vector<float> tOutside;
+        thread_local std::vector<float> tInside;
+        tCoverage.assign(count, 0.0f);
+        for (uint32_t y = 0; y < ftBitmap.rows; y++)
+            for (uint32_t x = 0; x < ftBitmap.width; x++)
+            {
+                uint8_t const value = (ftBitmap.pixel_mode == FT_PIXEL_MODE_MONO ?
+                    ((ftBitmap.buffer[x / 8 + ftBitmap.pitch * y] & (1 << (7 - x % 8))) != 0 ? 0xFF : 0x00) :
+                    ftBitmap.buffer[x + ftBitmap.pitch * y]);
+                tCoverage[(x + spread) + (y + spread) * static_cast<std::size_t>(result.width)] = value / 255.0f;
+            }
+
+        // squared distances to the nearest pixel inside (tOutside) and outside (tInside) the outline
+        tOutside.resize(count);
+        tInside.resize(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            bool const inside = tCoverage[i] >= 0.5f;
+            tOutside[i] = inside ? 0.0f : DistanceFieldFar;
+            tInside[i] = inside ? DistanceFieldFar : 0.0f;
+        }
+        distance_transform(tOutside, result.width, result.height);
+        distance_transform(tInside, result.width, result.height);
+
+        // encode signed distance (positive inside) so that the outline lies at 0.5
+        result.pixels.resize(count);
+        for (uint32_t y = 0; y < result.height; y++)
+            for (uint32_t x = 0; x < result.width; x++)
+            {
+                std::size_t const i = x + y * static_cast<std::size_t>(result.width);
+                float const coverage = tCoverage[i];
+                float distance;
+                if (coverage > 0.0f && coverage < 1.0f)
+                    distance = coverage - 0.5f;
+                else if (coverage >= 0.5f)
+                    distance = std::sqrt(tInside[i]) - 0.5f;
+                else
+                    distance = 0.5f - std::sqrt(tOutside[i]);
+                float const encoded = std::min(std::max(0.5f + distance / (2.0f * spread), 0.0f), 1.0f);
+                result.pixels[x + (result.height - 1 - y) * static_cast<std::size_t>(result.width)] = static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+            }
+
+        return result;
+    }
+
+    void glyph_rasterizer::request(const native_font_face& aFace, FT_Face aHandle, glyph_index_t aGlyphIndex, bool aPlaceholderServed)
+    {
+        if (aHandle == nullptr || !FT_IS_SCALABLE(aHandle))
+            return;
+        std::unique_lock<std::mutex> lock{ iMutex };
+        if (!iWorkersStarted)
+            start_workers();
+        if (iWorkers.empty())
+            return;
+        if (find_queued(aFace, aGlyphIndex) != iQueue.end() || find_completed(aFace, aGlyphIndex) != iCompleted.end() ||
+            std::find_if(iInFlight.begin(), iInFlight.end(), [&](const task& t) { return t.face == &aFace && t.glyphIndex == aGlyphIndex; }) != iInFlight.end())
+            return;
+        iQueue.push_back(task{ 
+            &aFace, 
+            aGlyphIndex, 
+            aHandle->stream->base, 
+            static_cast<FT_Long>(aHandle->stream->size), 
+            aHandle->face_index, 
+            static_cast<FT_F26Dot6>(aFace.size() * 64), 
+            static_cast<FT_UInt>(aFace.horizontal_dpi()), 
+            static_cast<FT_UInt>(aFace.vertical_dpi()), 
+            aPlaceholderServed });
+        lock.unlock();
+        iWorkAvailable.notify_one();
+    }
+
+    bool glyph_rasterizer::requested(const native_font_face& aFace, glyph_index_t aGlyphIndex) const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        auto const matches = [&](auto const& t) { return t.face == &aFace && t.glyphIndex == aGlyphIndex; };
+        return std::find_if(iQueue.begin(), iQueue.end(), matches) != iQueue.end() ||
+            std::find_if(iInFlight.begin(), iInFlight.end(), matches) != iInFlight.end() ||
+            std::find_if(iCompleted.begin(), iCompleted.end(), matches) != iCompleted.end();
+    }
+
+    void glyph_rasterizer::serve_placeholder(const native_font_face& aFace, glyph_index_t aGlyphIndex)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        auto const matches = [&](auto& t) { return t.face == &aFace && t.glyphIndex == aGlyphIndex; };
+        for (auto& t : iQueue)
+            if (matches(t))
+                t.placeholderServed = true;
+        for (auto& t : iInFlight)
+            if (matches(t))
+                t.placeholderServed = true;
+        for (auto& r : iCompleted)
+            if (matches(r))
+                r.placeholderServed = true;
+    }
+
+    glyph_rasterizer::result glyph_rasterizer::wait(const native_font_face& aFace, glyph_index_t aGlyphIndex)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        // a queued request is promoted so the caller does not wait behind prefetches
+        auto queued = find_queued(aFace, aGlyphIndex);
+        if (queued != iQueue.end() && queued != iQueue.begin())
+        {
+            auto t = *queued;
+            iQueue.erase(queued);
+            iQueue.push_front(t);
+        }
+        iWorkDone.wait(lock, [&]() { return find_completed(aFace, aGlyphIndex) != iCompleted.end(); });
+        auto completed = find_completed(aFace, aGlyphIndex);
+        auto r = std::move(*completed);
+        iCompleted.erase(completed);
+        return r;
+    }
+
+    glyph_rasterizer::glyph_list glyph_rasterizer::placeholders_ready() const
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        glyph_list ready;
+        for (auto const& r : iCompleted)
+            if (r.placeholderServed)
+                ready.emplace_back(r.face, r.glyphIndex);
+        return ready;
+    }
+
+    glyph_rasterizer::result_list glyph_rasterizer::take_completed()
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        result_list completed;
+        completed.swap(iCompleted);
+        return completed;
+    }
+
+    void glyph_rasterizer::cancel(const native_font_face& aFace)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        iQueue.erase(std::remove_if(iQueue.begin(), iQueue.end(), [&](const task& t) { return t.face == &aFace; }), iQueue.end());
+        iWorkDone.wait(lock, [&]() { return std::none_of(iInFlight.begin(), iInFlight.end(), [&](const task& t) { return t.face == &aFace; }); });
+        iCompleted.erase(std::remove_if(iCompleted.begin(), iCompleted.end(), [&](const result& r) { return r.face == &aFace; }), iCompleted.end());
+        for (auto& w : iWorkers)
+            w->purge.push_back(&aFace);
+        lock.unlock();
+        iWorkAvailable.notify_all();
+    }
+
+    void glyph_rasterizer::start_workers()
+    {
+        // called with iMutex held; workers block on it until the caller releases it
+        iWorkersStarted = true;
+        for (uint32_t i = 0u; i < iThreadCount; ++i)
+        {
+            iWorkers.push_back(std::make_unique<worker>());
+            auto& newWorker = *iWorkers.back();
+            if (FT_Init_FreeType(&newWorker.library) != 0)
+            {
+                iWorkers.pop_back();
+                break;
+            }
+            newWorker.thread = std::thread{ [this, &newWorker]() { work(newWorker); } };
+        }
+    }
+
+    void glyph_rasterizer::work(worker& aWorker)
+    {
+        std::unique_lock<std::mutex> lock{ iMutex };
+        for (;;)
+        {
+            iWorkAvailable.wait(lock, [&]() { return iStopping || !iQueue.empty() || !aWorker.purge.empty(); });
+            if (iStopping)
+                return;
+            aWorker.purge_faces();
+            if (iQueue.empty())
+                continue;
+            auto const t = iQueue.front();
+            iQueue.pop_front();
+            iInFlight.push_back(t);
+            lock.unlock();
+            std::optional<bitmap> glyph;
+            try
+            {
+                glyph = rasterize(aWorker.face(t), t.glyphIndex);
+            }
+            catch (...)
+            {
+            }
+            lock.lock();
+            auto inFlight = std::find_if(iInFlight.begin(), iInFlight.end(), [&](const task& f) { return f.face == t.face && f.glyphIndex == t.glyphIndex; });
+            iCompleted.push_back(result{ t.face, t.glyphIndex, std::move(glyph), inFlight->placeholderServed });
+            iInFlight.erase(inFlight);
+            iWorkDone.notify_all();
+        }
+    }
+
+    std::deque<glyph_rasterizer::task>::iterator glyph_rasterizer::find_queued(const native_font_face& aFace, glyph_index_t aGlyphIndex)
+    {
+        return std::find_if(iQueue.begin(), iQueue.end(), [&](const task& t) { return t.face == &aFace && t.glyphIndex == aGlyphIndex; });
+    }
+
+    glyph_rasterizer::result_list::iterator glyph_rasterizer::find_completed(const native_font_face& aFace, glyph_index_t aGlyphIndex)
+    {
+        return std::find_if(iCompleted.begin(), iCompleted.end(), [&](const result& r) { return r.face == &aFace && r.glyphIndex == aGlyphIndex; });
+    }
+}
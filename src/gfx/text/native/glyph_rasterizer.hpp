@@ -0,0 +1,124 @@
+// glyph_rasterizer.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <neogfx/core/geometrical.hpp>
+#include <neogfx/gfx/text/i_glyph_texture.hpp>
+#include "i_native_font_face.hpp"
+
+namespace neogfx
+{
+    class native_font_face;
+
+    // Pool of worker threads that rasterize glyphs off the UI thread. Each worker has its own FreeType library and
+    // its own FT_Face instances (FreeType faces are not thread safe) created over the same font data as the face
+    // that requested the glyph. Results are collected and uploaded to the glyph atlas by the UI thread in batches.
+    // The workers are started by the first request so an application that only rasterizes on demand has none.
+    class glyph_rasterizer
+    {
+    public:
+        typedef i_native_font_face::glyph_index_t glyph_index_t;
+        static constexpr uint32_t DistanceFieldEmSize = 64u;
+        static constexpr uint32_t DistanceFieldSpread = 8u;
+        struct bitmap
+        {
+            bool subpixel;
+            glyph_pixel_mode pixelMode;
+            uint32_t width;
+            uint32_t height;
+            point placement;
+            std::vector<uint8_t> pixels; // bottom-up rows; four bytes per pixel if subpixel otherwise one
+        };
+        struct result
+        {
+            const native_font_face* face;
+            glyph_index_t glyphIndex;
+            std::optional<bitmap> glyph; // not set if rasterization failed
+            bool placeholderServed;
+        };
+        typedef std::vector<result> result_list;
+        typedef std::vector<std::pair<const native_font_face*, glyph_index_t>> glyph_list;
+    private:
+        struct task
+        {
+            const native_font_face* face;
+            glyph_index_t glyphIndex;
+            const FT_Byte* data;
+            FT_Long dataSize;
+            FT_Long faceIndex;
+            FT_F26Dot6 charSize;
+            FT_UInt horizontalDpi;
+            FT_UInt verticalDpi;
+            bool placeholderServed;
+        };
+        struct worker;
+    public:
+        class scoped_blocking
+        {
+        public:
+            scoped_blocking();
+            ~scoped_blocking();
+        private:
+            bool iPrevious;
+        };
+    public:
+        glyph_rasterizer(uint32_t aThreadCount = std::max(1u, std::thread::hardware_concurrency() / 2u));
+        ~glyph_rasterizer();
+    public:
+        static bool blocking();
+        static bitmap rasterize(FT_Face aFace, glyph_index_t aGlyphIndex);
+        static bitmap rasterize_distance_field(FT_Face aFace, glyph_index_t aGlyphIndex);
+        // Filters a row of aWidth LCD sub-pixels into a row of RGBA pixels (alpha untouched) using SIMD where the target
+        // supports it; the scalar version gives identical results and is the reference for testing and benchmarking.
+        static void lcd_filter_row(const uint8_t* aSource, uint32_t aWidth, uint8_t* aDestination);
+        static void lcd_filter_row_scalar(const uint8_t* aSource, uint32_t aWidth, uint8_t* aDestination);
+    public:
+        void request(const native_font_face& aFace, FT_Face aHandle, glyph_index_t aGlyphIndex, bool aPlaceholderServed = false);
+        bool requested(const native_font_face& aFace, glyph_index_t aGlyphIndex) const;
+        void serve_placeholder(const native_font_face& aFace, glyph_index_t aGlyphIndex);
+        result wait(const native_font_face& aFace, glyph_index_t aGlyphIndex);
+        glyph_list placeholders_ready() const;
+        result_list take_completed();
+        void cancel(const native_font_face& aFace);
+    private:
+        void start_workers();
+        void work(worker& aWorker);
+        std::deque<task>::iterator find_queued(const native_font_face& aFace, glyph_index_t aGlyphIndex);
+        result_list::iterator find_completed(const native_font_face& aFace, glyph_index_t aGlyphIndex);
+    private:
+        mutable std::mutex iMutex;
+        std::condition_variable iWorkAvailable;
+        std::condition_variable iWorkDone;
+        std::deque<task> iQueue;
+        std::vector<task> iInFlight;
+        result_list iCompleted;
+        uint32_t iThreadCount;
+        std::vector<std::unique_ptr<worker>> iWorkers;
+        bool iWorkersStarted;
+        bool iStopping;
+    };
+}
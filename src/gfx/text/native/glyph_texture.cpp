@@ -22,8 +22,8 @@
 
 namespace neogfx
 {
-    glyph_texture::glyph_texture(const i_sub_texture& aTexture, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode) :
-        iTexture(aTexture), iSubpixel{ aSubpixel }, iPlacement{ aPlacement }, iPixelMode{ aPixelMode }
+    glyph_texture::glyph_texture(const i_sub_texture& aTexture, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode, bool aPlaceholder) :
+        iTexture(aTexture), iSubpixel{ aSubpixel }, iPlacement{ aPlacement }, iPixelMode{ aPixelMode }, iPlaceholder{ aPlaceholder }
     {
     }
 
@@ -50,4 +50,9 @@ namespace neogfx
     {
         return iPixelMode;
     }
+
+    bool glyph_texture::placeholder() const
+    {
+        return iPlaceholder;
+    }
 }
\ No newline at end of file
@@ -27,17 +27,19 @@ namespace neogfx
     class glyph_texture : public i_glyph_texture
     {
     public:
-        glyph_texture(const i_sub_texture& aTexture, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode);
+        glyph_texture(const i_sub_texture& aTexture, bool aSubpixel, const point& aPlacement, glyph_pixel_mode aPixelMode, bool aPlaceholder = false);
         ~glyph_texture();
     public:
         const i_sub_texture& texture() const override;
         bool subpixel() const override;
         const point& placement() const override;
         glyph_pixel_mode pixel_mode() const override;
+        bool placeholder() const override;
     private:
         const i_sub_texture& iTexture;
         bool iSubpixel;
         const point iPlacement;
         glyph_pixel_mode iPixelMode;
+        bool iPlaceholder;
     };
 }
\ No newline at end of file
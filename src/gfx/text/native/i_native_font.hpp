@@ -39,6 +39,7 @@ namespace neogfx
         virtual uint32_t style_count() const = 0;
         virtual font_style style(uint32_t aStyleIndex) const = 0;
         virtual const std::string& style_name(uint32_t aStyleIndex) const = 0;
+        virtual font_weight weight(uint32_t aStyleIndex) const = 0;
         virtual i_native_font_face& create_face(font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice) = 0;
         virtual i_native_font_face& create_face(const std::string& aStyleName, font::point_size aSize, const i_device_resolution& aDevice) = 0;
         // reference counting
@@ -56,9 +57,9 @@ namespace neogfx
         }
         font_weight min_weight() const
         {
-            auto minWeight = font::weight_from_style_name(style_name(0));
+            auto minWeight = weight(0u);
             for (auto si = 1u; si < style_count(); ++si)
-                minWeight = std::min(minWeight, font::weight_from_style_name(style_name(si)));
+                minWeight = std::min(minWeight, weight(si));
             return minWeight;
         }
     };
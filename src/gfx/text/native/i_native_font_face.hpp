@@ -65,6 +65,9 @@ namespace neogfx
         virtual void* aux_handle() const = 0;
         virtual glyph_index_t glyph_index(char32_t aCodePoint) const = 0;
         virtual i_glyph_texture& glyph_texture(const glyph& aGlyph) const = 0;
+        virtual const i_glyph_texture& distance_field_glyph_texture(const glyph& aGlyph) const = 0;
+        virtual dimension distance_field_scale() const = 0;
+        virtual dimension distance_field_spread() const = 0;
     public:
         virtual void add_ref() = 0;
         virtual void release() = 0;
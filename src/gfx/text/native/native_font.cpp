@@ -20,6 +20,9 @@
 #include <neogfx/neogfx.hpp>
 #include <boost/filesystem.hpp>
 #include <neolib/string_ci.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/i_texture_atlas.hpp>
+#include "../../native/i_native_texture.hpp"
 #include "native_font.hpp"
 #include "native_font_face.hpp"
 
@@ -35,6 +38,17 @@ namespace neogfx
         iCache.shrink_to_fit();
     }
 
+    native_font::native_font(FT_Library aFontLib, const std::string aFileName, const std::string& aFamilyName, const font_catalogue::face_list& aFaces) :
+        iFontLib(aFontLib), iSource(filename_type(aFileName)), iCache{}, iFamilyName{ aFamilyName }, iFaceCount(static_cast<FT_Long>(aFaces.size()))
+    {
+        // the file is not opened until a face is created
+        for (auto const& face : aFaces)
+        {
+            iStyleMap.emplace(std::make_pair(face.style, face.styleName), face.index);
+            iWeights.emplace(face.index, face.weight);
+        }
+    }
+
     native_font::native_font(FT_Library aFontLib, const void* aData, std::size_t aSizeInBytes) :
         iFontLib(aFontLib), iSource(memory_block_type(aData, aSizeInBytes)), iCache{}, iFaceCount(0)
     {
@@ -47,6 +61,13 @@ namespace neogfx
 
     native_font::~native_font()
     {
+        close_distance_field_faces();
+        if (!iDistanceFieldGlyphs.empty())
+        {
+            auto& distanceFieldAtlas = service<i_font_manager>().distance_field_atlas();
+            for (auto const& g : iDistanceFieldGlyphs)
+                distanceFieldAtlas.destroy_sub_texture(distanceFieldAtlas.sub_texture(g.second.texture().atlas_id()));
+        }
     }
 
     const std::string& native_font::family_name() const
@@ -75,6 +96,11 @@ namespace neogfx
         return std::next(iStyleMap.begin(), aStyleIndex)->first.second;
     }
 
+    font_weight native_font::weight(uint32_t aStyleIndex) const
+    {
+        return iWeights.at(std::next(iStyleMap.begin(), aStyleIndex)->second);
+    }
+
     namespace
     {
         uint32_t matching_bits(uint32_t lhs, uint32_t rhs)
@@ -154,6 +180,7 @@ namespace neogfx
         }
         if (iFaceUsage.empty())
         {
+            close_distance_field_faces();
             iCache.clear();
             iCache.shrink_to_fit();
         }
@@ -169,19 +196,8 @@ namespace neogfx
                 iFaceCount = face->num_faces;
                 iFamilyName = face->family_name;
             }
-            font_style style = font_style::Invalid;
-            if (face->style_flags & FT_STYLE_FLAG_ITALIC)
-                style = static_cast<font_style>(style | font_style::Italic);
-            if (face->style_flags & FT_STYLE_FLAG_BOLD)
-                style = static_cast<font_style>(style | font_style::Bold);
-            auto const searchKey = neolib::ci_string{ face->style_name };
-            if (searchKey.find("italic") != neolib::ci_string::npos)
-                style |= font_style::Italic;
-            if (searchKey.find("bold") != neolib::ci_string::npos || searchKey.find("heavy") != neolib::ci_string::npos || searchKey.find("black") != neolib::ci_string::npos)
-                style |= font_style::Bold;
-            if (style == font_style::Invalid)
-                style = font_style::Normal;
-            iStyleMap.emplace(std::make_pair(style, face->style_name), aFaceIndex);
+            iStyleMap.emplace(std::make_pair(font_catalogue::style_from_face(face), face->style_name), aFaceIndex);
+            iWeights.emplace(aFaceIndex, font_catalogue::weight_from_face(face));
         }
         catch (...)
         {
@@ -231,6 +247,56 @@ namespace neogfx
         FT_Done_Face(aFace);
     }
 
+    const i_glyph_texture& native_font::distance_field_glyph_texture(FT_Long aFaceIndex, i_native_font_face::glyph_index_t aGlyphIndex)
+    {
+        auto existingGlyph = iDistanceFieldGlyphs.find(std::make_pair(aFaceIndex, aGlyphIndex));
+        if (existingGlyph != iDistanceFieldGlyphs.end())
+            return existingGlyph->second;
+        glyph_rasterizer::bitmap rasterized;
+        try
+        {
+            rasterized = glyph_rasterizer::rasterize_distance_field(distance_field_face(aFaceIndex), aGlyphIndex);
+        }
+        catch (native_font_face::freetype_load_glyph_error)
+        {
+            std::cerr << "neogfx: warning: Cannot load font glyph" << std::endl;
+            rasterized = glyph_rasterizer::bitmap{ false, glyph_pixel_mode::Gray, 1u, 1u, point{}, { 0x00 } };
+        }
+        catch (native_font_face::freetype_render_glyph_error)
+        {
+            std::cerr << "neogfx: warning: Cannot render font glyph" << std::endl;
+            rasterized = glyph_rasterizer::bitmap{ false, glyph_pixel_mode::Gray, 1u, 1u, point{}, { 0x00 } };
+        }
+        auto& subTexture = service<i_font_manager>().distance_field_atlas().create_sub_texture(
+            neogfx::size{ static_cast<dimension>(rasterized.width), static_cast<dimension>(rasterized.height) },
+            1.0, texture_sampling::Normal, texture_data_format::Red);
+        auto const& glyphTexture = iDistanceFieldGlyphs.emplace(std::make_pair(aFaceIndex, aGlyphIndex),
+            glyph_texture{ subTexture, false, rasterized.placement, rasterized.pixelMode }).first->second;
+        if (!rasterized.pixels.empty())
+            subTexture.native_texture()->set_pixels(rect{ subTexture.atlas_location() }, &rasterized.pixels[0], 1u);
+        return glyphTexture;
+    }
+
+    FT_Face native_font::distance_field_face(FT_Long aFaceIndex)
+    {
+        auto existingFace = iDistanceFieldFaces.find(aFaceIndex);
+        if (existingFace != iDistanceFieldFaces.end())
+            return existingFace->second;
+        FT_Face newFace = open_face(aFaceIndex);
+        if (FT_IS_SCALABLE(newFace))
+            FT_Set_Pixel_Sizes(newFace, 0, glyph_rasterizer::DistanceFieldEmSize);
+        iDistanceFieldFaces.emplace(aFaceIndex, newFace);
+        return newFace;
+    }
+
+    void native_font::close_distance_field_faces()
+    {
+        // the faces reference iCache so must be closed before it is released
+        for (auto const& f : iDistanceFieldFaces)
+            close_face(f.second);
+        iDistanceFieldFaces.clear();
+    }
+
     i_native_font_face& native_font::create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice)
     {
         auto existingFace = iFaces.find(std::make_tuple(aFaceIndex, aSize, size(aDevice.horizontal_dpi(), aDevice.vertical_dpi())));
@@ -22,11 +22,14 @@
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
 #include <tuple>
+#include <boost/functional/hash.hpp>
 #include <neolib/variant.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include "../font_catalogue.hpp"
 #include "i_native_font.hpp"
 #include "i_native_font_face.hpp"
+#include "glyph_texture.hpp"
 
 namespace neogfx
 {
@@ -38,13 +41,18 @@ namespace neogfx
     private:
         typedef neolib::variant<filename_type, memory_block_type> source_type;
         typedef std::map<std::pair<font_style, std::string>, FT_Long> style_map;
+        typedef std::map<FT_Long, font_weight> weight_map;
         typedef std::map<std::tuple<FT_Long, font::point_size, size>, std::shared_ptr<i_native_font_face>> face_map;
         typedef std::unordered_map<i_native_font_face*, uint32_t> usage_map;
+        typedef std::map<FT_Long, FT_Face> distance_field_face_map;
+        typedef std::pair<FT_Long, i_native_font_face::glyph_index_t> distance_field_glyph_key;
+        typedef std::unordered_map<distance_field_glyph_key, glyph_texture, boost::hash<distance_field_glyph_key>> distance_field_glyph_map;
     public:
         struct failed_to_load_font : std::runtime_error { failed_to_load_font() : std::runtime_error("neogfx::native_font::failed_to_load_font") {} };
         struct no_matching_style_found : std::runtime_error { no_matching_style_found() : std::runtime_error("neogfx::native_font::no_matching_style_found") {} };
     public:
         native_font(FT_Library aFontLib, const std::string aFileName);
+        native_font(FT_Library aFontLib, const std::string aFileName, const std::string& aFamilyName, const font_catalogue::face_list& aFaces);
         native_font(FT_Library aFontLib, const void* aData, std::size_t aSizeInBytes);
         ~native_font();
     public:
@@ -53,15 +61,20 @@ namespace neogfx
         uint32_t style_count() const override;
         font_style style(uint32_t aStyleIndex) const override;
         const std::string& style_name(uint32_t aStyleIndex) const override;
+        font_weight weight(uint32_t aStyleIndex) const override;
         i_native_font_face& create_face(font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice) override;
         i_native_font_face& create_face(const std::string& aStyleName, font::point_size aSize, const i_device_resolution& aDevice) override;
     public:
         void add_ref(i_native_font_face& aFace) override;
         void release(i_native_font_face& aFace) override;
+    public:
+        const i_glyph_texture& distance_field_glyph_texture(FT_Long aFaceIndex, i_native_font_face::glyph_index_t aGlyphIndex);
     private:
         void register_face(FT_Long aFaceIndex);
         FT_Face open_face(FT_Long aFaceIndex);
         void close_face(FT_Face aFace);
+        FT_Face distance_field_face(FT_Long aFaceIndex);
+        void close_distance_field_faces();
         i_native_font_face& create_face(FT_Long aFaceIndex, font_style aStyle, font::point_size aSize, const i_device_resolution& aDevice);
     private:
         FT_Library iFontLib;
@@ -70,7 +83,10 @@ namespace neogfx
         std::string iFamilyName;
         FT_Long iFaceCount;
         style_map iStyleMap;
+        weight_map iWeights;
         face_map iFaces;
         usage_map iFaceUsage;
+        distance_field_face_map iDistanceFieldFaces;
+        distance_field_glyph_map iDistanceFieldGlyphs;
     };
 }
\ No newline at end of file
@@ -19,6 +19,9 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <tuple>
 #include <boost/functional/hash.hpp>
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -28,9 +31,10 @@
 #include FT_LCD_FILTER_H
 #include "../../native/opengl.hpp"
 #include "../../native/i_native_texture.hpp"
+#include "native_font.hpp"
 #include "native_font_face.hpp"
 #include <neogfx/gfx/text/glyph.hpp>
-#include <neogfx/gfx/text/i_font_manager.hpp>
+#include <neogfx/gfx/text/font_manager.hpp>
 #include <neogfx/gfx/i_texture_atlas.hpp>
 #include <neogfx/gfx/i_rendering_engine.hpp>
 
@@ -42,6 +46,9 @@ namespace neogfx
         typedef std::unordered_map<FT_Face, get_advance_cache_face> get_advance_cache;
         get_advance_cache sGetAdvanceCache;
 
+        std::unordered_set<const native_font_face*> sFaces;
+        uint64_t sGlyphUseGeneration;
+
         extern "C"
         {
             FT_EXPORT(FT_Error) orig_FT_Get_Advance(FT_Face face, FT_UInt gindex, FT_Int32 load_flags, FT_Fixed* padvance);
@@ -82,10 +89,15 @@ namespace neogfx
     {
         set_metrics();
         sGetAdvanceCache[iHandle] = get_advance_cache_face{};
+        sFaces.insert(this);
     }
 
     native_font_face::~native_font_face()
     {
+        sFaces.erase(this);
+        rendering_glyph_rasterizer().cancel(*this);
+        static_cast<font_manager&>(service<i_font_manager>()).forget_placeholder_glyphs(iId);
+        destroy_glyphs();
         if (iHandle != nullptr)
             sGetAdvanceCache.erase(sGetAdvanceCache.find(iHandle));
         FT_Done_Face(iHandle);
@@ -226,6 +238,8 @@ namespace neogfx
 
     void native_font_face::update_handle(void* aHandle) 
     { 
+        // workers hold faces over the font data of the current handle
+        rendering_glyph_rasterizer().cancel(*this);
         if (iHandle != nullptr)
             sGetAdvanceCache.erase(sGetAdvanceCache.find(iHandle));
         iHandle = static_cast<FT_Face>(aHandle);
@@ -248,158 +262,229 @@ namespace neogfx
         return FT_Get_Char_Index(iHandle, aCodePoint);
     }
 
-    inline glyph_pixel_mode to_glyph_pixel_mode(unsigned char aFreeTypePixelMode)
-    {
-        switch (aFreeTypePixelMode)
-        {
-        default:
-        case FT_PIXEL_MODE_NONE:
-            return glyph_pixel_mode::None;
-        case FT_PIXEL_MODE_MONO:
-            return glyph_pixel_mode::Mono;
-        case FT_PIXEL_MODE_GRAY:
-            return glyph_pixel_mode::Gray;
-        case FT_PIXEL_MODE_GRAY2:
-            return glyph_pixel_mode::Gray2Bit;
-        case FT_PIXEL_MODE_GRAY4:
-            return glyph_pixel_mode::Gray4Bit;
-        case FT_PIXEL_MODE_LCD:
-            return glyph_pixel_mode::LCD;
-        case FT_PIXEL_MODE_LCD_V:
-            return glyph_pixel_mode::LCD_V;
-        case FT_PIXEL_MODE_BGRA:
-            return glyph_pixel_mode::BGRA;
-        }
-    }
-         
     i_glyph_texture& native_font_face::glyph_texture(const glyph& aGlyph) const
     {
         auto existingGlyph = iGlyphs.find(aGlyph.value());
         if (existingGlyph != iGlyphs.end())
-            return existingGlyph->second;
-        try
         {
-            try
-            {
-                freetypeCheck(FT_Load_Glyph(iHandle, aGlyph.value(), FT_LOAD_TARGET_LCD | FT_LOAD_NO_BITMAP));
-            }
-            catch (freetype_error fe)
-            {
-                std::cerr << "neogfx: warning: Cannot load font glyph" << std::endl;
-                throw freetype_load_glyph_error(fe.what());
-            }
-            try
-            {
-                freetypeCheck(FT_Render_Glyph(iHandle->glyph, FT_RENDER_MODE_LCD));
-            }
-            catch (freetype_error fe)
-            {
-                std::cerr << "neogfx: warning: Cannot render font glyph" << std::endl;
-                throw freetype_render_glyph_error(fe.what());
-            }
+            existingGlyph->second.lastUse = sGlyphUseGeneration;
+            return existingGlyph->second.texture;
         }
-        catch (...)
+        // a glyph that failed to rasterize is never requested again
+        if (iFailedGlyphs.find(aGlyph.value()) != iFailedGlyphs.end())
+            return invalid_glyph(aGlyph);
+        auto& rasterizer = rendering_glyph_rasterizer();
+        auto const renderWhenReady = !glyph_rasterizer::blocking() && 
+            service<i_font_manager>().glyph_rasterization() == neogfx::glyph_rasterization::RenderWhenReady;
+        if (rasterizer.requested(*this, aGlyph.value()))
         {
-            thread_local bool inHere = false;
-            if (!inHere)
-            {
-                neolib::scoped_flag sf{ inHere };
-                glyph invalid = aGlyph;
-                auto const replacementGlyph = FT_Get_Char_Index(iHandle, 0xFFFD);
-                if (replacementGlyph != 0)
-                {
-                    invalid.set_value(replacementGlyph);
-                    return glyph_texture(aGlyph);
-                }
-            }
-            if (iInvalidGlyph == std::nullopt)
+            if (renderWhenReady)
             {
-                auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
-                    neogfx::size{ height(), height() }.ceil(),
-                    1.0, texture_sampling::Normal, texture_data_format::SubPixel);
-                iInvalidGlyph.emplace(
-                    subTexture,
-                    true,
-                    point{},
-                    glyph_pixel_mode::LCD);
-                // todo: render an invalid glyph symbol
+                rasterizer.serve_placeholder(*this, aGlyph.value());
+                return placeholder_glyph();
             }
-            return *iInvalidGlyph;
+            auto rasterized = rasterizer.wait(*this, aGlyph.value());
+            if (rasterized.glyph != std::nullopt)
+                return add_glyph(aGlyph.value(), *rasterized.glyph);
+        }
+        else if (renderWhenReady && FT_IS_SCALABLE(iHandle))
+        {
+            rasterizer.request(*this, iHandle, aGlyph.value(), true);
+            if (rasterizer.requested(*this, aGlyph.value()))
+                return placeholder_glyph();
         }
+        glyph_rasterizer::bitmap rasterized;
+        try
+        {
+            rasterized = glyph_rasterizer::rasterize(iHandle, aGlyph.value());
+        }
+        catch (freetype_load_glyph_error)
+        {
+            std::cerr << "neogfx: warning: Cannot load font glyph" << std::endl;
+            iFailedGlyphs.insert(aGlyph.value());
+            return invalid_glyph(aGlyph);
+        }
+        catch (freetype_render_glyph_error)
+        {
+            std::cerr << "neogfx: warning: Cannot render font glyph" << std::endl;
+            iFailedGlyphs.insert(aGlyph.value());
+            return invalid_glyph(aGlyph);
+        }
+        return add_glyph(aGlyph.value(), rasterized);
+    }
 
-        bool useSubpixelFiltering = true;
+    const i_glyph_texture& native_font_face::distance_field_glyph_texture(const glyph& aGlyph) const
+    {
+        // distance fields are rendered once per typeface at a fixed size and shared by all sizes of it
+        return static_cast<neogfx::native_font&>(iFont).distance_field_glyph_texture(iHandle->face_index, aGlyph.value());
+    }
 
-        FT_Bitmap& bitmap = iHandle->glyph->bitmap;
+    dimension native_font_face::distance_field_scale() const
+    {
+        return iSize * iPixelDensityDpi.cy / 72.0 / glyph_rasterizer::DistanceFieldEmSize;
+    }
 
-        auto pixelMode = to_glyph_pixel_mode(bitmap.pixel_mode);
+    dimension native_font_face::distance_field_spread() const
+    {
+        return glyph_rasterizer::DistanceFieldSpread * distance_field_scale();
+    }
 
-        if (pixelMode != glyph_pixel_mode::LCD)
-            useSubpixelFiltering = false;
+    void native_font_face::prefetch_glyphs(const std::u32string& aCodePoints) const
+    {
+        if (iHandle == nullptr)
+            return;
+        auto& rasterizer = rendering_glyph_rasterizer();
+        for (auto codePoint : aCodePoints)
+        {
+            auto const glyphIndex = glyph_index(codePoint);
+            if (glyphIndex != 0 && iGlyphs.find(glyphIndex) == iGlyphs.end())
+                rasterizer.request(*this, iHandle, glyphIndex);
+        }
+    }
 
-        auto subTextureWidth = bitmap.width / (useSubpixelFiltering ? 3 : 1);
+    i_glyph_texture& native_font_face::add_glyph(glyph_index_t aGlyphIndex, const glyph_rasterizer::bitmap& aBitmap) const
+    {
         auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
-            neogfx::size{ static_cast<dimension>(subTextureWidth), static_cast<dimension>(bitmap.rows) }.ceil(),
-            1.0, texture_sampling::Normal, pixelMode != glyph_pixel_mode::Mono ? texture_data_format::SubPixel : texture_data_format::Red);
+            neogfx::size{ static_cast<dimension>(aBitmap.width), static_cast<dimension>(aBitmap.height) }.ceil(),
+            1.0, texture_sampling::Normal, aBitmap.pixelMode != glyph_pixel_mode::Mono ? texture_data_format::SubPixel : texture_data_format::Red);
 
         rect glyphRect{ subTexture.atlas_location() };
-        i_glyph_texture& glyphTexture = iGlyphs.insert(std::make_pair(aGlyph.value(),
-            neogfx::glyph_texture{
+        i_glyph_texture& glyphTexture = iGlyphs.insert(std::make_pair(aGlyphIndex,
+            cached_glyph{
+                neogfx::glyph_texture{
+                    subTexture,
+                    aBitmap.subpixel,
+                    aBitmap.placement,
+                    aBitmap.pixelMode },
+                sGlyphUseGeneration })).first->second.texture;
+
+        if (!aBitmap.pixels.empty())
+            glyphTexture.texture().native_texture()->set_pixels(glyphRect, &aBitmap.pixels[0], 1u);
+
+        return glyphTexture;
+    }
+
+    i_glyph_texture& native_font_face::invalid_glyph(const glyph& aGlyph) const
+    {
+        thread_local bool inHere = false;
+        if (!inHere)
+        {
+            neolib::scoped_flag sf{ inHere };
+            glyph invalid = aGlyph;
+            auto const replacementGlyph = FT_Get_Char_Index(iHandle, 0xFFFD);
+            if (replacementGlyph != 0)
+            {
+                invalid.set_value(replacementGlyph);
+                // the replacement is rasterized now as a placeholder would be recorded against the wrong glyph
+                glyph_rasterizer::scoped_blocking sb;
+                return glyph_texture(invalid);
+            }
+        }
+        if (iInvalidGlyph == std::nullopt)
+        {
+            auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
+                neogfx::size{ height(), height() }.ceil(),
+                1.0, texture_sampling::Normal, texture_data_format::SubPixel);
+            iInvalidGlyph.emplace(
+                subTexture,
+                true,
+                point{},
+                glyph_pixel_mode::LCD);
+            // todo: render an invalid glyph symbol
+        }
+        return *iInvalidGlyph;
+    }
+
+    i_glyph_texture& native_font_face::placeholder_glyph() const
+    {
+        if (iPlaceholderGlyph == std::nullopt)
+        {
+            auto& subTexture = service<i_font_manager>().glyph_atlas().create_sub_texture(
+                neogfx::size{ 1.0, 1.0 }, 1.0, texture_sampling::Normal, texture_data_format::SubPixel);
+            std::array<uint8_t, 4> const transparent = {};
+            subTexture.native_texture()->set_pixels(rect{ subTexture.atlas_location() }, &transparent[0], 1u);
+            iPlaceholderGlyph.emplace(
                 subTexture,
-                useSubpixelFiltering,
-                point{
-                    iHandle->glyph->metrics.horiBearingX / 64.0,
-                    (iHandle->glyph->metrics.horiBearingY - iHandle->glyph->metrics.height) / 64.0 },
-                pixelMode })).first->second;
-
-        thread_local std::vector<GLubyte> glyphTextureData;
-        thread_local std::vector<std::array<GLubyte, 4>> subpixelGlyphTextureData;
-        glyphTextureData.clear();
-        subpixelGlyphTextureData.clear();
-
-        const GLubyte* textureData = 0;
-        
-        if (useSubpixelFiltering)
+                true,
+                point{},
+                glyph_pixel_mode::LCD,
+                true);
+        }
+        return *iPlaceholderGlyph;
+    }
+
+    void native_font_face::upload_rasterized_glyphs()
+    {
+        for (auto& rasterized : rendering_glyph_rasterizer().take_completed())
         {
-            subpixelGlyphTextureData.resize(static_cast<std::size_t>(glyphRect.cx * glyphRect.cy));
-            // sub-pixel FIR filter.
-            static double coefficients[] = { 0.5 / 16.0, 4.0 / 16.0, 7.0 / 16.0, 4.0 / 16.0, 0.5 / 16.0 };
-            for (uint32_t y = 0; y < bitmap.rows; y++)
+            auto& face = *rasterized.face;
+            if (rasterized.glyph == std::nullopt)
             {
-                for (uint32_t x = 0; x < bitmap.width; x++)
-                {
-                    uint8_t alpha = 0;
-                    for (int32_t z = -2; z <= 2; ++z)
-                        alpha += static_cast<uint8_t>(bitmap.buffer[std::max(0, std::min<int32_t>(bitmap.width - 1, x + z)) + bitmap.pitch * y] * coefficients[z + 2]);
-                    subpixelGlyphTextureData[(x / 3) + (bitmap.rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)][x % 3] = alpha;
-                }
+                // fall back to the invalid glyph for good rather than serving a placeholder forever
+                face.iFailedGlyphs.insert(rasterized.glyphIndex);
+                continue;
             }
-            textureData = &subpixelGlyphTextureData[0][0];
+            if (face.iGlyphs.find(rasterized.glyphIndex) == face.iGlyphs.end())
+                face.add_glyph(rasterized.glyphIndex, *rasterized.glyph);
         }
-        else
+    }
+
+    void native_font_face::advance_glyph_use_generation()
+    {
+        ++sGlyphUseGeneration;
+    }
+
+    void native_font_face::evict_glyphs(dimension aBudget)
+    {
+        auto& glyphAtlas = service<i_font_manager>().glyph_atlas();
+        auto used = glyphAtlas.stats().used;
+        if (used <= aBudget)
+            return;
+        // least recently used first; glyphs drawn in the previous frame are kept
+        std::vector<std::tuple<uint64_t, const native_font_face*, glyph_index_t>> candidates;
+        for (auto face : sFaces)
+            for (auto const& cachedGlyph : face->iGlyphs)
+                if (cachedGlyph.second.lastUse + 1u < sGlyphUseGeneration)
+                    candidates.emplace_back(cachedGlyph.second.lastUse, face, cachedGlyph.first);
+        std::sort(candidates.begin(), candidates.end());
+        // evict down to a low water mark so a full atlas doesn't cause eviction every frame
+        auto const lowWaterMark = aBudget * 0.75;
+        for (auto const& candidate : candidates)
         {
-            glyphTextureData.resize(static_cast<std::size_t>(glyphRect.cx * glyphRect.cy));
-            for (uint32_t y = 0; y < bitmap.rows; y++)
-                switch (bitmap.pixel_mode)
-                {
-                case FT_PIXEL_MODE_MONO: // 1 bit per pixel monochrome
-                    for (uint32_t x = 0; x < bitmap.width; x += 8)
-                        for (uint32_t b = 0; b < std::min(bitmap.width - x, 8u); ++b)
-                            glyphTextureData[(x + b) + (bitmap.rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)] =
-                                (x >= bitmap.width || y >= bitmap.rows) ? 0x00 : ((bitmap.buffer[x / 8 + bitmap.pitch * y] & (1 << (7 - b))) != 0 ? 0xFF : 0x00);
-                    break;
-                case FT_PIXEL_MODE_GRAY:
-                default:
-                    for (uint32_t x = 0; x < bitmap.width; x++)
-                        glyphTextureData[x + (bitmap.rows - 1 - y) * static_cast<std::size_t>(glyphRect.cx)] =
-                            (x >= bitmap.width || y >= bitmap.rows) ? 0x00 : bitmap.buffer[x + bitmap.pitch * y];
-                    break;
-                }
-            textureData = &glyphTextureData[0];
+            if (used <= lowWaterMark)
+                break;
+            auto& face = *std::get<1>(candidate);
+            auto existingGlyph = face.iGlyphs.find(std::get<2>(candidate));
+            auto const& location = existingGlyph->second.texture.texture().atlas_location();
+            used -= (location.cx + 2.0) * (location.cy + 2.0);
+            destroy_glyph_texture(existingGlyph->second.texture);
+            face.iGlyphs.erase(existingGlyph);
         }
-        
-        glyphTexture.texture().native_texture()->set_pixels(glyphRect, &textureData[0], 1u);
+        glyphAtlas.compact();
+    }
 
-        return glyphTexture;
+    void native_font_face::destroy_glyphs()
+    {
+        for (auto const& cachedGlyph : iGlyphs)
+            destroy_glyph_texture(cachedGlyph.second.texture);
+        iGlyphs.clear();
+        if (iInvalidGlyph != std::nullopt)
+            destroy_glyph_texture(*iInvalidGlyph);
+        iInvalidGlyph = std::nullopt;
+        if (iPlaceholderGlyph != std::nullopt)
+            destroy_glyph_texture(*iPlaceholderGlyph);
+        iPlaceholderGlyph = std::nullopt;
+    }
+
+    void native_font_face::destroy_glyph_texture(const i_glyph_texture& aGlyphTexture)
+    {
+        auto& glyphAtlas = service<i_font_manager>().glyph_atlas();
+        glyphAtlas.destroy_sub_texture(glyphAtlas.sub_texture(aGlyphTexture.texture().atlas_id()));
+    }
+
+    glyph_rasterizer& native_font_face::rendering_glyph_rasterizer()
+    {
+        return static_cast<font_manager&>(service<i_font_manager>()).glyph_rasterizer();
     }
 
     void native_font_face::add_ref()
@@ -21,6 +21,7 @@
 
 #include <neogfx/neogfx.hpp>
 #include <unordered_map>
+#include <unordered_set>
 #include <boost/functional/hash.hpp>
 #include <boost/pool/pool_alloc.hpp>
 #include <ft2build.h>
@@ -40,6 +41,7 @@
 #include <neogfx/hid/i_surface.hpp>
 #include <neogfx/gfx/text/font.hpp>
 #include "glyph_texture.hpp"
+#include "glyph_rasterizer.hpp"
 #include "i_native_font.hpp"
 #include "i_native_font_face.hpp"
 
@@ -71,7 +73,12 @@ namespace neogfx
     class native_font_face : public i_native_font_face
     {
     private:
-        typedef std::unordered_map<glyph_index_t, neogfx::glyph_texture> glyph_map;
+        struct cached_glyph
+        {
+            neogfx::glyph_texture texture;
+            uint64_t lastUse;
+        };
+        typedef std::unordered_map<glyph_index_t, cached_glyph> glyph_map;
         typedef std::pair<glyph_index_t, glyph_index_t> kerning_pair;
         typedef std::unordered_map<kerning_pair, dimension, boost::hash<kerning_pair>, std::equal_to<kerning_pair>,
             boost::fast_pool_allocator<std::pair<const kerning_pair, dimension>>> kerning_table;
@@ -125,11 +132,25 @@ namespace neogfx
         void* aux_handle() const override;
         glyph_index_t glyph_index(char32_t aCodePoint) const override;
         i_glyph_texture& glyph_texture(const glyph& aGlyph) const override;
+        const i_glyph_texture& distance_field_glyph_texture(const glyph& aGlyph) const override;
+        dimension distance_field_scale() const override;
+        dimension distance_field_spread() const override;
     public:
         void add_ref() override;
         void release() override;
+    public:
+        void prefetch_glyphs(const std::u32string& aCodePoints) const;
+        static void upload_rasterized_glyphs();
+        static void advance_glyph_use_generation();
+        static void evict_glyphs(dimension aBudget);
     private:
         void set_metrics();
+        void destroy_glyphs();
+        static void destroy_glyph_texture(const i_glyph_texture& aGlyphTexture);
+        i_glyph_texture& add_glyph(glyph_index_t aGlyphIndex, const glyph_rasterizer::bitmap& aBitmap) const;
+        i_glyph_texture& invalid_glyph(const glyph& aGlyph) const;
+        i_glyph_texture& placeholder_glyph() const;
+        static glyph_rasterizer& rendering_glyph_rasterizer();
     private:
         font_id iId;
         i_native_font& iFont;
@@ -141,9 +162,11 @@ namespace neogfx
         mutable std::unique_ptr<hb_handle> iAuxHandle;
         mutable std::shared_ptr<i_native_font_face> iFallbackFont;
         mutable glyph_map iGlyphs;
+        mutable std::unordered_set<glyph_index_t> iFailedGlyphs;
         bool iHasKerning;
         mutable kerning_table iKerningTable;
         mutable std::optional<bool> iHasFallback;
         mutable std::optional<neogfx::glyph_texture> iInvalidGlyph;
+        mutable std::optional<neogfx::glyph_texture> iPlaceholderGlyph;
     };
 }
\ No newline at end of file
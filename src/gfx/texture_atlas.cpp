@@ -70,15 +70,44 @@ namespace neogfx
         auto iterEntry = iEntries.find(aSubTexture.atlas_id());
         if (iterEntry == iEntries.end() || &aSubTexture != &iterEntry->second.second)
             throw sub_texture_not_found();
-        auto rectEntry = iterEntry->second.second.atlas_location();
-        auto space = iterEntry->second.first->second.used.find(rectEntry);
-        if (space != iterEntry->second.first->second.used.end())
-            iterEntry->second.first->second.used.erase(space);
-        iterEntry->second.first->second.freed.insert(rectEntry);
+        auto const& location = iterEntry->second.second.atlas_location();
+        iterEntry->second.first->second.remove(location + point{ -1.0, -1.0 } + size{ 2.0, 2.0 });
         iTextureManager.remove_sub_texture(aSubTexture);
         iEntries.erase(iterEntry);
     }
 
+    texture_atlas_stats texture_atlas::stats() const
+    {
+        texture_atlas_stats result = {};
+        result.pages = static_cast<uint32_t>(iPages.size());
+        result.subTextures = static_cast<uint32_t>(iEntries.size());
+        for (auto const& page : iPages)
+        {
+            result.capacity += page.second.dimensions().cx * page.second.dimensions().cy;
+            result.used += page.second.used_area();
+            result.reusable += page.second.reusable_area();
+        }
+        if (result.capacity > 0.0)
+            result.occupancy = result.used / result.capacity;
+        // proportion of the free space that is in holes left by destroyed sub-textures rather than unallocated
+        if (result.capacity > result.used)
+            result.fragmentation = result.reusable / (result.capacity - result.used);
+        return result;
+    }
+
+    void texture_atlas::compact()
+    {
+        // sub-textures are never moved (their locations are baked into glyph and vertex data) so compaction 
+        // is limited to releasing pages that no longer hold anything
+        for (auto iterPage = iPages.begin(); iterPage != iPages.end();)
+        {
+            if (iterPage->second.empty())
+                iterPage = iPages.erase(iterPage);
+            else
+                ++iterPage;
+        }
+    }
+
     const size& texture_atlas::page_size() const
     {
         return iPageSize;
@@ -86,7 +115,7 @@ namespace neogfx
 
     texture_atlas::pages::iterator texture_atlas::create_page(dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat)
     {
-        return iPages.insert(iPages.end(), page{ texture{ page_size(), aDpiScaleFactor, aSampling, aDataFormat }, fragments{ page_size() } });
+        return iPages.insert(iPages.end(), page{ texture{ page_size(), aDpiScaleFactor, aSampling, aDataFormat }, rect_pack{ page_size() } });
     }
 
     std::pair<texture_atlas::pages::iterator, rect> texture_atlas::allocate_space(const size& aSize, dimension aDpiScaleFactor, texture_sampling aSampling, texture_data_format aDataFormat)
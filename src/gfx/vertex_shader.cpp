@@ -27,8 +27,12 @@ namespace neogfx
     {
         auto& coord = add_attribute<vec3f>("VertexPosition"_s, 0u);
         auto& color = add_attribute<vec4f>("VertexColor"_s, 1u);
+        auto& clipRect = add_attribute<vec4f>("VertexClipRect"_s, 3u);
+        add_attribute("VertexInstanceTransformation"_s, 4u, shader_data_type::Mat4); // locations 4 to 7
         add_out_variable<vec3f>("Coord"_s, 0u).link(coord);
         add_out_variable<vec4f>("Color"_s, 1u).link(color);
+        add_out_variable<vec4f>("ClipRect"_s, 3u).link(clipRect);
+        uInstanced = false;
     }
 
     bool standard_vertex_shader::has_standard_vertex_matrices() const
@@ -64,6 +68,11 @@ namespace neogfx
         }
     }
 
+    void standard_vertex_shader::set_instanced(bool aInstanced)
+    {
+        uInstanced = aInstanced;
+    }
+
     void standard_vertex_shader::prepare_uniforms(const i_rendering_context& aContext, i_shader_program&)
     {
         if (iProjectionMatrix == std::nullopt)
@@ -110,8 +119,10 @@ namespace neogfx
         {
             static const string code =
             {
-                "void standard_vertex_shader(inout vec3 coord, inout vec4 color)\n"
+                "void standard_vertex_shader(inout vec3 coord, inout vec4 color, inout vec4 clipRect)\n"
                 "{\n"
+                "    if (uInstanced)\n"
+                "        coord = (VertexInstanceTransformation * vec4(coord, 1.0)).xyz;\n"
                 "    gl_Position = vec4((uProjectionMatrix * (uTransformationMatrix * vec4(coord, 1.0))).xyz, 1.0);\n"
                 "}\n"_s
             };
@@ -135,9 +146,9 @@ namespace neogfx
         {
             static const string code =
             {
-                "void standard_texture_vertex_shader(inout vec3 coord, inout vec4 color, inout vec2 texCoord)\n"
+                "void standard_texture_vertex_shader(inout vec3 coord, inout vec4 color, inout vec2 texCoord, inout vec4 clipRect)\n"
                 "{\n"
-                "    standard_vertex_shader(coord, color);\n"
+                "    standard_vertex_shader(coord, color, clipRect);\n"
                 "}\n"_s
             };
             aOutput += code;
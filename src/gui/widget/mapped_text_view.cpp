@@ -0,0 +1,436 @@
+// mapped_text_view.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+  
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <cstring>
+#include <boost/filesystem.hpp>
+#include <neogfx/gui/widget/mapped_text_view.hpp>
+#include <neogfx/gfx/graphics_context.hpp>
+#include <neogfx/app/i_app.hpp>
+
+namespace neogfx
+{
+    namespace
+    {
+        constexpr std::size_t IndexChunkSize = 1024u * 1024u;
+        constexpr uint32_t ProgressUpdateInterval_ms = 100u;
+    }
+
+    mapped_text_view::mapped_text_view(frame_style aFrameStyle) :
+        scrollable_widget{ scrollbar_style::Normal, aFrameStyle },
+        iIndexedLines{ 0u },
+        iIndexedBytes{ 0u },
+        iIndexing{ false },
+        iStopIndexing{ false },
+        iProgressUpdater{ service<neolib::async_task>(), [this](neolib::callback_timer& aTimer) { indexing_progress(); if (is_open()) aTimer.again(); }, ProgressUpdateInterval_ms, false },
+        iReportedLines{ 0u },
+        iWidestLine{ 0.0 },
+        iReportedWidestLine{ 0.0 },
+        iCachedLineLimit{ DefaultCachedLineLimit },
+        iLineLengthLimit{ DefaultLineLengthLimit }
+    {
+        init();
+    }
+
+    mapped_text_view::mapped_text_view(i_widget& aParent, frame_style aFrameStyle) :
+        scrollable_widget{ aParent, scrollbar_style::Normal, aFrameStyle },
+        iIndexedLines{ 0u },
+        iIndexedBytes{ 0u },
+        iIndexing{ false },
+        iStopIndexing{ false },
+        iProgressUpdater{ service<neolib::async_task>(), [this](neolib::callback_timer& aTimer) { indexing_progress(); if (is_open()) aTimer.again(); }, ProgressUpdateInterval_ms, false },
+        iReportedLines{ 0u },
+        iWidestLine{ 0.0 },
+        iReportedWidestLine{ 0.0 },
+        iCachedLineLimit{ DefaultCachedLineLimit },
+        iLineLengthLimit{ DefaultLineLengthLimit }
+    {
+        init();
+    }
+
+    mapped_text_view::mapped_text_view(i_layout& aLayout, frame_style aFrameStyle) :
+        scrollable_widget{ aLayout, scrollbar_style::Normal, aFrameStyle },
+        iIndexedLines{ 0u },
+        iIndexedBytes{ 0u },
+        iIndexing{ false },
+        iStopIndexing{ false },
+        iProgressUpdater{ service<neolib::async_task>(), [this](neolib::callback_timer& aTimer) { indexing_progress(); if (is_open()) aTimer.again(); }, ProgressUpdateInterval_ms, false },
+        iReportedLines{ 0u },
+        iWidestLine{ 0.0 },
+        iReportedWidestLine{ 0.0 },
+        iCachedLineLimit{ DefaultCachedLineLimit },
+        iLineLengthLimit{ DefaultLineLengthLimit }
+    {
+        init();
+    }
+
+    mapped_text_view::~mapped_text_view()
+    {
+        iStopIndexing = true;
+        if (iIndexer.joinable())
+            iIndexer.join();
+    }
+
+    void mapped_text_view::open(const std::string& aPath)
+    {
+        close();
+        boost::system::error_code ec;
+        auto const size = boost::filesystem::file_size(aPath, ec);
+        if (ec)
+            throw failed_to_open_file(aPath);
+        // an empty file cannot be mapped; it is simply a document with no lines
+        if (size != 0u)
+        {
+            try
+            {
+                iFile.open(aPath);
+            }
+            catch (const std::exception&)
+            {
+                throw failed_to_open_file(aPath);
+            }
+        }
+        iPath = aPath;
+        iCheckpoints.assign(1u, 0u);
+        iIndexedLines = 0u;
+        iIndexedBytes = 0u;
+        iStopIndexing = false;
+        iIndexing = true;
+        iIndexer = std::thread{ [this]() { index_lines(); } };
+        iProgressUpdater.again_if();
+        update_scrollbar_visibility();
+        update();
+        Opened.trigger();
+    }
+
+    void mapped_text_view::close()
+    {
+        if (!is_open())
+            return;
+        iStopIndexing = true;
+        if (iIndexer.joinable())
+            iIndexer.join();
+        iIndexing = false;
+        if (iFile.is_open())
+            iFile.close();
+        iPath.clear();
+        {
+            std::lock_guard<std::mutex> lg{ iIndexMutex };
+            iCheckpoints.clear();
+            iCheckpoints.shrink_to_fit();
+        }
+        iIndexedLines = 0u;
+        iIndexedBytes = 0u;
+        iReportedLines = 0u;
+        clear_shaped_lines();
+        iReportedWidestLine = 0.0;
+        vertical_scrollbar().set_position(0.0);
+        horizontal_scrollbar().set_position(0.0);
+        update_scrollbar_visibility();
+        update();
+        Closed.trigger();
+    }
+
+    bool mapped_text_view::is_open() const
+    {
+        return !iPath.empty();
+    }
+
+    const std::string& mapped_text_view::path() const
+    {
+        return iPath;
+    }
+
+    mapped_text_view::offset_type mapped_text_view::file_size() const
+    {
+        return iFile.is_open() ? static_cast<offset_type>(iFile.size()) : 0u;
+    }
+
+    bool mapped_text_view::indexing() const
+    {
+        return iIndexing;
+    }
+
+    mapped_text_view::line_index mapped_text_view::indexed_lines() const
+    {
+        return iIndexedLines;
+    }
+
+    mapped_text_view::line_index mapped_text_view::estimated_lines() const
+    {
+        auto const lines = indexed_lines();
+        if (!indexing())
+            return lines;
+        auto const bytes = static_cast<offset_type>(iIndexedBytes);
+        if (bytes == 0u || lines == 0u)
+            return lines;
+        // extrapolate from the average line length seen so far; refined as indexing proceeds
+        return std::max(lines, static_cast<line_index>(static_cast<double>(lines) * static_cast<double>(file_size()) / static_cast<double>(bytes)));
+    }
+
+    std::string mapped_text_view::line(line_index aLine) const
+    {
+        if (aLine >= indexed_lines())
+            throw std::out_of_range("neogfx::mapped_text_view::line");
+        auto const bounds = line_bounds(aLine);
+        return std::string{ bounds.first, bounds.second };
+    }
+
+    std::size_t mapped_text_view::cached_line_limit() const
+    {
+        return iCachedLineLimit;
+    }
+
+    void mapped_text_view::set_cached_line_limit(std::size_t aLimit)
+    {
+        iCachedLineLimit = std::max<std::size_t>(aLimit, 1u);
+        while (iShapedLines.size() > iCachedLineLimit)
+        {
+            iShapedLineMap.erase(iShapedLines.back().line);
+            iShapedLines.pop_back();
+        }
+    }
+
+    std::size_t mapped_text_view::line_length_limit() const
+    {
+        return iLineLengthLimit;
+    }
+
+    void mapped_text_view::set_line_length_limit(std::size_t aLimit)
+    {
+        if (iLineLengthLimit != aLimit)
+        {
+            iLineLengthLimit = aLimit;
+            clear_shaped_lines();
+            update_scrollbar_visibility();
+            update();
+        }
+    }
+
+    void mapped_text_view::paint(i_graphics_context& aGraphicsContext) const
+    {
+        scrollable_widget::paint(aGraphicsContext);
+        if (!is_open())
+            return;
+        auto const clientRect = client_rect(false);
+        scoped_scissor scissor{ aGraphicsContext, default_clip_rect().intersection(clientRect) };
+        auto const lineHeight = line_height();
+        if (lineHeight <= 0.0)
+            return;
+        auto const lines = indexed_lines();
+        text_appearance const appearance{ service<i_app>().current_style().palette().text_color_for_widget(*this) };
+        // only the lines intersecting the viewport are shaped
+        for (auto line = static_cast<line_index>(vertical_scrollbar().position() / lineHeight); line < lines; ++line)
+        {
+            point const linePos = clientRect.top_left() + point{ -horizontal_scrollbar().position(), line * lineHeight - vertical_scrollbar().position() };
+            if (linePos.y > clientRect.bottom() || linePos.y > update_rect().bottom())
+                break;
+            if (linePos.y + lineHeight < update_rect().top())
+                continue;
+            auto const& shapedLine = shape_line(aGraphicsContext, line);
+            aGraphicsContext.draw_glyph_text(linePos, shapedLine.text, appearance);
+        }
+    }
+
+    void mapped_text_view::set_font(const optional_font& aFont)
+    {
+        scrollable_widget::set_font(aFont);
+        clear_shaped_lines();
+        update_scrollbar_visibility();
+        update();
+    }
+
+    neogfx::scrolling_disposition mapped_text_view::scrolling_disposition() const
+    {
+        return neogfx::scrolling_disposition::DontScrollChildWidget;
+    }
+
+    void mapped_text_view::update_scrollbar_visibility(usv_stage_e aStage)
+    {
+        switch (aStage)
+        {
+        case UsvStageInit:
+            vertical_scrollbar().hide();
+            horizontal_scrollbar().hide();
+            break;
+        case UsvStageCheckVertical1:
+        case UsvStageCheckVertical2:
+            {
+                i_scrollbar::value_type oldPosition = vertical_scrollbar().position();
+                vertical_scrollbar().set_maximum(estimated_lines() * line_height());
+                vertical_scrollbar().set_step(line_height());
+                vertical_scrollbar().set_page(client_rect(false).height());
+                vertical_scrollbar().set_position(oldPosition);
+                if (vertical_scrollbar().maximum() - vertical_scrollbar().page() > 0.0)
+                    vertical_scrollbar().show();
+                else
+                    vertical_scrollbar().hide();
+                scrollable_widget::update_scrollbar_visibility(aStage);
+            }
+            break;
+        case UsvStageCheckHorizontal:
+            {
+                // the horizontal extent is the widest line shaped so far; refined as more lines are laid out
+                i_scrollbar::value_type oldPosition = horizontal_scrollbar().position();
+                horizontal_scrollbar().set_maximum(iWidestLine <= client_rect(false).width() ? 0.0 : iWidestLine);
+                horizontal_scrollbar().set_step(line_height());
+                horizontal_scrollbar().set_page(client_rect(false).width());
+                horizontal_scrollbar().set_position(oldPosition);
+                if (horizontal_scrollbar().maximum() - horizontal_scrollbar().page() > 0.0)
+                    horizontal_scrollbar().show();
+                else
+                    horizontal_scrollbar().hide();
+                scrollable_widget::update_scrollbar_visibility(aStage);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    void mapped_text_view::init()
+    {
+        set_focus_policy(neogfx::focus_policy::ClickTabFocus);
+        iSink += service<i_app>().current_style_changed([this](style_aspect)
+        {
+            clear_shaped_lines();
+            update_scrollbar_visibility();
+        });
+    }
+
+    void mapped_text_view::index_lines()
+    {
+        auto const data = iFile.is_open() ? iFile.data() : nullptr;
+        auto const size = file_size();
+        offset_type position = 0u;
+        line_index lines = 0u;
+        std::vector<offset_type> checkpoints;
+        while (position < size && !iStopIndexing)
+        {
+            auto const chunkEnd = std::min<offset_type>(size, position + IndexChunkSize);
+            while (position < chunkEnd)
+            {
+                auto const newLine = static_cast<const char*>(std::memchr(data + position, '\n', static_cast<std::size_t>(chunkEnd - position)));
+                if (newLine == nullptr)
+                {
+                    position = chunkEnd;
+                    break;
+                }
+                position = static_cast<offset_type>(newLine - data) + 1u;
+                if (++lines % LinesPerCheckpoint == 0u)
+                    checkpoints.push_back(position);
+            }
+            {
+                std::lock_guard<std::mutex> lg{ iIndexMutex };
+                iCheckpoints.insert(iCheckpoints.end(), checkpoints.begin(), checkpoints.end());
+            }
+            checkpoints.clear();
+            // publish the line count only once the checkpoints covering it are visible to readers
+            iIndexedLines = lines;
+            iIndexedBytes = position;
+        }
+        if (!iStopIndexing && size != 0u && data[size - 1u] != '\n')
+            iIndexedLines = lines + 1u;
+        iIndexing = false;
+    }
+
+    void mapped_text_view::indexing_progress()
+    {
+        bool const finished = !indexing() && iIndexer.joinable();
+        if (finished)
+            iIndexer.join();
+        if (finished || iReportedLines != indexed_lines() || iReportedWidestLine != iWidestLine)
+        {
+            iReportedLines = indexed_lines();
+            iReportedWidestLine = iWidestLine;
+            update_scrollbar_visibility();
+            update();
+        }
+        if (finished)
+            Indexed.trigger();
+    }
+
+    std::pair<const char*, const char*> mapped_text_view::line_bounds(line_index aLine) const
+    {
+        auto const data = iFile.data();
+        auto const end = data + file_size();
+        offset_type checkpoint;
+        {
+            std::lock_guard<std::mutex> lg{ iIndexMutex };
+            checkpoint = iCheckpoints[static_cast<std::size_t>(aLine / LinesPerCheckpoint)];
+        }
+        auto lineStart = data + checkpoint;
+        for (auto skip = aLine % LinesPerCheckpoint; skip != 0u; --skip)
+        {
+            auto const newLine = static_cast<const char*>(std::memchr(lineStart, '\n', static_cast<std::size_t>(end - lineStart)));
+            lineStart = (newLine != nullptr ? newLine + 1 : end);
+        }
+        auto lineEnd = static_cast<const char*>(std::memchr(lineStart, '\n', static_cast<std::size_t>(end - lineStart)));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+        if (lineEnd != lineStart && *(lineEnd - 1) == '\r')
+            --lineEnd;
+        return std::make_pair(lineStart, lineEnd);
+    }
+
+    const mapped_text_view::shaped_line& mapped_text_view::shape_line(i_graphics_context& aGraphicsContext, line_index aLine) const
+    {
+        auto existing = iShapedLineMap.find(aLine);
+        if (existing != iShapedLineMap.end())
+        {
+            iShapedLines.splice(iShapedLines.begin(), iShapedLines, existing->second);
+            return iShapedLines.front();
+        }
+        auto bounds = line_bounds(aLine);
+        if (static_cast<std::size_t>(bounds.second - bounds.first) > iLineLengthLimit)
+        {
+            // pathological lines are truncated (on a UTF-8 sequence boundary) to keep shaping cost bounded
+            bounds.second = bounds.first + iLineLengthLimit;
+            while (bounds.second != bounds.first && (static_cast<uint8_t>(*bounds.second) & 0xC0u) == 0x80u)
+                --bounds.second;
+        }
+        std::string const text{ bounds.first, bounds.second };
+        // shaped lines are cached by the view (above) so shaping bypasses the shared glyph text cache which
+        // would otherwise fill with, and evict other widgets' text for, lines of a file that are seen once
+        auto const& lineFont = font();
+        auto glyphText = aGraphicsContext.to_glyph_text(text.begin(), text.end(), [&lineFont](std::string::size_type) { return lineFont; });
+        auto const extents = aGraphicsContext.glyph_text_extent(glyphText);
+        iShapedLines.push_front(shaped_line{ aLine, std::move(glyphText), extents });
+        iShapedLineMap[aLine] = iShapedLines.begin();
+        while (iShapedLines.size() > iCachedLineLimit)
+        {
+            iShapedLineMap.erase(iShapedLines.back().line);
+            iShapedLines.pop_back();
+        }
+        iWidestLine = std::max(iWidestLine, extents.cx);
+        return iShapedLines.front();
+    }
+
+    void mapped_text_view::clear_shaped_lines()
+    {
+        iShapedLines.clear();
+        iShapedLineMap.clear();
+        iWidestLine = 0.0;
+    }
+
+    dimension mapped_text_view::line_height() const
+    {
+        return font().height();
+    }
+}
@@ -370,11 +370,17 @@ namespace neogfx
 
     void scrollable_widget::scrollbar_updated(const i_scrollbar& aScrollbar, i_scrollbar::update_reason_e)
     {
+        point scrollDelta;
         if (!iIgnoreScrollbarUpdates)
         {
             point scrollPosition = units_converter(*this).from_device_units(point(static_cast<coordinate>(horizontal_scrollbar().position()), static_cast<coordinate>(vertical_scrollbar().position())));
             if (iOldScrollPosition != scrollPosition)
             {
+                scrollDelta = -(scrollPosition - iOldScrollPosition);
+                if (aScrollbar.type() == scrollbar_type::Horizontal)
+                    scrollDelta.y = 0.0;
+                else if (aScrollbar.type() == scrollbar_type::Vertical)
+                    scrollDelta.x = 0.0;
                 for (auto& c : children())
                 {
                     point delta = -(scrollPosition - iOldScrollPosition);
@@ -394,7 +400,76 @@ namespace neogfx
                 }
             }
         }
-        update(true);
+        if (scrollDelta == point{} || !scroll_by_copy(scrollDelta))
+            update(true);
+    }
+
+    bool scrollable_widget::can_scroll_by_copy() const
+    {
+        // copying is only valid if nothing behind us shows through and the scrollbars don't overlay the client area
+        if (transparent_background() && !has_background_color())
+            return false;
+        if (vertical_scrollbar().visible() && vertical_scrollbar().style() != scrollbar_style::Normal)
+            return false;
+        if (horizontal_scrollbar().visible() && horizontal_scrollbar().style() != scrollbar_style::Normal)
+            return false;
+        return true;
+    }
+
+    bool scrollable_widget::scroll_by_copy(const point& aDelta)
+    {
+        if (!can_update() || !can_scroll_by_copy())
+            return false;
+        // content painted at a sub-pixel offset can't be reproduced by copying pixels
+        if (aDelta != aDelta.floor())
+            return false;
+        // a layer's texture (ours or an ancestor's) would be left stale by a copy on the surface
+        for (i_widget const* w = this; w != nullptr; w = w->has_parent() ? &w->parent() : nullptr)
+            if (w->layer())
+                return false;
+
+        rect area = to_window_coordinates(client_rect());
+        for (i_widget const* w = this; w->has_parent(); w = &w->parent())
+            area = area.intersection(w->parent().to_window_coordinates(w->parent().client_rect()));
+        if (area.empty())
+            return true;
+
+        surface().scroll_surface(area, aDelta);
+
+        // pixels within the area that aren't part of our scrolled content have been copied too so need repainting both
+        // where they are and where they were copied to
+        auto const repaint = [&](const rect& aRect)
+        {
+            for (auto const& r : { aRect.intersection(area), (aRect + aDelta).intersection(area) })
+                if (!r.empty())
+                    surface().invalidate_surface(r);
+        };
+        auto const scrollsWithUs = [&](const i_widget& aChild)
+        {
+            if (aDelta.y != 0.0 && (scrolling_disposition(aChild) & neogfx::scrolling_disposition::ScrollChildWidgetVertically) == neogfx::scrolling_disposition::DontScrollChildWidget)
+                return false;
+            if (aDelta.x != 0.0 && (scrolling_disposition(aChild) & neogfx::scrolling_disposition::ScrollChildWidgetHorizontally) == neogfx::scrolling_disposition::DontScrollChildWidget)
+                return false;
+            return true;
+        };
+        for (auto const& c : children())
+            if (c->visible() && !scrollsWithUs(*c))
+                repaint(c->non_client_rect());
+        // siblings of ours and of our ancestors earlier in z-order are painted on top of us
+        for (i_widget const* w = this; w->has_parent(); w = &w->parent())
+            for (auto const& sibling : w->parent().children())
+            {
+                if (&*sibling == w)
+                    break;
+                if (sibling->visible())
+                    repaint(sibling->non_client_rect());
+            }
+
+        if (vertical_scrollbar().visible())
+            update(to_client_coordinates(scrollbar_geometry(vertical_scrollbar())));
+        if (horizontal_scrollbar().visible())
+            update(to_client_coordinates(scrollbar_geometry(horizontal_scrollbar())));
+        return true;
     }
 
     color scrollable_widget::scrollbar_color(const i_scrollbar&) const
@@ -151,13 +151,116 @@ namespace neogfx
         return std::tie(iFont, iTextColor, iBackgroundColor, iTextEffect) < std::tie(aRhs.iFont, aRhs.iTextColor, aRhs.iBackgroundColor, aRhs.iTextEffect);
     }
 
+    text_edit::glyph_lines::const_iterator text_edit::glyph_column::line_at_ypos(coordinate aYpos) const
+    {
+        return std::lower_bound(iLines.begin(), iLines.end(), aYpos,
+            [this](const glyph_line& aLine, coordinate aValue) { return line(static_cast<glyph_lines::size_type>(&aLine - iLines.data())).ypos < aValue; });
+    }
+
+    text_edit::glyph_lines::const_iterator text_edit::glyph_column::line_at_glyph(document_glyphs::size_type aGlyph) const
+    {
+        return std::lower_bound(iLines.begin(), iLines.end(), aGlyph,
+            [this](const glyph_line& aLine, document_glyphs::size_type aValue) { return line(static_cast<glyph_lines::size_type>(&aLine - iLines.data())).lineStart < aValue; });
+    }
+
+    text_edit::glyph_lines::const_iterator text_edit::glyph_column::line_at_paragraph(glyph_paragraphs::size_type aParagraph) const
+    {
+        return std::lower_bound(iLines.begin(), iLines.end(), aParagraph,
+            [this](const glyph_line& aLine, glyph_paragraphs::size_type aValue) { return line(static_cast<glyph_lines::size_type>(&aLine - iLines.data())).paragraph < aValue; });
+    }
+
+    void text_edit::glyph_column::set_lines(glyph_lines&& aLines)
+    {
+        clear_lines();
+        iLines = std::move(aLines);
+        for (auto const& line : iLines)
+            iLineWidths.insert(line.extents.cx);
+    }
+
+    // O(edited lines) apart from moving the lines after the edit along in the vector
+    void text_edit::glyph_column::replace_lines(glyph_lines::const_iterator aFirst, glyph_lines::const_iterator aLast, const glyph_lines& aNewLines,
+        std::ptrdiff_t aParagraphs, std::ptrdiff_t aGlyphs, coordinate aY)
+    {
+        auto const first = static_cast<glyph_lines::size_type>(aFirst - iLines.begin());
+        auto const last = static_cast<glyph_lines::size_type>(aLast - iLines.begin());
+        // the lines before the edit keep any shift still pending for them; the replaced lines are discarded
+        if (shifted() && iShift.from < last)
+        {
+            apply_shift(iShift.from, first, iShift.paragraphs, iShift.glyphs, iShift.y);
+            iShift.from = last;
+        }
+        shift_lines(last, aParagraphs, aGlyphs, aY);
+        for (auto l = first; l != last; ++l)
+        {
+            auto const width = iLineWidths.find(iLines[l].extents.cx);
+            if (width != iLineWidths.end())
+                iLineWidths.erase(width);
+        }
+        for (auto const& line : aNewLines)
+            iLineWidths.insert(line.extents.cx);
+        iLines.insert(iLines.erase(iLines.begin() + first, iLines.begin() + last), aNewLines.begin(), aNewLines.end());
+        iShift.from = iShift.from - (last - first) + aNewLines.size();
+    }
+
+    void text_edit::glyph_column::clear_lines()
+    {
+        iLines.clear();
+        iShift = {};
+        iLineWidths.clear();
+    }
+
+    text_edit::glyph_line text_edit::glyph_column::line(glyph_lines::size_type aLine) const
+    {
+        auto result = iLines[aLine];
+        if (aLine >= iShift.from)
+        {
+            result.paragraph += iShift.paragraphs;
+            result.lineStart += iShift.glyphs;
+            result.lineEnd += iShift.glyphs;
+            result.ypos += iShift.y;
+        }
+        return result;
+    }
+
+    void text_edit::glyph_column::apply_shift(glyph_lines::size_type aFirst, glyph_lines::size_type aLast, std::ptrdiff_t aParagraphs, std::ptrdiff_t aGlyphs, coordinate aY)
+    {
+        for (auto l = aFirst; l < std::min(aLast, iLines.size()); ++l)
+        {
+            auto& line = iLines[l];
+            line.paragraph += aParagraphs;
+            line.lineStart += aGlyphs;
+            line.lineEnd += aGlyphs;
+            line.ypos += aY;
+        }
+    }
+
+    // combines a shift of the lines from aFrom onwards with the pending shift; only the lines between the two
+    // starting points are updated (in the common case of successive edits at the same place there are none)
+    void text_edit::glyph_column::shift_lines(glyph_lines::size_type aFrom, std::ptrdiff_t aParagraphs, std::ptrdiff_t aGlyphs, coordinate aY)
+    {
+        if (!shifted())
+            iShift.from = aFrom;
+        else if (aFrom < iShift.from)
+            apply_shift(aFrom, iShift.from, aParagraphs, aGlyphs, aY);
+        else if (aFrom > iShift.from)
+        {
+            apply_shift(iShift.from, aFrom, iShift.paragraphs, iShift.glyphs, iShift.y);
+            iShift.from = aFrom;
+        }
+        iShift.paragraphs += aParagraphs;
+        iShift.glyphs += aGlyphs;
+        iShift.y += aY;
+    }
+
     class text_edit::multiple_text_changes
     {
     public:
         multiple_text_changes(text_edit& aOwner) : 
             iOwner(aOwner)
         {
-            ++iOwner.iSuppressTextChangedNotification;
+            // changes made within the outermost scope are undone as one
+            if (iOwner.iSuppressTextChangedNotification++ == 0u)
+                iOwner.iJoinUndoGroup = false;
         }
         ~multiple_text_changes()
         {
@@ -187,7 +290,11 @@ namespace neogfx
         }, 16 },
         iSuppressTextChangedNotification{ 0u },
         iWantedToNotfiyTextChanged{ 0u },
-        iOutOfMemory{ false }
+        iOutOfMemory{ false },
+        iUndoMemory{ 0u },
+        iUndoMemoryLimit{ DefaultUndoMemoryLimit },
+        iJoinUndoGroup{ false },
+        iCoalesceUndo{ false }
     {
         init();
     }
@@ -206,7 +313,11 @@ namespace neogfx
         }, 16 },
         iSuppressTextChangedNotification{ 0u },
         iWantedToNotfiyTextChanged{ 0u },
-        iOutOfMemory{ false }
+        iOutOfMemory{ false },
+        iUndoMemory{ 0u },
+        iUndoMemoryLimit{ DefaultUndoMemoryLimit },
+        iJoinUndoGroup{ false },
+        iCoalesceUndo{ false }
     {
         init();
     }
@@ -225,7 +336,11 @@ namespace neogfx
         }, 16 },
         iSuppressTextChangedNotification{ 0u },
         iWantedToNotfiyTextChanged{ 0u },
-        iOutOfMemory{ false }
+        iOutOfMemory{ false },
+        iUndoMemory{ 0u },
+        iUndoMemoryLimit{ DefaultUndoMemoryLimit },
+        iJoinUndoGroup{ false },
+        iCoalesceUndo{ false }
     {
         init();
     }
@@ -311,13 +426,12 @@ namespace neogfx
             scoped_scissor scissor2{ aGraphicsContext, columnClipRect };
             auto const& columnRectSansMargins = column_rect(columnIndex);
             auto const& lines = column.lines();
-            auto line = std::lower_bound(lines.begin(), lines.end(), glyph_line{ {}, {}, {}, vertical_scrollbar().position(), {} },
-                [](const glyph_line& left, const glyph_line& right) { return left.ypos < right.ypos; });
-            if (line != lines.begin() && (line == lines.end() || line->ypos > vertical_scrollbar().position()))
+            auto line = column.line_at_ypos(vertical_scrollbar().position());
+            if (line != lines.begin() && (line == lines.end() || column.line(line).ypos > vertical_scrollbar().position()))
                 --line;
             if (line == lines.end())
                 continue;
-            auto y = line->ypos;
+            auto y = column.line(line).ypos;
             for (auto paintLine = line; paintLine != lines.end(); y += (paintLine++)->extents.cy)
             {
                 point linePos = columnRectSansMargins.top_left() + point{ -horizontal_scrollbar().position(), y - vertical_scrollbar().position() };
@@ -325,7 +439,8 @@ namespace neogfx
                     continue;
                 if (linePos.y > columnRectSansMargins.bottom() || linePos.y > update_rect().bottom())
                     break;
-                auto textDirection = glyph_text_direction(paintLine->lineStart.second, paintLine->lineEnd.second);
+                auto const resolvedLine = column.line(paintLine);
+                auto textDirection = glyph_text_direction(iGlyphs.begin() + resolvedLine.lineStart, iGlyphs.begin() + resolvedLine.lineEnd);
                 if (((Alignment & alignment::Horizontal) == alignment::Left && textDirection == text_direction::RTL) ||
                     ((Alignment & alignment::Horizontal) == alignment::Right && textDirection == text_direction::LTR))
                     linePos.x += aGraphicsContext.from_device_units(size{ columnRectSansMargins.width() - paintLine->extents.cx, 0.0 }).cx;
@@ -576,6 +691,11 @@ namespace neogfx
         switch (aStage)
         {
         case UsvStageInit:
+            if (iParagraphEdit != std::nullopt && refresh_lines(*iParagraphEdit))
+            {
+                iParagraphEdit = std::nullopt;
+                break;
+            }
             vertical_scrollbar().hide();
             horizontal_scrollbar().hide();
             refresh_lines();
@@ -641,12 +761,12 @@ namespace neogfx
 
     bool text_edit::can_undo() const
     {
-        return iPreviousText != iText;
+        return !iUndoStack.empty();
     }
 
     bool text_edit::can_redo() const
     {
-        return iPreviousText != iText;
+        return !iRedoStack.empty();
     }
 
     bool text_edit::can_cut() const
@@ -676,21 +796,30 @@ namespace neogfx
 
     void text_edit::undo(i_clipboard&)
     {
-        // todo: more intelligent undo
-        iText.swap(iPreviousText);
-        iUtf8TextCache = std::nullopt;
-
-        refresh_paragraph(iText.begin(), 0);
-        update();
-        cursor().set_position(iText.size());
-        if (iPreviousText != iText)
-            notify_text_changed();
+        if (iUndoStack.empty())
+            return;
+        multiple_text_changes mtc{ *this };
+        auto group = std::move(iUndoStack.back());
+        iUndoStack.pop_back();
+        iUndoMemory -= group.memory;
+        for (auto operation = group.operations.rbegin(); operation != group.operations.rend(); ++operation)
+            apply(*operation, true);
+        iRedoStack.push_back(std::move(group));
+        iCoalesceUndo = false;
     }
 
-    void text_edit::redo(i_clipboard& aClipboard)
+    void text_edit::redo(i_clipboard&)
     {
-        // todo: more intelligent redo
-        undo(aClipboard);
+        if (iRedoStack.empty())
+            return;
+        multiple_text_changes mtc{ *this };
+        auto group = std::move(iRedoStack.back());
+        iRedoStack.pop_back();
+        for (auto const& operation : group.operations)
+            apply(operation, false);
+        iUndoMemory += group.memory;
+        iUndoStack.push_back(std::move(group));
+        iCoalesceUndo = false;
     }
 
     void text_edit::cut(i_clipboard& aClipboard)
@@ -859,7 +988,7 @@ namespace neogfx
                 if (currentPosition.line != currentPosition.column->lines().begin())
                 {
                     auto const columnRectSansMargins = column_rect(column_index(*currentPosition.column));
-                    cursor().set_position(from_glyph(iGlyphs.begin() + document_hit_test(point{ *iCursorHint.x, std::prev(currentPosition.line)->ypos } +columnRectSansMargins.top_left(), false)).first, aMoveAnchor);
+                    cursor().set_position(from_glyph(iGlyphs.begin() + document_hit_test(point{ *iCursorHint.x, currentPosition.column->line(std::prev(currentPosition.line)).ypos } +columnRectSansMargins.top_left(), false)).first, aMoveAnchor);
                 }
             }
             break;
@@ -870,7 +999,7 @@ namespace neogfx
                 {
                     auto const columnRectSansMargins = column_rect(column_index(*currentPosition.column));
                     if (std::next(currentPosition.line) != currentPosition.column->lines().end())
-                        cursor().set_position(from_glyph(iGlyphs.begin() + document_hit_test(point{ *iCursorHint.x, std::next(currentPosition.line)->ypos } + columnRectSansMargins.top_left(), false)).first, aMoveAnchor);
+                        cursor().set_position(from_glyph(iGlyphs.begin() + document_hit_test(point{ *iCursorHint.x, currentPosition.column->line(std::next(currentPosition.line)).ypos } + columnRectSansMargins.top_left(), false)).first, aMoveAnchor);
                     else if (currentPosition.lineEnd != iGlyphs.end() && currentPosition.lineEnd->is_line_breaking_whitespace())
                         cursor().set_position(iText.size(), aMoveAnchor);
                 }
@@ -1062,8 +1191,7 @@ namespace neogfx
         glyph_lines::const_iterator line;
         for (; column != iGlyphColumns.end(); ++column)
         {
-            line = std::lower_bound(column->lines().begin(), column->lines().end(), glyph_line{ {}, { aGlyphPosition, iGlyphs.begin() + aGlyphPosition }, {}, 0.0, {} },
-                [](const glyph_line& left, const glyph_line& right) { return left.lineStart.first < right.lineStart.first; });
+            line = column->line_at_glyph(aGlyphPosition);
             if (line != column->lines().end())
                 break;
         }
@@ -1075,16 +1203,17 @@ namespace neogfx
         {
             if (line == lines.end())
             {
-                if (aGlyphPosition <= lines.back().lineEnd.first || iGlyphs.back().is_non_line_breaking_whitespace())
+                if (aGlyphPosition <= column->line(std::prev(lines.end())).lineEnd || iGlyphs.back().is_non_line_breaking_whitespace())
                     --line;
             }
-            else if (aGlyphPosition < line->lineStart.first)
+            else if (aGlyphPosition < column->line(line).lineStart)
                 --line;
         }
         if (line != lines.end())
         {
-            position_type lineStart = line->lineStart.first;
-            position_type lineEnd = line->lineEnd.first;
+            auto const resolvedLine = column->line(line);
+            position_type lineStart = resolvedLine.lineStart;
+            position_type lineEnd = resolvedLine.lineEnd;
             bool placeCursorToRight = (aGlyphPosition == lineEnd);
             if (aForCursor)
             {
@@ -1109,7 +1238,8 @@ namespace neogfx
             if (aGlyphPosition >= lineStart && aGlyphPosition <= lineEnd)
             {
                 delta alignmentAdjust;
-                auto textDirection = glyph_text_direction(lines.back().lineStart.second, lines.back().lineEnd.second);
+                auto const lastLine = column->line(std::prev(lines.end()));
+                auto textDirection = glyph_text_direction(iGlyphs.begin() + lastLine.lineStart, iGlyphs.begin() + lastLine.lineEnd);
                 if (((Alignment & alignment::Horizontal) == alignment::Left && textDirection == text_direction::RTL) ||
                     ((Alignment & alignment::Horizontal) == alignment::Right && textDirection == text_direction::LTR))
                     alignmentAdjust.dx = columnRectSansMargins.cx - line->extents.cx;
@@ -1119,26 +1249,27 @@ namespace neogfx
                 {
                     auto iterGlyph = iGlyphs.begin() + aGlyphPosition;
                     auto const& glyph = aGlyphPosition < lineEnd ? *iterGlyph : *(iterGlyph - 1);
-                    point linePos{ glyph.x - line->lineStart.second->x, line->ypos };
+                    point linePos{ glyph.x - iGlyphs[lineStart].x, resolvedLine.ypos };
                     if (placeCursorToRight)
                         linePos.x += glyph.advance().cx;
                     return position_info{ iterGlyph, column, line, iGlyphs.begin() + lineStart, iGlyphs.begin() + lineEnd, linePos + alignmentAdjust };
                 }
                 else
-                    return position_info{ line->lineStart.second, column, line, iGlyphs.begin() + lineStart, iGlyphs.begin() + lineEnd, point{ 0.0, line->ypos } + alignmentAdjust };
+                    return position_info{ iGlyphs.begin() + lineStart, column, line, iGlyphs.begin() + lineStart, iGlyphs.begin() + lineEnd, point{ 0.0, resolvedLine.ypos } + alignmentAdjust };
             }
         }
         point pos;
         if (!lines.empty())
         {
             pos.x = 0.0;
-            auto textDirection = glyph_text_direction(lines.back().lineStart.second, lines.back().lineEnd.second);
+            auto const lastLine = column->line(std::prev(lines.end()));
+            auto textDirection = glyph_text_direction(iGlyphs.begin() + lastLine.lineStart, iGlyphs.begin() + lastLine.lineEnd);
             if (((Alignment & alignment::Horizontal) == alignment::Left && textDirection == text_direction::RTL) ||
                 ((Alignment & alignment::Horizontal) == alignment::Right && textDirection == text_direction::LTR))
                 pos.x = columnRectSansMargins.cx;
             else if ((Alignment & alignment::Horizontal) == alignment::Centre)
                 pos.x = columnRectSansMargins.cx / 2.0;
-            pos.y = lines.back().ypos + lines.back().extents.cy;
+            pos.y = lastLine.ypos + lastLine.extents.cy;
         }
         return position_info{ iGlyphs.end(), column, lines.end(), iGlyphs.end(), iGlyphs.end(), pos };
     }
@@ -1166,16 +1297,16 @@ namespace neogfx
         point adjustedPosition = (aAdjustForScrollPosition ? aPosition + point{ horizontal_scrollbar().position(), vertical_scrollbar().position() } : aPosition) - columnRectSansMargins.top_left();
         adjustedPosition = adjustedPosition.max(point{});
         auto const& lines = column.lines();
-        auto line = std::lower_bound(lines.begin(), lines.end(), glyph_line{ {}, {}, {}, adjustedPosition.y, {} },
-            [](const glyph_line& left, const glyph_line& right) { return left.ypos < right.ypos; });
-        if (line == lines.end() && !lines.empty() && adjustedPosition.y < lines.back().ypos + lines.back().extents.cy)
+        auto line = column.line_at_ypos(adjustedPosition.y);
+        if (line == lines.end() && !lines.empty() && adjustedPosition.y < column.line(std::prev(lines.end())).ypos + lines.back().extents.cy)
             --line;
         if (line != lines.end())
         {
-            if (line != lines.begin() && adjustedPosition.y < line->ypos)
+            if (line != lines.begin() && adjustedPosition.y < column.line(line).ypos)
                 --line;
             delta alignmentAdjust;
-            auto textDirection = glyph_text_direction(lines.back().lineStart.second, lines.back().lineEnd.second);
+            auto const lastLine = column.line(std::prev(lines.end()));
+            auto textDirection = glyph_text_direction(iGlyphs.begin() + lastLine.lineStart, iGlyphs.begin() + lastLine.lineEnd);
             if (((Alignment & alignment::Horizontal) == alignment::Left && textDirection == text_direction::RTL) ||
                 ((Alignment & alignment::Horizontal) == alignment::Right && textDirection == text_direction::LTR))
                 alignmentAdjust.dx = columnRectSansMargins.cx - line->extents.cx;
@@ -1183,10 +1314,11 @@ namespace neogfx
                 alignmentAdjust.dx = (columnRectSansMargins.cx - line->extents.cx) / 2.0;
             adjustedPosition.x -= alignmentAdjust.dx;
             adjustedPosition = adjustedPosition.max(point{});
-            auto lineStart = (line != lines.end() ? line->lineStart.first : iGlyphs.size());
-            auto lineEnd = (line != lines.end() ? line->lineEnd.first : iGlyphs.size());
-            auto lineStartX = line->lineStart.second->x;
-            for (auto gi = line->lineStart.first; gi != lineEnd; ++gi)
+            auto const resolvedLine = column.line(line);
+            auto lineStart = resolvedLine.lineStart;
+            auto lineEnd = resolvedLine.lineEnd;
+            auto lineStartX = (lineStart < iGlyphs.size() ? iGlyphs[lineStart].x : 0.0);
+            for (auto gi = lineStart; gi != lineEnd; ++gi)
             {
                 auto& g = iGlyphs[gi];
                 if (adjustedPosition.x >= g.x - lineStartX && adjustedPosition.x < g.x - lineStartX + g.advance().cx)
@@ -1229,11 +1361,12 @@ namespace neogfx
     void text_edit::clear()
     {
         cursor().set_position(0);
+        clear_undo();
         iText.clear();
         iGlyphs.clear();
         iGlyphParagraphs.clear();
         for (std::size_t i = 0; i < iGlyphColumns.size(); ++i)
-            iGlyphColumns[i].lines().clear();
+            iGlyphColumns[i].clear_lines();
     }
 
     const std::string& text_edit::text() const
@@ -1275,13 +1408,35 @@ namespace neogfx
         auto eraseEnd = iText.begin() + aEnd;
         auto eraseAmount = eraseEnd - eraseBegin;
 
-        iPreviousText = iText;
+        record(text_operation{ text_operation::Delete, aStart, text_runs(aStart, aEnd) });
         iUtf8TextCache = std::nullopt;
 
         refresh_paragraph(iText.erase(eraseBegin, eraseEnd), -eraseAmount);
         update();
-        if (iPreviousText != iText)
-            notify_text_changed();
+        notify_text_changed();
+    }
+
+    std::size_t text_edit::undo_memory_limit() const
+    {
+        return iUndoMemoryLimit;
+    }
+
+    void text_edit::set_undo_memory_limit(std::size_t aLimit)
+    {
+        iUndoMemoryLimit = aLimit;
+        while (!iUndoStack.empty() && iUndoMemory > iUndoMemoryLimit)
+        {
+            iUndoMemory -= iUndoStack.front().memory;
+            iUndoStack.pop_front();
+        }
+    }
+
+    void text_edit::clear_undo()
+    {
+        iUndoStack.clear();
+        iRedoStack.clear();
+        iUndoMemory = 0u;
+        iCoalesceUndo = false;
     }
 
     std::pair<text_edit::position_type, text_edit::position_type> text_edit::related_glyphs(position_type aGlyphPosition) const
@@ -1464,11 +1619,16 @@ namespace neogfx
         if (!accept)
             return 0;
 
-        iPreviousText = iText;
         iUtf8TextCache = std::nullopt;
 
-        if (aClearFirst)
+        multiple_text_changes mtc{ *this };
+        bool changed = false;
+        if (aClearFirst && !iText.empty())
+        {
+            record(text_operation{ text_operation::Delete, 0, text_runs(0, iText.size()) });
             iText.clear();
+            changed = true;
+        }
 
         std::u32string text = neolib::utf8_to_utf32(aText);
         if (iNormalizedTextBuffer.capacity() < text.size())
@@ -1485,14 +1645,24 @@ namespace neogfx
                 eos = eol;
         }
         auto s = (&aStyle != &iDefaultStyle || iPersistDefaultStyle ? iStyles.insert(style(*this, aStyle)).first : iStyles.end());
-        auto insertionPoint = iText.begin() + cursor().position();
-        insertionPoint = iText.insert(s != iStyles.end() ? document_text::tag_type::tag_data{ static_cast<style_list::const_iterator>(s) } : document_text::tag_type::tag_data{ nullptr },
-            insertionPoint, iNormalizedTextBuffer.begin(), iNormalizedTextBuffer.begin() + eos);
-        refresh_paragraph(insertionPoint, eos);
+        auto const tagData = (s != iStyles.end() ? document_text::tag_type::tag_data{ static_cast<style_list::const_iterator>(s) } : document_text::tag_type::tag_data{ nullptr });
+        auto const insertionPosition = std::min<position_type>(cursor().position(), iText.size());
+        if (eos != 0)
+        {
+            text_operation::run_list runs;
+            runs.emplace_back(document_text::tag_type{ tagData }, iNormalizedTextBuffer.substr(0, eos));
+            record(text_operation{ text_operation::Insert, insertionPosition, std::move(runs) });
+            changed = true;
+        }
+        auto insertionPoint = iText.insert(tagData, iText.begin() + insertionPosition, iNormalizedTextBuffer.begin(), iNormalizedTextBuffer.begin() + eos);
+        if (!aClearFirst)
+            refresh_paragraph(insertionPoint, eos);
+        else
+            refresh_paragraph(iText.begin(), 0);
         update();
         if (aMoveCursor)
             cursor().set_position(insertionPoint - iText.begin() + eos);
-        if (iPreviousText != iText)
+        if (changed)
             notify_text_changed();
         return eos;
     }
@@ -1514,6 +1684,99 @@ namespace neogfx
             ++iWantedToNotfiyTextChanged;
     }
 
+    text_edit::text_operation::run_list text_edit::text_runs(position_type aStart, position_type aEnd) const
+    {
+        text_operation::run_list result;
+        for (auto iterChar = iText.begin() + aStart; iterChar != iText.begin() + aEnd; ++iterChar)
+        {
+            auto const& tagStyle = iText.tag(iterChar).style();
+            if (result.empty() || result.back().first.style() != tagStyle)
+                result.emplace_back(document_text::tag_type{ document_text::tag_type::tag_data{ tagStyle } }, std::u32string{});
+            result.back().second.push_back(*iterChar);
+        }
+        return result;
+    }
+
+    void text_edit::record(text_operation&& aOperation)
+    {
+        iRedoStack.clear();
+        bool const joinGroup = iSuppressTextChangedNotification != 0u && iJoinUndoGroup && !iUndoStack.empty();
+        if (iSuppressTextChangedNotification != 0u)
+            iJoinUndoGroup = true;
+        auto const memory = sizeof(text_operation) + aOperation.length() * sizeof(char32_t);
+        if (!joinGroup && iCoalesceUndo && coalesce(aOperation))
+        {
+            iUndoStack.back().memory += memory;
+            iUndoMemory += memory;
+        }
+        else
+        {
+            if (!joinGroup)
+                iUndoStack.push_back(undo_group{});
+            iUndoStack.back().operations.push_back(std::move(aOperation));
+            iUndoStack.back().memory += memory;
+            iUndoMemory += memory;
+        }
+        iCoalesceUndo = true;
+        // the group being recorded is always kept even if it alone exceeds the limit
+        while (iUndoStack.size() > 1u && iUndoMemory > iUndoMemoryLimit)
+        {
+            iUndoMemory -= iUndoStack.front().memory;
+            iUndoStack.pop_front();
+        }
+    }
+
+    bool text_edit::coalesce(const text_operation& aOperation)
+    {
+        // runs of typed characters (or of backspaces/deletes) are undone together; a new line ends a run
+        if (iUndoStack.empty() || iUndoStack.back().operations.size() != 1u)
+            return false;
+        auto& previous = iUndoStack.back().operations.back();
+        if (previous.type != aOperation.type || previous.runs.size() != 1u || aOperation.runs.size() != 1u)
+            return false;
+        auto& previousRun = previous.runs.back();
+        auto const& run = aOperation.runs.back();
+        if (run.second.size() != 1u || run.second[0] == U'\n' || previousRun.second.back() == U'\n' || previousRun.first.style() != run.first.style())
+            return false;
+        if (aOperation.type == text_operation::Insert && aOperation.position == previous.position + previousRun.second.size())
+            previousRun.second += run.second;
+        else if (aOperation.type == text_operation::Delete && aOperation.position == previous.position)
+            previousRun.second += run.second;
+        else if (aOperation.type == text_operation::Delete && aOperation.position + 1u == previous.position)
+        {
+            previousRun.second.insert(0, run.second);
+            previous.position = aOperation.position;
+        }
+        else
+            return false;
+        return true;
+    }
+
+    void text_edit::apply(const text_operation& aOperation, bool aUndo)
+    {
+        iUtf8TextCache = std::nullopt;
+        auto const length = aOperation.length();
+        if ((aOperation.type == text_operation::Insert) != aUndo)
+        {
+            auto position = aOperation.position;
+            for (auto const& run : aOperation.runs)
+            {
+                iText.insert(document_text::tag_type::tag_data{ run.first.style() }, iText.begin() + position, run.second.begin(), run.second.end());
+                position += run.second.size();
+            }
+            refresh_paragraph(iText.begin() + aOperation.position, length);
+            cursor().set_position(aOperation.position + length);
+        }
+        else
+        {
+            auto eraseBegin = iText.begin() + aOperation.position;
+            refresh_paragraph(iText.erase(eraseBegin, eraseBegin + length), -static_cast<std::ptrdiff_t>(length));
+            cursor().set_position(aOperation.position);
+        }
+        update();
+        notify_text_changed();
+    }
+
     text_edit::document_glyphs::const_iterator text_edit::to_glyph(document_text::const_iterator aWhere) const
     {
         std::size_t textIndex = static_cast<std::size_t>(aWhere - iText.begin());
@@ -1553,22 +1816,65 @@ namespace neogfx
 
     void text_edit::refresh_paragraph(document_text::const_iterator aWhere, ptrdiff_t aDelta)
     {
-        /* simple (naive) implementation just to get things moving (so just refresh everything) ... */
-        (void)aWhere;
-        graphics_context gc{ *this, graphics_context::type::Unattached };
-        if (password())
-            gc.set_password(true, PasswordMask.value().empty() ? "\xE2\x97\x8F"s : PasswordMask);
-        iGlyphs.clear();
-        iGlyphParagraphs.clear();
         iCharacterToParagraphCache.clear();
         iCharacterToParagraphCacheLastAccess.reset();
         iGlyphToParagraphCache.clear();
         iGlyphToParagraphCacheLastAccess.reset();
+        if ((aWhere == iText.begin() && aDelta == 0) || iGlyphParagraphs.empty())
+        {
+            iParagraphEdit = std::nullopt;
+            iGlyphs.clear();
+            iGlyphParagraphs.clear();
+            shape_paragraphs(iText.begin(), iText.end(), 0, iGlyphParagraphs.end());
+            refresh_columns();
+            return;
+        }
+        // an edit that hasn't been laid out yet can't be combined with this one so lay out everything
+        if (iParagraphEdit != std::nullopt)
+            iLineLayout = std::nullopt;
+        // find the paragraphs touched by the edit; the paragraph index still describes the text as it was before the edit
+        auto const& paragraphs = iGlyphParagraphs;
+        auto containing = [&paragraphs](document_text::size_type aCharacterPos)
+        {
+            auto gp = paragraphs.find_by_foreign_index(glyph_paragraph_index{ aCharacterPos, 0 }, [](const glyph_paragraph_index& aLhs, const glyph_paragraph_index& aRhs) { return aLhs.characters() < aRhs.characters(); }).first;
+            return gp != paragraphs.end() ? gp : std::prev(paragraphs.end());
+        };
+        auto const where = static_cast<document_text::size_type>(aWhere - iText.begin());
+        auto const removed = static_cast<document_text::size_type>(aDelta < 0 ? -aDelta : 0);
+        auto const firstParagraph = containing(where);
+        auto const lastParagraph = containing(where + removed);
+        auto const nextParagraph = std::next(lastParagraph);
+        auto const textStart = firstParagraph->first.text_start_index();
+        auto const textEnd = nextParagraph != paragraphs.end() ? 
+            static_cast<document_text::size_type>(lastParagraph->first.text_end_index() + aDelta) : iText.size();
+        auto const glyphStart = firstParagraph->first.start_index();
+        auto const glyphEnd = lastParagraph->first.end_index();
+        paragraph_edit edit{ 
+            static_cast<glyph_paragraphs::size_type>(firstParagraph - paragraphs.begin()), 
+            static_cast<glyph_paragraphs::size_type>(nextParagraph - firstParagraph), 
+            0, 
+            glyphEnd - glyphStart, 
+            0 };
+        iGlyphs.erase(iGlyphs.begin() + glyphStart, iGlyphs.begin() + glyphEnd);
+        for (auto p = firstParagraph; p != nextParagraph;)
+            p = iGlyphParagraphs.erase(p);
+        std::tie(edit.newParagraphs, edit.newGlyphs) = shape_paragraphs(iText.begin() + textStart, iText.begin() + textEnd, glyphStart, nextParagraph);
+        iParagraphEdit = edit;
+        refresh_columns();
+    }
+
+    std::pair<text_edit::glyph_paragraphs::size_type, text_edit::document_glyphs::size_type> text_edit::shape_paragraphs(document_text::const_iterator aStart, document_text::const_iterator aEnd, document_glyphs::size_type aGlyphPosition, glyph_paragraphs::const_iterator aNextParagraph)
+    {
+        std::pair<glyph_paragraphs::size_type, document_glyphs::size_type> result;
+        graphics_context gc{ *this, graphics_context::type::Unattached };
+        if (password())
+            gc.set_password(true, PasswordMask.value().empty() ? "\xE2\x97\x8F"s : PasswordMask);
         std::u32string paragraphBuffer;
-        auto paragraphStart = iText.begin();
+        auto paragraphStart = aStart;
         auto iterColumn = iGlyphColumns.begin();
+        std::vector<glyph_paragraphs::iterator> newParagraphs;
         neolib::vecarray<std::u32string::size_type, 16, -1> columnDelimiters;
-        auto fs = [this, paragraphStart, &columnDelimiters](std::u32string::size_type aSourceIndex)
+        auto fs = [this, &paragraphStart, &columnDelimiters](std::u32string::size_type aSourceIndex)
         {
             auto const& tagStyle = iText.tag(paragraphStart + aSourceIndex).style();
             std::size_t indexColumn = std::lower_bound(columnDelimiters.begin(), columnDelimiters.end(), aSourceIndex) - columnDelimiters.begin();
@@ -1580,7 +1886,7 @@ namespace neogfx
                 columnStyle.font() != std::nullopt ? columnStyle : iDefaultStyle;
             return style.font() != std::nullopt ? *style.font() : font();
         };
-        for (auto iterChar = iText.begin(); iterChar != iText.end(); ++iterChar)
+        for (auto iterChar = aStart; iterChar != aEnd; ++iterChar)
         {
             auto& column = *(iterColumn);
             auto ch = *iterChar;
@@ -1591,29 +1897,35 @@ namespace neogfx
                 continue;
             }
             bool newLine = (ch == U'\n');
-            if (newLine || iterChar == iText.end() - 1)
+            if (newLine || iterChar == aEnd - 1)
             {
                 paragraphBuffer.assign(paragraphStart, iterChar + 1);
                 auto gt = gc.to_glyph_text(paragraphBuffer.begin(), paragraphBuffer.end(), fs);
                 if (gt.cbegin() != gt.cend())
                 {
-                    auto paragraphGlyphs = iGlyphs.insert(iGlyphs.end(), gt.cbegin(), gt.cend());
+                    auto const previousGlyphCount = iGlyphs.size();
+                    iGlyphs.insert(iGlyphs.begin() + aGlyphPosition + result.second, gt.cbegin(), gt.cend());
                     for (auto& newGlyph : gt)
                         iGlyphs.cache_glyph_font(newGlyph.font_id());
-                    auto newParagraph = iGlyphParagraphs.insert(iGlyphParagraphs.end(),
+                    auto const paragraphGlyphCount = iGlyphs.size() - previousGlyphCount;
+                    auto newParagraph = iGlyphParagraphs.insert(aNextParagraph,
                         std::make_pair(
                             glyph_paragraph{ *this },
                             glyph_paragraph_index{
-                                static_cast<std::size_t>((iterChar + 1) - iText.begin()) - static_cast<std::size_t>(paragraphStart - iText.begin()),
-                                iGlyphs.size() - static_cast<std::size_t>(paragraphGlyphs - iGlyphs.begin()) }),
+                                static_cast<std::size_t>((iterChar + 1) - paragraphStart),
+                                paragraphGlyphCount }),
                                 glyph_paragraphs::skip_type{ glyph_paragraph_index{}, glyph_paragraph_index{} });
                     newParagraph->first.set_self(newParagraph);
+                    newParagraphs.push_back(newParagraph);
+                    ++result.first;
+                    result.second += paragraphGlyphCount;
                 }
                 paragraphStart = iterChar + 1;
+                iterColumn = iGlyphColumns.begin();
                 columnDelimiters.clear();
             }
         }
-        for (auto p = iGlyphParagraphs.begin(); p != iGlyphParagraphs.end(); ++p)
+        for (auto p : newParagraphs)
         {
             auto& paragraph = *p;
             if (paragraph.first.start() == paragraph.first.end())
@@ -1646,7 +1958,7 @@ namespace neogfx
                 x += glyph.advance().cx;
             }
         }
-        refresh_columns();
+        return result;
     }
 
     void text_edit::refresh_columns()
@@ -1659,127 +1971,28 @@ namespace neogfx
     {
         try
         {
-            /* simple (naive) implementation just to get things moving... */
             iOutOfMemory = false;
+            iParagraphEdit = std::nullopt;
             for (auto& column : iGlyphColumns)
-                column.lines().clear();
+                column.clear_lines();
+            glyph_lines lines;
             point pos{};
             dimension availableWidth = column_rect(0).width(); // todo: columns
             dimension availableHeight = column_rect(0).height();
             bool showVerticalScrollbar = false;
             bool showHorizontalScrollbar = false;
             iTextExtents = size{};
+            dimension trailingHeight = 0.0;
             uint32_t pass = 1;
             auto iterColumn = iGlyphColumns.begin();
             for (auto p = iGlyphParagraphs.begin(); p != iGlyphParagraphs.end();)
             {
-                auto& column = *iterColumn;
-                auto& lines = column.lines();
-                auto& paragraph = *p;
-                auto paragraphStart = paragraph.first.start();
-                auto paragraphEnd = paragraph.first.end();
-                if (paragraphStart == paragraphEnd || paragraphStart->is_line_breaking_whitespace())
-                {
-                    auto lineStart = paragraphStart;
-                    auto lineEnd = lineStart;
-                    auto const& glyph = *lineStart;
-                    auto const& glyphFont = glyph.font(iGlyphs);
-                    auto height = paragraph.first.height(lineStart, lineEnd);
-                    lines.push_back(
-                        glyph_line{
-                            { p - iGlyphParagraphs.begin(), p },
-                            { lineStart - iGlyphs.begin(), lineStart },
-                            { lineEnd - iGlyphs.begin(), lineEnd },
-                            pos.y,
-                            { 0.0, height } });
-                    pos.y += glyphFont.height();
-                }
-                else if (WordWrap && (paragraphEnd - 1)->x + (paragraphEnd - 1)->advance().cx > availableWidth)
-                {
-                    auto insertionPoint = lines.end();
-                    bool first = true;
-                    auto next = paragraph.first.start();
-                    auto lineStart = next;
-                    auto lineEnd = paragraphEnd;
-                    coordinate offset = 0.0;
-                    while (next != paragraphEnd)
-                    {
-                        auto split = std::lower_bound(next, paragraphEnd, paragraph_positioned_glyph{ offset + availableWidth });
-                        if (split != next && (split != paragraphEnd || (split - 1)->x + (split - 1)->advance().cx >= offset + availableWidth))
-                            --split;
-                        if (split == next)
-                            ++split;
-                        if (split != paragraphEnd)
-                        {
-                            std::pair<document_glyphs::iterator, document_glyphs::iterator> wordBreak = word_break(lineStart, split, paragraphEnd);
-                            lineEnd = wordBreak.first;
-                            next = wordBreak.second;
-                            if (wordBreak.first == wordBreak.second)
-                            {
-                                while (lineEnd != lineStart && (lineEnd - 1)->source() == wordBreak.first->source())
-                                    --lineEnd;
-                                next = lineEnd;
-                            }
-                        }
-                        else
-                            next = paragraphEnd;
-                        dimension x = (split != iGlyphs.end() ? split->x : (lineStart != lineEnd ? iGlyphs.back().x + iGlyphs.back().advance().cx : 0.0));
-                        auto height = paragraph.first.height(lineStart, lineEnd);
-                        if (lineEnd != lineStart && (lineEnd - 1)->is_line_breaking_whitespace())
-                            --lineEnd;
-                        bool rtl = false;
-                        if (!first &&
-                            insertionPoint->lineStart != insertionPoint->lineEnd &&
-                            lineStart != lineEnd &&
-                            insertionPoint->lineStart.second->direction() == text_direction::RTL &&
-                            (lineEnd - 1)->direction() == text_direction::RTL)
-                            rtl = true; // todo: is this sufficient for multi-line RTL text?
-                        if (!rtl)
-                            insertionPoint = lines.end();
-                        insertionPoint = lines.insert(insertionPoint,
-                            glyph_line{
-                                { p - iGlyphParagraphs.begin(), p },
-                                { lineStart - iGlyphs.begin(), lineStart },
-                                { lineEnd - iGlyphs.begin(), lineEnd },
-                                pos.y,
-                                { x - offset, height } });
-                        if (rtl)
-                        {
-                            auto ypos = (insertionPoint + 1)->ypos;
-                            for (auto i = insertionPoint; i != lines.end(); ++i)
-                            {
-                                i->ypos = ypos;
-                                ypos += i->extents.cy;
-                            }
-                        }
-                        pos.y += height;
-                        iTextExtents.cx = std::max(iTextExtents.cx, x - offset);
-                        lineStart = next;
-                        if (lineStart != paragraphEnd)
-                            offset = lineStart->x;
-                        lineEnd = paragraphEnd;
-                        first = false;
-                    }
-                }
-                else
+                layout_paragraph(p, lines, pos, availableWidth);
+                if (p + 1 == iGlyphParagraphs.end() && !iGlyphs.empty() && iGlyphs.back().is_line_breaking_whitespace())
                 {
-                    auto lineStart = paragraphStart;
-                    auto lineEnd = paragraphEnd;
-                    auto height = paragraph.first.height(lineStart, lineEnd);
-                    if (lineEnd != lineStart && (lineEnd - 1)->is_line_breaking_whitespace())
-                        --lineEnd;
-                    lines.push_back(
-                        glyph_line{
-                            { p - iGlyphParagraphs.begin(), p },
-                            { lineStart - iGlyphs.begin(), lineStart },
-                            { lineEnd - iGlyphs.begin(), lineEnd },
-                            pos.y,
-                            { (lineEnd - 1)->x + (lineEnd - 1)->advance().cx, height} });
-                    pos.y += lines.back().extents.cy;
-                    iTextExtents.cx = std::max(iTextExtents.cx, lines.back().extents.cx);
+                    trailingHeight = font().height();
+                    pos.y += trailingHeight;
                 }
-                if (p + 1 == iGlyphParagraphs.end() && !iGlyphs.empty() && iGlyphs.back().is_line_breaking_whitespace())
-                    pos.y += font().height();
                 auto next_pass = [&]()
                 {
                     if (pass <= 3)
@@ -1787,6 +2000,7 @@ namespace neogfx
                         lines.clear();
                         pos = point{};
                         iTextExtents = size{};
+                        trailingHeight = 0.0;
                         p = iGlyphParagraphs.begin();
                         ++pass;
                     }
@@ -1819,13 +2033,163 @@ namespace neogfx
                     break;
                 }
             }
+            iterColumn->set_lines(std::move(lines));
             iTextExtents.cy = pos.y;
+            iLineLayout = line_layout{ availableWidth, availableHeight, showVerticalScrollbar, showHorizontalScrollbar, trailingHeight };
         }
         catch (std::bad_alloc)
         {
             for (auto& column : iGlyphColumns)
-                column.lines().clear();
+                column.clear_lines();
             iOutOfMemory = true;
+            iLineLayout = std::nullopt;
+        }
+    }
+
+    bool text_edit::refresh_lines(const paragraph_edit& aEdit)
+    {
+        if (iLineLayout == std::nullopt || iOutOfMemory)
+            return false;
+        try
+        {
+            // lines are only laid out in the first column (see refresh_lines())
+            auto& column = iGlyphColumns[0];
+            auto const& lines = column.lines();
+            auto firstLine = column.line_at_paragraph(aEdit.firstParagraph);
+            auto endLine = column.line_at_paragraph(aEdit.firstParagraph + aEdit.oldParagraphs);
+            auto const linesHeight = iTextExtents.cy - iLineLayout->trailingHeight;
+            auto const top = (firstLine != lines.end() ? column.line(firstLine).ypos : linesHeight);
+            auto const oldBottom = (endLine != lines.end() ? column.line(endLine).ypos : linesHeight);
+            glyph_lines newLines;
+            point pos{ 0.0, top };
+            auto p = std::next(iGlyphParagraphs.begin(), aEdit.firstParagraph);
+            for (glyph_paragraphs::size_type i = 0; i < aEdit.newParagraphs; ++i, ++p)
+                layout_paragraph(p, newLines, pos, iLineLayout->availableWidth);
+            auto const deltaY = pos.y - oldBottom;
+            auto const deltaParagraphs = static_cast<std::ptrdiff_t>(aEdit.newParagraphs) - static_cast<std::ptrdiff_t>(aEdit.oldParagraphs);
+            auto const deltaGlyphs = static_cast<std::ptrdiff_t>(aEdit.newGlyphs) - static_cast<std::ptrdiff_t>(aEdit.oldGlyphs);
+            // the lines after the edit are moved by a shift the column applies as they are read
+            column.replace_lines(firstLine, endLine, newLines, deltaParagraphs, deltaGlyphs, deltaY);
+            dimension trailingHeight = 0.0;
+            if (!iGlyphs.empty() && iGlyphs.back().is_line_breaking_whitespace())
+                trailingHeight = font().height();
+            iTextExtents.cx = column.widest_line();
+            iTextExtents.cy = linesHeight + deltaY + trailingHeight;
+            iLineLayout->trailingHeight = trailingHeight;
+            // if scrollbar visibility would change then the whole document has to be laid out again
+            return (iTextExtents.cy >= iLineLayout->availableHeight) == iLineLayout->verticalScrollbar &&
+                (iTextExtents.cx > iLineLayout->availableWidth) == iLineLayout->horizontalScrollbar;
+        }
+        catch (std::bad_alloc)
+        {
+            return false;
+        }
+    }
+
+    void text_edit::layout_paragraph(glyph_paragraphs::iterator aParagraph, glyph_lines& aLines, point& aPosition, dimension aAvailableWidth)
+    {
+        auto& paragraph = *aParagraph;
+        auto paragraphStart = paragraph.first.start();
+        auto paragraphEnd = paragraph.first.end();
+        if (paragraphStart == paragraphEnd || paragraphStart->is_line_breaking_whitespace())
+        {
+            auto lineStart = paragraphStart;
+            auto lineEnd = lineStart;
+            auto const& glyph = *lineStart;
+            auto const& glyphFont = glyph.font(iGlyphs);
+            auto height = paragraph.first.height(lineStart, lineEnd);
+            aLines.push_back(
+                glyph_line{
+                    static_cast<glyph_paragraphs::size_type>(aParagraph - iGlyphParagraphs.begin()),
+                    static_cast<document_glyphs::size_type>(lineStart - iGlyphs.begin()),
+                    static_cast<document_glyphs::size_type>(lineEnd - iGlyphs.begin()),
+                    aPosition.y,
+                    { 0.0, height } });
+            aPosition.y += glyphFont.height();
+        }
+        else if (WordWrap && (paragraphEnd - 1)->x + (paragraphEnd - 1)->advance().cx > aAvailableWidth)
+        {
+            auto insertionPoint = aLines.end();
+            bool first = true;
+            auto next = paragraph.first.start();
+            auto lineStart = next;
+            auto lineEnd = paragraphEnd;
+            coordinate offset = 0.0;
+            while (next != paragraphEnd)
+            {
+                auto split = std::lower_bound(next, paragraphEnd, paragraph_positioned_glyph{ offset + aAvailableWidth });
+                if (split != next && (split != paragraphEnd || (split - 1)->x + (split - 1)->advance().cx >= offset + aAvailableWidth))
+                    --split;
+                if (split == next)
+                    ++split;
+                if (split != paragraphEnd)
+                {
+                    std::pair<document_glyphs::iterator, document_glyphs::iterator> wordBreak = word_break(lineStart, split, paragraphEnd);
+                    lineEnd = wordBreak.first;
+                    next = wordBreak.second;
+                    if (wordBreak.first == wordBreak.second)
+                    {
+                        while (lineEnd != lineStart && (lineEnd - 1)->source() == wordBreak.first->source())
+                            --lineEnd;
+                        next = lineEnd;
+                    }
+                }
+                else
+                    next = paragraphEnd;
+                dimension x = (split != iGlyphs.end() ? split->x : (lineStart != lineEnd ? iGlyphs.back().x + iGlyphs.back().advance().cx : 0.0));
+                auto height = paragraph.first.height(lineStart, lineEnd);
+                if (lineEnd != lineStart && (lineEnd - 1)->is_line_breaking_whitespace())
+                    --lineEnd;
+                bool rtl = false;
+                if (!first &&
+                    insertionPoint->lineStart != insertionPoint->lineEnd &&
+                    lineStart != lineEnd &&
+                    iGlyphs[insertionPoint->lineStart].direction() == text_direction::RTL &&
+                    (lineEnd - 1)->direction() == text_direction::RTL)
+                    rtl = true; // todo: is this sufficient for multi-line RTL text?
+                if (!rtl)
+                    insertionPoint = aLines.end();
+                insertionPoint = aLines.insert(insertionPoint,
+                    glyph_line{
+                        static_cast<glyph_paragraphs::size_type>(aParagraph - iGlyphParagraphs.begin()),
+                        static_cast<document_glyphs::size_type>(lineStart - iGlyphs.begin()),
+                        static_cast<document_glyphs::size_type>(lineEnd - iGlyphs.begin()),
+                        aPosition.y,
+                        { x - offset, height } });
+                if (rtl)
+                {
+                    auto ypos = (insertionPoint + 1)->ypos;
+                    for (auto i = insertionPoint; i != aLines.end(); ++i)
+                    {
+                        i->ypos = ypos;
+                        ypos += i->extents.cy;
+                    }
+                }
+                aPosition.y += height;
+                iTextExtents.cx = std::max(iTextExtents.cx, x - offset);
+                lineStart = next;
+                if (lineStart != paragraphEnd)
+                    offset = lineStart->x;
+                lineEnd = paragraphEnd;
+                first = false;
+            }
+        }
+        else
+        {
+            auto lineStart = paragraphStart;
+            auto lineEnd = paragraphEnd;
+            auto height = paragraph.first.height(lineStart, lineEnd);
+            if (lineEnd != lineStart && (lineEnd - 1)->is_line_breaking_whitespace())
+                --lineEnd;
+            aLines.push_back(
+                glyph_line{
+                    static_cast<glyph_paragraphs::size_type>(aParagraph - iGlyphParagraphs.begin()),
+                    static_cast<document_glyphs::size_type>(lineStart - iGlyphs.begin()),
+                    static_cast<document_glyphs::size_type>(lineEnd - iGlyphs.begin()),
+                    aPosition.y,
+                    { (lineEnd - 1)->x + (lineEnd - 1)->advance().cx, height} });
+            aPosition.y += aLines.back().extents.cy;
+            iTextExtents.cx = std::max(iTextExtents.cx, aLines.back().extents.cx);
         }
     }
 
@@ -1874,8 +2238,9 @@ namespace neogfx
 
     void text_edit::draw_glyphs(const i_graphics_context& aGraphicsContext, const point& aPosition, const glyph_column& aColumn, glyph_lines::const_iterator aLine) const
     {
-        auto lineStart = aLine->lineStart.second;
-        auto lineEnd = aLine->lineEnd.second;
+        auto const resolvedLine = aColumn.line(aLine);
+        document_glyphs::const_iterator lineStart = iGlyphs.begin() + resolvedLine.lineStart;
+        document_glyphs::const_iterator lineEnd = iGlyphs.begin() + resolvedLine.lineEnd;
         if (lineEnd != lineStart && (lineEnd - 1)->is_line_breaking_whitespace())
             --lineEnd;
         {
@@ -44,6 +44,14 @@ namespace neogfx
 
     i_widget* widget::debug;
 
+    namespace
+    {
+        // the layer whose texture is being (re)rendered and its rect in window coordinates; while set, widgets
+        // paint everything within the layer rather than just the surface's invalidated region
+        thread_local const i_widget* tRenderingLayer;
+        thread_local rect tRenderingLayerRect;
+    }
+
     widget::widget() :
         iSingular{ false },
         iParent{ nullptr },
@@ -51,7 +59,8 @@ namespace neogfx
         iLinkBefore{ nullptr },
         iLinkAfter{ nullptr },
         iParentLayout{ nullptr },
-        iLayoutInProgress{ 0 }
+        iLayoutInProgress{ 0 },
+        iLayerDirty{ true }
     {
         Position.Changed([this](const point&) { moved(); });
     }
@@ -63,7 +72,8 @@ namespace neogfx
         iLinkBefore{ nullptr },
         iLinkAfter{ nullptr },
         iParentLayout{ nullptr },
-        iLayoutInProgress{ 0 }
+        iLayoutInProgress{ 0 },
+        iLayerDirty{ true }
     {
         Position.Changed([this](const point&) { moved(); });
         aParent.add(*this);
@@ -76,7 +86,8 @@ namespace neogfx
         iLinkBefore{ nullptr },
         iLinkAfter{ nullptr },
         iParentLayout{ nullptr },
-        iLayoutInProgress{ 0 }
+        iLayoutInProgress{ 0 },
+        iLayerDirty{ true }
     {
         Position.Changed([this](const point&) { moved(); });
         aLayout.add(*this);
@@ -980,19 +991,35 @@ namespace neogfx
         if (aUpdateRect.empty())
             return false;
         surface().invalidate_surface(to_window_coordinates(aUpdateRect));
+        if (layer())
+            iLayerDirty = true;
+        // the nearest enclosing layer has to re-render its texture (and in turn marks any layer enclosing it)
+        for (auto ancestor = iParent; ancestor != nullptr; ancestor = ancestor->has_parent() ? &ancestor->parent() : nullptr)
+            if (ancestor->layer())
+            {
+                ancestor->update(ancestor->to_client_coordinates(to_window_coordinates(aUpdateRect)));
+                break;
+            }
         return true;
     }
 
     bool widget::requires_update() const
     {
-        return surface().has_invalidated_area() && !surface().invalidated_area().intersection(non_client_rect()).empty();
+        if (tRenderingLayer != nullptr)
+            return !tRenderingLayerRect.intersection(non_client_rect()).empty();
+        if (!surface().has_invalidated_area())
+            return false;
+        auto const ncr = non_client_rect();
+        return !surface().invalidated_area().intersection(ncr).empty() && surface().invalidated_region().intersects(ncr);
     }
 
     rect widget::update_rect() const
     {
         if (!requires_update())
             throw no_update_rect();
-        return to_client_coordinates(surface().invalidated_area().intersection(non_client_rect()));
+        if (tRenderingLayer != nullptr)
+            return to_client_coordinates(tRenderingLayerRect.intersection(non_client_rect()));
+        return to_client_coordinates(surface().invalidated_region().intersection(surface().invalidated_area().intersection(non_client_rect())));
     }
 
     rect widget::default_clip_rect(bool aIncludeNonClient) const
@@ -1025,6 +1052,12 @@ namespace neogfx
         if (!requires_update())
             return;
 
+        if (layer() && tRenderingLayer != this)
+        {
+            render_layer(aGraphicsContext);
+            return;
+        }
+
         if (debug == this)
             std::cerr << "widget::render(...)" << std::endl;
 
@@ -1077,6 +1110,51 @@ namespace neogfx
         }
     }
 
+    void widget::render_layer(i_graphics_context& aGraphicsContext) const
+    {
+        iDefaultClipRect = std::make_pair(std::nullopt, std::nullopt);
+
+        auto const layerRect = to_client_coordinates(non_client_rect());
+        auto const layerClipRect = default_clip_rect(true);
+        if (layerClipRect.empty())
+            return;
+
+        if (iLayerTexture == std::nullopt || iLayerTexture->extents() != extents())
+        {
+            iLayerTexture.emplace(extents(), 1.0, texture_sampling::Nearest);
+            iLayerDirty = true;
+        }
+        if (iLayerClipRect != layerClipRect)
+            iLayerDirty = true; // texture only holds what was visible when it was rendered
+
+        if (iLayerDirty)
+        {
+            if (debug == this)
+                std::cerr << "widget::render_layer(...): re-rendering layer" << std::endl;
+            // cleared before painting so that updates made while painting (e.g. animation) are not lost
+            iLayerDirty = false;
+            iLayerClipRect = layerClipRect;
+            graphics_context layerGc{ *iLayerTexture };
+            layerGc.set_logical_coordinate_system(neogfx::logical_coordinate_system::AutomaticGui);
+            layerGc.set_target_origin(origin());
+            {
+                scoped_scissor scissor{ layerGc, rect{ origin(), extents() } };
+                layerGc.clear(color{ vec4{ 0.0, 0.0, 0.0, 0.0 } });
+            }
+            neolib::scoped_pointer<const i_widget> sp{ tRenderingLayer, this };
+            auto const previousLayerRect = tRenderingLayerRect;
+            tRenderingLayerRect = to_window_coordinates(layerClipRect);
+            render(layerGc);
+            tRenderingLayerRect = previousLayerRect;
+            layerGc.flush();
+        }
+
+        aGraphicsContext.set_extents(extents());
+        aGraphicsContext.set_origin(origin());
+        scoped_scissor scissor{ aGraphicsContext, layerClipRect.intersection(update_rect()) };
+        aGraphicsContext.draw_texture(layerRect, *iLayerTexture);
+    }
+
     bool widget::transparent_background() const
     {
         return !is_root();
@@ -1112,6 +1190,26 @@ namespace neogfx
         }
     }
 
+    bool widget::layer() const
+    {
+        return Layer;
+    }
+
+    void widget::set_layer(bool aLayer)
+    {
+        if (Layer != aLayer)
+        {
+            Layer = aLayer;
+            if (!Layer)
+            {
+                iLayerTexture = std::nullopt;
+                iLayerClipRect = std::nullopt;
+            }
+            iLayerDirty = true;
+            update(true);
+        }
+    }
+
     double widget::transparency() const
     {
         return 1.0 - opacity();
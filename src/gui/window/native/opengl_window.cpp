@@ -27,6 +27,8 @@
 #include <neogfx/app/i_app.hpp>
 #include <neogfx/hid/i_surface_window.hpp>
 #include <neogfx/gfx/i_rendering_context.hpp>
+#include <neogfx/gfx/graphics_context.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
 #include "opengl_window.hpp"
 #include "../../../gfx/native/opengl_helpers.hpp"
 #include "../../../gfx/native/opengl_texture.hpp"
@@ -37,7 +39,10 @@ namespace neogfx
         native_window{ aRenderingEngine, aSurfaceManager },
         iSurfaceWindow{ aWindow },
         iLogicalCoordinateSystem{ neogfx::logical_coordinate_system::AutomaticGui },
+        iScrollBuffer{ 0 },
         iFrameCounter{ 0 },
+        iRepaintedPixels{ 0 },
+        iPresentedPixels{ 0 },
         iRendering{ false },
         iPaused{ 0 }
     {
@@ -203,35 +208,78 @@ namespace neogfx
         return 1.0 / averageDuration_s;
     }
 
+    uint64_t opengl_window::repainted_pixels() const
+    {
+        return iRepaintedPixels;
+    }
+
+    uint64_t opengl_window::presented_pixels() const
+    {
+        return iPresentedPixels;
+    }
+
     void opengl_window::invalidate(const rect& aInvalidatedRect)
     {
         if (aInvalidatedRect.cx != 0.0 && aInvalidatedRect.cy != 0.0)
+            iInvalidatedRegion.add(aInvalidatedRect);
+    }
+
+    void opengl_window::scroll(const rect& aArea, const point& aDelta)
+    {
+        rect const area = aArea.intersection(rect{ point{}, extents() });
+        rect const moved = (area + aDelta).intersection(area);
+        bool const wholePixels = aDelta == aDelta.floor() && area.top_left() == area.top_left().floor() && area.extents() == area.extents().floor();
+        if (moved.empty() || !wholePixels)
         {
-            if (!has_invalidated_area())
-                iInvalidatedArea = aInvalidatedRect.ceil();
-            else
-                iInvalidatedArea = invalidated_area().combine(aInvalidatedRect).ceil();
+            invalidate(area);
+            return;
+        }
+        // the copy is done at the start of the next frame so damage already pending within the area moves with it
+        if (iInvalidatedRegion.intersects(area))
+        {
+            damage_region damage = iInvalidatedRegion;
+            for (auto const& damagedRect : iInvalidatedRegion)
+            {
+                auto const movedDamage = (damagedRect.intersection(area) + aDelta).intersection(area);
+                if (!movedDamage.empty())
+                    damage.add(movedDamage);
+            }
+            iInvalidatedRegion = damage;
         }
+        iPendingScrolls.emplace_back(area, aDelta);
+        if (aDelta.y > 0.0)
+            invalidate(rect{ area.top_left(), size{ area.cx, aDelta.y } });
+        else if (aDelta.y < 0.0)
+            invalidate(rect{ point{ area.x, moved.bottom() }, size{ area.cx, -aDelta.y } });
+        if (aDelta.x > 0.0)
+            invalidate(rect{ area.top_left(), size{ aDelta.x, area.cy } });
+        else if (aDelta.x < 0.0)
+            invalidate(rect{ point{ moved.right(), area.y }, size{ -aDelta.x, area.cy } });
     }
 
     bool opengl_window::has_invalidated_area() const
     {
-        return iInvalidatedArea != std::nullopt;
+        return !iInvalidatedRegion.empty();
     }
 
     const rect& opengl_window::invalidated_area() const
     {
         if (has_invalidated_area())
-            return *iInvalidatedArea;
+            return iInvalidatedRegion.bounding_rect();
         throw no_invalidated_area();
     }
 
+    const damage_region& opengl_window::invalidated_region() const
+    {
+        return iInvalidatedRegion;
+    }
+
     rect opengl_window::validate()
     {
         if (has_invalidated_area())
         {
             rect validatedArea = invalidated_area();
-            iInvalidatedArea = std::nullopt;
+            iInvalidatedRegion.clear();
             return validatedArea;
         }
         throw no_invalidated_area();
@@ -279,8 +327,15 @@ namespace neogfx
 
         scoped_render_target srt{ *this };
 
+        service<i_font_manager>().upload_rasterized_glyphs();
+        service<i_font_manager>().evict_glyphs();
+
         if (iFrameBufferExtents.cx < static_cast<double>(extents().cx) || iFrameBufferExtents.cy < static_cast<double>(extents().cy))
         {
+            // frame buffer contents are lost so anything pending a scroll has to be repainted instead
+            for (auto const& scroll : iPendingScrolls)
+                invalidate(scroll.first);
+            iPendingScrolls.clear();
             if (iFrameBufferExtents != size{})
             {
                 glCheck(glDeleteRenderbuffers(1, &iDepthStencilBuffer));
@@ -314,26 +369,135 @@ namespace neogfx
         GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0 };
         glCheck(glDrawBuffers(sizeof(drawBuffers) / sizeof(drawBuffers[0]), drawBuffers));
 
-        glCheck(surface_window().native_window_render(invalidated_area()));
+        auto& stats = rendering_engine().frame_stats();
+        auto const paintStart = std::chrono::high_resolution_clock::now();
+        auto const flushTimeBefore = stats.flushTime;
+
+        apply_scrolls();
+
+        // the overlay is translucent so the widgets beneath it (and beneath where it was) are repainted every time
+        // it is drawn and once more when it is switched off; widgets clip their painting to the invalidated region
+        // so the overlay's rects must be invalidated rather than just rendered
+        if (iFrameStatsOverlayRect != std::nullopt)
+            invalidate(*iFrameStatsOverlayRect);
+        iFrameStatsOverlayRect = rendering_engine().frame_stats_overlay_enabled() ? frame_stats_overlay_rect() : optional_rect{};
+        if (iFrameStatsOverlayRect != std::nullopt)
+            invalidate(*iFrameStatsOverlayRect);
+        // widgets may invalidate during painting so render from a copy of the damage region
+        damage_region const toRender = iInvalidatedRegion;
+        iRepaintedPixels = 0;
+        for (auto const& damagedRect : toRender)
+        {
+            glCheck(surface_window().native_window_render(damagedRect));
+            iRepaintedPixels += static_cast<uint64_t>(damagedRect.cx * damagedRect.cy);
+        }
+
+        if (iFrameStatsOverlayRect != std::nullopt)
+            render_frame_stats_overlay();
 
         rendering_engine().vertex_arrays().execute();
 
-        glCheck(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
-        glCheck(glBindFramebuffer(GL_READ_FRAMEBUFFER, iFrameBuffer));
-        glCheck(glBlitFramebuffer(0, 0, static_cast<GLint>(extents().cx), static_cast<GLint>(extents().cy), 0, 0, static_cast<GLint>(extents().cx), static_cast<GLint>(extents().cy), GL_COLOR_BUFFER_BIT, GL_NEAREST));
+        auto const swapStart = std::chrono::high_resolution_clock::now();
+        stats.paintTime += std::chrono::duration_cast<frame_stats::duration>(swapStart - paintStart) - (stats.flushTime - flushTimeBefore);
+
+        present();
 
         display();
 
+        stats.swapTime += std::chrono::duration_cast<frame_stats::duration>(std::chrono::high_resolution_clock::now() - swapStart);
+        stats.repaintedPixels += iRepaintedPixels;
+        stats.presentedPixels += iPresentedPixels;
+
         iRendering = false;
         validate();
 
+        // keep the overlay's stats current
+        if (iFrameStatsOverlayRect != std::nullopt)
+            invalidate(*iFrameStatsOverlayRect);
+
         surface_window().rendering_finished().trigger();
 
+        rendering_engine().end_frame();
+
         iFpsData.push_back(frame_times{ *iLastFrameTime, std::chrono::high_resolution_clock::now() });
         if (iFpsData.size() > 100)
             iFpsData.pop_front();        
     }
 
+    namespace
+    {
+        dimension const FrameStatsOverlayMargin = 4.0;
+    }
+
+    rect opengl_window::frame_stats_overlay_rect() const
+    {
+        graphics_context gc{ static_cast<const i_render_target&>(*this) };
+        return rect{ point{ FrameStatsOverlayMargin, FrameStatsOverlayMargin },
+            gc.multiline_text_extent(to_string(rendering_engine().last_frame_stats()), font{}) + size{ FrameStatsOverlayMargin * 2.0 } };
+    }
+
+    void opengl_window::render_frame_stats_overlay()
+    {
+        // drawn straight into the frame buffer after the widgets so it shows the previous frame's stats
+        graphics_context gc{ static_cast<const i_render_target&>(*this) };
+        auto const& overlayRect = *iFrameStatsOverlayRect;
+        gc.fill_rect(overlayRect, color::Black.with_alpha(0xC0));
+        gc.draw_multiline_text(overlayRect.top_left() + point{ FrameStatsOverlayMargin, FrameStatsOverlayMargin },
+            to_string(rendering_engine().last_frame_stats()), font{}, text_appearance{ color::White });
+        gc.flush();
+    }
+
+    void opengl_window::apply_scrolls()
+    {
+        if (iPendingScrolls.empty())
+            return;
+        // blitting within a single frame buffer is undefined when source and destination overlap so go via a scratch
+        // frame buffer (multisample like ours; a multisample blit requires equal sample counts and extents)
+        if (iScrollBufferTexture == std::nullopt || iScrollBufferTexture->extents() != iFrameBufferExtents)
+        {
+            if (iScrollBuffer == 0)
+                glCheck(glGenFramebuffers(1, &iScrollBuffer));
+            glCheck(glBindFramebuffer(GL_FRAMEBUFFER, iScrollBuffer));
+            iScrollBufferTexture = std::nullopt;
+            iScrollBufferTexture.emplace(iFrameBufferExtents, 1.0, texture_sampling::Multisample);
+            glCheck(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, static_cast<GLuint>(reinterpret_cast<std::intptr_t>(iScrollBufferTexture->native_texture()->handle())), 0));
+        }
+        auto const surfaceHeight = extents().cy;
+        for (auto const& scroll : iPendingScrolls)
+        {
+            auto const& area = scroll.first;
+            auto const& delta = scroll.second;
+            rect const destination = (area + delta).intersection(area);
+            rect const source = destination - delta;
+            GLint const sx0 = static_cast<GLint>(source.left());
+            GLint const sy0 = static_cast<GLint>(surfaceHeight - source.bottom());
+            GLint const sx1 = static_cast<GLint>(source.right());
+            GLint const sy1 = static_cast<GLint>(surfaceHeight - source.top());
+            GLint const dx0 = static_cast<GLint>(destination.left());
+            GLint const dy0 = static_cast<GLint>(surfaceHeight - destination.bottom());
+            GLint const dx1 = static_cast<GLint>(destination.right());
+            GLint const dy1 = static_cast<GLint>(surfaceHeight - destination.top());
+            glCheck(glBindFramebuffer(GL_READ_FRAMEBUFFER, iFrameBuffer));
+            glCheck(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, iScrollBuffer));
+            glCheck(glBlitFramebuffer(sx0, sy0, sx1, sy1, sx0, sy0, sx1, sy1, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+            glCheck(glBindFramebuffer(GL_READ_FRAMEBUFFER, iScrollBuffer));
+            glCheck(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, iFrameBuffer));
+            glCheck(glBlitFramebuffer(sx0, sy0, sx1, sy1, dx0, dy0, dx1, dy1, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+        }
+        iPendingScrolls.clear();
+        glCheck(glBindFramebuffer(GL_FRAMEBUFFER, iFrameBuffer));
+    }
+
+    void opengl_window::present()
+    {
+        // the back buffer's contents are undefined after a swap (triple buffering, discard on swap, compositors) so
+        // always present the whole of our frame buffer, which holds the complete frame
+        glCheck(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+        glCheck(glBindFramebuffer(GL_READ_FRAMEBUFFER, iFrameBuffer));
+        glCheck(glBlitFramebuffer(0, 0, static_cast<GLint>(extents().cx), static_cast<GLint>(extents().cy), 0, 0, static_cast<GLint>(extents().cx), static_cast<GLint>(extents().cy), GL_COLOR_BUFFER_BIT, GL_NEAREST));
+        iPresentedPixels = static_cast<uint64_t>(extents().cx * extents().cy);
+    }
+
     void opengl_window::pause()
     {
         ++iPaused;
@@ -377,6 +541,12 @@ namespace neogfx
             glCheck(glDeleteRenderbuffers(1, &iDepthStencilBuffer));
             iFrameBufferTexture = std::nullopt;
             glCheck(glDeleteFramebuffers(1, &iFrameBuffer));
+            if (iScrollBuffer != 0)
+            {
+                iScrollBufferTexture = std::nullopt;
+                glCheck(glDeleteFramebuffers(1, &iScrollBuffer));
+                iScrollBuffer = 0;
+            }
         }
         if (target_active())
             deactivate_target();
@@ -61,10 +61,14 @@ namespace neogfx
         uint64_t frame_counter() const override;
         double fps() const override;
         double potential_fps() const override;
+        uint64_t repainted_pixels() const override;
+        uint64_t presented_pixels() const override;
     public:
         void invalidate(const rect& aInvalidatedRect) override;
+        void scroll(const rect& aArea, const point& aDelta) override;
         bool has_invalidated_area() const override;
         const rect& invalidated_area() const override;
+        const damage_region& invalidated_region() const override;
         rect validate() override;
         bool can_render() const override;
         void render(bool aOOBRequest = false) override;
@@ -80,6 +84,10 @@ namespace neogfx
         void set_destroyed() override;
     private:
         virtual void display() = 0;
+        void present();
+        rect frame_stats_overlay_rect() const;
+        void render_frame_stats_overlay();
+        void apply_scrolls();
     private:
         i_surface_window& iSurfaceWindow;
         neogfx::logical_coordinate_system iLogicalCoordinateSystem;
@@ -88,8 +96,14 @@ namespace neogfx
         mutable optional_texture iFrameBufferTexture;
         GLuint iDepthStencilBuffer;
         size iFrameBufferExtents;
-        std::optional<rect> iInvalidatedArea;
+        damage_region iInvalidatedRegion;
+        std::vector<std::pair<rect, point>> iPendingScrolls;
+        GLuint iScrollBuffer;
+        optional_texture iScrollBufferTexture;
         uint64_t iFrameCounter;
+        uint64_t iRepaintedPixels;
+        uint64_t iPresentedPixels;
+        optional_rect iFrameStatsOverlayRect;
         typedef std::chrono::time_point<std::chrono::high_resolution_clock> frame_time_point;
         typedef std::pair<frame_time_point, frame_time_point> frame_times;
         std::optional<frame_time_point> iLastFrameTime;
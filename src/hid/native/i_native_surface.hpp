@@ -25,6 +25,7 @@
 #include <neogfx/core/event.hpp>
 #include <neogfx/gfx/i_graphics_context.hpp>
 #include <neogfx/gfx/i_render_target.hpp>
+#include <neogfx/gfx/damage_region.hpp>
 
 namespace neogfx
 {
@@ -61,10 +62,14 @@ namespace neogfx
         virtual uint64_t frame_counter() const = 0;
         virtual double fps() const = 0;
         virtual double potential_fps() const = 0;
+        virtual uint64_t repainted_pixels() const = 0;
+        virtual uint64_t presented_pixels() const = 0;
     public:
         virtual void invalidate(const rect& aInvalidatedRect) = 0;
+        virtual void scroll(const rect& aArea, const point& aDelta) = 0;
         virtual bool has_invalidated_area() const = 0;
         virtual const rect& invalidated_area() const = 0;
+        virtual const damage_region& invalidated_region() const = 0;
         virtual rect validate() = 0;
         virtual bool can_render() const = 0;
         virtual void render(bool aOOBRequest = false) = 0;
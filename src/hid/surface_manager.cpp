@@ -18,10 +18,12 @@
 */
 
 #include <neogfx/neogfx.hpp>
+#include <algorithm>
 #include <neolib/string_utils.hpp>
 
 #include <neogfx/hid/surface_manager.hpp>
 #include <neogfx/gui/window/i_window.hpp>
+#include <neogfx/gfx/text/i_font_manager.hpp>
 #include "native/i_native_surface.hpp"
 #include "../gui/window/native/i_native_window.hpp"
 
@@ -139,6 +141,11 @@ namespace neogfx
         if (iRenderingSurfaces || iRenderingEngine.creating_window())
             return;
         iRenderingSurfaces = true;
+        // only the text drawn with placeholders is repainted, not whole surfaces
+        service<i_font_manager>().invalidate_rasterized_glyphs();
+        // one glyph use generation per rendering pass over all surfaces, not per window rendered
+        if (std::any_of(iSurfaces.begin(), iSurfaces.end(), [](auto const& s) { return s->has_invalidated_area(); }))
+            service<i_font_manager>().advance_glyph_use_generation();
         for (auto& s : iSurfaces)
             s->render_surface();
         iRenderingSurfaces = false;
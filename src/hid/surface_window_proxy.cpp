@@ -36,7 +36,8 @@ namespace neogfx
         iNativeWindow{ aNativeWindowCreator(*this) },
         iClosed{ false },
         iCapturingWidget{ nullptr },
-        iClickedWidget{ nullptr }
+        iClickedWidget{ nullptr },
+        iRenderingArea{ nullptr }
     {
         iNativeSurfaceDestroyed.emplace(iNativeWindow->as_lifetime());
         service<i_surface_manager>().add_surface(*this);
@@ -211,6 +212,11 @@ namespace neogfx
             as_widget().update(aInvalidatedRect);
     }
 
+    void surface_window_proxy::scroll_surface(const rect& aArea, const point& aDelta)
+    {
+        native_surface().scroll(aArea, aDelta);
+    }
+
     bool surface_window_proxy::has_invalidated_area() const
     {
         return native_surface().has_invalidated_area();
@@ -218,9 +224,16 @@ namespace neogfx
 
     const rect& surface_window_proxy::invalidated_area() const
     {
+        if (iRenderingArea != nullptr)
+            return *iRenderingArea;
         return native_surface().invalidated_area();
     }
 
+    const damage_region& surface_window_proxy::invalidated_region() const
+    {
+        return native_surface().invalidated_region();
+    }
+
     rect surface_window_proxy::validate()
     {
         return native_surface().validate();
@@ -231,6 +244,16 @@ namespace neogfx
         return as_window().rendering_priority();
     }
 
+    uint64_t surface_window_proxy::repainted_pixels() const
+    {
+        return has_native_surface() ? native_surface().repainted_pixels() : 0u;
+    }
+
+    uint64_t surface_window_proxy::presented_pixels() const
+    {
+        return has_native_surface() ? native_surface().presented_pixels() : 0u;
+    }
+
     void surface_window_proxy::render_surface()
     {
         if (has_native_surface())
@@ -464,8 +487,9 @@ namespace neogfx
         return as_widget().ready_to_render();
     }
 
-    void surface_window_proxy::native_window_render(const rect&) const
+    void surface_window_proxy::native_window_render(const rect& aInvalidatedRect) const
     {
+        neolib::scoped_pointer<const rect> sp{ iRenderingArea, &aInvalidatedRect };
         graphics_context gc{ *this };
         as_widget().render(gc);
         gc.flush();
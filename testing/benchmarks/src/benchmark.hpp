@@ -0,0 +1,84 @@
+// benchmark.hpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <neogfx/neogfx.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+namespace neogfx::benchmarks
+{
+    typedef std::vector<std::string> arguments;
+    typedef std::function<void(const arguments&)> benchmark;
+
+    inline std::map<std::string, benchmark>& registry()
+    {
+        static std::map<std::string, benchmark> sRegistry;
+        return sRegistry;
+    }
+
+    struct register_benchmark
+    {
+        register_benchmark(const std::string& aName, benchmark aBenchmark)
+        {
+            registry()[aName] = std::move(aBenchmark);
+        }
+    };
+
+    // runs aSetup (untimed) then aBody (timed) aSamples times and reports the minimum and median in milliseconds
+    template <typename Setup, typename Body>
+    inline void measure(const std::string& aName, uint32_t aSamples, Setup aSetup, Body aBody)
+    {
+        std::vector<double> samples;
+        for (uint32_t s = 0u; s < aSamples; ++s)
+        {
+            aSetup();
+            auto const start = std::chrono::high_resolution_clock::now();
+            aBody();
+            auto const end = std::chrono::high_resolution_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        std::cout << std::left << std::setw(40) << aName << std::right << std::fixed << std::setprecision(3) <<
+            " min " << std::setw(10) << samples.front() << " ms" <<
+            "  median " << std::setw(10) << samples[samples.size() / 2u] << " ms" << std::endl;
+    }
+
+    template <typename Body>
+    inline void measure(const std::string& aName, uint32_t aSamples, Body aBody)
+    {
+        measure(aName, aSamples, []() {}, aBody);
+    }
+
+    inline volatile char sSink;
+
+    // stops the optimizer discarding a result that is otherwise unused
+    template <typename T>
+    inline void keep(const T& aValue)
+    {
+        sSink = *reinterpret_cast<const volatile char*>(&aValue);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+// ecs_iteration_benchmark.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/game/ecs.hpp>
+#include <neogfx/game/archetype_storage.hpp>
+#include <neogfx/game/rigid_body.hpp>
+#include <neogfx/game/transformation.hpp>
+#include "benchmark.hpp"
+
+namespace neogfx::benchmarks
+{
+    namespace
+    {
+        void integrate(game::rigid_body& aRigidBody)
+        {
+            aRigidBody.position += aRigidBody.velocity;
+        }
+
+        void place(const game::rigid_body& aRigidBody, game::transformation& aTransformation)
+        {
+            aTransformation.matrix[3][0] = aRigidBody.position.x;
+            aTransformation.matrix[3][1] = aRigidBody.position.y;
+            aTransformation.matrix[3][2] = aRigidBody.position.z;
+        }
+
+        // usage: ecs_iteration [<entities> [<samples>]]
+        // the same rigid_body and transformation records held both by the static_component storage (a vector per
+        // component joined through each component's entity index) and by the archetype storage (the components of
+        // an entity side by side in chunks), iterated over one component and over the join of both
+        void ecs_iteration(const arguments& aArguments)
+        {
+            auto const entities = aArguments.size() >= 1u ? static_cast<uint32_t>(std::stoul(aArguments[0])) : 100000u;
+            auto const samples = aArguments.size() >= 2u ? static_cast<uint32_t>(std::stoul(aArguments[1])) : 20u;
+            game::ecs ecs{ game::ecs_flags::None };
+            auto& rigidBodies = ecs.component<game::rigid_body>();
+            auto& transformations = ecs.component<game::transformation>();
+            auto& archetypes = ecs.archetype_storage();
+            for (uint32_t i = 0u; i < entities; ++i)
+            {
+                auto const e = ecs.next_entity_id();
+                game::rigid_body const rigidBody{ vec3{ i * 1.0, 0.0, 0.0 }, 1.0, vec3{ 1.0, 2.0, 3.0 } };
+                game::transformation const transformation{ mat44::identity() };
+                rigidBodies.populate(e, rigidBody);
+                transformations.populate(e, transformation);
+                archetypes.populate(e, rigidBody);
+                archetypes.populate(e, transformation);
+            }
+            auto const suffix = " (" + std::to_string(entities) + " entities)";
+            measure("static_component rigid_body" + suffix, samples, [&]()
+            {
+                for (auto& rigidBody : rigidBodies.live_records())
+                    integrate(rigidBody);
+            });
+            measure("archetype rigid_body" + suffix, samples, [&]()
+            {
+                archetypes.for_each<game::rigid_body>([](game::entity_id, game::rigid_body& aRigidBody)
+                {
+                    integrate(aRigidBody);
+                });
+            });
+            measure("static_component rigid_body+transformation" + suffix, samples, [&]()
+            {
+                auto const liveBodies = rigidBodies.live_records();
+                for (auto rigidBody = liveBodies.begin(); rigidBody != liveBodies.end(); ++rigidBody)
+                    place(*rigidBody, transformations.entity_record(rigidBody.entity()));
+            });
+            measure("archetype rigid_body+transformation" + suffix, samples, [&]()
+            {
+                archetypes.for_each<game::rigid_body, game::transformation>([](game::entity_id, game::rigid_body& aRigidBody, game::transformation& aTransformation)
+                {
+                    place(aRigidBody, aTransformation);
+                });
+            });
+            keep(std::as_const(rigidBodies).component_data()[0].position.x);
+        }
+
+        register_benchmark const sEcsIteration{ "ecs_iteration", ecs_iteration };
+    }
+}
@@ -0,0 +1,86 @@
+// font_catalogue_benchmark.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <boost/filesystem.hpp>
+#include "../../../src/gfx/text/font_catalogue.hpp"
+#include "benchmark.hpp"
+
+namespace neogfx::benchmarks
+{
+    namespace
+    {
+        std::string default_font_directory()
+        {
+#ifdef WIN32
+            char const* windowsDirectory = std::getenv("WINDIR");
+            return std::string{ windowsDirectory != nullptr ? windowsDirectory : "C:\\Windows" } + "\\fonts";
+#else
+            return "/usr/share/fonts";
+#endif
+        }
+
+        // the font directory scan font_manager performs at startup
+        font_catalogue::statistics index_fonts(FT_Library aFontLib, const std::string& aFontDirectory, const std::string& aCataloguePath)
+        {
+            font_catalogue catalogue{ aCataloguePath };
+            for (boost::filesystem::directory_iterator file(aFontDirectory); file != boost::filesystem::directory_iterator(); ++file)
+            {
+                if (!boost::filesystem::is_regular_file(file->status()))
+                    continue;
+                boost::system::error_code ec;
+                auto const fileSize = boost::filesystem::file_size(file->path(), ec);
+                if (ec)
+                    continue;
+                auto const lastWriteTime = boost::filesystem::last_write_time(file->path(), ec);
+                if (ec)
+                    continue;
+                catalogue.validate(aFontLib, file->path().string(), static_cast<uint64_t>(fileSize), static_cast<int64_t>(lastWriteTime));
+            }
+            catalogue.save();
+            return catalogue.stats();
+        }
+
+        // usage: font_catalogue [<font directory> [<samples>]]
+        // cold: no catalogue so every font file is opened (the behaviour before the catalogue existed)
+        // warm: a catalogue written by a previous run so no font file is opened
+        void font_catalogue_startup(const arguments& aArguments)
+        {
+            auto const fontDirectory = aArguments.size() >= 1u ? aArguments[0] : default_font_directory();
+            auto const samples = aArguments.size() >= 2u ? static_cast<uint32_t>(std::stoul(aArguments[1])) : 5u;
+            auto const cataloguePath = (boost::filesystem::temp_directory_path() / "neogfx_benchmark_font_catalogue.dat").string();
+            FT_Library fontLib;
+            if (FT_Init_FreeType(&fontLib) != 0)
+                throw std::runtime_error("FT_Init_FreeType failed");
+            font_catalogue::statistics stats;
+            measure("font catalogue startup (cold)", samples,
+                [&]() { boost::system::error_code ec; boost::filesystem::remove(cataloguePath, ec); },
+                [&]() { stats = index_fonts(fontLib, fontDirectory, cataloguePath); });
+            std::cout << "  files: " << stats.files << ", scanned: " << stats.scanned << std::endl;
+            measure("font catalogue startup (warm)", samples,
+                [&]() { stats = index_fonts(fontLib, fontDirectory, cataloguePath); });
+            std::cout << "  files: " << stats.files << ", scanned: " << stats.scanned << std::endl;
+            boost::system::error_code ec;
+            boost::filesystem::remove(cataloguePath, ec);
+            FT_Done_FreeType(fontLib);
+        }
+
+        register_benchmark const sFontCatalogueStartup{ "font_catalogue", font_catalogue_startup };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+// lcd_filter_benchmark.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <random>
+#include "../../../src/gfx/text/native/glyph_rasterizer.hpp"
+#include "benchmark.hpp"
+
+namespace neogfx::benchmarks
+{
+    namespace
+    {
+        // usage: lcd_filter [<glyph width> [<glyphs> [<samples>]]]
+        // filters the rows of <glyphs> LCD glyph bitmaps <glyph width> pixels wide (and as many high) with the SIMD
+        // path and with the scalar path; the two results are compared as a check on the SIMD path
+        void lcd_filter(const arguments& aArguments)
+        {
+            auto const glyphWidth = aArguments.size() >= 1u ? static_cast<uint32_t>(std::stoul(aArguments[0])) : 16u;
+            auto const glyphs = aArguments.size() >= 2u ? static_cast<uint32_t>(std::stoul(aArguments[1])) : 10000u;
+            auto const samples = aArguments.size() >= 3u ? static_cast<uint32_t>(std::stoul(aArguments[2])) : 10u;
+            auto const subpixels = glyphWidth * 3u;
+            auto const rows = glyphWidth * glyphs;
+            std::vector<uint8_t> source(static_cast<std::size_t>(subpixels) * rows);
+            std::mt19937 random{ 42u };
+            std::uniform_int_distribution<uint32_t> value{ 0u, 255u };
+            for (auto& subpixel : source)
+                subpixel = static_cast<uint8_t>(value(random));
+            std::vector<uint8_t> simd(static_cast<std::size_t>(glyphWidth) * rows * 4u);
+            std::vector<uint8_t> scalar(simd.size());
+            auto filter_all = [&](auto aFilter, std::vector<uint8_t>& aDestination)
+            {
+                for (uint32_t row = 0u; row < rows; ++row)
+                    aFilter(&source[static_cast<std::size_t>(row) * subpixels], subpixels, &aDestination[static_cast<std::size_t>(row) * glyphWidth * 4u]);
+            };
+            auto const name = "lcd_filter_row " + std::to_string(glyphs) + " x " + std::to_string(glyphWidth) + "px";
+            measure(name + " (SIMD)", samples, [&]() { filter_all(&glyph_rasterizer::lcd_filter_row, simd); });
+            measure(name + " (scalar)", samples, [&]() { filter_all(&glyph_rasterizer::lcd_filter_row_scalar, scalar); });
+            if (simd != scalar)
+                throw std::logic_error("lcd_filter_row: SIMD and scalar results differ");
+        }
+
+        register_benchmark const sLcdFilter{ "lcd_filter", lcd_filter };
+    }
+}
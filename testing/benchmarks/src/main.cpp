@@ -0,0 +1,56 @@
+// main.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include "benchmark.hpp"
+
+namespace ng = neogfx;
+
+// usage: benchmarks [<benchmark> [<arguments>...]]; all benchmarks are run (without arguments) if none is named
+int main(int argc, char* argv[])
+{
+    auto const& registry = ng::benchmarks::registry();
+    try
+    {
+        if (argc < 2)
+        {
+            for (auto const& b : registry)
+            {
+                std::cout << b.first << ":" << std::endl;
+                b.second({});
+            }
+            return EXIT_SUCCESS;
+        }
+        auto const b = registry.find(argv[1]);
+        if (b == registry.end())
+        {
+            std::cerr << "Unknown benchmark '" << argv[1] << "'; available benchmarks:" << std::endl;
+            for (auto const& available : registry)
+                std::cerr << "  " << available.first << std::endl;
+            return EXIT_FAILURE;
+        }
+        b->second(ng::benchmarks::arguments{ argv + 2, argv + argc });
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "benchmark failed: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
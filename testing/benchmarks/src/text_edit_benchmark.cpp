@@ -0,0 +1,63 @@
+// text_edit_benchmark.cpp
+/*
+  neogfx C++ GUI Library
+  Copyright (c) 2020 Leigh Johnston.  All Rights Reserved.
+
+  This program is free software: you can redistribute it and / or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <neogfx/neogfx.hpp>
+#include <neogfx/app/app.hpp>
+#include <neogfx/gui/window/window.hpp>
+#include <neogfx/gui/widget/text_edit.hpp>
+#include "benchmark.hpp"
+
+namespace neogfx::benchmarks
+{
+    namespace
+    {
+        std::string make_document(uint32_t aLines)
+        {
+            std::string result;
+            for (uint32_t line = 0u; line < aLines; ++line)
+                result += "The quick brown fox jumps over the lazy dog " + std::to_string(line) + "\n";
+            return result;
+        }
+
+        // usage: text_edit [<lines> [<keystrokes>]]
+        // the time from a character being typed to the text_edit's lines being up to date (each sample is one keystroke);
+        // typing near the start of the document is the worst case as every line after the edit moves
+        void text_edit_keystroke_latency(const arguments& aArguments)
+        {
+            auto const lines = aArguments.size() >= 1u ? static_cast<uint32_t>(std::stoul(aArguments[0])) : 10000u;
+            auto const keystrokes = aArguments.size() >= 2u ? static_cast<uint32_t>(std::stoul(aArguments[1])) : 200u;
+            app benchmarkApp;
+            window benchmarkWindow{ window_placement{ rect{ point{ 0.0, 0.0 }, size{ 800.0, 600.0 } } }, "text_edit benchmark" };
+            text_edit textEdit{ benchmarkWindow.client_layout() };
+            benchmarkWindow.layout_items();
+            textEdit.set_text(make_document(lines));
+            auto type_at = [&](const std::string& aName, text_edit::position_type aPosition)
+            {
+                textEdit.cursor().set_position(aPosition);
+                measure(aName + " (" + std::to_string(lines) + " lines)", keystrokes,
+                    [&]() { textEdit.text_input("x"); });
+            };
+            type_at("text_edit keystroke at start", 0u);
+            type_at("text_edit keystroke in middle", static_cast<text_edit::position_type>(textEdit.text().size() / 2u));
+            type_at("text_edit keystroke at end", static_cast<text_edit::position_type>(textEdit.text().size()));
+        }
+
+        register_benchmark const sTextEditKeystrokeLatency{ "text_edit", text_edit_keystroke_latency };
+    }
+}